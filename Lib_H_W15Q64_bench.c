@@ -0,0 +1,1652 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_bench.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Набор тестов производительности драйвера w15q64 на модели
+ *              микросхемы (запускается на хосте)
+ *  @warning    Сборка (или CMakeLists.txt, цель w15q64_bench):
+ *                  gcc -O2 -o w15q64_bench Lib_H_W15Q64_bench.c \
+ *                      Lib_H_W15Q64_sim.c Lib_H_W15Q64_flash_memory.c \
+ *                      Lib_H_W15Q64_job.c Lib_H_W15Q64_cache.c \
+ *                      Lib_H_W15Q64_wbuf.c Lib_H_W15Q64_erase.c \
+ *                      Lib_H_W15Q64_verify.c Lib_H_W15Q64_srv.c \
+ *                      Lib_H_W15Q64_srv_posix.c Lib_H_W15Q64_stripe.c \
+ *                      Lib_H_W15Q64_stats.c Lib_H_W15Q64_sfdp.c \
+ *                      Lib_H_W15Q64_ftl.c Lib_H_W15Q64_ring.c \
+ *                      Lib_H_W15Q64_update.c Lib_H_W15Q64_crc.c \
+ *                      Lib_H_W15Q64_integrity.c Lib_H_W15Q64_stream.c \
+ *                      -pthread [-DW15Q64_STATS=1]
+ *              Запуск:
+ *                  ./w15q64_bench [частота SCK в МГц] [-g] [-d] [-q]
+ *              Ключ -g включает функцию transaction (одна транзакция на шине
+ *              за один вызов функции порта), ключ -d - функции transmitReceive
+ *              и transmitReceiveDMA, ключ -q - порт с 2 и 4 линиями данных
+ *              (W15Q64_BusInit() выбирает команду чтения и устанавливает QE).
+ *              При сборке с W15Q64_STATS после таблицы выводятся счетчики
+ *              драйвера за все тесты.
+ *              Все времена - виртуальные времена модели (см. Lib_H_W15Q64_sim.h),
+ *              а не время работы хоста. Результаты используются как базовая
+ *              линия для оценки изменений в библиотеке.
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#include "Lib_H_W15Q64_sim.h"
+#include "Lib_H_W15Q64_job.h"
+#include "Lib_H_W15Q64_cache.h"
+#include "Lib_H_W15Q64_wbuf.h"
+#include "Lib_H_W15Q64_erase.h"
+#include "Lib_H_W15Q64_verify.h"
+#include "Lib_H_W15Q64_srv.h"
+#include "Lib_H_W15Q64_srv_posix.h"
+#include "Lib_H_W15Q64_stripe.h"
+#include "Lib_H_W15Q64_stats.h"
+#include "Lib_H_W15Q64_sfdp.h"
+#include "Lib_H_W15Q64_ftl.h"
+#include "Lib_H_W15Q64_ring.h"
+#include "Lib_H_W15Q64_update.h"
+#include "Lib_H_W15Q64_crc.h"
+#include "Lib_H_W15Q64_integrity.h"
+#include "Lib_H_W15Q64_stream.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_BENCH_MAX_MHZ                              4000 //    clockHz - uint32_t
+#define W15Q64_BENCH_SEQ_READ_LEN                         0x100000UL
+#define W15Q64_BENCH_READ_CHUNK                           4096
+#define W15Q64_BENCH_STREAM_CHUNK                         256
+#define W15Q64_BENCH_STREAM_BUFS                          4
+#define W15Q64_BENCH_STATUS_POLLS                         10000
+#define W15Q64_BENCH_BYTE_READ_LEN                        4096
+#define W15Q64_BENCH_RANDOM_READS                         10000
+#define W15Q64_BENCH_RANDOM_READ_LEN                      16
+#define W15Q64_BENCH_SEQ_WRITE_LEN                        0x40000UL
+#define W15Q64_BENCH_REWRITE_SECTORS                      16
+#define W15Q64_BENCH_POLL_FIRST_US                        20
+#define W15Q64_BENCH_POLL_MAX_US                          40
+#define W15Q64_BENCH_LOOP_PERIOD_US                       100
+#define W15Q64_BENCH_CACHE_LINES                          32
+#define W15Q64_BENCH_CACHE_LINE_SIZE                      128
+#define W15Q64_BENCH_LOG_LEN                              0x10000UL
+#define W15Q64_BENCH_LOG_RECORD                           16
+#define W15Q64_BENCH_LOG_DEADLINE_US                      2000
+#define W15Q64_BENCH_RANGE_START                          0x11000UL
+#define W15Q64_BENCH_RANGE_LEN                            0x5E000UL
+#define W15Q64_BENCH_RANGE_DIRTY_STEP                     3 //  Каждый 3-й сектор не чист
+#define W15Q64_BENCH_CACHE_REGIONS                        4 //  Горячие области
+#define W15Q64_BENCH_RWE_BLOCKS                           2 //  Блоки 64 КБ для чтения во время стирания
+#define W15Q64_BENCH_RWE_READ_PERIOD_US                   5000
+#define W15Q64_BENCH_RWE_READ_LEN                         256
+#define W15Q64_BENCH_MC_READERS                           2 //  Задачи чтения (приоритеты 1, 2)
+#define W15Q64_BENCH_MC_READS                             500
+#define W15Q64_BENCH_MC_SECTORS                           4 //  Стирание и запись задачей записи
+#define W15Q64_BENCH_MC_READ_BASE                         0x100000UL
+#define W15Q64_BENCH_STRIPE_CHIPS                         4
+#define W15Q64_BENCH_STRIPE_UNIT                          4096
+#define W15Q64_BENCH_FTL_START                            0x200000UL
+#define W15Q64_BENCH_FTL_SECTORS                          32
+#define W15Q64_BENCH_FTL_BLOCKS                           256
+#define W15Q64_BENCH_FTL_HOT                              16 // Часто изменяемые блоки
+#define W15Q64_BENCH_FTL_WRITES                           1024
+#define W15Q64_BENCH_FTL_PERIOD_US                        5000 // Период записей
+#define W15Q64_BENCH_RING_START                           0x240000UL
+#define W15Q64_BENCH_RING_SECTORS                         16
+#define W15Q64_BENCH_RING_QUEUE                           8 //  Страниц очереди
+#define W15Q64_BENCH_RING_RECORDS                         8192
+#define W15Q64_BENCH_RING_PERIOD_US                       1000 // Период записей
+#define W15Q64_BENCH_UPD_START                            0x300000UL
+#define W15Q64_BENCH_UPD_LEN                              0x40000UL
+#define W15Q64_BENCH_UPD_CHUNK                            1024 //  Часть образа
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    W15Q64sim_t sim;
+    W15Q64spi_t spi;
+    uint8_t buf[W15Q64_BENCH_READ_CHUNK];
+    uint8_t *pBig; //           Буфер на W15Q64_BENCH_SEQ_READ_LEN байт
+    uint32_t seed;
+    uint32_t dmaDone;
+    W15Q64cache_t cache;
+    W15Q64cacheLine_t cacheLines[W15Q64_BENCH_CACHE_LINES];
+    uint8_t cacheArena[W15Q64_BENCH_CACHE_LINES * W15Q64_BENCH_CACHE_LINE_SIZE];
+    W15Q64wbuf_t wbuf;
+    W15Q64stats_t stats;
+    W15Q64dev_t dev; //         Параметры SFDP модели
+    _Bool devValid;
+    W15Q64id_t id; //           Результат W15Q64_Probe()
+} W15Q64bench_t; //     Структура содержит окружение тестов
+
+typedef struct {
+    W15Q64srv_t *srv;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    W15Q64job_t job;
+    uint8_t prio;
+    uint32_t seed;
+    uint8_t buf[W15Q64_PAGE_SIZE];
+} W15Q64benchClient_t; //   Задача-клиент очереди запросов (поток POSIX)
+
+typedef struct {
+    const char *name;
+    void (* run) (W15Q64bench_t *bench,
+            uint32_t *pOps,
+            uint32_t *pBytes);
+} W15Q64benchCase_t; // Описание одного теста
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+static W15Q64bench_t bench;
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint32_t W15Q64_BenchRand(W15Q64bench_t *bench);
+static void W15Q64_BenchWaitBusy(W15Q64bench_t *bench);
+static void W15Q64_BenchPrepare(W15Q64bench_t *bench,
+                                uint32_t addr,
+                                uint32_t len);
+static void W15Q64_BenchSeqRead(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes);
+static void W15Q64_BenchByteRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchLongRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchAutoRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchChunkRead(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchStreamRead(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchStatusRegs(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchStatusPoll(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchDmaDone(void *pCtx);
+static void W15Q64_BenchDmaRead(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes);
+static void W15Q64_BenchRandomRead(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchContRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchCacheRead(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchSeqWrite(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchWrite(W15Q64bench_t *bench,
+                              uint32_t *pOps,
+                              uint32_t *pBytes);
+static void W15Q64_BenchStreamFill(void *pCtx,
+                                   uint32_t addr,
+                                   uint8_t *pBuf,
+                                   uint16_t cnt);
+static void W15Q64_BenchWriteStream(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes);
+static void W15Q64_BenchSfdpUse(W15Q64bench_t *bench,
+                                _Bool use);
+static void W15Q64_BenchWriteSfdp(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchLogDirect(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static uint32_t W15Q64_BenchNowUs(void);
+static void W15Q64_BenchLogWbuf(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes);
+static void W15Q64_BenchEraseRewrite(W15Q64bench_t *bench,
+                                     uint32_t *pOps,
+                                     uint32_t *pBytes);
+static void W15Q64_BenchFtl(W15Q64bench_t *bench,
+                            uint32_t *pOps,
+                            uint32_t *pBytes);
+static void W15Q64_BenchRing(W15Q64bench_t *bench,
+                             uint32_t *pOps,
+                             uint32_t *pBytes);
+static void W15Q64_BenchUpdatePrepare(W15Q64bench_t *bench);
+static void W15Q64_BenchUpdateFull(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchUpdateDiff(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchJobs(W15Q64bench_t *bench,
+                             uint32_t *pOps,
+                             uint32_t *pBytes);
+static void W15Q64_BenchReadErase(W15Q64bench_t *bench,
+                                  _Bool preempt,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchReadEraseWait(W15Q64bench_t *bench,
+                                      uint32_t *pOps,
+                                      uint32_t *pBytes);
+static void W15Q64_BenchReadEraseSuspend(W15Q64bench_t *bench,
+                                         uint32_t *pOps,
+                                         uint32_t *pBytes);
+static void W15Q64_BenchSrvWait(void *pCtx,
+                               uint32_t timeoutUs);
+static void W15Q64_BenchClientDone(void *pCtx,
+                                   W15Q64job_t *job);
+static void W15Q64_BenchClientExec(W15Q64benchClient_t *client);
+static void *W15Q64_BenchReader(void *pArg);
+static void *W15Q64_BenchWriter(void *pArg);
+static void *W15Q64_BenchServer(void *pArg);
+static void W15Q64_BenchMultiClient(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes);
+static _Bool W15Q64_BenchStripeInit(W15Q64bench_t *bench,
+                                    W15Q64stripe_t *vol,
+                                    W15Q64sim_t *pSims,
+                                    W15Q64spi_t *pSpi);
+static void W15Q64_BenchStripeFree(W15Q64sim_t *pSims);
+static void W15Q64_BenchStripeWrite(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes);
+static void W15Q64_BenchStripeErase(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes);
+static void W15Q64_BenchErase4KB(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchErase32KB(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchErase64KB(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchEraseRange(W15Q64bench_t *bench,
+                                   _Bool skipBlank,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchRangeAll(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes);
+static void W15Q64_BenchRangeSkip(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchRangeSfdp(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes);
+static void W15Q64_BenchBlankCheck(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes);
+static void W15Q64_BenchVerify(W15Q64bench_t *bench,
+                               uint32_t *pOps,
+                               uint32_t *pBytes);
+static void W15Q64_BenchScrub(W15Q64bench_t *bench,
+                              uint32_t *pOps,
+                              uint32_t *pBytes);
+static void W15Q64_BenchRun(W15Q64bench_t *bench,
+                            const W15Q64benchCase_t *pCase);
+static void W15Q64_BenchPrintStats(W15Q64bench_t *bench);
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Список тестов
+//------------------------------------------------------------------------------
+static const W15Q64benchCase_t benchCases[] = {
+    {"seq read FastReadData 4KB", W15Q64_BenchSeqRead},
+    {"seq read FastReadData32 1MB", W15Q64_BenchLongRead},
+    {"seq read FastReadAuto 4KB", W15Q64_BenchAutoRead},
+    {"seq read DMA 64KB", W15Q64_BenchDmaRead},
+    {"seq read FastReadData 256B", W15Q64_BenchChunkRead},
+    {"seq read Stream 256B x4", W15Q64_BenchStreamRead},
+    {"BlankCheck 1MB", W15Q64_BenchBlankCheck},
+    {"Verify 1MB", W15Q64_BenchVerify},
+    {"IntegrityScrub 1MB", W15Q64_BenchScrub},
+    {"seq read ReadData 1B", W15Q64_BenchByteRead},
+    {"status poll ReadStatRegs", W15Q64_BenchStatusRegs},
+    {"status poll IsBusy", W15Q64_BenchStatusPoll},
+    {"random read 16B", W15Q64_BenchRandomRead},
+    {"random read 16B FastReadCont", W15Q64_BenchContRead},
+    {"hot read 16B CacheRead", W15Q64_BenchCacheRead},
+    {"seq write PageProg 256B", W15Q64_BenchSeqWrite},
+    {"seq write Write backoff", W15Q64_BenchWrite},
+    {"seq write WriteStream", W15Q64_BenchWriteStream},
+    {"seq write Write SFDP poll", W15Q64_BenchWriteSfdp},
+    {"log 16B PageProg", W15Q64_BenchLogDirect},
+    {"log 16B Wbuf", W15Q64_BenchLogWbuf},
+    {"erase 4KB + rewrite", W15Q64_BenchEraseRewrite},
+    {"ftl 256B block rewrite", W15Q64_BenchFtl},
+    {"ring 16B append 1 kHz", W15Q64_BenchRing},
+    {"update 256KB full rewrite", W15Q64_BenchUpdateFull},
+    {"update 256KB 3 sectors diff", W15Q64_BenchUpdateDiff},
+    {"jobs erase+write Poll", W15Q64_BenchJobs},
+    {"read 256B during erase", W15Q64_BenchReadEraseWait},
+    {"read 256B during erase susp", W15Q64_BenchReadEraseSuspend},
+    {"multi-client Srv 3 threads", W15Q64_BenchMultiClient},
+    {"stripe x4 write 256KB", W15Q64_BenchStripeWrite},
+    {"stripe x4 erase 256KB", W15Q64_BenchStripeErase},
+    {"SectorErase4KB", W15Q64_BenchErase4KB},
+    {"BlockErase32KB", W15Q64_BenchErase32KB},
+    {"BlockErase64KB", W15Q64_BenchErase64KB},
+    {"EraseRange 376KB", W15Q64_BenchRangeAll},
+    {"EraseRange 376KB skipBlank", W15Q64_BenchRangeSkip},
+    {"EraseRange 376KB SFDP poll", W15Q64_BenchRangeSfdp},
+};
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    unsigned long mhz;
+    char *pEnd;
+
+    if (!W15Q64_SimInit(&bench.sim, NULL, W15Q64_SIM_CAPACITY)
+        || !W15Q64_SimBind(&bench.sim, &bench.spi))
+    {
+        fprintf(stderr, "w15q64_bench: simulator init failed\n");
+        return 1;
+    }
+    for (i = 1; i < (uint32_t) argc; i++)
+    {
+        if (strcmp(argv[i], "-g") == 0)
+        {
+            W15Q64_SimGather(&bench.sim, &bench.spi, true);
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            W15Q64_SimDuplex(&bench.sim, &bench.spi, true);
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            W15Q64_SimMultiIo(&bench.sim, &bench.spi, W15Q64_BUS_DUAL | W15Q64_BUS_QUAD);
+        }
+        else
+        {
+            // Частота SCK в МГц: целое число от 1 до W15Q64_BENCH_MAX_MHZ
+            mhz = strtoul(argv[i], &pEnd, 10);
+            if ((pEnd == argv[i]) || (*pEnd != '\0')
+                || (mhz == 0) || (mhz > W15Q64_BENCH_MAX_MHZ))
+            {
+                fprintf(stderr, "usage: w15q64_bench [SCK MHz 1-%u] [-g] [-d] [-q]\n",
+                        (unsigned) W15Q64_BENCH_MAX_MHZ);
+                W15Q64_SimFree(&bench.sim);
+                return 1;
+            }
+            bench.sim.timing.clockHz = (uint32_t) (mhz * 1000000UL);
+        }
+    }
+    bench.seed = 12345;
+    bench.pBig = (uint8_t *) malloc(W15Q64_BENCH_SEQ_READ_LEN);
+    if (bench.pBig == NULL)
+    {
+        fprintf(stderr, "w15q64_bench: out of memory\n");
+        return 1;
+    }
+
+    printf("W15Q64 benchmark, SCK %lu Hz, port call overhead %lu ns, %s\n",
+           (unsigned long) bench.sim.timing.clockHz,
+           (unsigned long) bench.sim.timing.callNs,
+           (bench.spi.transaction != NULL) ? "gathered transactions" : "per-segment callbacks");
+    printf("full-duplex/DMA port: %s\n", (bench.spi.transmitReceive != NULL) ? "yes" : "no");
+    W15Q64_StatsInit(&bench.stats, W15Q64_BenchNowUs);
+    W15Q64_StatsAttach(&bench.spi, &bench.stats);
+    printf("read instruction: %02Xh\n", W15Q64_BusInit(&bench.spi));
+    bench.devValid = W15Q64_SfdpProbe(&bench.spi, &bench.dev);
+    if (bench.devValid)
+    {
+        printf("sfdp: %lu bytes, tPP %lu us, tSE %lu us\n",
+               (unsigned long) bench.dev.capacity,
+               (unsigned long) bench.dev.tPPtypUs,
+               (unsigned long) bench.dev.erase[0].typUs);
+    }
+    if (W15Q64_Probe(&bench.spi, &bench.id))
+    {
+        printf("probe: JEDEC ID %02X %02X %02X, status %04X\n",
+               bench.id.manufacturerId, bench.id.memoryType, bench.id.capacityCode,
+               bench.id.status);
+    }
+    printf("%-28s %8s %10s %10s %10s %8s %8s %8s %8s\n",
+           "case", "ops", "time ms", "MB/s", "ops/s",
+           "wire/B", "CS/op", "call/op", "poll/op");
+    for (i = 0; i < sizeof (benchCases) / sizeof (benchCases[0]); i++)
+    {
+        W15Q64_BenchRun(&bench, &benchCases[i]);
+    }
+    W15Q64_BenchPrintStats(&bench);
+
+    free(bench.pBig);
+    W15Q64_SimFree(&bench.sim);
+    return 0;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция выполняет один тест и печатает строку результатов
+ *  @param  *bench: Указатель на окружение тестов
+ *  @param  *pCase: Указатель на описание теста
+ *  @retval None
+ */
+static void W15Q64_BenchRun(W15Q64bench_t *bench,
+                            const W15Q64benchCase_t *pCase)
+{
+    uint32_t ops = 0,
+            bytes = 0;
+    uint64_t startNs;
+    double sec, wire;
+    W15Q64simStats_t *st = &bench->sim.stats;
+
+    W15Q64_SimResetStats(&bench->sim);
+    startNs = W15Q64_SimNowNs(&bench->sim);
+    pCase->run(bench, &ops, &bytes);
+    sec = (double) (W15Q64_SimNowNs(&bench->sim) - startNs) / 1e9;
+    wire = (double) (st->txBytes + st->rxBytes);
+
+    printf("%-28s %8lu %10.3f %10.3f %10.0f %8.3f %8.2f %8.2f %8.2f%s\n",
+           pCase->name,
+           (unsigned long) ops,
+           sec * 1e3,
+           (sec > 0) ? ((double) bytes / sec / 1e6) : 0.0,
+           (sec > 0) ? ((double) ops / sec) : 0.0,
+           (bytes != 0) ? (wire / bytes) : 0.0,
+           (ops != 0) ? ((double) st->csCycles / ops) : 0.0,
+           (ops != 0) ? ((double) st->portCalls / ops) : 0.0,
+           (ops != 0) ? ((double) st->statusReads / ops) : 0.0,
+           (st->violations != 0) ? "  PROTOCOL VIOLATIONS" : "");
+}
+
+static uint32_t W15Q64_BenchRand(W15Q64bench_t *bench)
+{
+    bench->seed = bench->seed * 1103515245UL + 12345UL;
+    return bench->seed >> 1;
+}
+
+/**
+ *  @brief  Функция ожидает окончания внутренней операции так же, как это
+ *          делает код, использующий библиотеку
+ */
+static void W15Q64_BenchWaitBusy(W15Q64bench_t *bench)
+{
+    W15Q64statRegs_t status;
+    do
+    {
+        W15Q64_ReadStatRegs(&bench->spi, &status);
+    }
+    while (status.reg1[W15Q64_BUSY]);
+}
+
+/**
+ *  @brief  Функция подготавливает область памяти модели к тесту без
+ *          обращения к шине (стирание)
+ */
+static void W15Q64_BenchPrepare(W15Q64bench_t *bench,
+                                uint32_t addr,
+                                uint32_t len)
+{
+    memset(&bench->sim.pMem[addr], 0xFF, len);
+}
+
+static void W15Q64_BenchSeqRead(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes)
+{
+    uint32_t addr;
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_READ_LEN; addr += W15Q64_BENCH_READ_CHUNK)
+    {
+        W15Q64_FastReadData(&bench->spi, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchAutoRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    uint32_t addr;
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_READ_LEN; addr += W15Q64_BENCH_READ_CHUNK)
+    {
+        W15Q64_FastReadAuto(&bench->spi, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchLongRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    W15Q64_FastReadData32(&bench->spi, 0, bench->pBig, W15Q64_BENCH_SEQ_READ_LEN);
+    *pOps = 1;
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchBlankCheck(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    W15Q64verifyResult_t res;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_READ_LEN);
+    W15Q64_BlankCheck(&bench->spi, 0, W15Q64_BENCH_SEQ_READ_LEN, &res);
+    *pOps = 1;
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchVerify(W15Q64bench_t *bench,
+                               uint32_t *pOps,
+                               uint32_t *pBytes)
+{
+    W15Q64verifyResult_t res;
+
+    memcpy(bench->pBig, bench->sim.pMem, W15Q64_BENCH_SEQ_READ_LEN);
+    W15Q64_Verify(&bench->spi, 0, bench->pBig, W15Q64_BENCH_SEQ_READ_LEN, &res);
+    *pOps = 1;
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+/**
+ *  @brief  Проверка CRC-32C страниц 1 МБ (ср. "Verify 1MB"). Страницы с CRC
+ *          записываются в модель без времени, в 3 страницах изменяется бит
+ */
+static void W15Q64_BenchScrub(W15Q64bench_t *bench,
+                              uint32_t *pOps,
+                              uint32_t *pBytes)
+{
+    W15Q64verifyResult_t res;
+    uint8_t *pPage;
+    uint32_t addr,
+            crc,
+            i;
+
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_READ_LEN; addr += W15Q64_PAGE_SIZE)
+    {
+        pPage = &bench->sim.pMem[addr];
+        for (i = 0; i < W15Q64_INTEGRITY_DATA; i++)
+        {
+            pPage[i] = (uint8_t) W15Q64_BenchRand(bench);
+        }
+        crc = W15Q64_Crc32c(0, pPage, W15Q64_INTEGRITY_DATA);
+        memcpy(&pPage[W15Q64_INTEGRITY_DATA], &crc, 4); //  Хост little-endian
+    }
+    for (i = 1; i <= 3; i++)
+    {
+        bench->sim.pMem[i * (W15Q64_BENCH_SEQ_READ_LEN / 4) + 17] ^= 0x04;
+    }
+
+    W15Q64_IntegrityScrub(&bench->spi, 0, W15Q64_BENCH_SEQ_READ_LEN / W15Q64_PAGE_SIZE, &res);
+    printf("  scrub: %lu bad pages, first 0x%06lX\n",
+           (unsigned long) res.mismatches, (unsigned long) res.firstAddr);
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_READ_LEN);
+    *pOps = W15Q64_BENCH_SEQ_READ_LEN / W15Q64_PAGE_SIZE;
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchChunkRead(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    uint32_t addr;
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_READ_LEN; addr += W15Q64_BENCH_STREAM_CHUNK)
+    {
+        W15Q64_FastReadData(&bench->spi, addr, &bench->pBig[addr], W15Q64_BENCH_STREAM_CHUNK);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchStreamRead(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    W15Q64stream_t st;
+    const uint8_t *pData;
+    uint32_t cnt;
+
+    W15Q64_StreamOpen(&st, &bench->spi, 0, W15Q64_BENCH_SEQ_READ_LEN, bench->buf,
+                      W15Q64_BENCH_STREAM_CHUNK, W15Q64_BENCH_STREAM_BUFS);
+    while ((pData = W15Q64_StreamGet(&st, &cnt)) != NULL)
+    {
+        memcpy(&bench->pBig[*pBytes], pData, cnt);
+        *pBytes += cnt;
+        (*pOps)++;
+    }
+    W15Q64_StreamClose(&st);
+    printf("  stream: %lu buffers, %lu stalls\n",
+           (unsigned long) st.stats.buffers, (unsigned long) st.stats.stalls);
+}
+
+static void W15Q64_BenchStatusRegs(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    W15Q64statRegs_t status;
+    uint32_t i;
+
+    (void) pBytes;
+    for (i = 0; i < W15Q64_BENCH_STATUS_POLLS; i++)
+    {
+        W15Q64_ReadStatRegs(&bench->spi, &status);
+        (*pOps)++;
+    }
+}
+
+static void W15Q64_BenchStatusPoll(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    uint32_t i;
+
+    (void) pBytes;
+    for (i = 0; i < W15Q64_BENCH_STATUS_POLLS; i++)
+    {
+        W15Q64_IsBusy(&bench->spi);
+        (*pOps)++;
+    }
+}
+
+static void W15Q64_BenchDmaDone(void *pCtx)
+{
+    ((W15Q64bench_t *) pCtx)->dmaDone++;
+}
+
+static void W15Q64_BenchDmaRead(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    bench->dmaDone = 0;
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_READ_LEN; addr += 0x10000UL)
+    {
+        while (!W15Q64_FastReadDataDMA(&bench->spi, addr, &bench->pBig[addr], 0x10000UL,
+                                       W15Q64_BenchDmaDone, bench))
+        {
+        }
+        (*pOps)++;
+    }
+    while (bench->spi.dmaBusy)
+    {
+    }
+    *pBytes = W15Q64_BENCH_SEQ_READ_LEN;
+}
+
+static void W15Q64_BenchByteRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    uint32_t addr;
+    for (addr = 0; addr < W15Q64_BENCH_BYTE_READ_LEN; addr++)
+    {
+        bench->buf[addr] = W15Q64_ReadData(&bench->spi, addr);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_BYTE_READ_LEN;
+}
+
+static void W15Q64_BenchRandomRead(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    uint32_t i;
+    for (i = 0; i < W15Q64_BENCH_RANDOM_READS; i++)
+    {
+        W15Q64_FastReadData(&bench->spi,
+                            W15Q64_BenchRand(bench) % (W15Q64_SIM_CAPACITY - W15Q64_BENCH_RANDOM_READ_LEN),
+                            bench->buf,
+                            W15Q64_BENCH_RANDOM_READ_LEN);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_RANDOM_READS * W15Q64_BENCH_RANDOM_READ_LEN;
+}
+
+static void W15Q64_BenchContRead(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    uint32_t i;
+    for (i = 0; i < W15Q64_BENCH_RANDOM_READS; i++)
+    {
+        W15Q64_FastReadCont(&bench->spi,
+                            W15Q64_BenchRand(bench) % (W15Q64_SIM_CAPACITY - W15Q64_BENCH_RANDOM_READ_LEN),
+                            bench->buf,
+                            W15Q64_BENCH_RANDOM_READ_LEN);
+        (*pOps)++;
+    }
+    W15Q64_ContReadExit(&bench->spi);
+    *pBytes = W15Q64_BENCH_RANDOM_READS * W15Q64_BENCH_RANDOM_READ_LEN;
+}
+
+/**
+ *  @brief  Чтение конфигурации: случайные 16 байт из нескольких горячих
+ *          областей по 1 КБ через кэш чтения
+ */
+static void W15Q64_BenchCacheRead(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    uint32_t i,
+            region;
+
+    W15Q64_CacheInit(&bench->cache, &bench->spi,
+                     bench->cacheLines, W15Q64_BENCH_CACHE_LINES,
+                     bench->cacheArena, W15Q64_BENCH_CACHE_LINE_SIZE);
+    for (i = 0; i < W15Q64_BENCH_RANDOM_READS; i++)
+    {
+        region = W15Q64_BenchRand(bench) % W15Q64_BENCH_CACHE_REGIONS;
+        W15Q64_CacheRead(&bench->cache,
+                         region * 0x10000UL + W15Q64_BenchRand(bench) % (1024 - W15Q64_BENCH_RANDOM_READ_LEN),
+                         bench->buf,
+                         W15Q64_BENCH_RANDOM_READ_LEN);
+        (*pOps)++;
+    }
+    printf("  cache: %lu hits, %lu misses, %lu evictions\n",
+           (unsigned long) bench->cache.stats.hits,
+           (unsigned long) bench->cache.stats.misses,
+           (unsigned long) bench->cache.stats.evictions);
+    bench->spi.modify = NULL;
+    *pBytes = W15Q64_BENCH_RANDOM_READS * W15Q64_BENCH_RANDOM_READ_LEN;
+}
+
+static void W15Q64_BenchSeqWrite(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+    memset(bench->buf, 0x5A, W15Q64_BENCH_READ_CHUNK);
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_WRITE_LEN; addr += 256)
+    {
+        W15Q64_PageProg(&bench->spi, addr, bench->buf, 256);
+        W15Q64_BenchWaitBusy(bench);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+}
+
+static void W15Q64_BenchWrite(W15Q64bench_t *bench,
+                              uint32_t *pOps,
+                              uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+    bench->spi.pollFirstUs = W15Q64_BENCH_POLL_FIRST_US;
+    bench->spi.pollMaxUs = W15Q64_BENCH_POLL_MAX_US;
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_WRITE_LEN; addr += W15Q64_BENCH_READ_CHUNK)
+    {
+        // Данные готовятся до записи, как и в W15Q64_BenchStreamFill()
+        W15Q64_BenchStreamFill(bench, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+        W15Q64_Write(&bench->spi, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+    }
+    bench->spi.pollFirstUs = 0;
+    bench->spi.pollMaxUs = 0;
+    *pOps = W15Q64_BENCH_SEQ_WRITE_LEN / W15Q64_PAGE_SIZE;
+    *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+}
+
+/**
+ *  @brief  Функция заполнения страницы для W15Q64_WriteStream(). Время
+ *          подготовки данных (1 мкс на 4 байта) учитывается в модели и
+ *          перекрывается с программированием предыдущей страницы
+ */
+static void W15Q64_BenchStreamFill(void *pCtx,
+                                   uint32_t addr,
+                                   uint8_t *pBuf,
+                                   uint16_t cnt)
+{
+    W15Q64bench_t *bench = (W15Q64bench_t *) pCtx;
+    memset(pBuf, (uint8_t) (addr >> 8), cnt);
+    W15Q64_SimAdvanceNs(&bench->sim, (uint64_t) cnt * 1000 / 4);
+}
+
+static void W15Q64_BenchWriteStream(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes)
+{
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+    bench->spi.pollFirstUs = W15Q64_BENCH_POLL_FIRST_US;
+    bench->spi.pollMaxUs = W15Q64_BENCH_POLL_MAX_US;
+    W15Q64_WriteStream(&bench->spi, 0, W15Q64_BENCH_SEQ_WRITE_LEN,
+                       W15Q64_BenchStreamFill, bench);
+    bench->spi.pollFirstUs = 0;
+    bench->spi.pollMaxUs = 0;
+    *pOps = W15Q64_BENCH_SEQ_WRITE_LEN / W15Q64_PAGE_SIZE;
+    *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+}
+
+/**
+ *  @brief  Функция подключает к порту параметры SFDP модели (задержки опроса
+ *          BUSY из tPP и tSE) или восстанавливает параметры по умолчанию
+ */
+static void W15Q64_BenchSfdpUse(W15Q64bench_t *bench,
+                                _Bool use)
+{
+    if (use && bench->devValid)
+    {
+        W15Q64_SfdpApply(&bench->spi, &bench->dev);
+        return;
+    }
+    bench->spi.pDev = NULL;
+    bench->spi.pollFirstUs = 0;
+    bench->spi.pollMaxUs = 0;
+}
+
+/**
+ *  @brief  То же, что "seq write Write backoff", но с задержками опроса BUSY
+ *          из параметров SFDP
+ */
+static void W15Q64_BenchWriteSfdp(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+    W15Q64_BenchSfdpUse(bench, true);
+    for (addr = 0; addr < W15Q64_BENCH_SEQ_WRITE_LEN; addr += W15Q64_BENCH_READ_CHUNK)
+    {
+        W15Q64_BenchStreamFill(bench, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+        W15Q64_Write(&bench->spi, addr, bench->buf, W15Q64_BENCH_READ_CHUNK);
+    }
+    W15Q64_BenchSfdpUse(bench, false);
+    *pOps = W15Q64_BENCH_SEQ_WRITE_LEN / W15Q64_PAGE_SIZE;
+    *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+}
+
+/**
+ *  @brief  Журнал: последовательные записи по 16 байт, каждая - отдельной
+ *          командой Page Program
+ */
+static void W15Q64_BenchLogDirect(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_LOG_LEN);
+    for (addr = 0; addr < W15Q64_BENCH_LOG_LEN; addr += W15Q64_BENCH_LOG_RECORD)
+    {
+        W15Q64_PageProg(&bench->spi, addr, bench->buf, W15Q64_BENCH_LOG_RECORD);
+        W15Q64_WaitBusy(&bench->spi);
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_LOG_LEN;
+}
+
+static uint32_t W15Q64_BenchNowUs(void)
+{
+    return (uint32_t) (W15Q64_SimNowNs(&bench.sim) / 1000);
+}
+
+/**
+ *  @brief  Журнал: те же записи через буфер записи с deadline
+ */
+static void W15Q64_BenchLogWbuf(W15Q64bench_t *bench,
+                                uint32_t *pOps,
+                                uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_LOG_LEN);
+    W15Q64_WbufInit(&bench->wbuf, &bench->spi,
+                    W15Q64_BENCH_LOG_DEADLINE_US, W15Q64_BenchNowUs);
+    for (addr = 0; addr < W15Q64_BENCH_LOG_LEN; addr += W15Q64_BENCH_LOG_RECORD)
+    {
+        W15Q64_WbufWrite(&bench->wbuf, addr, bench->buf, W15Q64_BENCH_LOG_RECORD);
+        W15Q64_WbufPoll(&bench->wbuf);
+        (*pOps)++;
+    }
+    W15Q64_WbufFlush(&bench->wbuf);
+    *pBytes = W15Q64_BENCH_LOG_LEN;
+}
+
+static void W15Q64_BenchEraseRewrite(W15Q64bench_t *bench,
+                                     uint32_t *pOps,
+                                     uint32_t *pBytes)
+{
+    uint32_t sector, addr;
+
+    memset(bench->buf, 0xA5, W15Q64_BENCH_READ_CHUNK);
+    for (sector = 0; sector < W15Q64_BENCH_REWRITE_SECTORS; sector++)
+    {
+        W15Q64_SectorErase4KB(&bench->spi, sector * 4096);
+        W15Q64_BenchWaitBusy(bench);
+        for (addr = 0; addr < 4096; addr += 256)
+        {
+            W15Q64_PageProg(&bench->spi, sector * 4096 + addr, bench->buf, 256);
+            W15Q64_BenchWaitBusy(bench);
+        }
+        (*pOps)++;
+    }
+    *pBytes = W15Q64_BENCH_REWRITE_SECTORS * 4096;
+}
+
+/**
+ *  @brief  Изменение блоков по 256 байт через журнальный слой (ср. "erase 4KB
+ *          + rewrite"): W15Q64_BENCH_FTL_WRITES записей с периодом
+ *          W15Q64_BENCH_FTL_PERIOD_US в W15Q64_BENCH_FTL_HOT блоков из
+ *          W15Q64_BENCH_FTL_BLOCKS. Между записями сборка мусора и
+ *          стирание выполняются в фоне (W15Q64_FtlPoll()), запись во время
+ *          стирания приостанавливает его. Время включает монтирование и
+ *          паузы между записями
+ */
+static void W15Q64_BenchFtl(W15Q64bench_t *bench,
+                            uint32_t *pOps,
+                            uint32_t *pBytes)
+{
+    static W15Q64ftlSector_t sectors[W15Q64_BENCH_FTL_SECTORS];
+    static uint16_t map[W15Q64_BENCH_FTL_BLOCKS];
+    W15Q64ftl_t ftl;
+    uint64_t startNs,
+            opNs,
+            worstNs = 0,
+            nextNs;
+    uint32_t i,
+            minErase = 0xFFFFFFFFUL,
+            maxErase = 0;
+    uint16_t lba;
+
+    if (!W15Q64_FtlInit(&ftl, &bench->spi, W15Q64_BENCH_FTL_START,
+                        W15Q64_BENCH_FTL_SECTORS, sectors, map, W15Q64_BENCH_FTL_BLOCKS))
+    {
+        return;
+    }
+    ftl.now_us = W15Q64_BenchNowUs;
+    W15Q64_FtlMount(&ftl);
+    for (lba = 0; lba < W15Q64_BENCH_FTL_BLOCKS; lba++)
+    {
+        memset(bench->buf, (uint8_t) lba, W15Q64_PAGE_SIZE);
+        W15Q64_FtlWrite(&ftl, lba, bench->buf);
+    }
+    for (i = 0; i < W15Q64_BENCH_FTL_WRITES; i++)
+    {
+        lba = (uint16_t) (W15Q64_BenchRand(bench) % W15Q64_BENCH_FTL_HOT);
+        memset(bench->buf, (uint8_t) i, W15Q64_PAGE_SIZE);
+        startNs = W15Q64_SimNowNs(&bench->sim);
+        W15Q64_FtlWrite(&ftl, lba, bench->buf);
+        opNs = W15Q64_SimNowNs(&bench->sim) - startNs;
+        if (opNs > worstNs)
+        {
+            worstNs = opNs;
+        }
+
+        // Свободное время до следующей записи
+        nextNs = startNs + W15Q64_BENCH_FTL_PERIOD_US * 1000ULL;
+        while (W15Q64_SimNowNs(&bench->sim) < nextNs)
+        {
+            if (!W15Q64_FtlPoll(&ftl))
+            {
+                W15Q64_SimAdvanceNs(&bench->sim, W15Q64_BENCH_LOOP_PERIOD_US * 1000UL);
+            }
+        }
+    }
+    while (W15Q64_FtlPoll(&ftl))
+    {
+        W15Q64_SimAdvanceNs(&bench->sim, W15Q64_BENCH_LOOP_PERIOD_US * 1000UL);
+    }
+    for (i = 0; i < W15Q64_BENCH_FTL_SECTORS; i++)
+    {
+        if (sectors[i].eraseCnt < minErase)
+        {
+            minErase = sectors[i].eraseCnt;
+        }
+        if (sectors[i].eraseCnt > maxErase)
+        {
+            maxErase = sectors[i].eraseCnt;
+        }
+    }
+    printf("  ftl: %lu programs, %lu gc copies, %lu erases, %lu suspends, %lu fg collects, "
+           "erase count %lu..%lu, worst write %lu us\n",
+           (unsigned long) ftl.stats.programs,
+           (unsigned long) ftl.stats.gcCopies,
+           (unsigned long) ftl.stats.erases,
+           (unsigned long) ftl.stats.suspends,
+           (unsigned long) ftl.stats.fgCollects,
+           (unsigned long) minErase,
+           (unsigned long) maxErase,
+           (unsigned long) (worstNs / 1000));
+    *pOps = W15Q64_BENCH_FTL_BLOCKS + W15Q64_BENCH_FTL_WRITES;
+    *pBytes = *pOps * W15Q64_PAGE_SIZE;
+}
+
+/**
+ *  @brief  Кольцевой журнал: записи по W15Q64_BENCH_LOG_RECORD байт с
+ *          периодом W15Q64_BENCH_RING_PERIOD_US (журнал проходит круг
+ *          несколько раз), W15Q64_RingPoll() после каждой записи. Затем
+ *          повторное монтирование и чтение всех записей
+ */
+static void W15Q64_BenchRing(W15Q64bench_t *bench,
+                             uint32_t *pOps,
+                             uint32_t *pBytes)
+{
+    static uint8_t queue[W15Q64_BENCH_RING_QUEUE * W15Q64_PAGE_SIZE];
+    W15Q64ring_t ring;
+    W15Q64ringCursor_t cur;
+    uint64_t startNs,
+            opNs,
+            worstNs = 0;
+    uint32_t i,
+            reads,
+            cnt = 0;
+
+    if (!W15Q64_RingInit(&ring, &bench->spi, W15Q64_BENCH_RING_START,
+                         W15Q64_BENCH_RING_SECTORS, queue, W15Q64_BENCH_RING_QUEUE))
+    {
+        return;
+    }
+    W15Q64_RingMount(&ring);
+    for (i = 0; i < W15Q64_BENCH_RING_RECORDS; i++)
+    {
+        memset(bench->buf, (uint8_t) i, W15Q64_BENCH_LOG_RECORD);
+        startNs = W15Q64_SimNowNs(&bench->sim);
+        W15Q64_RingAppend(&ring, bench->buf, W15Q64_BENCH_LOG_RECORD);
+        W15Q64_RingPoll(&ring);
+        opNs = W15Q64_SimNowNs(&bench->sim) - startNs;
+        if (opNs > worstNs)
+        {
+            worstNs = opNs;
+        }
+        W15Q64_SimAdvanceNs(&bench->sim, W15Q64_BENCH_RING_PERIOD_US * 1000UL - opNs);
+    }
+    W15Q64_RingFlush(&ring);
+    printf("  ring: %lu pages, %lu erases, %lu overruns, worst append+poll %lu us\n",
+           (unsigned long) ring.stats.pages,
+           (unsigned long) ring.stats.erases,
+           (unsigned long) ring.stats.overruns,
+           (unsigned long) (worstNs / 1000));
+
+    startNs = W15Q64_SimNowNs(&bench->sim);
+    W15Q64_RingInit(&ring, &bench->spi, W15Q64_BENCH_RING_START,
+                    W15Q64_BENCH_RING_SECTORS, queue, W15Q64_BENCH_RING_QUEUE);
+    W15Q64_RingMount(&ring);
+    opNs = W15Q64_SimNowNs(&bench->sim) - startNs;
+    reads = ring.stats.mountReads;
+    W15Q64_RingFirst(&ring, &cur);
+    while (W15Q64_RingNext(&ring, &cur, bench->buf) != 0)
+    {
+        cnt++;
+    }
+    printf("  ring: mount %lu reads %lu us, %lu records kept\n",
+           (unsigned long) reads,
+           (unsigned long) (opNs / 1000),
+           (unsigned long) cnt);
+    *pOps = W15Q64_BENCH_RING_RECORDS;
+    *pBytes = W15Q64_BENCH_RING_RECORDS * W15Q64_BENCH_LOG_RECORD;
+}
+
+/**
+ *  @brief  Подготовка обновления образа: старый образ записывается в модель
+ *          (без времени), в pBig - новый образ, в котором изменены 3
+ *          сектора: в одном биты только сбрасываются, в двух - и
+ *          устанавливаются
+ */
+static void W15Q64_BenchUpdatePrepare(W15Q64bench_t *bench)
+{
+    uint32_t i;
+
+    for (i = 0; i < W15Q64_BENCH_UPD_LEN; i++)
+    {
+        bench->pBig[i] = (uint8_t) W15Q64_BenchRand(bench);
+    }
+    memset(&bench->pBig[W15Q64_BENCH_UPD_LEN - W15Q64_SECTOR_SIZE], 0xFF, W15Q64_SECTOR_SIZE);
+    memcpy(&bench->sim.pMem[W15Q64_BENCH_UPD_START], bench->pBig, W15Q64_BENCH_UPD_LEN);
+
+    memset(&bench->pBig[W15Q64_BENCH_UPD_LEN - W15Q64_SECTOR_SIZE], 0x5A, 300);
+    for (i = 0; i < 64; i++)
+    {
+        bench->pBig[5 * W15Q64_SECTOR_SIZE + 100 + i] ^= 0xFF;
+        bench->pBig[40 * W15Q64_SECTOR_SIZE + 7 * i] ^= 0x10;
+    }
+}
+
+/**
+ *  @brief  Обновление образа записью целиком: стирание блоками 64 КБ и
+ *          программирование всех страниц
+ */
+static void W15Q64_BenchUpdateFull(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    uint32_t addr;
+
+    W15Q64_BenchUpdatePrepare(bench);
+    for (addr = 0; addr < W15Q64_BENCH_UPD_LEN; addr += W15Q64_PAGE_SIZE)
+    {
+        if ((addr & (W15Q64_BLOCK_64KB_SIZE - 1)) == 0)
+        {
+            W15Q64_BlockErase64KB(&bench->spi, W15Q64_BENCH_UPD_START + addr);
+            W15Q64_BenchWaitBusy(bench);
+        }
+        W15Q64_PageProg(&bench->spi, W15Q64_BENCH_UPD_START + addr, &bench->pBig[addr],
+                        W15Q64_PAGE_SIZE);
+        W15Q64_BenchWaitBusy(bench);
+    }
+    *pOps = W15Q64_BENCH_UPD_LEN / W15Q64_SECTOR_SIZE;
+    *pBytes = W15Q64_BENCH_UPD_LEN;
+}
+
+/**
+ *  @brief  Обновление того же образа с записью только измененных секторов,
+ *          образ передается частями по W15Q64_BENCH_UPD_CHUNK байт
+ */
+static void W15Q64_BenchUpdateDiff(W15Q64bench_t *bench,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    static W15Q64update_t upd;
+    uint32_t addr;
+
+    W15Q64_BenchUpdatePrepare(bench);
+    W15Q64_UpdateBegin(&upd, &bench->spi, W15Q64_BENCH_UPD_START, W15Q64_BenchNowUs);
+    for (addr = 0; addr < W15Q64_BENCH_UPD_LEN; addr += W15Q64_BENCH_UPD_CHUNK)
+    {
+        W15Q64_UpdateWrite(&upd, &bench->pBig[addr], W15Q64_BENCH_UPD_CHUNK);
+    }
+    if (!W15Q64_UpdateEnd(&upd)
+        || (memcmp(&bench->sim.pMem[W15Q64_BENCH_UPD_START], bench->pBig,
+                   W15Q64_BENCH_UPD_LEN) != 0))
+    {
+        printf("  update: IMAGE MISMATCH\n");
+    }
+    printf("  update: %lu skipped, %lu without erase, %lu erased, %lu pages,"
+           " %lu bytes saved, %lu of %lu ms saved\n",
+           (unsigned long) upd.stats.skipped,
+           (unsigned long) upd.stats.programmed,
+           (unsigned long) upd.stats.erased,
+           (unsigned long) upd.stats.pages,
+           (unsigned long) upd.stats.bytesSaved,
+           (unsigned long) (upd.stats.savedUs / 1000),
+           (unsigned long) (upd.stats.fullUs / 1000));
+    *pOps = upd.stats.sectors;
+    *pBytes = W15Q64_BENCH_UPD_LEN;
+}
+
+/**
+ *  @brief  Стирание и запись 16 секторов через очередь заданий. W15Q64_Poll()
+ *          вызывается из "главного цикла" с периодом W15Q64_BENCH_LOOP_PERIOD_US,
+ *          время между вызовами остается свободным для остальной программы
+ */
+static void W15Q64_BenchJobs(W15Q64bench_t *bench,
+                             uint32_t *pOps,
+                             uint32_t *pBytes)
+{
+    static W15Q64job_t jobs[2 * W15Q64_BENCH_REWRITE_SECTORS];
+    W15Q64jobQueue_t queue;
+    uint32_t sector;
+
+    memset(bench->buf, 0xC3, W15Q64_BENCH_READ_CHUNK);
+    W15Q64_JobInit(&queue, &bench->spi);
+    for (sector = 0; sector < W15Q64_BENCH_REWRITE_SECTORS; sector++)
+    {
+        W15Q64_JobErase(&jobs[2 * sector], W15Q64_SECTOR_ERASE_4KB,
+                        sector * W15Q64_SECTOR_SIZE, NULL, NULL);
+        W15Q64_JobSubmit(&queue, &jobs[2 * sector]);
+        W15Q64_JobProgram(&jobs[2 * sector + 1], sector * W15Q64_SECTOR_SIZE,
+                          bench->buf, W15Q64_SECTOR_SIZE, NULL, NULL);
+        W15Q64_JobSubmit(&queue, &jobs[2 * sector + 1]);
+    }
+    while (W15Q64_Poll(&queue))
+    {
+        W15Q64_SimAdvanceNs(&bench->sim, W15Q64_BENCH_LOOP_PERIOD_US * 1000UL);
+    }
+    *pOps = W15Q64_BENCH_REWRITE_SECTORS;
+    *pBytes = W15Q64_BENCH_REWRITE_SECTORS * W15Q64_SECTOR_SIZE;
+}
+
+/**
+ *  @brief  Срочные чтения каждые W15Q64_BENCH_RWE_READ_PERIOD_US во время
+ *          стирания блоков 64 КБ через очередь заданий: без вытеснения чтение
+ *          ждет окончания стирания, с вытеснением - Suspend/Resume
+ */
+static void W15Q64_BenchReadErase(W15Q64bench_t *bench,
+                                  _Bool preempt,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    W15Q64job_t jobs[W15Q64_BENCH_RWE_BLOCKS],
+            read;
+    W15Q64jobQueue_t queue;
+    uint32_t block,
+            nextUs;
+
+    W15Q64_JobInit(&queue, &bench->spi);
+    W15Q64_JobPreempt(&queue, preempt, W15Q64_BenchNowUs);
+    for (block = 0; block < W15Q64_BENCH_RWE_BLOCKS; block++)
+    {
+        W15Q64_JobErase(&jobs[block], W15Q64_BLOCK_ERASE_64KB,
+                        block * W15Q64_BLOCK_64KB_SIZE, NULL, NULL);
+        W15Q64_JobSubmit(&queue, &jobs[block]);
+    }
+
+    read.state = W15Q64_JOB_DONE;
+    nextUs = W15Q64_BenchNowUs();
+    while (W15Q64_Poll(&queue))
+    {
+        if ((read.state == W15Q64_JOB_DONE)
+            && ((int32_t) (W15Q64_BenchNowUs() - nextUs) >= 0))
+        {
+            W15Q64_JobRead(&read, W15Q64_BLOCK_64KB_SIZE * W15Q64_BENCH_RWE_BLOCKS,
+                           bench->buf, W15Q64_BENCH_RWE_READ_LEN, NULL, NULL);
+            W15Q64_JobSubmitRead(&queue, &read);
+            nextUs += W15Q64_BENCH_RWE_READ_PERIOD_US;
+        }
+        W15Q64_SimAdvanceNs(&bench->sim, W15Q64_BENCH_LOOP_PERIOD_US * 1000UL);
+    }
+    printf("  reads: %lu, worst latency %lu us, suspends %lu\n",
+           (unsigned long) queue.reads, (unsigned long) queue.maxReadUs,
+           (unsigned long) queue.suspends);
+    *pOps = queue.reads;
+    *pBytes = queue.reads * W15Q64_BENCH_RWE_READ_LEN;
+}
+
+static void W15Q64_BenchReadEraseWait(W15Q64bench_t *bench,
+                                      uint32_t *pOps,
+                                      uint32_t *pBytes)
+{
+    W15Q64_BenchReadErase(bench, false, pOps, pBytes);
+}
+
+static void W15Q64_BenchReadEraseSuspend(W15Q64bench_t *bench,
+                                         uint32_t *pOps,
+                                         uint32_t *pBytes)
+{
+    W15Q64_BenchReadErase(bench, true, pOps, pBytes);
+}
+
+/**
+ *  @brief  Ожидание задачи обслуживания: во время BUSY продвигает время
+ *          модели на время ожидания (модель не связана с реальным временем)
+ */
+static void W15Q64_BenchSrvWait(void *pCtx,
+                               uint32_t timeoutUs)
+{
+    if (timeoutUs != 0)
+    {
+        W15Q64_SimAdvanceNs(&bench.sim, timeoutUs * 1000UL);
+    }
+    W15Q64_OsPosixWait(pCtx, timeoutUs);
+}
+
+static void W15Q64_BenchClientDone(void *pCtx,
+                                   W15Q64job_t *job)
+{
+    W15Q64benchClient_t *client = (W15Q64benchClient_t *) pCtx;
+
+    (void) job;
+    pthread_mutex_lock(&client->mutex);
+    pthread_cond_signal(&client->cond);
+    pthread_mutex_unlock(&client->mutex);
+}
+
+/**
+ *  @brief  Функция ставит запрос клиента в очередь и ждет его выполнения
+ */
+static void W15Q64_BenchClientExec(W15Q64benchClient_t *client)
+{
+    pthread_mutex_lock(&client->mutex);
+    W15Q64_SrvSubmit(client->srv, &client->job, client->prio);
+    while (client->job.state != W15Q64_JOB_DONE)
+    {
+        pthread_cond_wait(&client->cond, &client->mutex);
+    }
+    pthread_mutex_unlock(&client->mutex);
+}
+
+static void *W15Q64_BenchReader(void *pArg)
+{
+    W15Q64benchClient_t *client = (W15Q64benchClient_t *) pArg;
+    uint32_t i;
+
+    for (i = 0; i < W15Q64_BENCH_MC_READS; i++)
+    {
+        client->seed = client->seed * 1103515245UL + 12345UL;
+        W15Q64_JobRead(&client->job,
+                       W15Q64_BENCH_MC_READ_BASE + (client->seed >> 8) % 0x10000UL,
+                       client->buf, W15Q64_BENCH_RANDOM_READ_LEN,
+                       W15Q64_BenchClientDone, client);
+        W15Q64_BenchClientExec(client);
+    }
+    return NULL;
+}
+
+static void *W15Q64_BenchWriter(void *pArg)
+{
+    W15Q64benchClient_t *client = (W15Q64benchClient_t *) pArg;
+    uint32_t sector,
+            addr;
+
+    memset(client->buf, 0x3C, sizeof (client->buf));
+    for (sector = 0; sector < W15Q64_BENCH_MC_SECTORS; sector++)
+    {
+        W15Q64_JobErase(&client->job, W15Q64_SECTOR_ERASE_4KB,
+                        sector * W15Q64_SECTOR_SIZE, W15Q64_BenchClientDone, client);
+        W15Q64_BenchClientExec(client);
+        for (addr = 0; addr < W15Q64_SECTOR_SIZE; addr += W15Q64_PAGE_SIZE)
+        {
+            W15Q64_JobProgram(&client->job, sector * W15Q64_SECTOR_SIZE + addr,
+                              client->buf, W15Q64_PAGE_SIZE,
+                              W15Q64_BenchClientDone, client);
+            W15Q64_BenchClientExec(client);
+        }
+    }
+    return NULL;
+}
+
+static void *W15Q64_BenchServer(void *pArg)
+{
+    W15Q64_SrvRun((W15Q64srv_t *) pArg);
+    return NULL;
+}
+
+/**
+ *  @brief  Задача записи (стирание и запись страниц, приоритет 0) и
+ *          W15Q64_BENCH_MC_READERS задач чтения 16 байт работают с одной
+ *          микросхемой через очередь запросов и задачу обслуживания
+ */
+static void W15Q64_BenchMultiClient(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes)
+{
+    static W15Q64benchClient_t clients[W15Q64_BENCH_MC_READERS + 1];
+    pthread_t threads[W15Q64_BENCH_MC_READERS + 1],
+            server;
+    W15Q64osPosix_t posix;
+    W15Q64os_t os;
+    W15Q64srv_t srv;
+    uint8_t i;
+
+    if (!W15Q64_OsPosixInit(&os, &posix))
+    {
+        return;
+    }
+    os.wait = W15Q64_BenchSrvWait;
+    W15Q64_SrvInit(&srv, &bench->spi, &os, W15Q64_BenchNowUs);
+    pthread_create(&server, NULL, W15Q64_BenchServer, &srv);
+
+    for (i = 0; i <= W15Q64_BENCH_MC_READERS; i++)
+    {
+        clients[i].srv = &srv;
+        clients[i].prio = i;
+        clients[i].seed = i;
+        pthread_mutex_init(&clients[i].mutex, NULL);
+        pthread_cond_init(&clients[i].cond, NULL);
+        pthread_create(&threads[i], NULL,
+                       (i == 0) ? W15Q64_BenchWriter : W15Q64_BenchReader, &clients[i]);
+    }
+    for (i = 0; i <= W15Q64_BENCH_MC_READERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        pthread_cond_destroy(&clients[i].cond);
+        pthread_mutex_destroy(&clients[i].mutex);
+    }
+    W15Q64_SrvStop(&srv);
+    pthread_join(server, NULL);
+    W15Q64_OsPosixDeinit(&posix);
+
+    printf("  requests: %lu, reads ahead of writes %lu, worst read latency %lu us, suspends %lu\n",
+           (unsigned long) srv.submitted, (unsigned long) srv.bypassed,
+           (unsigned long) srv.queue.maxReadUs, (unsigned long) srv.queue.suspends);
+    *pOps = srv.submitted;
+    *pBytes = W15Q64_BENCH_MC_READERS * W15Q64_BENCH_MC_READS * W15Q64_BENCH_RANDOM_READ_LEN
+            + W15Q64_BENCH_MC_SECTORS * W15Q64_SECTOR_SIZE;
+}
+
+/**
+ *  @brief  Функция создает том из микросхемы теста и еще
+ *          W15Q64_BENCH_STRIPE_CHIPS - 1 моделей с общими часами (одна шина,
+ *          разные CS). Счетчики трафика в таблице - только первой микросхемы
+ */
+static _Bool W15Q64_BenchStripeInit(W15Q64bench_t *bench,
+                                    W15Q64stripe_t *vol,
+                                    W15Q64sim_t *pSims,
+                                    W15Q64spi_t *pSpi)
+{
+    W15Q64spi_t *ppSpi[W15Q64_BENCH_STRIPE_CHIPS] = {&bench->spi};
+    uint8_t i;
+
+    for (i = 1; i < W15Q64_BENCH_STRIPE_CHIPS; i++)
+    {
+        if (!W15Q64_SimInit(&pSims[i - 1], NULL, W15Q64_SIM_CAPACITY)
+            || !W15Q64_SimBind(&pSims[i - 1], &pSpi[i - 1]))
+        {
+            return false;
+        }
+        pSims[i - 1].timing = bench->sim.timing;
+        W15Q64_SimShareClock(&pSims[i - 1], &bench->sim);
+        pSpi[i - 1].pollFirstUs = W15Q64_BENCH_POLL_FIRST_US;
+        ppSpi[i] = &pSpi[i - 1];
+    }
+    bench->spi.pollFirstUs = W15Q64_BENCH_POLL_FIRST_US;
+    return W15Q64_StripeInit(vol, ppSpi, W15Q64_BENCH_STRIPE_CHIPS,
+                             W15Q64_BENCH_STRIPE_UNIT);
+}
+
+static void W15Q64_BenchStripeFree(W15Q64sim_t *pSims)
+{
+    uint8_t i;
+
+    bench.spi.pollFirstUs = 0;
+    for (i = 1; i < W15Q64_BENCH_STRIPE_CHIPS; i++)
+    {
+        W15Q64_SimFree(&pSims[i - 1]);
+    }
+}
+
+/**
+ *  @brief  Запись W15Q64_BENCH_SEQ_WRITE_LEN байт в том из
+ *          W15Q64_BENCH_STRIPE_CHIPS микросхем (ср. "seq write Write backoff")
+ */
+static void W15Q64_BenchStripeWrite(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes)
+{
+    W15Q64sim_t sims[W15Q64_BENCH_STRIPE_CHIPS - 1];
+    W15Q64spi_t spi[W15Q64_BENCH_STRIPE_CHIPS - 1];
+    W15Q64stripe_t vol;
+
+    if (W15Q64_BenchStripeInit(bench, &vol, sims, spi))
+    {
+        W15Q64_BenchPrepare(bench, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+        memset(bench->pBig, 0x5A, W15Q64_BENCH_SEQ_WRITE_LEN);
+        W15Q64_StripeWrite(&vol, 0, bench->pBig, W15Q64_BENCH_SEQ_WRITE_LEN);
+        *pOps = W15Q64_BENCH_SEQ_WRITE_LEN / W15Q64_PAGE_SIZE;
+        *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+    }
+    W15Q64_BenchStripeFree(sims);
+}
+
+/**
+ *  @brief  Стирание W15Q64_BENCH_SEQ_WRITE_LEN байт тома (по 64 КБ в каждой
+ *          микросхеме)
+ */
+static void W15Q64_BenchStripeErase(W15Q64bench_t *bench,
+                                    uint32_t *pOps,
+                                    uint32_t *pBytes)
+{
+    W15Q64sim_t sims[W15Q64_BENCH_STRIPE_CHIPS - 1];
+    W15Q64spi_t spi[W15Q64_BENCH_STRIPE_CHIPS - 1];
+    W15Q64stripe_t vol;
+
+    if (W15Q64_BenchStripeInit(bench, &vol, sims, spi))
+    {
+        W15Q64_StripeErase(&vol, 0, W15Q64_BENCH_SEQ_WRITE_LEN);
+        *pOps = W15Q64_BENCH_STRIPE_CHIPS;
+        *pBytes = W15Q64_BENCH_SEQ_WRITE_LEN;
+    }
+    W15Q64_BenchStripeFree(sims);
+}
+
+static void W15Q64_BenchErase4KB(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    W15Q64_SectorErase4KB(&bench->spi, 0);
+    W15Q64_BenchWaitBusy(bench);
+    *pOps = 1;
+    *pBytes = 4096;
+}
+
+static void W15Q64_BenchErase32KB(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    W15Q64_BlockErase32KB(&bench->spi, 0);
+    W15Q64_BenchWaitBusy(bench);
+    *pOps = 1;
+    *pBytes = 0x8000;
+}
+
+static void W15Q64_BenchErase64KB(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    W15Q64_BlockErase64KB(&bench->spi, 0);
+    W15Q64_BenchWaitBusy(bench);
+    *pOps = 1;
+    *pBytes = 0x10000;
+}
+
+/**
+ *  @brief  Стирание невыровненной области, в которой не чист каждый
+ *          W15Q64_BENCH_RANGE_DIRTY_STEP-й сектор
+ */
+static void W15Q64_BenchEraseRange(W15Q64bench_t *bench,
+                                   _Bool skipBlank,
+                                   uint32_t *pOps,
+                                   uint32_t *pBytes)
+{
+    W15Q64erasePlan_t plan = {0};
+    uint32_t addr;
+
+    W15Q64_BenchPrepare(bench, W15Q64_BENCH_RANGE_START, W15Q64_BENCH_RANGE_LEN);
+    for (addr = W15Q64_BENCH_RANGE_START;
+         addr < W15Q64_BENCH_RANGE_START + W15Q64_BENCH_RANGE_LEN;
+         addr += W15Q64_SECTOR_SIZE * W15Q64_BENCH_RANGE_DIRTY_STEP)
+    {
+        bench->sim.pMem[addr + W15Q64_SECTOR_SIZE - 1] = 0x00;
+    }
+
+    W15Q64_EraseRange(&bench->spi, W15Q64_BENCH_RANGE_START, W15Q64_BENCH_RANGE_LEN,
+                      skipBlank, &plan);
+    printf("  plan: %u x 64KB, %u x 32KB, %u x 4KB, %u skipped, estimate %lu ms\n",
+           plan.cnt64KB, plan.cnt32KB, plan.cnt4KB, plan.skipped,
+           (unsigned long) (plan.estimatedUs / 1000));
+    *pOps = plan.opCnt;
+    *pBytes = W15Q64_BENCH_RANGE_LEN;
+}
+
+static void W15Q64_BenchRangeAll(W15Q64bench_t *bench,
+                                 uint32_t *pOps,
+                                 uint32_t *pBytes)
+{
+    W15Q64_BenchEraseRange(bench, false, pOps, pBytes);
+}
+
+static void W15Q64_BenchRangeSkip(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    W15Q64_BenchEraseRange(bench, true, pOps, pBytes);
+}
+
+/**
+ *  @brief  То же, что "EraseRange 376KB", но с временами стирания и
+ *          задержками опроса BUSY из параметров SFDP
+ */
+static void W15Q64_BenchRangeSfdp(W15Q64bench_t *bench,
+                                  uint32_t *pOps,
+                                  uint32_t *pBytes)
+{
+    W15Q64_BenchSfdpUse(bench, true);
+    W15Q64_BenchEraseRange(bench, false, pOps, pBytes);
+    W15Q64_BenchSfdpUse(bench, false);
+}
+
+/**
+ *  @brief  Функция выводит счетчики драйвера (только при сборке с
+ *          W15Q64_STATS)
+ */
+static void W15Q64_BenchPrintStats(W15Q64bench_t *bench)
+{
+    static const char *kinds[W15Q64_STATS_KINDS] = {"read", "program", "erase"};
+    W15Q64statsSnap_t snap;
+    uint32_t i,
+            k;
+
+    if (!W15Q64_StatsAttach(&bench->spi, &bench->stats))
+    {
+        return;
+    }
+    W15Q64_StatsSnapshot(&bench->stats, &snap, false);
+
+    printf("\ndriver counters: %lu transactions, %llu bytes out, %llu bytes in, %lu busy polls\n",
+           (unsigned long) snap.transactions, (unsigned long long) snap.txBytes,
+           (unsigned long long) snap.rxBytes, (unsigned long) snap.busyPolls);
+    printf("opcodes:");
+    for (i = 0, k = 0; i < 256; i++)
+    {
+        if (snap.opcodes[i] != 0)
+        {
+            printf("%s %02lXh %lu", ((k++ % 8) == 0) ? "\n " : ",",
+                   (unsigned long) i, (unsigned long) snap.opcodes[i]);
+        }
+    }
+    printf("\n");
+    for (k = 0; k < W15Q64_STATS_KINDS; k++)
+    {
+        if (snap.hist[k].cnt == 0)
+        {
+            continue;
+        }
+        printf("%-8s %8lu ops, avg %8.1f us, max %8lu us, buckets (<2^i us):",
+               kinds[k], (unsigned long) snap.hist[k].cnt,
+               (double) snap.hist[k].sumUs / snap.hist[k].cnt,
+               (unsigned long) snap.hist[k].maxUs);
+        for (i = 0; i < W15Q64_STATS_BUCKETS; i++)
+        {
+            if (snap.hist[k].bucket[i] != 0)
+            {
+                printf(" %lu:%lu", (unsigned long) i, (unsigned long) snap.hist[k].bucket[i]);
+            }
+        }
+        printf("\n");
+    }
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,309 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_cache.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Кэш чтения в ОЗУ для микросхемы flash памяти w15q64
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_cache.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static W15Q64cacheLine_t *W15Q64_CacheLookup(W15Q64cache_t *cache,
+                                             uint32_t tag);
+static W15Q64cacheLine_t *W15Q64_CacheFill(W15Q64cache_t *cache,
+                                           uint32_t tag);
+static void W15Q64_CacheModify(void *pCtx,
+                               uint32_t addr,
+                               const uint8_t *pData,
+                               uint32_t cnt);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция инициализирует пустой кэш и подключает его к структуре spi
+ *  @param  *cache: Указатель на структуру кэша
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  *pLines:    Указатель на массив из lineCnt строк
+ *  @param  lineCnt:    Количество строк кэша
+ *  @param  *pArena:    Указатель на область данных lineCnt * lineSize байт
+ *  @param  lineSize:   Размер строки в байтах, степень двойки от 16
+ *  @retval true - кэш подключен, false - неверные параметры
+ */
+_Bool W15Q64_CacheInit(W15Q64cache_t *cache,
+                       W15Q64spi_t *spi,
+                       W15Q64cacheLine_t *pLines,
+                       uint16_t lineCnt,
+                       uint8_t *pArena,
+                       uint32_t lineSize)
+{
+    if ((lineCnt == 0) || (lineSize < 16) || ((lineSize & (lineSize - 1)) != 0))
+    {
+        return false;
+    }
+
+    cache->spi = spi;
+    cache->pLines = pLines;
+    cache->pArena = pArena;
+    cache->lineCnt = lineCnt;
+    cache->lineSize = lineSize;
+    cache->clock = 0;
+    memset(pLines, 0, sizeof (W15Q64cacheLine_t) * lineCnt);
+    W15Q64_CacheResetStats(cache);
+
+    spi->modify = W15Q64_CacheModify;
+    spi->pModifyCtx = cache;
+    return true;
+}
+
+/**
+ *  @brief  Функция читает массив байт через кэш: найденные строки копируются
+ *          из ОЗУ, отсутствующие читаются из микросхемы целиком и замещают
+ *          строку, к которой дольше всего не было обращений. Чтение длиннее
+ *          всего кэша выполняется напрямую, не вытесняя строки
+ *  @param  *cache: Указатель на структуру кэша
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут
+ *                      записаны данные
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_CacheRead(W15Q64cache_t *cache,
+                      uint32_t addr,
+                      uint8_t *pRxData,
+                      uint32_t cnt)
+{
+    W15Q64cacheLine_t *line;
+    uint32_t tag,
+            offset,
+            chunk;
+
+    if (cnt >= (uint32_t) cache->lineCnt * cache->lineSize)
+    {
+        cache->stats.bypass++;
+        W15Q64_FastReadAuto(cache->spi, addr, pRxData, cnt);
+        return;
+    }
+
+    while (cnt != 0)
+    {
+        tag = addr & ~(cache->lineSize - 1);
+        offset = addr - tag;
+        chunk = cache->lineSize - offset;
+        if (chunk > cnt)
+        {
+            chunk = cnt;
+        }
+
+        line = W15Q64_CacheLookup(cache, tag);
+        if (line != NULL)
+        {
+            cache->stats.hits++;
+        }
+        else
+        {
+            cache->stats.misses++;
+            line = W15Q64_CacheFill(cache, tag);
+        }
+        line->stamp = ++cache->clock;
+        memcpy(pRxData,
+               &cache->pArena[(uint32_t) (line - cache->pLines) * cache->lineSize + offset],
+               chunk);
+
+        addr += chunk;
+        pRxData += chunk;
+        cnt -= chunk;
+    }
+}
+
+/**
+ *  @brief  Функция помечает недействительными строки, пересекающиеся с
+ *          областью памяти
+ *  @param  *cache: Указатель на структуру кэша
+ *  @param  addr:   Адрес начала области
+ *  @param  cnt:    Размер области в байтах
+ *  @retval None
+ */
+void W15Q64_CacheInvalidate(W15Q64cache_t *cache,
+                            uint32_t addr,
+                            uint32_t cnt)
+{
+    uint16_t i;
+
+    for (i = 0; i < cache->lineCnt; i++)
+    {
+        if (cache->pLines[i].valid
+            && (cache->pLines[i].tag < addr + cnt)
+            && (cache->pLines[i].tag + cache->lineSize > addr))
+        {
+            cache->pLines[i].valid = false;
+        }
+    }
+}
+
+/**
+ *  @brief  Функция обнуляет счетчики кэша
+ *  @param  *cache: Указатель на структуру кэша
+ *  @retval None
+ */
+void W15Q64_CacheResetStats(W15Q64cache_t *cache)
+{
+    memset(&cache->stats, 0, sizeof (cache->stats));
+}
+
+//==============================================================================
+// Локальные функции
+
+static W15Q64cacheLine_t *W15Q64_CacheLookup(W15Q64cache_t *cache,
+                                             uint32_t tag)
+{
+    uint16_t i;
+
+    for (i = 0; i < cache->lineCnt; i++)
+    {
+        if (cache->pLines[i].valid && (cache->pLines[i].tag == tag))
+        {
+            return &cache->pLines[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  @brief  Функция выбирает строку для замещения (свободную или LRU) и
+ *          читает в нее данные из микросхемы
+ */
+static W15Q64cacheLine_t *W15Q64_CacheFill(W15Q64cache_t *cache,
+                                           uint32_t tag)
+{
+    W15Q64cacheLine_t *line = &cache->pLines[0];
+    uint16_t i;
+
+    for (i = 0; i < cache->lineCnt; i++)
+    {
+        if (!cache->pLines[i].valid)
+        {
+            line = &cache->pLines[i];
+            break;
+        }
+        if ((cache->clock - cache->pLines[i].stamp) > (cache->clock - line->stamp))
+        {
+            line = &cache->pLines[i];
+        }
+    }
+    if (line->valid)
+    {
+        cache->stats.evictions++;
+    }
+
+    W15Q64_FastReadAuto(cache->spi, tag,
+                        &cache->pArena[(uint32_t) (line - cache->pLines) * cache->lineSize],
+                        cache->lineSize);
+    line->tag = tag;
+    line->valid = true;
+    return line;
+}
+
+/**
+ *  @brief  Функция обновляет строки кэша после Page Program или стирания
+ *          (вызывается драйвером через поле modify структуры W15Q64spi_t).
+ *          Page Program только сбрасывает биты, поэтому данные строки
+ *          объединяются по "И". Адрес Page Program заворачивается внутри
+ *          страницы так же, как в микросхеме
+ */
+static void W15Q64_CacheModify(void *pCtx,
+                               uint32_t addr,
+                               const uint8_t *pData,
+                               uint32_t cnt)
+{
+    W15Q64cache_t *cache = (W15Q64cache_t *) pCtx;
+    W15Q64cacheLine_t *line;
+    uint8_t *pLine = NULL;
+    uint32_t i,
+            byteAddr,
+            page;
+    uint16_t n;
+
+    if ((pData == NULL) && (cnt == 0))
+    {
+        // Стерта неизвестная область: сбрасываются все строки
+        for (n = 0; n < cache->lineCnt; n++)
+        {
+            cache->pLines[n].valid = false;
+        }
+        return;
+    }
+
+    if (pData == NULL)
+    {
+        // Стирание: строки внутри области заполняются 0xFF
+        for (n = 0; n < cache->lineCnt; n++)
+        {
+            line = &cache->pLines[n];
+            if (!line->valid || (line->tag >= addr + cnt) || (line->tag + cache->lineSize <= addr))
+            {
+                continue;
+            }
+            if ((line->tag >= addr) && (line->tag + cache->lineSize <= addr + cnt))
+            {
+                memset(&cache->pArena[(uint32_t) n * cache->lineSize], 0xFF, cache->lineSize);
+                cache->stats.updates++;
+            }
+            else
+            {
+                line->valid = false; //     Строка больше стираемой области
+            }
+        }
+        return;
+    }
+
+    page = W15Q64_PageSize(cache->spi);
+    for (i = 0; i < cnt; i++)
+    {
+        byteAddr = (addr & ~(page - 1UL)) | ((addr + i) & (page - 1UL));
+        if ((i == 0) || ((byteAddr & (cache->lineSize - 1)) == 0))
+        {
+            line = W15Q64_CacheLookup(cache, byteAddr & ~(cache->lineSize - 1));
+            pLine = (line == NULL) ? NULL
+                    : &cache->pArena[(uint32_t) (line - cache->pLines) * cache->lineSize];
+            if (line != NULL)
+            {
+                cache->stats.updates++;
+            }
+        }
+        if (pLine != NULL)
+        {
+            pLine[byteAddr & (cache->lineSize - 1)] &= pData[i];
+        }
+    }
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
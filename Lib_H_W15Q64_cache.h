@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_cache.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Кэш чтения в ОЗУ для микросхемы flash памяти w15q64
+ *  @warning    Память под строки кэша (массив W15Q64cacheLine_t и область
+ *              данных lineCnt * lineSize байт) выделяет вызывающая сторона,
+ *              обычно статически. Замещение строк - LRU.
+ *              W15Q64_CacheInit() подключает кэш к полям modify/pModifyCtx
+ *              структуры W15Q64spi_t, поэтому W15Q64_PageProg(), все варианты
+ *              W15Q64_Erase() и W15Q64_ChipErase() (в том числе вызванные из
+ *              W15Q64_Write() и очереди заданий) обновляют строки кэша.
+ *              Запись в обход драйвера требует вызова W15Q64_CacheInvalidate().
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_CACHE_H
+#define	LIB_H_W15Q64_CACHE_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t tag; //            Адрес начала строки в микросхеме
+    uint32_t stamp; //          Момент последнего обращения (для LRU)
+    _Bool valid;
+} W15Q64cacheLine_t; // Структура описывает одну строку кэша
+
+typedef struct {
+    uint32_t hits; //           Строка найдена в кэше
+    uint32_t misses; //         Строка прочитана из микросхемы
+    uint32_t evictions; //      Замещена действительная строка
+    uint32_t bypass; //         Чтения мимо кэша (длиннее всего кэша)
+    uint32_t updates; //        Строки, обновленные при Page Program / Erase
+} W15Q64cacheStats_t; //    Структура содержит счетчики для выбора размера кэша
+
+typedef struct {
+    W15Q64spi_t *spi;
+    W15Q64cacheLine_t *pLines;
+    uint8_t *pArena; //         Данные строк, lineCnt * lineSize байт
+    uint16_t lineCnt;
+    uint32_t lineSize; //       Степень двойки, не меньше 16 байт
+    uint32_t clock; //          Счетчик обращений
+    W15Q64cacheStats_t stats;
+} W15Q64cache_t; // Структура содержит состояние кэша чтения
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_CacheInit(W15Q64cache_t *cache,
+        W15Q64spi_t *spi,
+        W15Q64cacheLine_t *pLines,
+        uint16_t lineCnt,
+        uint8_t *pArena,
+        uint32_t lineSize);
+extern void W15Q64_CacheRead(W15Q64cache_t *cache,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_CacheInvalidate(W15Q64cache_t *cache,
+        uint32_t addr,
+        uint32_t cnt);
+extern void W15Q64_CacheResetStats(W15Q64cache_t *cache);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,218 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_crc.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Вычисление CRC-32C (Castagnoli) для контроля данных
+ *              микросхемы flash памяти w15q64
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_crc.h"
+#if (W15Q64_CRC_HW != 0) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_CRC_POLY                                   0x82F63B78UL
+
+#if (W15Q64_CRC_HW != 0) && defined(__GNUC__) && defined(__x86_64__)
+#define W15Q64_CRC_HW_X86                                 1
+#elif (W15Q64_CRC_HW != 0) && defined(__ARM_FEATURE_CRC32)
+#define W15Q64_CRC_HW_ARM                                 1
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+static uint32_t crcTable[W15Q64_CRC_SLICES][256];
+static volatile _Bool crcReady = false;
+#if defined(W15Q64_CRC_HW_X86) || defined(W15Q64_CRC_HW_ARM)
+static _Bool crcHw = false;
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint32_t W15Q64_CrcSoft(uint32_t crc,
+                               const uint8_t *pData,
+                               uint32_t cnt);
+#if defined(W15Q64_CRC_HW_X86) || defined(W15Q64_CRC_HW_ARM)
+static uint32_t W15Q64_CrcHw(uint32_t crc,
+                             const uint8_t *pData,
+                             uint32_t cnt);
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция заполняет таблицы и проверяет наличие команд CRC32C
+ *          процессора. Повторный вызов безопасен
+ *  @retval None
+ */
+void W15Q64_CrcInit(void)
+{
+    uint32_t crc;
+    uint16_t i;
+    uint8_t k;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ (W15Q64_CRC_POLY & (0UL - (crc & 1)));
+        }
+        crcTable[0][i] = crc;
+    }
+    for (i = 0; i < 256; i++)
+    {
+        for (k = 1; k < W15Q64_CRC_SLICES; k++)
+        {
+            crcTable[k][i] = (crcTable[k - 1][i] >> 8) ^ crcTable[0][crcTable[k - 1][i] & 0xFF];
+        }
+    }
+#if defined(W15Q64_CRC_HW_X86)
+    __builtin_cpu_init();
+    crcHw = __builtin_cpu_supports("sse4.2") != 0;
+#elif defined(W15Q64_CRC_HW_ARM)
+    crcHw = true;
+#endif
+    crcReady = true;
+}
+
+/**
+ *  @brief  Функция продолжает вычисление CRC-32C
+ *  @param  crc:    Результат для предыдущих данных, 0 - начало
+ *  @param  *pData: Данные
+ *  @param  cnt:    Количество байт
+ *  @retval CRC-32C всех данных
+ */
+uint32_t W15Q64_Crc32c(uint32_t crc,
+                       const uint8_t *pData,
+                       uint32_t cnt)
+{
+    if (!crcReady)
+    {
+        W15Q64_CrcInit();
+    }
+#if defined(W15Q64_CRC_HW_X86) || defined(W15Q64_CRC_HW_ARM)
+    if (crcHw)
+    {
+        return ~W15Q64_CrcHw(~crc, pData, cnt);
+    }
+#endif
+    return ~W15Q64_CrcSoft(~crc, pData, cnt);
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция вычисляет CRC таблицами: по 8 байт за шаг (slice-by-8),
+ *          остаток и вариант с одной таблицей - по байту
+ */
+static uint32_t W15Q64_CrcSoft(uint32_t crc,
+                               const uint8_t *pData,
+                               uint32_t cnt)
+{
+#if W15Q64_CRC_SLICES == 8
+    uint32_t lo,
+            hi;
+
+    while (cnt >= 8)
+    {
+        lo = crc ^ ((uint32_t) pData[0] | ((uint32_t) pData[1] << 8)
+                    | ((uint32_t) pData[2] << 16) | ((uint32_t) pData[3] << 24));
+        hi = (uint32_t) pData[4] | ((uint32_t) pData[5] << 8)
+                | ((uint32_t) pData[6] << 16) | ((uint32_t) pData[7] << 24);
+        crc = crcTable[7][lo & 0xFF] ^ crcTable[6][(lo >> 8) & 0xFF]
+                ^ crcTable[5][(lo >> 16) & 0xFF] ^ crcTable[4][lo >> 24]
+                ^ crcTable[3][hi & 0xFF] ^ crcTable[2][(hi >> 8) & 0xFF]
+                ^ crcTable[1][(hi >> 16) & 0xFF] ^ crcTable[0][hi >> 24];
+        pData += 8;
+        cnt -= 8;
+    }
+#endif
+    while (cnt-- != 0)
+    {
+        crc = (crc >> 8) ^ crcTable[0][(crc ^ *pData++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(W15Q64_CRC_HW_X86)
+/**
+ *  @brief  Функция вычисляет CRC командой crc32 (SSE4.2) по 8 байт
+ */
+__attribute__((target("sse4.2")))
+static uint32_t W15Q64_CrcHw(uint32_t crc,
+                             const uint8_t *pData,
+                             uint32_t cnt)
+{
+    unsigned long long crc64 = crc,
+            val;
+
+    while (cnt >= 8)
+    {
+        memcpy(&val, pData, 8);
+        crc64 = __builtin_ia32_crc32di(crc64, val);
+        pData += 8;
+        cnt -= 8;
+    }
+    crc = (uint32_t) crc64;
+    while (cnt-- != 0)
+    {
+        crc = __builtin_ia32_crc32qi(crc, *pData++);
+    }
+    return crc;
+}
+#elif defined(W15Q64_CRC_HW_ARM)
+/**
+ *  @brief  Функция вычисляет CRC командами CRC32C ARMv8 по 8 байт
+ */
+static uint32_t W15Q64_CrcHw(uint32_t crc,
+                             const uint8_t *pData,
+                             uint32_t cnt)
+{
+    uint64_t val;
+
+    while (cnt >= 8)
+    {
+        memcpy(&val, pData, 8);
+        crc = __crc32cd(crc, val);
+        pData += 8;
+        cnt -= 8;
+    }
+    while (cnt-- != 0)
+    {
+        crc = __crc32cb(crc, *pData++);
+    }
+    return crc;
+}
+#endif
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
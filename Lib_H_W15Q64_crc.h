@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_crc.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Вычисление CRC-32C (Castagnoli) для контроля данных
+ *              микросхемы flash памяти w15q64
+ *  @warning    Полином 0x1EDC6F41 (отраженный 0x82F63B78), начальное
+ *              значение и инверсия результата 0xFFFFFFFF. Вычисление
+ *              продолжается по частям: W15Q64_Crc32c(W15Q64_Crc32c(0, a), b)
+ *              равно CRC объединения a и b.
+ *              Программно - таблицами по W15Q64_CRC_SLICES байт за шаг
+ *              (slice-by-8: 8 КБ ОЗУ, slice-by-1: 1 КБ), таблицы
+ *              заполняются W15Q64_CrcInit() или при первом вызове.
+ *              Если W15Q64_CRC_HW не равен 0, используются команды
+ *              процессора: SSE4.2 crc32 на x86-64 (наличие проверяется при
+ *              инициализации) и CRC32C ARMv8 (__ARM_FEATURE_CRC32).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_CRC_H
+#define	LIB_H_W15Q64_CRC_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#ifndef W15Q64_CRC_SLICES
+#define W15Q64_CRC_SLICES                                 8 //  8 или 1
+#endif
+
+#ifndef W15Q64_CRC_HW
+#define W15Q64_CRC_HW                                     1
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_CrcInit(void);
+extern uint32_t W15Q64_Crc32c(uint32_t crc,
+        const uint8_t *pData,
+        uint32_t cnt);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
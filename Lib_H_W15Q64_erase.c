@@ -0,0 +1,301 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_erase.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Стирание произвольной области микросхемы flash памяти w15q64
+ *              минимальным по времени набором команд стирания
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include "Lib_H_W15Q64_erase.h"
+#include "Lib_H_W15Q64_verify.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_EraseWalk(W15Q64spi_t *spi,
+                             uint32_t start,
+                             uint32_t len,
+                             _Bool skipBlank,
+                             W15Q64erasePlan_t *pPlan,
+                             _Bool execute);
+static void W15Q64_EraseEmit(W15Q64spi_t *spi,
+                             W15Q64erasePlan_t *pPlan,
+                             uint8_t instruct,
+                             uint32_t addr,
+                             _Bool execute);
+static uint8_t W15Q64_BitCnt(uint16_t mask);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция составляет план стирания области без выполнения команд
+ *          стирания (при skipBlank = true сектора области читаются)
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  start:  Адрес начала области
+ *  @param  len:    Размер области в байтах
+ *  @param  skipBlank:  true - не стирать сектора, заполненные 0xFF
+ *  @param  *pPlan: Указатель на структуру плана (поля pOps и maxOps
+ *                  заполняются вызывающей стороной)
+ *  @retval None
+ */
+void W15Q64_ErasePlan(W15Q64spi_t *spi,
+                      uint32_t start,
+                      uint32_t len,
+                      _Bool skipBlank,
+                      W15Q64erasePlan_t *pPlan)
+{
+    W15Q64_EraseWalk(spi, start, len, skipBlank, pPlan, false);
+}
+
+/**
+ *  @brief  Функция стирает область минимальным по времени набором команд и
+ *          ожидает окончания стирания
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  start:  Адрес начала области
+ *  @param  len:    Размер области в байтах
+ *  @param  skipBlank:  true - не стирать сектора, заполненные 0xFF
+ *  @param  *pPlan: Указатель на структуру, в которую записывается
+ *                  выполненный план, или NULL
+ *  @retval None
+ */
+void W15Q64_EraseRange(W15Q64spi_t *spi,
+                       uint32_t start,
+                       uint32_t len,
+                       _Bool skipBlank,
+                       W15Q64erasePlan_t *pPlan)
+{
+    W15Q64erasePlan_t plan = {0};
+
+    W15Q64_EraseWalk(spi, start, len, skipBlank,
+                     (pPlan != NULL) ? pPlan : &plan, true);
+}
+
+/**
+ *  @brief  Функция возвращает типовое время команды стирания: из параметров
+ *          SFDP (spi->pDev), если они подключены, иначе из документации на
+ *          w25q64. Для блока, стирание которого микросхема не поддерживает,
+ *          возвращается 0xFFFFFFFF (команда никогда не выбирается)
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  instruct:   W15Q64_SECTOR_ERASE_4KB, W15Q64_BLOCK_ERASE_32KB или
+ *                      W15Q64_BLOCK_ERASE_64KB
+ *  @retval Время в микросекундах
+ */
+uint32_t W15Q64_EraseUs(W15Q64spi_t *spi,
+                        uint8_t instruct)
+{
+    uint8_t i;
+
+    if (spi->pDev != NULL)
+    {
+        for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+        {
+            if ((spi->pDev->erase[i].instruct == instruct) && (spi->pDev->erase[i].typUs != 0))
+            {
+                return spi->pDev->erase[i].typUs;
+            }
+        }
+        if (instruct != W15Q64_SECTOR_ERASE_4KB)
+        {
+            return 0xFFFFFFFFUL;
+        }
+    }
+    switch (instruct)
+    {
+        case W15Q64_BLOCK_ERASE_64KB:
+            return W15Q64_T_BE2_US;
+        case W15Q64_BLOCK_ERASE_32KB:
+            return W15Q64_T_BE1_US;
+        default:
+            return W15Q64_T_SE_US;
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция обходит область по блокам 64 КБ и для каждого блока
+ *          выбирает самый быстрый набор команд стирания
+ */
+static void W15Q64_EraseWalk(W15Q64spi_t *spi,
+                             uint32_t start,
+                             uint32_t len,
+                             _Bool skipBlank,
+                             W15Q64erasePlan_t *pPlan,
+                             _Bool execute)
+{
+    const uint16_t sectors = W15Q64_BLOCK_64KB_SIZE / W15Q64_SECTOR_SIZE;
+    const uint32_t tSE = W15Q64_EraseUs(spi, W15Q64_SECTOR_ERASE_4KB),
+            tBE1 = W15Q64_EraseUs(spi, W15Q64_BLOCK_ERASE_32KB),
+            tBE2 = W15Q64_EraseUs(spi, W15Q64_BLOCK_ERASE_64KB);
+    uint32_t end,
+            block,
+            addr,
+            halfCost[2];
+    uint16_t inMask,
+            needMask,
+            halfMask;
+    uint8_t i,
+            h;
+    _Bool use32KB[2];
+
+    pPlan->opCnt = 0;
+    pPlan->cnt4KB = 0;
+    pPlan->cnt32KB = 0;
+    pPlan->cnt64KB = 0;
+    pPlan->skipped = 0;
+    pPlan->estimatedUs = 0;
+    if (len == 0)
+    {
+        return;
+    }
+
+    // Границы секторов
+    end = (start + len + W15Q64_SECTOR_SIZE - 1) & ~(W15Q64_SECTOR_SIZE - 1UL);
+    start &= ~(W15Q64_SECTOR_SIZE - 1UL);
+    if (end > W15Q64_Capacity(spi))
+    {
+        end = W15Q64_Capacity(spi);
+    }
+
+    for (block = start & ~(W15Q64_BLOCK_64KB_SIZE - 1UL); block < end;
+         block += W15Q64_BLOCK_64KB_SIZE)
+    {
+        // Сектора блока, входящие в область, и сектора, требующие стирания
+        inMask = 0;
+        needMask = 0;
+        for (i = 0; i < sectors; i++)
+        {
+            addr = block + (uint32_t) i * W15Q64_SECTOR_SIZE;
+            if ((addr < start) || (addr >= end))
+            {
+                continue;
+            }
+            inMask |= (uint16_t) (1U << i);
+            if (!(skipBlank && W15Q64_BlankCheck(spi, addr, W15Q64_SECTOR_SIZE, NULL)))
+            {
+                needMask |= (uint16_t) (1U << i);
+            }
+        }
+        if (needMask == 0)
+        {
+            pPlan->skipped += W15Q64_BitCnt(inMask);
+            continue;
+        }
+
+        // Стоимость половин блока: Block Erase 32KB или отдельные сектора
+        for (h = 0; h < 2; h++)
+        {
+            halfMask = (uint16_t) (0x00FFU << (h * 8));
+            halfCost[h] = W15Q64_BitCnt(needMask & halfMask) * tSE;
+            use32KB[h] = ((inMask & halfMask) == halfMask) && (tBE1 < halfCost[h]);
+            if (use32KB[h])
+            {
+                halfCost[h] = tBE1;
+            }
+        }
+
+        if ((inMask == 0xFFFF) && (tBE2 <= halfCost[0] + halfCost[1]))
+        {
+            W15Q64_EraseEmit(spi, pPlan, W15Q64_BLOCK_ERASE_64KB, block, execute);
+            continue;
+        }
+        for (h = 0; h < 2; h++)
+        {
+            if (use32KB[h])
+            {
+                W15Q64_EraseEmit(spi, pPlan, W15Q64_BLOCK_ERASE_32KB,
+                                 block + h * W15Q64_BLOCK_32KB_SIZE, execute);
+                continue;
+            }
+            // Пропущены только чистые сектора, не покрытые командой блока
+            pPlan->skipped += W15Q64_BitCnt((uint16_t) (inMask & ~needMask
+                                                        & (0x00FFU << (h * 8))));
+            for (i = (uint8_t) (h * 8); i < (uint8_t) (h * 8 + 8); i++)
+            {
+                if ((needMask & (1U << i)) != 0)
+                {
+                    W15Q64_EraseEmit(spi, pPlan, W15Q64_SECTOR_ERASE_4KB,
+                                     block + (uint32_t) i * W15Q64_SECTOR_SIZE, execute);
+                }
+            }
+        }
+    }
+}
+
+/**
+ *  @brief  Функция добавляет команду в план и при execute = true выполняет ее
+ */
+static void W15Q64_EraseEmit(W15Q64spi_t *spi,
+                             W15Q64erasePlan_t *pPlan,
+                             uint8_t instruct,
+                             uint32_t addr,
+                             _Bool execute)
+{
+    if ((pPlan->pOps != NULL) && (pPlan->opCnt < pPlan->maxOps))
+    {
+        pPlan->pOps[pPlan->opCnt].instruct = instruct;
+        pPlan->pOps[pPlan->opCnt].addr = addr;
+    }
+    pPlan->opCnt++;
+    pPlan->estimatedUs += W15Q64_EraseUs(spi, instruct);
+
+    switch (instruct)
+    {
+        case W15Q64_BLOCK_ERASE_64KB:
+            pPlan->cnt64KB++;
+            break;
+        case W15Q64_BLOCK_ERASE_32KB:
+            pPlan->cnt32KB++;
+            break;
+        default:
+            pPlan->cnt4KB++;
+            break;
+    }
+
+    if (execute)
+    {
+        W15Q64_Erase(spi, addr, instruct);
+        W15Q64_WaitBusy(spi);
+    }
+}
+
+static uint8_t W15Q64_BitCnt(uint16_t mask)
+{
+    uint8_t cnt = 0;
+    for (; mask != 0; mask &= (uint16_t) (mask - 1))
+    {
+        cnt++;
+    }
+    return cnt;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
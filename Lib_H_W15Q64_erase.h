@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_erase.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Стирание произвольной области микросхемы flash памяти w15q64
+ *              минимальным по времени набором команд стирания
+ *  @warning    Стирание выполняется секторами по 4 КБ, поэтому область
+ *              расширяется до границ секторов: начало округляется вниз,
+ *              конец - вверх.
+ *              Для каждого блока 64 КБ выбирается самый быстрый вариант
+ *              (по типовым временам tSE, tBE1, tBE2): один Block Erase 64KB,
+ *              Block Erase 32KB для половин или отдельные Sector Erase 4KB.
+ *              Если к spi подключены параметры SFDP (W15Q64_SfdpApply()),
+ *              используются их времена, а блоки, стирание которых микросхема
+ *              не поддерживает, не применяются.
+ *              При skipBlank = true сектора, уже заполненные 0xFF, читаются
+ *              заранее и не стираются.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_ERASE_H
+#define	LIB_H_W15Q64_ERASE_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Типовые времена стирания, мкс (см. 9.6 AC Electrical Characteristics)
+#define W15Q64_T_SE_US                                    45000UL
+#define W15Q64_T_BE1_US                                   120000UL
+#define W15Q64_T_BE2_US                                   150000UL
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint8_t instruct; //        W15Q64_SECTOR_ERASE_4KB, W15Q64_BLOCK_ERASE_32KB
+    //                          или W15Q64_BLOCK_ERASE_64KB
+    uint32_t addr;
+} W15Q64eraseOp_t; //   Одна команда стирания
+
+typedef struct {
+    W15Q64eraseOp_t *pOps; //   Массив для команд плана или NULL (только счетчики)
+    uint16_t maxOps; //         Размер массива pOps
+
+    // Результат
+    uint16_t opCnt; //          Количество команд (в pOps - не больше maxOps)
+    uint16_t cnt4KB;
+    uint16_t cnt32KB;
+    uint16_t cnt64KB;
+    uint16_t skipped; //        Чистых секторов, не покрытых командами плана
+    uint32_t estimatedUs; //    Оценка времени стирания по типовым временам
+} W15Q64erasePlan_t; // Структура содержит план стирания области
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_ErasePlan(W15Q64spi_t *spi,
+        uint32_t start,
+        uint32_t len,
+        _Bool skipBlank,
+        W15Q64erasePlan_t *pPlan);
+extern void W15Q64_EraseRange(W15Q64spi_t *spi,
+        uint32_t start,
+        uint32_t len,
+        _Bool skipBlank,
+        W15Q64erasePlan_t *pPlan);
+extern uint32_t W15Q64_EraseUs(W15Q64spi_t *spi,
+        uint8_t instruct);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
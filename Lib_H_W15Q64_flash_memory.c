@@ -17,7 +17,33 @@
 
 //******************************************************************************
 // Секция include: здесь подключается заголовочный файл к модулю
-#include "Lib_H_w15q64_flash_memory.h"
+#include <string.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#if W15Q64_STATS
+#include "Lib_H_W15Q64_stats.h"
+#endif
+#if W15Q64_STATIC_PORT
+#include W15Q64_PORT_HEADER
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Управление CS: для структуры с sc_ON = NULL - порт W15Q64_PORT_HEADER
+#if W15Q64_STATIC_PORT
+#define W15Q64_CS_ON(spi)   do { if ((spi)->sc_ON == NULL) { W15Q64_PORT_CS_ON(); } \
+                                 else { (spi)->sc_ON(); } } while (0)
+#define W15Q64_CS_OFF(spi)  do { if ((spi)->sc_ON == NULL) { W15Q64_PORT_CS_OFF(); } \
+                                 else { (spi)->cs_OFF(); } } while (0)
+#else
+#define W15Q64_CS_ON(spi)   (spi)->sc_ON()
+#define W15Q64_CS_OFF(spi)  (spi)->cs_OFF()
+#endif
+
+// Заголовок команды чтения: инструкция, адрес (до 4 байт) и M7-0, dummy
+#define W15Q64_READ_HEADER_SIZE                           10
 //******************************************************************************
 
 
@@ -29,6 +55,24 @@
 //------------------------------------------------------------------------------
 // Локальные переменные
 //------------------------------------------------------------------------------
+
+// Параметры команд чтения по нескольким линиям (см. 7.2.13 - 7.2.16)
+typedef struct {
+    uint8_t instruct;
+    uint8_t addrLines; //       Линий для адреса и M7-0
+    uint8_t dataLines; //       Линий для данных
+    _Bool modeBits; //          После адреса передаются биты M7-0
+    uint8_t dummyClocks; //     Тактов dummy после адреса (и M7-0)
+    uint8_t busMask; //         Требуемые возможности порта
+} W15Q64readMode_t;
+
+static const W15Q64readMode_t readModes[] = {
+    {W15Q64_FAST_READ, 1, 1, false, 8, 0},
+    {W15Q64_FAST_READ_DUAL_OUTPUT, 1, 2, false, 8, W15Q64_BUS_DUAL},
+    {W15Q64_FAST_READ_QUAD_OUTPUT, 1, 4, false, 8, W15Q64_BUS_QUAD},
+    {W15Q64_FAST_READ_DUAL_IO, 2, 2, true, 0, W15Q64_BUS_DUAL},
+    {W15Q64_FAST_READ_QUAD_IO, 4, 4, true, 4, W15Q64_BUS_QUAD},
+};
 //******************************************************************************
 
 
@@ -37,11 +81,34 @@
 void W15Q64_WriteEn(W15Q64spi_t *spi);
 void W15Q64_WriteEnStatReg(W15Q64spi_t *spi);
 void W15Q64_WriteDis(W15Q64spi_t *spi);
-uint8_t W15Q64_ReadStatReg(W15Q64spi_t *spi,
-                           uint8_t instruct);
 void W15Q64_AddrTo3Arr(uint32_t addr,
                        uint8_t *pAddr);
 uint8_t W15Q64_BitsInByte(_Bool *pStatReg);
+static uint8_t W15Q64_AddrToArr(W15Q64spi_t *spi,
+                                uint32_t addr,
+                                uint8_t *pAddr);
+static uint8_t W15Q64_DummyClocks(W15Q64spi_t *spi,
+                                  const W15Q64readMode_t *mode);
+static void W15Q64_Command(W15Q64spi_t *spi,
+                           uint8_t *pHeader,
+                           uint8_t headerCnt,
+                           uint8_t *pData,
+                           uint32_t cnt,
+                           uint8_t dir);
+static void W15Q64_Segment(W15Q64spi_t *spi,
+                           W15Q64seg_t *pSeg);
+static const W15Q64readMode_t *W15Q64_FindReadMode(uint8_t instruct);
+static uint8_t W15Q64_ReadHeader(W15Q64spi_t *spi,
+                                 const W15Q64readMode_t *mode,
+                                 uint32_t addr,
+                                 uint8_t *pHeader,
+                                 W15Q64seg_t *pSeg);
+static uint8_t W15Q64_ReadStart(W15Q64spi_t *spi,
+                                uint32_t addr,
+                                uint32_t cnt);
+static void W15Q64_Bus(W15Q64spi_t *spi,
+                       W15Q64seg_t *pSeg,
+                       uint8_t segCnt);
 //******************************************************************************
 
 
@@ -81,19 +148,16 @@ void W15Q64_ReadStatRegs(W15Q64spi_t *spi,
 uint8_t W15Q64_ReadData(W15Q64spi_t *spi,
                         uint32_t addr)
 {
-    uint8_t addrArr[3],
-            instruct = W15Q64_READ_DATA,
+    uint8_t header[5] = {W15Q64_READ_DATA},
+            headerCnt,
             dataByte = 0;
-    ;
-    // Преобразовываем адрес устройства в массив из 3-х байт для отправки на шину SPI
-    W15Q64_AddrTo3Arr(addr, addrArr);
+
+    // Преобразовываем адрес устройства в массив из 3-х (4-х) байт для отправки на шину SPI
+    headerCnt = (uint8_t) (1 + W15Q64_AddrToArr(spi, addr, &header[1]));
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.11 Read Data (03h))
-    spi->sc_ON();
-    spi->transmit(&instruct, 1); //         Instruсtion
-    spi->transmit(addrArr, 3); //           24-Bit Address
-    spi->receive(&dataByte, 1); //          Data Out 1
-    spi->cs_OFF();
+    // Instruсtion, 24-Bit Address; Data Out 1
+    W15Q64_Command(spi, header, headerCnt, &dataByte, 1, W15Q64_SEG_RX);
 
     return dataByte;
 }
@@ -113,20 +177,131 @@ void W15Q64_FastReadData(W15Q64spi_t *spi,
                          uint8_t *pRxData,
                          uint16_t cnt)
 {
-    uint8_t addrArr[3],
-            instruct = W15Q64_FAST_READ,
-            dummyByte = 0;
-    ;
-    // Преобразовываем адрес устройства в массив из 3-х байт для оправки на шину SPI
-    W15Q64_AddrTo3Arr(addr, addrArr);
+    uint8_t header[6] = {W15Q64_FAST_READ},
+            headerCnt;
+
+    // Преобразовываем адрес устройства в массив из 3-х (4-х) байт для оправки на шину SPI
+    headerCnt = (uint8_t) (2 + W15Q64_AddrToArr(spi, addr, &header[1]));
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.12 Fast Read (0Bh))
-    spi->sc_ON();
-    spi->transmit(&instruct, 1); //         Instruction
-    spi->transmit(addrArr, 3); //           24-Bit Address
-    spi->transmit(&dummyByte, 1); //        Dummy Clocks
-    spi->receive(pRxData, cnt); //          Data Out Array
-    spi->cs_OFF();
+    // Instruction, 24-Bit Address, Dummy Clocks; Data Out Array
+    W15Q64_Command(spi, header, headerCnt, pRxData, cnt, W15Q64_SEG_RX);
+}
+
+/**
+ *  @brief  Функция выполняет чтение массива байт произвольной длины (до всего
+ *          объема микросхемы) одной командой Fast Read
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные из микросхемы flash memory
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
+ *  @retval None
+ * 
+ *  @warning    Если порт не поддерживает transmitReceive, прием выполняется
+ *              частями по 65535 байт через receive без перехода CS в "1"
+ */
+void W15Q64_FastReadData32(W15Q64spi_t *spi,
+                           uint32_t addr,
+                           uint8_t *pRxData,
+                           uint32_t cnt)
+{
+    uint8_t header[6] = {W15Q64_FAST_READ},
+            headerCnt;
+
+    headerCnt = (uint8_t) (2 + W15Q64_AddrToArr(spi, addr, &header[1]));
+
+    // Instruction, 24-Bit Address, Dummy Clocks; Data Out Array
+    W15Q64_Command(spi, header, headerCnt, pRxData, cnt, W15Q64_SEG_RX);
+}
+
+/**
+ *  @brief  Функция запускает чтение массива байт через DMA: данные 
+ *          принимаются сразу в массив вызывающей стороны, функция 
+ *          возвращает управление, не дожидаясь окончания приема.
+ *          Используется команда чтения, выбранная W15Q64_BusInit().
+ *          По окончании приема (вызов W15Q64_DmaComplete() из порта) CS
+ *          переводится в "1" и вызывается функция done
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные из микросхемы flash memory
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
+ *  @param  done:   Функция завершения или NULL
+ *  @param  *pCtx:  Указатель, передаваемый в функцию завершения
+ *  @retval true - чтение запущено (или выполнено), false - предыдущее 
+ *          асинхронное чтение еще не завершено
+ * 
+ *  @warning    Если порт не поддерживает transmitReceiveDMA или выполняет
+ *              транзакции целиком (функция transaction), чтение выполняется
+ *              блокирующим образом (W15Q64_FastReadAuto()) и done
+ *              вызывается до возврата из функции
+ */
+_Bool W15Q64_FastReadDataDMA(W15Q64spi_t *spi,
+                             uint32_t addr,
+                             uint8_t *pRxData,
+                             uint32_t cnt,
+                             W15Q64done_t done,
+                             void *pCtx)
+{
+    if (spi->dmaBusy)
+    {
+        return false;
+    }
+
+    if ((spi->transmitReceiveDMA == NULL) || (spi->transaction != NULL)
+        || ((spi->sc_ON == NULL) && (W15Q64_STATIC_PORT == 0)))
+    {
+        W15Q64_FastReadAuto(spi, addr, pRxData, cnt);
+        if (done != NULL)
+        {
+            done(pCtx);
+        }
+        return true;
+    }
+
+    spi->dmaDone = done;
+    spi->pDmaCtx = pCtx;
+    spi->dmaBusy = true;
+    // Instruction, Address, Dummy; Data Out Array
+    spi->dmaLines = W15Q64_ReadStart(spi, addr, cnt);
+    spi->transmitReceiveDMA(NULL, pRxData, cnt);
+    return true;
+}
+
+/**
+ *  @brief  Функция завершает асинхронное чтение. Вызывается портом из 
+ *          прерывания по окончании обмена через DMA
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_DmaComplete(W15Q64spi_t *spi)
+{
+    W15Q64done_t done = spi->dmaDone;
+
+    // При длинном чтении (W15Q64_ReadNextDMA()) CS остается в "0"
+    if (spi->holdLines == 0)
+    {
+        W15Q64_CS_OFF(spi);
+        if ((spi->dmaLines != 1) && (spi->setLines != NULL))
+        {
+            spi->setLines(1);
+        }
+    }
+    spi->dmaBusy = false;
+#if W15Q64_STATS
+    if ((spi->pStats != NULL) && (spi->holdLines == 0))
+    {
+        W15Q64_StatsBusEnd(spi->pStats, W15Q64_FAST_READ, spi->pStats->dmaStartUs);
+    }
+#endif
+    if (done != NULL)
+    {
+        done(spi->pDmaCtx);
+    }
 }
 
 /**
@@ -140,15 +315,131 @@ void W15Q64_FastReadData(W15Q64spi_t *spi,
 void W15Q64_WriteStatRegs(W15Q64spi_t *spi,
                           W15Q64statRegs_t *status)
 {
-    uint8_t txData = W15Q64_WRITE_STATUS_REGISTER,
-            statRegsArr[2] = {W15Q64_BitsInByte(status->reg1),
+    uint8_t header[3] = {W15Q64_WRITE_STATUS_REGISTER,
+        W15Q64_BitsInByte(status->reg1),
         W15Q64_BitsInByte(status->reg2)};
 
+    W15Q64_WriteEn(spi);
+
     // Работа с микросхемой через интерфейс SPI (см. 7.2.10 Write Status Register (01h))
-    spi->sc_ON();
-    spi->transmit(&txData, 1); //       Instruction
-    spi->transmit(statRegsArr, 2); //   Status Register 1, then Status Register 2
-    spi->cs_OFF();
+    // Instruction, Status Register 1, then Status Register 2
+    W15Q64_Command(spi, header, 3, NULL, 0, W15Q64_SEG_TX);
+}
+
+/**
+ *  @brief  Функция читает Status Register 1 и 2 в упакованном виде
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Status Register 1 (биты 7-0) и Status Register 2 (биты 15-8),
+ *          см. W15Q64_SR_BUSY, W15Q64_SR_WEL, W15Q64_SR_QE, W15Q64_SR_SUS
+ */
+uint16_t W15Q64_ReadStatus(W15Q64spi_t *spi)
+{
+    return (uint16_t) (W15Q64_PollStatus(spi)
+            | (W15Q64_ReadStatReg(spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_2) << 8));
+}
+
+/**
+ *  @brief  Функция записывает Status Register 1 и 2 из упакованного 
+ *          значения (Write Enable и Write Status Register одной командой)
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  status: Status Register 1 (биты 7-0) и Status Register 2 (биты 15-8)
+ *  @retval None
+ */
+void W15Q64_WriteStatus(W15Q64spi_t *spi,
+                        uint16_t status)
+{
+    uint8_t header[3] = {W15Q64_WRITE_STATUS_REGISTER,
+        (uint8_t) status,
+        (uint8_t) (status >> 8)};
+
+    W15Q64_WriteEn(spi);
+    W15Q64_Command(spi, header, 3, NULL, 0, W15Q64_SEG_TX);
+}
+
+/**
+ *  @brief  Функция читает Status Register 1 одной транзакцией из 2 байт
+ *          (для циклов ожидания). Если порт поддерживает transmitReceive,
+ *          инструкция передается и байт регистра принимается одним вызовом
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Status Register 1
+ */
+uint8_t W15Q64_PollStatus(W15Q64spi_t *spi)
+{
+    uint8_t txData[2] = {W15Q64_READ_STATUS_REGISTER_1, 0xFF},
+            rxData[2] = {0, 0};
+#if W15Q64_STATS
+    W15Q64seg_t seg[2] = {
+        {txData, 1, W15Q64_SEG_TX, 1},
+        {&rxData[1], 1, W15Q64_SEG_RX, 1}
+    };
+    uint32_t startUs = 0;
+#endif
+
+    if ((spi->transmitReceive == NULL) || (spi->transaction != NULL)
+        || (spi->contInstruct != 0))
+    {
+        return W15Q64_ReadStatReg(spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_1);
+    }
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        startUs = W15Q64_StatsBus(spi->pStats, W15Q64_READ_STATUS_REGISTER_1, seg, 2);
+    }
+#endif
+
+    // Работа с шиной данных SPI (см. 7.2.9 Read Status Register 1 and 2)
+    W15Q64_CS_ON(spi);
+    spi->transmitReceive(txData, rxData, 2);
+    W15Q64_CS_OFF(spi);
+
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        W15Q64_StatsBusEnd(spi->pStats, W15Q64_READ_STATUS_REGISTER_1, startUs);
+        W15Q64_StatsStatus(spi->pStats, rxData[1]);
+    }
+#endif
+    return rxData[1];
+}
+
+/**
+ *  @brief  Функция проверяет бит BUSY (см. W15Q64_PollStatus())
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval true - идет запись или стирание
+ */
+_Bool W15Q64_IsBusy(W15Q64spi_t *spi)
+{
+    return W15Q64_STATUS_BUSY(W15Q64_PollStatus(spi));
+}
+
+/**
+ *  @brief  Функция читает за один вызов JEDEC ID (9Fh), Unique ID (4Bh) и
+ *          Status Register 1 и 2
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  *pId:   Указатель на структуру результата
+ *  @retval true - микросхема отвечает (код производителя не 00h и не FFh)
+ */
+_Bool W15Q64_Probe(W15Q64spi_t *spi,
+                   W15Q64id_t *pId)
+{
+    uint8_t jedec = W15Q64_JEDEC_ID,
+            uniqueHeader[5] = {W15Q64_READ_UNIQUE_ID, 0x00, 0x00, 0x00, 0x00},
+            jedecId[3] = {0};
+
+    // Instruction; Manufacturer, Memory Type, Capacity (см. 7.2.34 Read JEDEC ID (9Fh))
+    W15Q64_Command(spi, &jedec, 1, jedecId, 3, W15Q64_SEG_RX);
+    // Instruction, 4 Dummy Bytes; 64-bit Unique ID (см. 7.2.33 Read Unique ID Number (4Bh))
+    W15Q64_Command(spi, uniqueHeader, 5, pId->uniqueId, W15Q64_UNIQUE_ID_SIZE, W15Q64_SEG_RX);
+    pId->manufacturerId = jedecId[0];
+    pId->memoryType = jedecId[1];
+    pId->capacityCode = jedecId[2];
+    pId->status = W15Q64_ReadStatus(spi);
+    return (jedecId[0] != 0x00) && (jedecId[0] != 0xFF);
 }
 
 /**
@@ -165,34 +456,37 @@ void W15Q64_WriteStatRegs(W15Q64spi_t *spi,
  *  @warning    Запись данных может начинаться с шагом в 256 байт, т.е. младшие 
  *              8 бит должны быть нулями.
  *              Записать за один раз можно только 256 байт, 257 байт будет 
- *              перезаписывать первый байт.
+ *              перезаписывать первый байт (размер страницы -
+ *              W15Q64_PageSize()).
  */
 void W15Q64_PageProg(W15Q64spi_t *spi,
                      uint32_t addr,
                      uint8_t *pTxData,
                      uint16_t cnt)
 {
-    uint8_t txInstruct = W15Q64_PAGE_PROGRAM,
-            addrArr[3];
+    uint8_t header[5] = {W15Q64_PAGE_PROGRAM},
+            headerCnt;
 
     // Программирование страницы ограниченно 256 байтами
     // cnt - это количество передаваемых данных!!! Поэтому верхний предел "cnt = 256" а не "cnt = 255"
-    if (cnt > 256)
+    if (cnt > W15Q64_PageSize(spi))
     {
-        cnt = 256;
+        cnt = W15Q64_PageSize(spi);
     }
 
-    // Преобразовываем адрес устройства в массив, состоящий из 3-х байт для оправки на шину SPI
-    W15Q64_AddrTo3Arr(addr, addrArr);
+    // Преобразовываем адрес устройства в массив, состоящий из 3-х (4-х) байт для оправки на шину SPI
+    headerCnt = (uint8_t) (1 + W15Q64_AddrToArr(spi, addr, &header[1]));
 
     W15Q64_WriteEn(spi);
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.20 Page Program (02h))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->transmit(addrArr, 3); //           24-Bit Address
-    spi->transmit(pTxData, cnt); //         Data Bytes
-    spi->cs_OFF();
+    // Instruction, 24-Bit Address; Data Bytes
+    W15Q64_Command(spi, header, headerCnt, pTxData, cnt, W15Q64_SEG_TX);
+
+    if (spi->modify != NULL)
+    {
+        spi->modify(spi->pModifyCtx, addr, pTxData, cnt);
+    }
 }
 
 /**
@@ -210,20 +504,41 @@ void W15Q64_ReadSecReg(W15Q64spi_t *spi,
                        uint8_t *pRxData,
                        uint16_t cnt)
 {
-    uint8_t dummyByte = 0,
-            instruct = W15Q64_READ_SECURITY_REGISTER,
-            addrArr[3];
+    uint8_t header[6] = {W15Q64_READ_SECURITY_REGISTER},
+            headerCnt;
 
-    // Преобразовываем адрес устройства в массив, состоящий из 3-х байт для оправки на шину SPI
-    W15Q64_AddrTo3Arr(addr, addrArr);
+    // Преобразовываем адрес устройства в массив, состоящий из 3-х (4-х) байт для оправки на шину SPI
+    headerCnt = (uint8_t) (2 + W15Q64_AddrToArr(spi, addr, &header[1]));
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.38 Read Security Registers (48h))
-    spi->sc_ON();
-    spi->transmit(&instruct, 1); //         Instruction
-    spi->transmit(addrArr, 3); //           24-Bit Address
-    spi->transmit(&dummyByte, 1); //        Dummy Byte
-    spi->transmit(pRxData, cnt); //         Data Out
-    spi->cs_OFF();
+    // Instruction, 24-Bit Address, Dummy Byte; Data Out
+    W15Q64_Command(spi, header, headerCnt, pRxData, cnt, W15Q64_SEG_RX);
+}
+
+/**
+ *  @brief  Функция выполняет чтение таблиц SFDP (Serial Flash Discoverable
+ *          Parameters). Адрес всегда 3-х байтный, независимо от режима
+ *          4-Byte Address
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес в области SFDP
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
+ *  @retval None
+ */
+void W15Q64_ReadSfdp(W15Q64spi_t *spi,
+                     uint32_t addr,
+                     uint8_t *pRxData,
+                     uint16_t cnt)
+{
+    uint8_t header[5] = {W15Q64_READ_SFDP_REGISTER};
+
+    W15Q64_AddrTo3Arr(addr, &header[1]);
+
+    // Работа с микросхемой через интерфейс SPI (см. 7.2.37 Read SFDP Register (5Ah))
+    // Instruction, 24-Bit Address, Dummy Byte; Data Out
+    W15Q64_Command(spi, header, 5, pRxData, cnt, W15Q64_SEG_RX);
 }
 
 
@@ -241,16 +556,30 @@ void W15Q64_ReadSecReg(W15Q64spi_t *spi,
  */
 void W15Q64_Erase(W15Q64spi_t *spi, uint32_t addr, uint8_t txInstruct)
 {
+    uint8_t header[5] = {txInstruct},
+            headerCnt;
+    uint32_t size;
+
     W15Q64_WriteEn(spi);
-    uint8_t txData = txInstruct,
-            addrAdrr[3];
-    W15Q64_AddrTo3Arr(addr, addrAdrr);
+    headerCnt = (uint8_t) (1 + W15Q64_AddrToArr(spi, addr, &header[1]));
 
     // Работа с микросхемой через интерфейс SPI (общая последовательность при стирании данных)
-    spi->sc_ON();
-    spi->transmit(&txData, 1); //           Instruction
-    spi->transmit(addrAdrr, 3); //          24-Bit Address
-    spi->cs_OFF();
+    // Instruction, 24-Bit Address
+    W15Q64_Command(spi, header, headerCnt, NULL, 0, W15Q64_SEG_TX);
+
+    if (spi->modify != NULL)
+    {
+        size = W15Q64_EraseSize(spi, txInstruct);
+        if (size != 0)
+        {
+            spi->modify(spi->pModifyCtx, addr & ~(size - 1UL), NULL, size);
+        }
+        else
+        {
+            // Размер стирания неизвестен - содержимое памяти не определено
+            spi->modify(spi->pModifyCtx, 0, NULL, 0);
+        }
+    }
 }
 
 void W15Q64_SectorErase4KB(W15Q64spi_t *spi,
@@ -275,10 +604,15 @@ void W15Q64_ChipErase(W15Q64spi_t *spi)
 {
     uint8_t txInstruct = W15Q64_CHIP_ERASE;
 
+    W15Q64_WriteEn(spi);
+
     // Работа с микросхемой через интерфейс SPI (см. Chip Erase (C7h))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->cs_OFF();
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
+
+    if (spi->modify != NULL)
+    {
+        spi->modify(spi->pModifyCtx, 0, NULL, W15Q64_Capacity(spi));
+    }
 }
 
 void W15Q64_EraseProgram_Suspend(W15Q64spi_t *spi)
@@ -286,9 +620,7 @@ void W15Q64_EraseProgram_Suspend(W15Q64spi_t *spi)
     uint8_t txInstruct = W15Q64_ERASE_PROGRAM_SUSPEND;
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.26 Erase_Program Suspend (75h))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->cs_OFF();
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
 }
 
 void W15Q64_EraseProgram_Resume(W15Q64spi_t *spi)
@@ -296,9 +628,7 @@ void W15Q64_EraseProgram_Resume(W15Q64spi_t *spi)
     uint8_t txInstruct = W15Q64_ERASE_PROGRAM_RESUME;
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.27 Erase/Program Resume (7Ah))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->cs_OFF();
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
 }
 
 void W15Q64_PowerDown(W15Q64spi_t *spi)
@@ -306,9 +636,7 @@ void W15Q64_PowerDown(W15Q64spi_t *spi)
     uint8_t txInstruct = W15Q64_POWER_DOWN;
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.28 Power-down (B9h))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->cs_OFF();
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
 }
 
 void W15Q64_ReleasePowerDown(W15Q64spi_t *spi)
@@ -316,139 +644,1058 @@ void W15Q64_ReleasePowerDown(W15Q64spi_t *spi)
     uint8_t txInstruct = W15Q64_RELEASE_POWER_DOWN;
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.29 Release Power-down (ABh))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->cs_OFF();
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
 }
 
 uint8_t W15Q64_DeviceID(W15Q64spi_t *spi)
 {
-    uint8_t txInstruct = W15Q64_RELEASE_POWER_DOWN,
-            dummyBytes[3] = {0x00, 0x00, 0x00},
-    deviceID = 0;
+    uint8_t header[4] = {W15Q64_RELEASE_POWER_DOWN, 0x00, 0x00, 0x00},
+            deviceID = 0;
 
     // Работа с микросхемой через интерфейс SPI (см. 7.2.29 Release Power-down (ABh))
-    spi->sc_ON();
-    spi->transmit(&txInstruct, 1); //       Instruction
-    spi->transmit(dummyBytes, 3); //        3 Dummy Bytes
-    spi->receive(&deviceID, 1); //          Device ID
-    spi->cs_OFF();
+    // Instruction, 3 Dummy Bytes; Device ID
+    W15Q64_Command(spi, header, 4, &deviceID, 1, W15Q64_SEG_RX);
     return deviceID;
 }
 
 //==============================================================================
-// Локальные функции
+// Чтение по нескольким линиям данных (Dual/Quad SPI)
 
 /**
- *  @brief  Функция отправляет инструкцию в микросхему flash памяти для отключения 
- *          блокировки на запись
- *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
- *                      для работы с шиной SPI
+ *  @brief  Функция выполняет чтение массива байт одной из команд Fast Read:
+ *          W15Q64_FAST_READ, W15Q64_FAST_READ_DUAL_OUTPUT, 
+ *          W15Q64_FAST_READ_QUAD_OUTPUT, W15Q64_FAST_READ_DUAL_IO или
+ *          W15Q64_FAST_READ_QUAD_IO. Если порт не поддерживает нужное 
+ *          количество линий, используется W15Q64_FAST_READ
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  instruct:   Команда чтения
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные из микросхемы flash memory
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
  *  @retval None
+ * 
+ *  @warning    Команды Quad требуют установленного бита QE (см. 
+ *              W15Q64_QuadEnable())
  */
-void W15Q64_WriteEn(W15Q64spi_t *spi)
+void W15Q64_FastReadMulti(W15Q64spi_t *spi,
+                          uint8_t instruct,
+                          uint32_t addr,
+                          uint8_t *pRxData,
+                          uint32_t cnt)
 {
-    uint8_t txData = W15Q64_WRITE_ENABLE;
+    const W15Q64readMode_t *mode = W15Q64_FindReadMode(instruct);
+    uint8_t header[W15Q64_READ_HEADER_SIZE];
+    W15Q64seg_t seg[4];
+    uint8_t segCnt;
 
-    // Работа с микросхемой по шине SPI (см. 7.2.6 Write Enable (06h))
-    spi->sc_ON();
-    spi->transmit(&txData, 1); //           Instruction
-    spi->cs_OFF();
+    if ((mode->busMask & ~spi->busWidths) != 0)
+    {
+        mode = &readModes[0];
+    }
+    segCnt = W15Q64_ReadHeader(spi, mode, addr, header, seg);
+    // Data Out Array
+    seg[segCnt++] = (W15Q64seg_t) {pRxData, cnt, W15Q64_SEG_RX, mode->dataLines};
+
+    W15Q64_Transaction(spi, seg, segCnt);
 }
 
 /**
- *  @brief  Функция отправляет инструкцию в микросхему flash памяти для отключения 
- *          блокировки на запись 
- *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
- *                      для работы с шиной SPI
+ *  @brief  Функция выполняет чтение массива байт самой быстрой командой,
+ *          выбранной W15Q64_BusInit()
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные из микросхемы flash memory
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
  *  @retval None
  */
-void W15Q64_WriteEnStatReg(W15Q64spi_t *spi)
+void W15Q64_FastReadAuto(W15Q64spi_t *spi,
+                         uint32_t addr,
+                         uint8_t *pRxData,
+                         uint32_t cnt)
 {
-    uint8_t txData = W15Q64_VOLATILE_SR_WRITE_EN;
-
-    // Работа с микросхемой по шине SPI (см. 7.2.7 Write Enable for Volatile Status Register (50h))
-    spi->sc_ON();
-    spi->transmit(&txData, 1);
-    spi->cs_OFF();
+    W15Q64_FastReadMulti(spi,
+                         (spi->readInstruct != 0) ? spi->readInstruct : (uint8_t) W15Q64_FAST_READ,
+                         addr, pRxData, cnt);
 }
 
 /**
- *  @brief  Функция отправляет инструкцию в микросхему flash памяти для включения 
- *          блокировки на запись
- *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
- *                      для работы с шиной SPI
- *  @retval None
+ *  @brief  Функция устанавливает или сбрасывает бит QE (Quad Enable) в 
+ *          Status Register 2 (энергонезависимая запись) и ожидает окончания
+ *          записи
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  enable: true - разрешить команды Quad SPI
+ *  @retval Значение бита QE после записи
  */
-void W15Q64_WriteDis(W15Q64spi_t *spi)
+_Bool W15Q64_QuadEnable(W15Q64spi_t *spi,
+                        _Bool enable)
 {
-    uint8_t txData = W15Q64_WRITE_DIS;
+    uint8_t reg1 = W15Q64_ReadStatReg(spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_1),
+            reg2 = W15Q64_ReadStatReg(spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_2),
+            header[3] = {W15Q64_WRITE_STATUS_REGISTER};
 
-    // Работа с микросхемой по шине SPI (см. 7.2.8 Write Disable (04h))
-    spi->sc_ON();
-    spi->transmit(&txData, 1);
-    spi->cs_OFF();
-}
+    if (((reg2 & (1 << W15Q64_QE)) != 0) == enable)
+    {
+        return enable;
+    }
 
-/**
- *  @brief  Функция делает преобразование 3-х байтного адреса в массив из 3-х байт
- *  @param  addr:   Адрес в памяти микросхемы flash памяти
- *  @param  *pAddr: Указатель на массив в который будут записаны 3 байта адреса   
- *  @retval None
- */
-void W15Q64_AddrTo3Arr(uint32_t addr,
-                       uint8_t *pAddr)
-{
-    *pAddr++ = (uint8_t) ((addr >> 16) & 0xFF);
-    *pAddr++ = (uint8_t) ((addr >> 8) & 0xFF);
-    *pAddr = (uint8_t) (addr & 0xFF);
+    // Status Register 1 записывается вместе с SR2 без изменений
+    header[1] = reg1;
+    header[2] = enable ? (uint8_t) (reg2 | (1 << W15Q64_QE))
+            : (uint8_t) (reg2 & ~(1 << W15Q64_QE));
+
+    W15Q64_WriteEn(spi);
+    // Работа с микросхемой через интерфейс SPI (см. 7.2.10 Write Status Register (01h))
+    W15Q64_Command(spi, header, 3, NULL, 0, W15Q64_SEG_TX);
+    W15Q64_WaitBusy(spi);
+
+    reg2 = W15Q64_ReadStatReg(spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_2);
+    return (reg2 & (1 << W15Q64_QE)) != 0;
 }
 
 /**
- *  @brief  Функция выполняет запись битов из массива размерностью 8 в байт данных
- *  @param  *statRegs:  Массив, в каждой ячейке которого может быть одно из двух 
- *                      состояний - "0" или "1"
- *  @retval Байт данных, преобразованный из массива битов
+ *  @brief  Функция выбирает самую быструю команду чтения, доступную порту
+ *          (поле busWidths), и при необходимости устанавливает бит QE.
+ *          Вызывается один раз после заполнения структуры spi
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Выбранная команда чтения
  */
-uint8_t W15Q64_BitsInByte(_Bool *pStatReg)
+uint8_t W15Q64_BusInit(W15Q64spi_t *spi)
 {
-    uint8_t byteMask_if_true [8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
-    uint8_t byteMask_if_false [8] = {0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F};
-    uint8_t statReg = 0;
-    uint8_t i = 0;
+    spi->readInstruct = W15Q64_FAST_READ;
 
-    for (i = 0; i <= W15Q64_SRP0; i++)
+    if ((spi->busWidths & W15Q64_BUS_QUAD) != 0)
     {
-        if (pStatReg[i])
-        {
-            statReg |= byteMask_if_true[i];
-        }
-        else
+        if (W15Q64_QuadEnable(spi, true))
         {
-            statReg &= byteMask_if_false[i];
+            spi->readInstruct = W15Q64_FAST_READ_QUAD_IO;
+            return spi->readInstruct;
         }
+        // QE не установился - команды Quad недоступны
+        spi->busWidths &= (uint8_t) ~W15Q64_BUS_QUAD;
     }
-    return statReg;
+    if ((spi->busWidths & W15Q64_BUS_DUAL) != 0)
+    {
+        spi->readInstruct = W15Q64_FAST_READ_DUAL_IO;
+    }
+    return spi->readInstruct;
 }
 
 /**
- *  @brief  Функция отправляет данные на шину SPI и принимает 1 байт данных 
- *          с шины SPI
- *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
- *                      для работы с шиной SPI
- *  @param  instruct:   Инструкция для отправки на шину данных SPI
+ *  @brief  Функция выполняет чтение массива байт командой Fast Read Quad I/O
+ *          (EBh) в режиме Continuous Read: первая транзакция передает 
+ *          инструкцию и биты M7-0 = W15Q64_CONT_READ_MODE, последующие - 
+ *          только адрес, M7-0 и dummy. Перед любой другой командой драйвер
+ *          выводит микросхему из режима (см. W15Q64_ContReadExit()).
+ *          Если порт не поддерживает 4 линии, используется W15Q64_FastReadAuto()
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут 
+ *                      записаны данные из микросхемы flash memory
+ *  @param  cnt:    Количество данных, которое необходимо записать в массив
+ *  @retval None
+ * 
+ *  @warning    Требуется установленный бит QE (см. W15Q64_BusInit())
  */
-uint8_t W15Q64_ReadStatReg(W15Q64spi_t *spi,
-                           uint8_t instruct)
+void W15Q64_FastReadCont(W15Q64spi_t *spi,
+                         uint32_t addr,
+                         uint8_t *pRxData,
+                         uint32_t cnt)
 {
-    uint8_t rxData = 0;
+    const W15Q64readMode_t *mode = W15Q64_FindReadMode(W15Q64_FAST_READ_QUAD_IO);
+    uint8_t opcode = W15Q64_FAST_READ_QUAD_IO,
+            addrArr[5],
+            addrCnt,
+            dummy,
+            zeros[4] = {0};
+    W15Q64seg_t seg[4];
+    uint8_t segCnt = 0;
 
-    // Работа с шиной данных SPI (см. 7.2.9 Read Status Register 1 and 2)
-    spi->sc_ON();
-    spi->transmit(&instruct, 1); //     Instruction
-    spi->receive(&rxData, 1); //        Status Register 1 or 2
-    spi->cs_OFF();
-    return rxData;
+    if ((spi->busWidths & W15Q64_BUS_QUAD) == 0)
+    {
+        W15Q64_FastReadAuto(spi, addr, pRxData, cnt);
+        return;
+    }
+    addrCnt = W15Q64_AddrToArr(spi, addr, addrArr);
+    addrArr[addrCnt] = W15Q64_CONT_READ_MODE;
+    dummy = W15Q64_DummyClocks(spi, mode);
+
+    // Instruction (только при входе в режим Continuous Read)
+    if (spi->contInstruct != opcode)
+    {
+        W15Q64_ContReadExit(spi);
+        seg[segCnt++] = (W15Q64seg_t) {&opcode, 1, W15Q64_SEG_TX, 1};
+    }
+    // 24-Bit Address, M7-0
+    seg[segCnt++] = (W15Q64seg_t) {addrArr, addrCnt + 1UL, W15Q64_SEG_TX, mode->addrLines};
+    // Dummy Clocks
+    if (spi->dummyAsClocks)
+    {
+        seg[segCnt++] = (W15Q64seg_t) {NULL, dummy,
+                                       W15Q64_SEG_DUMMY, mode->addrLines};
+    }
+    else
+    {
+        seg[segCnt++] = (W15Q64seg_t) {zeros,
+                                       (uint32_t) dummy * mode->addrLines / 8,
+                                       W15Q64_SEG_TX, mode->addrLines};
+    }
+    // Data Out Array
+    seg[segCnt++] = (W15Q64seg_t) {pRxData, cnt, W15Q64_SEG_RX, mode->dataLines};
+
+    W15Q64_Bus(spi, seg, segCnt);
+    spi->contInstruct = opcode;
+}
+
+/**
+ *  @brief  Функция выводит микросхему из режима Continuous Read (Continuous
+ *          Read Mode Reset: 16 тактов с "1" на IO0 подходят и для Dual I/O,
+ *          и для Quad I/O). Если микросхема не в режиме, ничего не передается.
+ *          Вызывается драйвером перед каждой командой, отдельный вызов нужен
+ *          только перед передачей шины другому драйверу
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_ContReadExit(W15Q64spi_t *spi)
+{
+    uint8_t modeReset[2] = {0xFF, 0xFF};
+    W15Q64seg_t seg = {modeReset, 2, W15Q64_SEG_TX, 1};
+
+    if (spi->contInstruct == 0)
+    {
+        return;
+    }
+    spi->contInstruct = 0;
+    W15Q64_Bus(spi, &seg, 1);
+}
+
+//==============================================================================
+// Чтение с удержанием CS (потоковое чтение)
+
+/**
+ *  @brief  Функция начинает длинное чтение: передает заголовок команды
+ *          чтения, выбранной W15Q64_BusInit(), и оставляет CS в "0". Данные
+ *          принимаются по частям W15Q64_ReadNext() или W15Q64_ReadNextDMA()
+ *          без повторной передачи инструкции, адреса и dummy, чтение
+ *          завершается W15Q64_ReadClose()
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   "Адрес памяти в микросхеме 24-Bit Address"
+ *  @retval true - чтение начато, false - порт не может удерживать CS
+ *          (только функция transaction)
+ * 
+ *  @warning    До W15Q64_ReadClose() другие функции драйвера для этой
+ *              микросхемы вызывать нельзя. Если для команды нужно несколько
+ *              линий, а функции setLines нет, используется W15Q64_FAST_READ
+ */
+_Bool W15Q64_ReadOpen(W15Q64spi_t *spi,
+                      uint32_t addr)
+{
+    if ((spi->sc_ON == NULL) && (W15Q64_STATIC_PORT == 0))
+    {
+        return false;
+    }
+    spi->holdLines = W15Q64_ReadStart(spi, addr, 0);
+    return true;
+}
+
+/**
+ *  @brief  Функция принимает следующую часть данных длинного чтения
+ *          (см. W15Q64_ReadOpen())
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  *pRxData:   Указатель на массив для данных
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_ReadNext(W15Q64spi_t *spi,
+                     uint8_t *pRxData,
+                     uint32_t cnt)
+{
+    W15Q64seg_t seg = {pRxData, cnt, W15Q64_SEG_RX, spi->holdLines};
+
+    W15Q64_Segment(spi, &seg);
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        spi->pStats->snap.rxBytes += cnt;
+    }
+#endif
+}
+
+/**
+ *  @brief  Функция запускает прием следующей части данных длинного чтения
+ *          через DMA. По окончании приема (вызов W15Q64_DmaComplete() из
+ *          порта) CS остается в "0" и вызывается функция done
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  *pRxData:   Указатель на массив для данных
+ *  @param  cnt:    Количество байт
+ *  @param  done:   Функция завершения или NULL
+ *  @param  *pCtx:  Указатель, передаваемый в функцию завершения
+ *  @retval true - прием запущен (или выполнен), false - предыдущий 
+ *          асинхронный прием еще не завершен
+ * 
+ *  @warning    Если порт не поддерживает transmitReceiveDMA, прием 
+ *              выполняется блокирующим образом и done вызывается до возврата
+ *              из функции
+ */
+_Bool W15Q64_ReadNextDMA(W15Q64spi_t *spi,
+                         uint8_t *pRxData,
+                         uint32_t cnt,
+                         W15Q64done_t done,
+                         void *pCtx)
+{
+    if (spi->dmaBusy)
+    {
+        return false;
+    }
+    if (spi->transmitReceiveDMA == NULL)
+    {
+        W15Q64_ReadNext(spi, pRxData, cnt);
+        if (done != NULL)
+        {
+            done(pCtx);
+        }
+        return true;
+    }
+
+    spi->dmaDone = done;
+    spi->pDmaCtx = pCtx;
+    spi->dmaBusy = true;
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        spi->pStats->snap.rxBytes += cnt;
+    }
+#endif
+    spi->transmitReceiveDMA(NULL, pRxData, cnt);
+    return true;
+}
+
+/**
+ *  @brief  Функция завершает длинное чтение: CS переводится в "1"
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval None
+ * 
+ *  @warning    Прием через DMA должен быть завершен (spi->dmaBusy = false)
+ */
+void W15Q64_ReadClose(W15Q64spi_t *spi)
+{
+    if (spi->holdLines == 0)
+    {
+        return;
+    }
+    W15Q64_CS_OFF(spi);
+    if ((spi->holdLines != 1) && (spi->setLines != NULL))
+    {
+        spi->setLines(1);
+    }
+    spi->holdLines = 0;
+}
+
+//==============================================================================
+// Микросхемы объемом больше 16 MiB
+
+/**
+ *  @brief  Функция включает или выключает режим 4-Byte Address: все команды
+ *          с адресом (кроме Read SFDP) передают 32-битный адрес. Если
+ *          параметры микросхемы (spi->pDev) требуют Write Enable перед B7h,
+ *          он выполняется
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  enable: true - 4-Byte Address, false - 3-Byte Address
+ *  @retval None
+ */
+void W15Q64_Addr4Byte(W15Q64spi_t *spi,
+                      _Bool enable)
+{
+    uint8_t txInstruct = enable ? W15Q64_ENTER_4BYTE_ADDRESS_MODE
+            : W15Q64_EXIT_4BYTE_ADDRESS_MODE;
+
+    if (enable && (spi->pDev != NULL)
+        && ((spi->pDev->enter4Byte & W15Q64_ENTER_4BYTE_B7) == 0)
+        && ((spi->pDev->enter4Byte & W15Q64_ENTER_4BYTE_WREN_B7) != 0))
+    {
+        W15Q64_WriteEn(spi);
+    }
+
+    // Работа с микросхемой через интерфейс SPI (Enter/Exit 4-Byte Address Mode (B7h/E9h))
+    W15Q64_Command(spi, &txInstruct, 1, NULL, 0, W15Q64_SEG_TX);
+    spi->addrBytes = enable ? 4 : 3;
+}
+
+/**
+ *  @brief  Функция возвращает объем памяти микросхемы
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Объем в байтах: из параметров SFDP (spi->pDev) или 
+ *          W15Q64_CAPACITY (всегда при W15Q64_STATIC_GEOMETRY)
+ */
+uint32_t W15Q64_Capacity(W15Q64spi_t *spi)
+{
+    return ((W15Q64_STATIC_GEOMETRY == 0) && (spi->pDev != NULL))
+            ? spi->pDev->capacity : W15Q64_CAPACITY;
+}
+
+/**
+ *  @brief  Функция возвращает размер страницы Page Program
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Размер в байтах: из параметров SFDP (spi->pDev) или 
+ *          W15Q64_PAGE_SIZE (всегда при W15Q64_STATIC_GEOMETRY)
+ */
+uint16_t W15Q64_PageSize(W15Q64spi_t *spi)
+{
+    return ((W15Q64_STATIC_GEOMETRY == 0) && (spi->pDev != NULL) && (spi->pDev->pageSize != 0))
+            ? spi->pDev->pageSize : W15Q64_PAGE_SIZE;
+}
+
+/**
+ *  @brief  Функция возвращает размер области, стираемой инструкцией
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  instruct:   Инструкция стирания
+ *  @retval Размер в байтах: из параметров SFDP (spi->pDev), для инструкций
+ *          W25Q64 без параметров SFDP - стандартный размер, 0 - инструкция
+ *          неизвестна
+ */
+uint32_t W15Q64_EraseSize(W15Q64spi_t *spi,
+                          uint8_t instruct)
+{
+    uint8_t i;
+
+    if ((W15Q64_STATIC_GEOMETRY == 0) && (spi->pDev != NULL))
+    {
+        for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+        {
+            if ((spi->pDev->erase[i].instruct == instruct) && (spi->pDev->erase[i].size != 0))
+            {
+                return spi->pDev->erase[i].size;
+            }
+        }
+    }
+
+    switch (instruct)
+    {
+        case W15Q64_SECTOR_ERASE_4KB:
+            return W15Q64_SECTOR_SIZE;
+        case W15Q64_BLOCK_ERASE_32KB:
+            return W15Q64_BLOCK_32KB_SIZE;
+        case W15Q64_BLOCK_ERASE_64KB:
+            return W15Q64_BLOCK_64KB_SIZE;
+        default:
+            return 0;
+    }
+}
+
+//==============================================================================
+// Транзакции на шине SPI
+
+/**
+ *  @brief  Функция выполняет одну транзакцию на шине SPI (от CS low до CS high),
+ *          состоящую из последовательности сегментов передачи и приема.
+ *          Если в структуре spi задана функция transaction, то вся транзакция
+ *          передается в нее одним вызовом (например, для построения цепочки
+ *          дескрипторов DMA), иначе используются функции sc_ON, transmit,
+ *          receive и cs_OFF. Если микросхема в режиме Continuous Read, 
+ *          перед транзакцией выполняется выход из него
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  *pSeg:  Указатель на первый элемент массива сегментов
+ *  @param  segCnt: Количество сегментов
+ *  @retval None
+ */
+void W15Q64_Transaction(W15Q64spi_t *spi,
+                        W15Q64seg_t *pSeg,
+                        uint8_t segCnt)
+{
+    W15Q64_ContReadExit(spi);
+    W15Q64_Bus(spi, pSeg, segCnt);
+}
+
+//==============================================================================
+// Запись массивов произвольной длины
+
+/**
+ *  @brief  Функция ожидает окончания внутренней операции микросхемы (бит BUSY
+ *          в Status Register 1). Если в структуре spi задана функция delay_us,
+ *          то между опросами выполняется задержка, начиная с pollFirstUs и
+ *          удваиваясь до pollMaxUs
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @retval Количество опросов, при которых бит BUSY был установлен
+ */
+uint32_t W15Q64_WaitBusy(W15Q64spi_t *spi)
+{
+    uint32_t polls = 0,
+            delayUs = spi->pollFirstUs;
+
+    while (W15Q64_IsBusy(spi))
+    {
+        polls++;
+        if ((spi->delay_us != NULL) && (delayUs != 0))
+        {
+            spi->delay_us(delayUs);
+            if (delayUs < spi->pollMaxUs)
+            {
+                delayUs = ((delayUs << 1) > spi->pollMaxUs) ? spi->pollMaxUs : (delayUs << 1);
+            }
+        }
+    }
+    return polls;
+}
+
+/**
+ *  @brief  Функция записывает массив произвольной длины во flash память.
+ *          Массив разбивается на части по границам страниц, для каждой части
+ *          выполняется Page Program и ожидание окончания записи
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address", выравнивание
+ *                  не требуется
+ *  @param  *pTxData:   Указатель на первый элемент массива с данными
+ *  @param  cnt:    Количество байт для записи
+ *  @retval None
+ * 
+ *  @warning    Область памяти должна быть предварительно стерта
+ */
+void W15Q64_Write(W15Q64spi_t *spi,
+                  uint32_t addr,
+                  uint8_t *pTxData,
+                  uint32_t cnt)
+{
+    const uint16_t page = W15Q64_PageSize(spi);
+    uint16_t chunk;
+
+    while (cnt != 0)
+    {
+        // Количество байт до конца текущей страницы
+        chunk = (uint16_t) (page - (addr % page));
+        if (chunk > cnt)
+        {
+            chunk = (uint16_t) cnt;
+        }
+
+        W15Q64_PageProg(spi, addr, pTxData, chunk);
+        W15Q64_WaitBusy(spi);
+
+        addr += chunk;
+        pTxData += chunk;
+        cnt -= chunk;
+    }
+}
+
+/**
+ *  @brief  Функция записывает поток данных произвольной длины во flash память.
+ *          Данные запрашиваются у вызывающей стороны постранично через функцию
+ *          fill, причем буфер следующей страницы заполняется, пока микросхема
+ *          программирует текущую (двойная буферизация)
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  cnt:    Количество байт для записи
+ *  @param  fill:   Функция, заполняющая буфер очередной части данных
+ *  @param  *pCtx:  Указатель, передаваемый в функцию fill
+ *  @retval None
+ * 
+ *  @warning    Функция использует 512 байт стека под буферы страниц, части
+ *              не длиннее W15Q64_PAGE_SIZE (у микросхем с большей страницей
+ *              программирование идет частями страницы).
+ *              Область памяти должна быть предварительно стерта
+ */
+void W15Q64_WriteStream(W15Q64spi_t *spi,
+                        uint32_t addr,
+                        uint32_t cnt,
+                        W15Q64fill_t fill,
+                        void *pCtx)
+{
+    uint8_t pageBuf[2][W15Q64_PAGE_SIZE],
+            cur = 0;
+    uint16_t page = W15Q64_PageSize(spi),
+            chunk,
+            nextChunk;
+
+    if (cnt == 0)
+    {
+        return;
+    }
+
+    if (page > W15Q64_PAGE_SIZE)
+    {
+        page = W15Q64_PAGE_SIZE;
+    }
+    chunk = (uint16_t) (page - (addr % page));
+    if (chunk > cnt)
+    {
+        chunk = (uint16_t) cnt;
+    }
+    fill(pCtx, addr, pageBuf[cur], chunk);
+
+    while (cnt != 0)
+    {
+        W15Q64_PageProg(spi, addr, pageBuf[cur], chunk);
+        addr += chunk;
+        cnt -= chunk;
+
+        // Пока идет программирование страницы, готовим следующую
+        nextChunk = (cnt > page) ? page : (uint16_t) cnt;
+        if (nextChunk != 0)
+        {
+            fill(pCtx, addr, pageBuf[cur ^ 1], nextChunk);
+        }
+
+        W15Q64_WaitBusy(spi);
+        cur ^= 1;
+        chunk = nextChunk;
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция отправляет инструкцию в микросхему flash памяти для отключения 
+ *          блокировки на запись
+ *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
+ *                      для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_WriteEn(W15Q64spi_t *spi)
+{
+    uint8_t txData = W15Q64_WRITE_ENABLE;
+
+    // Работа с микросхемой по шине SPI (см. 7.2.6 Write Enable (06h))
+    W15Q64_Command(spi, &txData, 1, NULL, 0, W15Q64_SEG_TX);
+}
+
+/**
+ *  @brief  Функция отправляет инструкцию в микросхему flash памяти для отключения 
+ *          блокировки на запись 
+ *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
+ *                      для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_WriteEnStatReg(W15Q64spi_t *spi)
+{
+    uint8_t txData = W15Q64_VOLATILE_SR_WRITE_EN;
+
+    // Работа с микросхемой по шине SPI (см. 7.2.7 Write Enable for Volatile Status Register (50h))
+    W15Q64_Command(spi, &txData, 1, NULL, 0, W15Q64_SEG_TX);
+}
+
+/**
+ *  @brief  Функция отправляет инструкцию в микросхему flash памяти для включения 
+ *          блокировки на запись
+ *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
+ *                      для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_WriteDis(W15Q64spi_t *spi)
+{
+    uint8_t txData = W15Q64_WRITE_DIS;
+
+    // Работа с микросхемой по шине SPI (см. 7.2.8 Write Disable (04h))
+    W15Q64_Command(spi, &txData, 1, NULL, 0, W15Q64_SEG_TX);
+}
+
+/**
+ *  @brief  Функция делает преобразование 3-х байтного адреса в массив из 3-х байт
+ *  @param  addr:   Адрес в памяти микросхемы flash памяти
+ *  @param  *pAddr: Указатель на массив в который будут записаны 3 байта адреса   
+ *  @retval None
+ */
+void W15Q64_AddrTo3Arr(uint32_t addr,
+                       uint8_t *pAddr)
+{
+    *pAddr++ = (uint8_t) ((addr >> 16) & 0xFF);
+    *pAddr++ = (uint8_t) ((addr >> 8) & 0xFF);
+    *pAddr = (uint8_t) (addr & 0xFF);
+}
+
+/**
+ *  @brief  Функция записывает адрес в массив по текущей длине адреса
+ *          (spi->addrBytes или W15Q64_ADDR_BYTES при
+ *          W15Q64_STATIC_GEOMETRY), старшим байтом вперед
+ *  @retval Количество байт адреса: 3 или 4
+ */
+static uint8_t W15Q64_AddrToArr(W15Q64spi_t *spi,
+                                uint32_t addr,
+                                uint8_t *pAddr)
+{
+    if ((W15Q64_STATIC_GEOMETRY != 0) ? (W15Q64_ADDR_BYTES == 4) : (spi->addrBytes == 4))
+    {
+        *pAddr++ = (uint8_t) ((addr >> 24) & 0xFF);
+        W15Q64_AddrTo3Arr(addr, pAddr);
+        return 4;
+    }
+    W15Q64_AddrTo3Arr(addr, pAddr);
+    return 3;
+}
+
+/**
+ *  @brief  Функция возвращает количество тактов dummy команды чтения: из
+ *          параметров SFDP (spi->pDev), если команда в них описана, иначе из
+ *          таблицы readModes. Такты M7-0 передаются байтом адреса и не
+ *          входят в результат
+ */
+static uint8_t W15Q64_DummyClocks(W15Q64spi_t *spi,
+                                  const W15Q64readMode_t *mode)
+{
+    uint8_t i,
+            clocks;
+
+    if ((W15Q64_STATIC_GEOMETRY != 0) || (spi->pDev == NULL))
+    {
+        return mode->dummyClocks;
+    }
+    for (i = 0; i < W15Q64_DEV_READ_TYPES; i++)
+    {
+        if ((spi->pDev->read[i].instruct == 0)
+            || (spi->pDev->read[i].instruct != mode->instruct))
+        {
+            continue;
+        }
+        clocks = (uint8_t) (spi->pDev->read[i].modeClocks + spi->pDev->read[i].dummyClocks);
+        if (mode->modeBits)
+        {
+            clocks = (clocks > 8 / mode->addrLines) ? (uint8_t) (clocks - 8 / mode->addrLines) : 0;
+        }
+        return clocks;
+    }
+    return mode->dummyClocks;
+}
+
+/**
+ *  @brief  Функция выполняет запись битов из массива размерностью 8 в байт данных
+ *  @param  *statRegs:  Массив, в каждой ячейке которого может быть одно из двух 
+ *                      состояний - "0" или "1"
+ *  @retval Байт данных, преобразованный из массива битов
+ */
+uint8_t W15Q64_BitsInByte(_Bool *pStatReg)
+{
+    uint8_t byteMask_if_true [8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    uint8_t byteMask_if_false [8] = {0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F};
+    uint8_t statReg = 0;
+    uint8_t i = 0;
+
+    for (i = 0; i <= W15Q64_SRP0; i++)
+    {
+        if (pStatReg[i])
+        {
+            statReg |= byteMask_if_true[i];
+        }
+        else
+        {
+            statReg &= byteMask_if_false[i];
+        }
+    }
+    return statReg;
+}
+
+/**
+ *  @brief  Функция отправляет данные на шину SPI и принимает 1 байт данных 
+ *          с шины SPI
+ *  @param  *spiFunc:   Указатель на структуру, содержащую указатели на функции 
+ *                      для работы с шиной SPI
+ *  @param  instruct:   Инструкция для отправки на шину данных SPI
+ */
+uint8_t W15Q64_ReadStatReg(W15Q64spi_t *spi,
+                           uint8_t instruct)
+{
+    uint8_t rxData = 0;
+
+    // Работа с шиной данных SPI (см. 7.2.9 Read Status Register 1 and 2)
+    // Instruction; Status Register 1 or 2
+    W15Q64_Command(spi, &instruct, 1, &rxData, 1, W15Q64_SEG_RX);
+#if W15Q64_STATS
+    if ((spi->pStats != NULL) && (instruct == W15Q64_READ_STATUS_REGISTER_1))
+    {
+        W15Q64_StatsStatus(spi->pStats, rxData);
+    }
+#endif
+    return rxData;
+}
+
+/**
+ *  @brief  Функция выполняет команду микросхемы: заголовок (инструкция, адрес,
+ *          dummy) передается одним сегментом, за ним следует сегмент данных
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на 
+ *                  функции для работы с шиной SPI
+ *  @param  *pHeader:   Указатель на массив заголовка команды
+ *  @param  headerCnt:  Количество байт заголовка
+ *  @param  *pData: Указатель на массив данных (может быть NULL при cnt = 0)
+ *  @param  cnt:    Количество байт данных
+ *  @param  dir:    Направление передачи данных: W15Q64_SEG_TX или W15Q64_SEG_RX
+ *  @retval None
+ */
+static void W15Q64_Command(W15Q64spi_t *spi,
+                           uint8_t *pHeader,
+                           uint8_t headerCnt,
+                           uint8_t *pData,
+                           uint32_t cnt,
+                           uint8_t dir)
+{
+    W15Q64seg_t seg[2] = {
+        {pHeader, headerCnt, W15Q64_SEG_TX, 1},
+        {pData, cnt, dir, 1}
+    };
+
+    W15Q64_Transaction(spi, seg, (cnt != 0) ? 2 : 1);
+}
+
+/**
+ *  @brief  Функция передает или принимает один сегмент транзакции при 
+ *          уже установленном CS. Используется порт W15Q64_PORT_HEADER (при
+ *          sc_ON = NULL), transmitReceive, если порт его поддерживает, иначе
+ *          transmit/receive частями по 65535 байт
+ */
+static void W15Q64_Segment(W15Q64spi_t *spi,
+                           W15Q64seg_t *pSeg)
+{
+    uint8_t *pData = pSeg->pData,
+            zeros[8] = {0};
+    uint32_t cnt = pSeg->cnt;
+    uint16_t chunk;
+
+    if (cnt == 0)
+    {
+        return;
+    }
+    if (pSeg->dir == W15Q64_SEG_DUMMY)
+    {
+        // Такты dummy передаются байтами 0x00 по текущему количеству линий
+        cnt = (cnt * ((pSeg->lines > 1) ? pSeg->lines : 1) + 7) / 8;
+        pData = zeros;
+        if (cnt > sizeof (zeros))
+        {
+            cnt = sizeof (zeros);
+        }
+    }
+#if W15Q64_STATIC_PORT
+    if (spi->sc_ON == NULL)
+    {
+        if (pSeg->dir == W15Q64_SEG_RX)
+        {
+            W15Q64_PORT_RECEIVE(pData, cnt);
+        }
+        else
+        {
+            W15Q64_PORT_TRANSMIT(pData, cnt);
+        }
+        return;
+    }
+#endif
+    if (spi->transmitReceive != NULL)
+    {
+        if (pSeg->dir == W15Q64_SEG_RX)
+        {
+            spi->transmitReceive(NULL, pData, cnt);
+        }
+        else
+        {
+            spi->transmitReceive(pData, NULL, cnt);
+        }
+        return;
+    }
+
+    while (cnt != 0)
+    {
+        chunk = (cnt > 0xFFFF) ? 0xFFFF : (uint16_t) cnt;
+        if (pSeg->dir == W15Q64_SEG_RX)
+        {
+            spi->receive(pData, chunk);
+        }
+        else
+        {
+            spi->transmit(pData, chunk);
+        }
+        pData += chunk;
+        cnt -= chunk;
+    }
+}
+
+/**
+ *  @brief  Функция возвращает параметры команды чтения, для неизвестной 
+ *          команды - параметры Fast Read (0Bh)
+ */
+static const W15Q64readMode_t *W15Q64_FindReadMode(uint8_t instruct)
+{
+    uint8_t i;
+    for (i = 0; i < sizeof (readModes) / sizeof (readModes[0]); i++)
+    {
+        if (readModes[i].instruct == instruct)
+        {
+            return &readModes[i];
+        }
+    }
+    return &readModes[0];
+}
+
+/**
+ *  @brief  Функция заполняет сегменты заголовка команды чтения (инструкция,
+ *          адрес и M7-0 = 00h, dummy) по параметрам mode
+ *  @param  *pHeader:   Буфер на W15Q64_READ_HEADER_SIZE байт для сегментов
+ *  @param  *pSeg:  Массив не меньше чем на 3 сегмента
+ *  @retval Количество сегментов
+ */
+static uint8_t W15Q64_ReadHeader(W15Q64spi_t *spi,
+                                 const W15Q64readMode_t *mode,
+                                 uint32_t addr,
+                                 uint8_t *pHeader,
+                                 W15Q64seg_t *pSeg)
+{
+    uint8_t *pAddr = &pHeader[1], //    24(32)-Bit Address, M7-0 = 00h
+            *pZeros = &pHeader[6],
+            addrCnt,
+            dummy,
+            segCnt = 0;
+
+    memset(pHeader, 0, W15Q64_READ_HEADER_SIZE);
+    pHeader[0] = mode->instruct;
+    addrCnt = W15Q64_AddrToArr(spi, addr, pAddr);
+    dummy = W15Q64_DummyClocks(spi, mode);
+
+    // Instruction
+    pSeg[segCnt++] = (W15Q64seg_t) {pHeader, 1, W15Q64_SEG_TX, 1};
+    // 24-Bit Address (и M7-0 для команд Dual/Quad I/O)
+    pSeg[segCnt++] = (W15Q64seg_t) {pAddr, mode->modeBits ? addrCnt + 1UL : addrCnt,
+                                    W15Q64_SEG_TX, mode->addrLines};
+    // Dummy Clocks
+    if (dummy != 0)
+    {
+        if (spi->dummyAsClocks)
+        {
+            pSeg[segCnt++] = (W15Q64seg_t) {NULL, dummy,
+                                            W15Q64_SEG_DUMMY, mode->addrLines};
+        }
+        else
+        {
+            pSeg[segCnt++] = (W15Q64seg_t) {pZeros,
+                                            (uint32_t) dummy * mode->addrLines / 8,
+                                            W15Q64_SEG_TX, mode->addrLines};
+        }
+    }
+    return segCnt;
+}
+
+/**
+ *  @brief  Функция начинает команду чтения, выбранную W15Q64_BusInit(): CS
+ *          в "0", передача заголовка и переключение на линии данных. Прием
+ *          данных и CS в "1" выполняет вызывающая функция. Если для команды
+ *          нужно несколько линий, а функции setLines нет, используется
+ *          W15Q64_FAST_READ
+ *  @param  cnt:    Количество байт данных (для счетчиков)
+ *  @retval Количество линий данных
+ */
+static uint8_t W15Q64_ReadStart(W15Q64spi_t *spi,
+                                uint32_t addr,
+                                uint32_t cnt)
+{
+    const W15Q64readMode_t *mode = W15Q64_FindReadMode(spi->readInstruct);
+    uint8_t header[W15Q64_READ_HEADER_SIZE],
+            segCnt,
+            lines,
+            curLines = 1,
+            i;
+    W15Q64seg_t seg[4];
+
+    if (((mode->busMask & ~spi->busWidths) != 0)
+        || ((spi->setLines == NULL) && (mode->busMask != 0)))
+    {
+        mode = &readModes[0];
+    }
+    segCnt = W15Q64_ReadHeader(spi, mode, addr, header, seg);
+    W15Q64_ContReadExit(spi);
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        seg[segCnt] = (W15Q64seg_t) {NULL, cnt, W15Q64_SEG_RX, mode->dataLines};
+        spi->pStats->dmaStartUs = W15Q64_StatsBus(spi->pStats, mode->instruct,
+                                                  seg, (uint8_t) (segCnt + 1));
+    }
+#else
+    (void) cnt;
+#endif
+
+    W15Q64_CS_ON(spi);
+    for (i = 0; i < segCnt + 1; i++)
+    {
+        // Последний шаг - переключение на линии данных
+        lines = (i < segCnt) ? seg[i].lines : mode->dataLines;
+        if ((spi->setLines != NULL) && (lines != curLines))
+        {
+            spi->setLines(lines);
+            curLines = lines;
+        }
+        if (i < segCnt)
+        {
+            W15Q64_Segment(spi, &seg[i]);
+        }
+    }
+    return mode->dataLines;
+}
+
+/**
+ *  @brief  Функция выполняет транзакцию на шине SPI без проверки режима
+ *          Continuous Read (см. W15Q64_Transaction())
+ */
+static void W15Q64_Bus(W15Q64spi_t *spi,
+                       W15Q64seg_t *pSeg,
+                       uint8_t segCnt)
+{
+    uint8_t i,
+            lines,
+            curLines = 1;
+#if W15Q64_STATS
+    // Продолжение Continuous Read начинается с адреса, а не с инструкции
+    uint8_t opcode = (spi->contInstruct != 0) ? spi->contInstruct : pSeg[0].pData[0];
+    uint32_t startUs = 0;
+
+    if (spi->pStats != NULL)
+    {
+        startUs = W15Q64_StatsBus(spi->pStats, opcode, pSeg, segCnt);
+    }
+#endif
+
+    if (spi->transaction != NULL)
+    {
+        spi->transaction(pSeg, segCnt);
+    }
+    else
+    {
+        W15Q64_CS_ON(spi);
+        for (i = 0; i < segCnt; i++)
+        {
+            lines = (pSeg[i].lines > 1) ? pSeg[i].lines : 1;
+            if ((spi->setLines != NULL) && (lines != curLines))
+            {
+                spi->setLines(lines);
+                curLines = lines;
+            }
+            W15Q64_Segment(spi, &pSeg[i]);
+        }
+        W15Q64_CS_OFF(spi);
+        if (curLines != 1)
+        {
+            spi->setLines(1);
+        }
+    }
+
+#if W15Q64_STATS
+    if (spi->pStats != NULL)
+    {
+        W15Q64_StatsBusEnd(spi->pStats, opcode, startUs);
+    }
+#endif
 }
 //******************************************************************************
 
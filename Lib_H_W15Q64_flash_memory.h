@@ -30,6 +30,40 @@
 
 //******************************************************************************
 // Секция определения констант
+
+// Счетчики команд и задержек (см. Lib_H_W15Q64_stats.h), 1 - включены
+#ifndef W15Q64_STATS
+#define W15Q64_STATS                                      0
+#endif
+
+// Привязка порта на этапе компиляции, 1 - включена. Функции порта задаются
+// макросами в заголовочном файле W15Q64_PORT_HEADER:
+//      W15Q64_PORT_CS_ON()             - CS в "0"
+//      W15Q64_PORT_CS_OFF()            - CS в "1"
+//      W15Q64_PORT_TRANSMIT(pTx, cnt)  - передача cnt (uint32_t) байт
+//      W15Q64_PORT_RECEIVE(pRx, cnt)   - прием cnt (uint32_t) байт
+// Макросы (или static inline функции) встраиваются в W15Q64_Bus(), косвенных
+// вызовов на транзакцию нет. Порт используется для структур W15Q64spi_t с
+// sc_ON = NULL и transaction = NULL, остальные структуры работают через
+// указатели на функции, как и без этого режима. Порт один на сборку и
+// передает данные по одной линии. Заголовок по умолчанию
+// Lib_H_W15Q64_port.h подключает порт к модели микросхемы (образец для
+// своего порта, собирается тестами CMakeLists.txt)
+#ifndef W15Q64_STATIC_PORT
+#define W15Q64_STATIC_PORT                                0
+#endif
+#if W15Q64_STATIC_PORT && !defined(W15Q64_PORT_HEADER)
+#define W15Q64_PORT_HEADER                                "Lib_H_W15Q64_port.h"
+#endif
+
+// Параметры микросхемы на этапе компиляции, 1 - включены: объем
+// W15Q64_CAPACITY и длина адреса W15Q64_ADDR_BYTES, параметры SFDP
+// (spi->pDev) и spi->addrBytes для них не используются, и вычисления адреса
+// сворачиваются компилятором
+#ifndef W15Q64_STATIC_GEOMETRY
+#define W15Q64_STATIC_GEOMETRY                            0
+#endif
+
 // Standart SPI Instructions
 #define W15Q64_WRITE_ENABLE                               0x06
 #define W15Q64_VOLATILE_SR_WRITE_EN                       0x50
@@ -59,6 +93,8 @@
 #define W15Q64_RESET                                      0x99
 #define W15Q64_SET_READ_PARAMETERS                        0xC0
 #define W15Q64_BURST_READ_WITH_WRAP                       0x0C
+#define W15Q64_ENTER_4BYTE_ADDRESS_MODE                   0xB7 // Микросхемы > 16 MiB
+#define W15Q64_EXIT_4BYTE_ADDRESS_MODE                    0xE9
 
 // Dual SPI Instructions
 #define W15Q64_FAST_READ_DUAL_OUTPUT                      0x3B
@@ -79,6 +115,51 @@
 #define W15Q64_SECURITY_REGISTER_ADDRES_1                0x001000
 #define W15Q64_SECURITY_REGISTER_ADDRES_2                0x002000
 #define W15Q64_SECURITY_REGISTER_ADDRES_3                0x003000
+
+// Организация памяти
+#define W15Q64_PAGE_SIZE                                  256
+#define W15Q64_SECTOR_SIZE                                4096
+#define W15Q64_BLOCK_32KB_SIZE                            0x8000UL
+#define W15Q64_BLOCK_64KB_SIZE                            0x10000UL
+#ifndef W15Q64_CAPACITY
+#define W15Q64_CAPACITY                                   0x800000UL
+#endif
+#ifndef W15Q64_ADDR_BYTES
+#define W15Q64_ADDR_BYTES                                 ((W15Q64_CAPACITY > 0x1000000UL) ? 4 : 3)
+#endif
+
+// Упакованные Status Register 1 (младший байт) и 2 (старший байт), см.
+// W15Q64_ReadStatus()
+#define W15Q64_SR_BUSY                                    (1U << W15Q64_BUSY)
+#define W15Q64_SR_WEL                                     (1U << W15Q64_WEL)
+#define W15Q64_SR_QE                                      (1U << (8 + W15Q64_QE))
+#define W15Q64_SR_SUS                                     (1U << (8 + W15Q64_SUS))
+
+#define W15Q64_UNIQUE_ID_SIZE                             8
+
+// Направление передачи сегмента транзакции (см. W15Q64seg_t)
+#define W15Q64_SEG_TX                                     0
+#define W15Q64_SEG_RX                                     1
+#define W15Q64_SEG_DUMMY                                  2 // cnt - количество тактов
+
+// Биты M7-0, оставляющие микросхему в режиме Continuous Read (M5-4 = 10b)
+#define W15Q64_CONT_READ_MODE                             0x20
+
+// Количество линий данных, поддерживаемых портом (см. W15Q64spi_t.busWidths)
+#define W15Q64_BUS_DUAL                                   0x02
+#define W15Q64_BUS_QUAD                                   0x04
+
+// Поддерживаемая длина адреса (см. W15Q64dev_t.addrModes)
+#define W15Q64_ADDR_3BYTE                                 0x01
+#define W15Q64_ADDR_4BYTE                                 0x02
+
+// Способ входа в режим 4-Byte Address (см. W15Q64dev_t.enter4Byte)
+#define W15Q64_ENTER_4BYTE_B7                             0x01 // Инструкция B7h
+#define W15Q64_ENTER_4BYTE_WREN_B7                        0x02 // 06h, затем B7h
+
+// Количество типов стирания и команд чтения в W15Q64dev_t
+#define W15Q64_DEV_ERASE_TYPES                            4
+#define W15Q64_DEV_READ_TYPES                             4
 //******************************************************************************
 
 
@@ -106,6 +187,57 @@ enum W15Q64_statReg2 {
     W15Q64_CMP,
     W15Q64_SUS
 };
+
+typedef struct {
+    uint8_t *pData; //          Указатель на массив передаваемых или принимаемых данных
+    uint32_t cnt; //            Количество байт
+    uint8_t dir; //             W15Q64_SEG_TX, W15Q64_SEG_RX или W15Q64_SEG_DUMMY
+    uint8_t lines; //           Количество линий данных: 1 (0), 2 или 4
+} W15Q64seg_t; //       Сегмент транзакции на шине SPI: заголовок команды
+//                      (инструкция, адрес, dummy) или данные
+
+typedef void (* W15Q64done_t) (void *pCtx); //  Функция завершения асинхронной операции
+
+struct W15Q64stats_s;
+
+typedef void (* W15Q64modify_t) (void *pCtx,
+        uint32_t addr,
+        const uint8_t *pData,
+        uint32_t cnt); //   Функция, вызываемая драйвером после команды 
+//                          изменения памяти: pData != NULL - Page Program
+//                          (запрограммированные биты только сбрасываются),
+//                          pData = NULL - стирание cnt байт с адреса addr,
+//                          pData = NULL и cnt = 0 - стерта неизвестная
+//                          область (содержимое памяти не определено)
+
+typedef struct {
+    uint8_t instruct; //        Инструкция, 0 - тип не поддерживается
+    uint32_t size; //           Размер стираемой области в байтах
+    uint32_t typUs; //          Типовое время стирания
+    uint32_t maxUs; //          Максимальное время стирания
+} W15Q64eraseType_t;
+
+typedef struct {
+    uint8_t instruct; //        Инструкция, 0 - команда не поддерживается
+    uint8_t modeClocks; //      Тактов M7-0 после адреса
+    uint8_t dummyClocks; //     Тактов dummy после M7-0
+} W15Q64readType_t;
+
+typedef struct {
+    uint32_t capacity; //       Объем памяти в байтах
+    uint16_t pageSize; //       Размер страницы Page Program
+    uint8_t addrModes; //       W15Q64_ADDR_3BYTE | W15Q64_ADDR_4BYTE
+    uint8_t enter4Byte; //      W15Q64_ENTER_4BYTE_xxx, 0 - нет способа
+    W15Q64eraseType_t erase[W15Q64_DEV_ERASE_TYPES]; // Типы стирания 1 - 4
+    W15Q64readType_t read[W15Q64_DEV_READ_TYPES]; //    1-1-2, 1-2-2, 1-1-4, 1-4-4
+    uint32_t tPPtypUs; //       Page Program
+    uint32_t tPPmaxUs;
+    uint32_t tCEtypMs; //       Chip Erase
+    uint32_t tCEmaxMs;
+    uint32_t tSUSmaxUs; //      Задержка Suspend, 0 - Suspend не поддерживается
+    uint32_t tRSminUs; //       Интервал Resume -> Suspend
+} W15Q64dev_t; //   Структура содержит параметры микросхемы (см. 
+//                  W15Q64_SfdpProbe())
 //******************************************************************************
 
 
@@ -113,23 +245,84 @@ enum W15Q64_statReg2 {
 // Секция определения глобальных переменных
 
 typedef struct {
-    // Указатели на функции для работы с шиной SPI
+    // Указатели на функции для работы с шиной SPI (sc_ON = NULL - порт
+    // W15Q64_PORT_HEADER, см. W15Q64_STATIC_PORT)
     void (* transmit) (uint8_t *pTxData, uint16_t cnt);
     void (* receive) (uint8_t *pRxData, uint16_t cnt);
-//    void (* transmitReceive) (uint8_t *pTxData,
-//            uint8_t *pRxData,
-//            uint16_t cnt);
     void (* sc_ON) (void);
     void (* cs_OFF) (void);
+
+    // Необязательные поля. Если не используются, должны быть равны 0 (NULL)
+    void (* delay_us) (uint32_t us); // Задержка между опросами бита BUSY
+    uint32_t pollFirstUs; //            Задержка перед повторным опросом BUSY
+    uint32_t pollMaxUs; //              Предел задержки, при каждом опросе
+    //                                  задержка удваивается до этого значения
+    void (* transaction) (W15Q64seg_t *pSeg,
+            uint8_t segCnt); //         Вся транзакция одним вызовом: CS low,
+    //                                  сегменты по порядку, CS high
+    void (* transmitReceive) (uint8_t *pTxData,
+            uint8_t *pRxData,
+            uint32_t cnt); //           Полнодуплексный обмен с 32-битной длиной.
+    //                                  pTxData = NULL - передаются нули,
+    //                                  pRxData = NULL - принятые данные
+    //                                  отбрасываются
+    void (* transmitReceiveDMA) (uint8_t *pTxData,
+            uint8_t *pRxData,
+            uint32_t cnt); //           То же через DMA: функция только запускает
+    //                                  обмен, по его окончании порт должен
+    //                                  вызвать W15Q64_DmaComplete()
+    uint8_t busWidths; //               W15Q64_BUS_DUAL | W15Q64_BUS_QUAD: порт
+    //                                  умеет передавать данные по 2/4 линиям
+    //                                  (через transaction или setLines)
+    void (* setLines) (uint8_t lines); // Переключение количества линий для
+    //                                  следующих вызовов transmit/receive
+    _Bool dummyAsClocks; //             Порт принимает сегменты W15Q64_SEG_DUMMY
+    //                                  (cnt - количество тактов), иначе dummy
+    //                                  передаются байтами 0x00
+
+    // Служебные поля драйвера
+    volatile _Bool dmaBusy; //          Идет асинхронное чтение
+    uint8_t dmaLines; //                Линий данных асинхронного чтения
+    W15Q64done_t dmaDone;
+    void *pDmaCtx;
+    uint8_t readInstruct; //            Команда чтения, выбранная W15Q64_BusInit()
+    uint8_t contInstruct; //            Микросхема в режиме Continuous Read этой
+    //                                  команды, 0 - нет
+    W15Q64modify_t modify; //           Уведомление об изменении памяти (кэш)
+    void *pModifyCtx;
+    uint8_t holdLines; //               Открыто длинное чтение (W15Q64_ReadOpen()):
+    //                                  линий данных, 0 - нет
+    uint8_t addrBytes; //               Длина адреса в командах: 3 (0) или 4
+    //                                  (см. W15Q64_Addr4Byte())
+    const W15Q64dev_t *pDev; //         Параметры микросхемы (W15Q64_SfdpApply())
+    //                                  или NULL - параметры w25q64
+#if W15Q64_STATS
+    struct W15Q64stats_s *pStats; //    Счетчики (W15Q64_StatsAttach()) или NULL
+#endif
 } W15Q64spi_t; //       Стуктура содержит указатели на функции, обеспечивающие 
 //                      работу на шине SPI. Должны быть проинициализированы в
 //                      вызывающей функции
 
+typedef void (* W15Q64fill_t) (void *pCtx,
+        uint32_t addr,
+        uint8_t *pBuf,
+        uint16_t cnt); //   Функция заполнения буфера очередной страницы для
+//                          W15Q64_WriteStream(): в pBuf необходимо записать
+//                          cnt байт данных, предназначенных для адреса addr
+
 typedef struct {
     _Bool reg1[8]; //            Status Register 1 array
     _Bool reg2[8]; //            Status Register 2 array
 } W15Q64statRegs_t; //  Структура содержит два массива для хранения значений 
 //                      Status Register 1 and Status Register 2
+
+typedef struct {
+    uint8_t manufacturerId; //  JEDEC ID (9Fh): производитель (EFh - Winbond)
+    uint8_t memoryType;
+    uint8_t capacityCode; //    log2 объема в байтах (17h - 8 МБ)
+    uint8_t uniqueId[W15Q64_UNIQUE_ID_SIZE]; // Read Unique ID (4Bh)
+    uint16_t status; //         Status Register 1 и 2 (см. W15Q64_SR_BUSY)
+} W15Q64id_t; //    Структура содержит результат W15Q64_Probe()
 //******************************************************************************
 
 
@@ -143,6 +336,10 @@ extern void W15Q64_PageProg(W15Q64spi_t *spi,
         uint32_t addr,
         uint8_t *pTxData,
         uint16_t cnt);
+extern void W15Q64_ReadSfdp(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint16_t cnt);
 extern void W15Q64_ReadSecReg(W15Q64spi_t *spi,
         uint32_t addr,
         uint8_t *pRxData,
@@ -153,6 +350,45 @@ extern void W15Q64_FastReadData(W15Q64spi_t *spi,
         uint32_t addr,
         uint8_t *pRxData,
         uint16_t cnt);
+extern void W15Q64_FastReadData32(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern _Bool W15Q64_FastReadDataDMA(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt,
+        W15Q64done_t done,
+        void *pCtx);
+extern void W15Q64_DmaComplete(W15Q64spi_t *spi);
+extern void W15Q64_FastReadMulti(W15Q64spi_t *spi,
+        uint8_t instruct,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_FastReadAuto(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern _Bool W15Q64_QuadEnable(W15Q64spi_t *spi,
+        _Bool enable);
+extern uint8_t W15Q64_BusInit(W15Q64spi_t *spi);
+extern void W15Q64_FastReadCont(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_ContReadExit(W15Q64spi_t *spi);
+extern _Bool W15Q64_ReadOpen(W15Q64spi_t *spi,
+        uint32_t addr);
+extern void W15Q64_ReadNext(W15Q64spi_t *spi,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern _Bool W15Q64_ReadNextDMA(W15Q64spi_t *spi,
+        uint8_t *pRxData,
+        uint32_t cnt,
+        W15Q64done_t done,
+        void *pCtx);
+extern void W15Q64_ReadClose(W15Q64spi_t *spi);
 extern void W15Q64_Erase(W15Q64spi_t *spi,
         uint32_t addr,
         uint8_t txInstruct);
@@ -168,11 +404,44 @@ extern void W15Q64_EraseProgram_Resume(W15Q64spi_t *spi);
 extern void W15Q64_PowerDown(W15Q64spi_t *spi);
 extern void W15Q64_ReleasePowerDown(W15Q64spi_t *spi);
 extern uint8_t W15Q64_DeviceID(W15Q64spi_t *spi);
+extern uint8_t W15Q64_ReadStatReg(W15Q64spi_t *spi,
+        uint8_t instruct);
+extern uint16_t W15Q64_ReadStatus(W15Q64spi_t *spi);
+extern void W15Q64_WriteStatus(W15Q64spi_t *spi,
+        uint16_t status);
+extern uint8_t W15Q64_PollStatus(W15Q64spi_t *spi);
+extern _Bool W15Q64_IsBusy(W15Q64spi_t *spi);
+extern _Bool W15Q64_Probe(W15Q64spi_t *spi,
+        W15Q64id_t *pId);
+extern uint32_t W15Q64_WaitBusy(W15Q64spi_t *spi);
+extern void W15Q64_Addr4Byte(W15Q64spi_t *spi,
+        _Bool enable);
+extern uint32_t W15Q64_Capacity(W15Q64spi_t *spi);
+extern uint16_t W15Q64_PageSize(W15Q64spi_t *spi);
+extern uint32_t W15Q64_EraseSize(W15Q64spi_t *spi,
+        uint8_t instruct);
+extern void W15Q64_Transaction(W15Q64spi_t *spi,
+        W15Q64seg_t *pSeg,
+        uint8_t segCnt);
+extern void W15Q64_Write(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pTxData,
+        uint32_t cnt);
+extern void W15Q64_WriteStream(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint32_t cnt,
+        W15Q64fill_t fill,
+        void *pCtx);
 //******************************************************************************
 
 
 //******************************************************************************
 // Секция определения макросов
+
+// Проверка битов упакованных регистров (W15Q64_ReadStatus(),
+// W15Q64_PollStatus())
+#define W15Q64_STATUS_BUSY(status)                        (((status) & W15Q64_SR_BUSY) != 0)
+#define W15Q64_STATUS_WEL(status)                         (((status) & W15Q64_SR_WEL) != 0)
 //******************************************************************************
 
 #endif
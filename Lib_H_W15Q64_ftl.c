@@ -0,0 +1,735 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_ftl.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Журнальный слой логических блоков (FTL) на микросхеме flash
+ *              памяти w15q64
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_ftl.h"
+#include "Lib_H_W15Q64_verify.h"
+#include "Lib_H_W15Q64_job.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static _Bool W15Q64_FtlCollect(W15Q64ftl_t *ftl,
+                               _Bool background);
+static uint16_t W15Q64_FtlPickVictim(W15Q64ftl_t *ftl,
+                                     _Bool background);
+static _Bool W15Q64_FtlAppend(W15Q64ftl_t *ftl,
+                              uint16_t lba,
+                              const uint8_t *pData);
+static uint16_t W15Q64_FtlAlloc(W15Q64ftl_t *ftl);
+static _Bool W15Q64_FtlHeadReady(W15Q64ftl_t *ftl);
+static _Bool W15Q64_FtlNeedCollect(W15Q64ftl_t *ftl);
+static _Bool W15Q64_FtlFinishErase(W15Q64ftl_t *ftl,
+                                   _Bool wait);
+static _Bool W15Q64_FtlSuspend(W15Q64ftl_t *ftl);
+static void W15Q64_FtlResume(W15Q64ftl_t *ftl);
+static void W15Q64_FtlFormat(W15Q64ftl_t *ftl,
+                             uint16_t sector);
+static void W15Q64_FtlWriteHeader(W15Q64ftl_t *ftl,
+                                  uint16_t sector);
+static _Bool W15Q64_FtlHeaderOk(const uint8_t *pMeta);
+static _Bool W15Q64_FtlEntryOk(const uint8_t *pEntry);
+static uint32_t W15Q64_FtlPageSeq(W15Q64ftl_t *ftl,
+                                  uint16_t page);
+static uint32_t W15Q64_FtlAddr(W15Q64ftl_t *ftl,
+                               uint16_t sector,
+                               uint8_t page);
+static uint32_t W15Q64_FtlCrc(const uint8_t *pData,
+                              uint32_t cnt);
+static uint32_t W15Q64_FtlGet32(const uint8_t *p);
+static void W15Q64_FtlPut32(uint8_t *p,
+                            uint32_t val);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция задает область микросхемы и массивы состояния слоя
+ *          логических блоков. После нее вызывается W15Q64_FtlMount()
+ *  @param  *ftl:   Указатель на структуру слоя
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  start:  Адрес области, кратен 4 КБ
+ *  @param  sectorCnt:  Количество секторов области
+ *  @param  *pSectors:  Массив на sectorCnt элементов
+ *  @param  *pMap:  Массив на lbaCnt элементов
+ *  @param  lbaCnt: Количество логических блоков
+ *  @retval true - параметры допустимы
+ */
+_Bool W15Q64_FtlInit(W15Q64ftl_t *ftl,
+                     W15Q64spi_t *spi,
+                     uint32_t start,
+                     uint16_t sectorCnt,
+                     W15Q64ftlSector_t *pSectors,
+                     uint16_t *pMap,
+                     uint16_t lbaCnt)
+{
+    if (((start & (W15Q64_SECTOR_SIZE - 1)) != 0)
+        || (sectorCnt < 3) || (sectorCnt > W15Q64_FTL_MAX_SECTORS)
+        || (lbaCnt == 0)
+        || (lbaCnt > (uint32_t) (sectorCnt - 2) * W15Q64_FTL_DATA_PAGES)
+        || (start + (uint32_t) sectorCnt * W15Q64_SECTOR_SIZE > W15Q64_Capacity(spi)))
+    {
+        return false;
+    }
+
+    memset(ftl, 0, sizeof (*ftl));
+    ftl->spi = spi;
+    ftl->start = start;
+    ftl->sectorCnt = sectorCnt;
+    ftl->lbaCnt = lbaCnt;
+    ftl->pSectors = pSectors;
+    ftl->pMap = pMap;
+    ftl->gcFree = W15Q64_FTL_GC_FREE;
+    ftl->wearDelta = W15Q64_FTL_WEAR_DELTA;
+    ftl->head = W15Q64_FTL_NONE;
+    ftl->victim = W15Q64_FTL_NONE;
+    ftl->erasing = W15Q64_FTL_NONE;
+    return true;
+}
+
+/**
+ *  @brief  Функция восстанавливает таблицу блоков по микросхеме: читает
+ *          страницу 0 каждого сектора и данные версий, которые новее уже
+ *          найденных. Сектора без действительного заголовка (чистая
+ *          микросхема, прерванное стирание) стираются
+ *  @param  *ftl:   Указатель на структуру слоя
+ *  @retval None
+ */
+void W15Q64_FtlMount(W15Q64ftl_t *ftl)
+{
+    W15Q64ftlSector_t *sec;
+    const uint8_t *pEntry;
+    uint32_t seq,
+            lba,
+            maxSeq = 0,
+            maxErase = 0;
+    uint16_t s;
+    uint8_t i;
+    _Bool found = false;
+
+    for (lba = 0; lba < ftl->lbaCnt; lba++)
+    {
+        ftl->pMap[lba] = W15Q64_FTL_NONE;
+    }
+    ftl->head = W15Q64_FTL_NONE;
+    ftl->victim = W15Q64_FTL_NONE;
+    ftl->erasing = W15Q64_FTL_NONE;
+    ftl->freeCnt = 0;
+
+    for (s = 0; s < ftl->sectorCnt; s++)
+    {
+        sec = &ftl->pSectors[s];
+        sec->used = 0;
+        sec->valid = 0;
+        W15Q64_FastReadData(ftl->spi, W15Q64_FtlAddr(ftl, s, 0), ftl->meta, W15Q64_PAGE_SIZE);
+        if (!W15Q64_FtlHeaderOk(ftl->meta))
+        {
+            sec->state = W15Q64_FTL_SECTOR_ERASE;
+            sec->eraseCnt = 0;
+            continue;
+        }
+        sec->eraseCnt = W15Q64_FtlGet32(&ftl->meta[4]);
+        if (sec->eraseCnt > maxErase)
+        {
+            maxErase = sec->eraseCnt;
+        }
+
+        // Записи программируются по порядку, первая чистая - конец сектора
+        for (i = 0; i < W15Q64_FTL_DATA_PAGES; i++)
+        {
+            pEntry = &ftl->meta[W15Q64_FTL_ENTRY_SIZE * (i + 1)];
+            if ((W15Q64_FtlGet32(&pEntry[0]) == 0xFFFFFFFFUL)
+                && (W15Q64_FtlGet32(&pEntry[4]) == 0xFFFFFFFFUL)
+                && (W15Q64_FtlGet32(&pEntry[8]) == 0xFFFFFFFFUL)
+                && (W15Q64_FtlGet32(&pEntry[12]) == 0xFFFFFFFFUL))
+            {
+                break;
+            }
+            sec->used = (uint8_t) (i + 1);
+            if (!W15Q64_FtlEntryOk(pEntry))
+            {
+                continue;
+            }
+            seq = W15Q64_FtlGet32(&pEntry[0]);
+            lba = W15Q64_FtlGet32(&pEntry[4]);
+            if ((!found) || (seq > maxSeq))
+            {
+                maxSeq = seq;
+                ftl->head = s;
+                found = true;
+            }
+            if ((lba >= ftl->lbaCnt)
+                || ((ftl->pMap[lba] != W15Q64_FTL_NONE)
+                    && (seq <= W15Q64_FtlPageSeq(ftl, ftl->pMap[lba]))))
+            {
+                continue;
+            }
+
+            // Данные версии могли не дописаться
+            W15Q64_FastReadData(ftl->spi, W15Q64_FtlAddr(ftl, s, (uint8_t) (i + 1)),
+                                ftl->page, W15Q64_PAGE_SIZE);
+            if (W15Q64_FtlCrc(ftl->page, W15Q64_PAGE_SIZE) != W15Q64_FtlGet32(&pEntry[8]))
+            {
+                ftl->stats.dropped++;
+                continue;
+            }
+            ftl->pMap[lba] = (uint16_t) (s * W15Q64_FTL_PAGES + i + 1);
+        }
+        sec->state = (sec->used != 0) ? W15Q64_FTL_SECTOR_USED : W15Q64_FTL_SECTOR_FREE;
+    }
+
+    for (lba = 0; lba < ftl->lbaCnt; lba++)
+    {
+        if (ftl->pMap[lba] != W15Q64_FTL_NONE)
+        {
+            ftl->pSectors[ftl->pMap[lba] / W15Q64_FTL_PAGES].valid++;
+        }
+    }
+    for (s = 0; s < ftl->sectorCnt; s++)
+    {
+        sec = &ftl->pSectors[s];
+        if (sec->state == W15Q64_FTL_SECTOR_ERASE)
+        {
+            sec->eraseCnt = maxErase; //    Счетчик стираний потерян
+            W15Q64_FtlFormat(ftl, s);
+        }
+        if (sec->state == W15Q64_FTL_SECTOR_FREE)
+        {
+            ftl->freeCnt++;
+        }
+    }
+    if ((ftl->head != W15Q64_FTL_NONE)
+        && (ftl->pSectors[ftl->head].used >= W15Q64_FTL_DATA_PAGES))
+    {
+        ftl->head = W15Q64_FTL_NONE;
+    }
+    ftl->seq = found ? (maxSeq + 1) : 1;
+}
+
+/**
+ *  @brief  Функция записывает новую версию логического блока
+ *  @param  *ftl:   Указатель на структуру слоя
+ *  @param  lba:    Номер логического блока
+ *  @param  *pData: Данные блока, W15Q64_PAGE_SIZE байт
+ *  @retval W15Q64_FTL_OK, W15Q64_FTL_ERR_LBA, W15Q64_FTL_ERR_FULL
+ */
+uint8_t W15Q64_FtlWrite(W15Q64ftl_t *ftl,
+                        uint16_t lba,
+                        const uint8_t *pData)
+{
+    _Bool suspended,
+            ok;
+
+    if (lba >= ftl->lbaCnt)
+    {
+        return W15Q64_FTL_ERR_LBA;
+    }
+    ftl->stats.writes++;
+
+    // Последний свободный сектор оставляется для переноса блоков. Начатый
+    // перенос заканчивается до записи (ему нужны страницы сектора записи),
+    // если резерва нет (пропадание питания во время переноса) - создается.
+    // Только в этом случае запись ждет окончания фонового стирания
+    if (W15Q64_FtlNeedCollect(ftl))
+    {
+        ftl->stats.fgCollects++;
+        while (W15Q64_FtlNeedCollect(ftl) && W15Q64_FtlCollect(ftl, false))
+        {
+        }
+        if ((ftl->freeCnt == 0) || ((!W15Q64_FtlHeadReady(ftl)) && (ftl->freeCnt <= 1)))
+        {
+            return W15Q64_FTL_ERR_FULL;
+        }
+    }
+    suspended = W15Q64_FtlSuspend(ftl);
+    ok = W15Q64_FtlAppend(ftl, lba, pData);
+    if (suspended)
+    {
+        W15Q64_FtlResume(ftl);
+    }
+    return ok ? W15Q64_FTL_OK : W15Q64_FTL_ERR_FULL;
+}
+
+/**
+ *  @brief  Функция читает последнюю версию логического блока
+ *  @param  *ftl:   Указатель на структуру слоя
+ *  @param  lba:    Номер логического блока
+ *  @param  *pRxData:   Буфер на W15Q64_PAGE_SIZE байт
+ *  @retval true - блок записывался, false - буфер заполнен 0xFF
+ */
+_Bool W15Q64_FtlRead(W15Q64ftl_t *ftl,
+                     uint16_t lba,
+                     uint8_t *pRxData)
+{
+    uint16_t page;
+    _Bool suspended;
+
+    if ((lba >= ftl->lbaCnt) || (ftl->pMap[lba] == W15Q64_FTL_NONE))
+    {
+        memset(pRxData, 0xFF, W15Q64_PAGE_SIZE);
+        return false;
+    }
+    suspended = W15Q64_FtlSuspend(ftl);
+    page = ftl->pMap[lba];
+    W15Q64_FastReadData(ftl->spi,
+                        W15Q64_FtlAddr(ftl, page / W15Q64_FTL_PAGES,
+                                       (uint8_t) (page % W15Q64_FTL_PAGES)),
+                        pRxData, W15Q64_PAGE_SIZE);
+    if (suspended)
+    {
+        W15Q64_FtlResume(ftl);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция выполняет один шаг фоновой сборки мусора: перенос одной
+ *          страницы, запуск стирания или проверку его окончания. Вызывается
+ *          из главного цикла (задачи) в свободное время
+ *  @param  *ftl:   Указатель на структуру слоя
+ *  @retval true - работа не закончена
+ */
+_Bool W15Q64_FtlPoll(W15Q64ftl_t *ftl)
+{
+    return W15Q64_FtlCollect(ftl, true);
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция выполняет один шаг сборки мусора. При background = false
+ *          стирание выполняется с ожиданием
+ *  @retval true - шаг выполнен, false - сборка не требуется или невозможна
+ */
+static _Bool W15Q64_FtlCollect(W15Q64ftl_t *ftl,
+                               _Bool background)
+{
+    const uint8_t *pEntry;
+    uint32_t lba;
+    uint16_t page;
+    uint8_t i;
+
+    if (ftl->erasing != W15Q64_FTL_NONE)
+    {
+        W15Q64_FtlFinishErase(ftl, !background);
+        return true;
+    }
+    if (ftl->victim == W15Q64_FTL_NONE)
+    {
+        ftl->victim = W15Q64_FtlPickVictim(ftl, background);
+        if (ftl->victim == W15Q64_FTL_NONE)
+        {
+            return false;
+        }
+        ftl->victimPage = 0;
+        W15Q64_FastReadData(ftl->spi, W15Q64_FtlAddr(ftl, ftl->victim, 0),
+                            ftl->meta, W15Q64_PAGE_SIZE);
+    }
+
+    // Перенос следующей действительной страницы
+    while (ftl->victimPage < ftl->pSectors[ftl->victim].used)
+    {
+        i = ftl->victimPage++;
+        pEntry = &ftl->meta[W15Q64_FTL_ENTRY_SIZE * (i + 1)];
+        lba = W15Q64_FtlGet32(&pEntry[4]);
+        page = (uint16_t) (ftl->victim * W15Q64_FTL_PAGES + i + 1);
+        if ((!W15Q64_FtlEntryOk(pEntry)) || (lba >= ftl->lbaCnt) || (ftl->pMap[lba] != page))
+        {
+            continue;
+        }
+        W15Q64_FastReadData(ftl->spi, W15Q64_FtlAddr(ftl, ftl->victim, (uint8_t) (i + 1)),
+                            ftl->page, W15Q64_PAGE_SIZE);
+        if (!W15Q64_FtlAppend(ftl, (uint16_t) lba, ftl->page))
+        {
+            ftl->victimPage--;
+            return false;
+        }
+        ftl->stats.gcCopies++;
+        return true;
+    }
+
+    // Признак в заголовке: при прерванном стирании сектор будет стерт заново
+    ftl->page[0] = 0x00;
+    W15Q64_PageProg(ftl->spi, W15Q64_FtlAddr(ftl, ftl->victim, 0) + 12, ftl->page, 1);
+    W15Q64_WaitBusy(ftl->spi);
+    W15Q64_Erase(ftl->spi, W15Q64_FtlAddr(ftl, ftl->victim, 0), W15Q64_SECTOR_ERASE_4KB);
+    ftl->pSectors[ftl->victim].state = W15Q64_FTL_SECTOR_ERASE;
+    ftl->erasing = ftl->victim;
+    ftl->victim = W15Q64_FTL_NONE;
+    if (!background)
+    {
+        W15Q64_FtlFinishErase(ftl, true);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция выбирает сектор для сборки мусора: с наименьшим числом
+ *          действительных страниц, а в фоне - также полностью
+ *          недействительный сектор или сектор с наименьшим счетчиком
+ *          стираний для выравнивания износа
+ */
+static uint16_t W15Q64_FtlPickVictim(W15Q64ftl_t *ftl,
+                                     _Bool background)
+{
+    const W15Q64ftlSector_t *sec;
+    uint32_t maxErase = 0;
+    uint16_t s,
+            best = W15Q64_FTL_NONE,
+            stale = W15Q64_FTL_NONE,
+            cold = W15Q64_FTL_NONE;
+
+    for (s = 0; s < ftl->sectorCnt; s++)
+    {
+        sec = &ftl->pSectors[s];
+        if (sec->eraseCnt > maxErase)
+        {
+            maxErase = sec->eraseCnt;
+        }
+        if ((sec->state != W15Q64_FTL_SECTOR_USED) || (s == ftl->head))
+        {
+            continue;
+        }
+        if ((sec->used > sec->valid)
+            && ((best == W15Q64_FTL_NONE) || (sec->valid < ftl->pSectors[best].valid)))
+        {
+            best = s;
+        }
+        if ((sec->valid == 0) && (sec->used == W15Q64_FTL_DATA_PAGES))
+        {
+            stale = s;
+        }
+        if ((cold == W15Q64_FTL_NONE) || (sec->eraseCnt < ftl->pSectors[cold].eraseCnt))
+        {
+            cold = s;
+        }
+    }
+
+    if (!background)
+    {
+        return best;
+    }
+    if (stale != W15Q64_FTL_NONE)
+    {
+        return stale;
+    }
+    if ((cold != W15Q64_FTL_NONE) && (ftl->freeCnt >= 2)
+        && (maxErase - ftl->pSectors[cold].eraseCnt > ftl->wearDelta))
+    {
+        ftl->stats.wearMoves++;
+        return cold;
+    }
+    return (ftl->freeCnt < ftl->gcFree) ? best : W15Q64_FTL_NONE;
+}
+
+/**
+ *  @brief  Функция записывает версию блока в следующую страницу сектора
+ *          записи: сначала запись о странице, затем данные
+ *  @retval false - нет свободного сектора
+ */
+static _Bool W15Q64_FtlAppend(W15Q64ftl_t *ftl,
+                              uint16_t lba,
+                              const uint8_t *pData)
+{
+    W15Q64ftlSector_t *sec;
+    uint8_t entry[W15Q64_FTL_ENTRY_SIZE];
+    uint16_t old;
+    uint8_t i;
+
+    if (!W15Q64_FtlHeadReady(ftl))
+    {
+        ftl->head = W15Q64_FtlAlloc(ftl);
+        if (ftl->head == W15Q64_FTL_NONE)
+        {
+            return false;
+        }
+    }
+    sec = &ftl->pSectors[ftl->head];
+    i = sec->used;
+
+    W15Q64_FtlPut32(&entry[0], ftl->seq);
+    W15Q64_FtlPut32(&entry[4], lba);
+    W15Q64_FtlPut32(&entry[8], W15Q64_FtlCrc(pData, W15Q64_PAGE_SIZE));
+    W15Q64_FtlPut32(&entry[12], W15Q64_FtlCrc(entry, 12));
+    W15Q64_PageProg(ftl->spi, W15Q64_FtlAddr(ftl, ftl->head, 0) + W15Q64_FTL_ENTRY_SIZE * (i + 1UL),
+                    entry, W15Q64_FTL_ENTRY_SIZE);
+    W15Q64_WaitBusy(ftl->spi);
+    // Логическая страница пишется частями по странице микросхемы
+    W15Q64_Write(ftl->spi, W15Q64_FtlAddr(ftl, ftl->head, (uint8_t) (i + 1)),
+                 (uint8_t *) pData, W15Q64_PAGE_SIZE);
+    ftl->seq++;
+    sec->used++;
+
+    old = ftl->pMap[lba];
+    if (old != W15Q64_FTL_NONE)
+    {
+        ftl->pSectors[old / W15Q64_FTL_PAGES].valid--;
+    }
+    ftl->pMap[lba] = (uint16_t) (ftl->head * W15Q64_FTL_PAGES + i + 1);
+    sec->valid++;
+    ftl->stats.programs++;
+    return true;
+}
+
+/**
+ *  @brief  Функция выбирает свободный сектор с наименьшим счетчиком стираний
+ */
+static uint16_t W15Q64_FtlAlloc(W15Q64ftl_t *ftl)
+{
+    uint16_t s,
+            best = W15Q64_FTL_NONE;
+
+    for (s = 0; s < ftl->sectorCnt; s++)
+    {
+        if ((ftl->pSectors[s].state == W15Q64_FTL_SECTOR_FREE)
+            && ((best == W15Q64_FTL_NONE)
+                || (ftl->pSectors[s].eraseCnt < ftl->pSectors[best].eraseCnt)))
+        {
+            best = s;
+        }
+    }
+    if (best != W15Q64_FTL_NONE)
+    {
+        ftl->pSectors[best].state = W15Q64_FTL_SECTOR_USED;
+        ftl->freeCnt--;
+    }
+    return best;
+}
+
+static _Bool W15Q64_FtlHeadReady(W15Q64ftl_t *ftl)
+{
+    return (ftl->head != W15Q64_FTL_NONE)
+            && (ftl->pSectors[ftl->head].used < W15Q64_FTL_DATA_PAGES);
+}
+
+/**
+ *  @brief  Функция проверяет, что перед записью блока нужна сборка мусора
+ */
+static _Bool W15Q64_FtlNeedCollect(W15Q64ftl_t *ftl)
+{
+    return (ftl->freeCnt == 0)
+            || ((ftl->freeCnt == 1)
+                && ((ftl->victim != W15Q64_FTL_NONE) || (!W15Q64_FtlHeadReady(ftl))));
+}
+
+/**
+ *  @brief  Функция завершает запущенное стирание: записывает заголовок и
+ *          отмечает сектор свободным
+ *  @param  wait:   true - ждать окончания стирания
+ *  @retval true - стирание завершено (или не запускалось)
+ */
+static _Bool W15Q64_FtlFinishErase(W15Q64ftl_t *ftl,
+                                   _Bool wait)
+{
+    W15Q64ftlSector_t *sec;
+
+    if (ftl->erasing == W15Q64_FTL_NONE)
+    {
+        return true;
+    }
+    if ((!wait)
+        && ((W15Q64_ReadStatReg(ftl->spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_1)
+             & (1 << W15Q64_BUSY)) != 0))
+    {
+        return false;
+    }
+    W15Q64_WaitBusy(ftl->spi);
+
+    sec = &ftl->pSectors[ftl->erasing];
+    sec->eraseCnt++;
+    W15Q64_FtlWriteHeader(ftl, ftl->erasing);
+    sec->state = W15Q64_FTL_SECTOR_FREE;
+    sec->used = 0;
+    sec->valid = 0;
+    ftl->freeCnt++;
+    ftl->stats.erases++;
+    ftl->erasing = W15Q64_FTL_NONE;
+    return true;
+}
+
+/**
+ *  @brief  Функция освобождает шину от фонового стирания перед чтением или
+ *          записью блока: завершает его, если оно закончилось, иначе
+ *          отправляет Erase Suspend (не раньше, чем через tRS после
+ *          последнего Resume). Без часов now_us или если микросхема не
+ *          поддерживает Suspend (W15Q64_JobTsusUs() = 0) ждет окончания
+ *          стирания
+ *  @retval true - стирание приостановлено, нужен W15Q64_FtlResume()
+ */
+static _Bool W15Q64_FtlSuspend(W15Q64ftl_t *ftl)
+{
+    if (ftl->erasing == W15Q64_FTL_NONE)
+    {
+        return false;
+    }
+    if ((ftl->now_us == NULL) || (W15Q64_JobTsusUs(ftl->spi) == 0))
+    {
+        W15Q64_FtlFinishErase(ftl, true);
+        return false;
+    }
+    do
+    {
+        if (W15Q64_FtlFinishErase(ftl, false))
+        {
+            return false;
+        }
+    } while ((uint32_t) (ftl->now_us() - ftl->resumeUs) <= W15Q64_JobTrsUs(ftl->spi));
+
+    // BUSY остается в "1" в течение tSUS после Suspend
+    W15Q64_EraseProgram_Suspend(ftl->spi);
+    if (ftl->spi->delay_us != NULL)
+    {
+        ftl->spi->delay_us(W15Q64_JobTsusUs(ftl->spi));
+    }
+    W15Q64_WaitBusy(ftl->spi);
+    ftl->stats.suspends++;
+    return true;
+}
+
+static void W15Q64_FtlResume(W15Q64ftl_t *ftl)
+{
+    W15Q64_EraseProgram_Resume(ftl->spi);
+    ftl->resumeUs = ftl->now_us();
+}
+
+/**
+ *  @brief  Функция стирает сектор (если он не чистый) и записывает заголовок
+ */
+static void W15Q64_FtlFormat(W15Q64ftl_t *ftl,
+                             uint16_t sector)
+{
+    W15Q64ftlSector_t *sec = &ftl->pSectors[sector];
+    uint32_t addr = W15Q64_FtlAddr(ftl, sector, 0);
+
+    if (!W15Q64_BlankCheck(ftl->spi, addr, W15Q64_SECTOR_SIZE, NULL))
+    {
+        W15Q64_Erase(ftl->spi, addr, W15Q64_SECTOR_ERASE_4KB);
+        W15Q64_WaitBusy(ftl->spi);
+        sec->eraseCnt++;
+        ftl->stats.erases++;
+    }
+    W15Q64_FtlWriteHeader(ftl, sector);
+    sec->state = W15Q64_FTL_SECTOR_FREE;
+    sec->used = 0;
+    sec->valid = 0;
+}
+
+/**
+ *  @brief  Функция записывает заголовок стертого сектора: признак, счетчик
+ *          стираний, CRC32 (байт 12 - признак начатого стирания)
+ */
+static void W15Q64_FtlWriteHeader(W15Q64ftl_t *ftl,
+                                  uint16_t sector)
+{
+    uint8_t hdr[W15Q64_FTL_ENTRY_SIZE];
+
+    memset(hdr, 0xFF, sizeof (hdr));
+    W15Q64_FtlPut32(&hdr[0], W15Q64_FTL_MAGIC);
+    W15Q64_FtlPut32(&hdr[4], ftl->pSectors[sector].eraseCnt);
+    W15Q64_FtlPut32(&hdr[8], W15Q64_FtlCrc(hdr, 8));
+    W15Q64_PageProg(ftl->spi, W15Q64_FtlAddr(ftl, sector, 0), hdr, sizeof (hdr));
+    W15Q64_WaitBusy(ftl->spi);
+}
+
+static _Bool W15Q64_FtlHeaderOk(const uint8_t *pMeta)
+{
+    return (W15Q64_FtlGet32(&pMeta[0]) == W15Q64_FTL_MAGIC)
+            && (W15Q64_FtlGet32(&pMeta[8]) == W15Q64_FtlCrc(pMeta, 8))
+            && (pMeta[12] == 0xFF);
+}
+
+static _Bool W15Q64_FtlEntryOk(const uint8_t *pEntry)
+{
+    return W15Q64_FtlGet32(&pEntry[12]) == W15Q64_FtlCrc(pEntry, 12);
+}
+
+/**
+ *  @brief  Функция читает номер версии страницы из записи в ее секторе
+ */
+static uint32_t W15Q64_FtlPageSeq(W15Q64ftl_t *ftl,
+                                  uint16_t page)
+{
+    uint8_t seq[4];
+
+    W15Q64_FastReadData(ftl->spi,
+                        W15Q64_FtlAddr(ftl, page / W15Q64_FTL_PAGES, 0)
+                        + W15Q64_FTL_ENTRY_SIZE * (page % W15Q64_FTL_PAGES),
+                        seq, sizeof (seq));
+    return W15Q64_FtlGet32(seq);
+}
+
+static uint32_t W15Q64_FtlAddr(W15Q64ftl_t *ftl,
+                               uint16_t sector,
+                               uint8_t page)
+{
+    return ftl->start + (uint32_t) sector * W15Q64_SECTOR_SIZE
+            + (uint32_t) page * W15Q64_PAGE_SIZE;
+}
+
+/**
+ *  @brief  Функция вычисляет CRC-32 (полином 0x04C11DB7, отраженный)
+ */
+static uint32_t W15Q64_FtlCrc(const uint8_t *pData,
+                              uint32_t cnt)
+{
+    uint32_t crc = 0xFFFFFFFFUL;
+    uint8_t k;
+
+    while (cnt-- != 0)
+    {
+        crc ^= *pData++;
+        for (k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t W15Q64_FtlGet32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8)
+            | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void W15Q64_FtlPut32(uint8_t *p,
+                            uint32_t val)
+{
+    p[0] = (uint8_t) val;
+    p[1] = (uint8_t) (val >> 8);
+    p[2] = (uint8_t) (val >> 16);
+    p[3] = (uint8_t) (val >> 24);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
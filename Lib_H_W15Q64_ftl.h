@@ -0,0 +1,163 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_ftl.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Журнальный слой логических блоков (FTL) на микросхеме flash
+ *              памяти w15q64: запись без стирания на месте, сборка мусора и
+ *              выравнивание износа секторов
+ *  @warning    Логический блок - одна страница (256 байт). Новая версия
+ *              блока записывается в следующую свободную страницу области
+ *              (W15Q64_PageProg()), старая становится недействительной,
+ *              поэтому запись занимает время программирования, а не
+ *              стирания. Таблица логический -> физический блок хранится в
+ *              ОЗУ и восстанавливается W15Q64_FtlMount() по микросхеме.
+ *
+ *              Разметка сектора 4 КБ: страница 0 - заголовок (признак,
+ *              счетчик стираний) и 15 записей о страницах данных 1..15
+ *              (номер версии, номер блока, CRC32 данных). Запись о странице
+ *              программируется до ее данных, поэтому после пропадания питания:
+ *              - страница без записи никогда не программировалась;
+ *              - при несовпадении CRC записи или данных версия отбрасывается и
+ *                используется предыдущая;
+ *              - сектор, стирание которого было прервано, отмечен признаком
+ *                перед стиранием и стирается повторно.
+ *
+ *              Сборка мусора переносит действительные блоки сектора с
+ *              наименьшим их числом и стирает его. W15Q64_FtlPoll()
+ *              выполняет ее по шагам в фоне (одна страница или проверка
+ *              BUSY за вызов, стирание без ожидания), пока свободных
+ *              секторов меньше gcFree. Если свободным остался один сектор
+ *              (резерв для переноса), запись выполняет сборку сама.
+ *              Новый сектор выбирается с наименьшим счетчиком стираний; если
+ *              разница счетчиков больше wearDelta, фоновая сборка переносит
+ *              сектор с редко изменяемыми данными (статическое выравнивание).
+ *              Если задана функция now_us, чтение и запись во время
+ *              фонового стирания приостанавливают его (Erase Suspend, Page
+ *              Program в другой сектор допускается) и возобновляют после
+ *              операции; следующий Suspend - не раньше, чем через tRS после
+ *              Resume (W15Q64_JobTrsUs()), чтобы стирание продвигалось.
+ *              Без now_us чтение и запись ждут окончания стирания.
+ *
+ *              Число блоков lbaCnt не больше (sectorCnt - 2) * 15, число
+ *              секторов не больше W15Q64_FTL_MAX_SECTORS.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_FTL_H
+#define	LIB_H_W15Q64_FTL_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_FTL_MAGIC                                  0x314C5446UL // "FTL1"
+#define W15Q64_FTL_PAGES                                  (W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE)
+#define W15Q64_FTL_DATA_PAGES                             (W15Q64_FTL_PAGES - 1)
+#define W15Q64_FTL_ENTRY_SIZE                             16
+#define W15Q64_FTL_MAX_SECTORS                            4095
+#define W15Q64_FTL_NONE                                   0xFFFF
+
+// Значения по умолчанию для W15Q64_FtlInit()
+#define W15Q64_FTL_GC_FREE                                3 //  Свободных секторов
+#define W15Q64_FTL_WEAR_DELTA                             64 // Стираний
+
+// Состояние сектора
+#define W15Q64_FTL_SECTOR_FREE                            0
+#define W15Q64_FTL_SECTOR_USED                            1
+#define W15Q64_FTL_SECTOR_ERASE                           2 //  Требует стирания
+
+// Результат W15Q64_FtlWrite()
+#define W15Q64_FTL_OK                                     0
+#define W15Q64_FTL_ERR_LBA                                1
+#define W15Q64_FTL_ERR_FULL                               2
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t eraseCnt;
+    uint8_t state;
+    uint8_t used; //            Занятых страниц данных (записей)
+    uint8_t valid; //           Из них действительных
+} W15Q64ftlSector_t; // Структура содержит состояние одного сектора
+
+typedef struct {
+    uint32_t writes; //         Вызовы W15Q64_FtlWrite()
+    uint32_t programs; //       Записано страниц данных (с переносами)
+    uint32_t gcCopies; //       Страниц перенесено сборкой мусора
+    uint32_t erases;
+    uint32_t wearMoves; //      Секторов перенесено для выравнивания износа
+    uint32_t fgCollects; //     Сборки мусора, выполненные при записи
+    uint32_t suspends; //       Фоновых стираний приостановлено
+    uint32_t dropped; //        Версий отброшено при монтировании (CRC)
+} W15Q64ftlStats_t;
+
+typedef struct {
+    W15Q64spi_t *spi;
+    uint32_t start; //                  Адрес области, кратен 4 КБ
+    uint16_t sectorCnt;
+    uint16_t lbaCnt;
+    W15Q64ftlSector_t *pSectors; //     sectorCnt элементов
+    uint16_t *pMap; //                  lbaCnt элементов: номер страницы
+    //                                  (сектор * 16 + страница) или
+    //                                  W15Q64_FTL_NONE
+    uint8_t gcFree; //                  Порог фоновой сборки мусора
+    uint32_t wearDelta; //              Порог статического выравнивания износа
+    uint32_t (* now_us) (void); //      Часы для приостановки фонового
+    //                                  стирания или NULL (по умолчанию)
+    W15Q64ftlStats_t stats;
+
+    // Служебные поля
+    uint32_t seq; //                    Номер следующей версии
+    uint16_t head; //                   Сектор, в который идет запись
+    uint16_t freeCnt;
+    uint16_t victim; //                 Сектор, из которого идет перенос
+    uint8_t victimPage;
+    uint16_t erasing; //                Сектор, стирание которого запущено
+    uint32_t resumeUs; //               Момент последнего Resume
+    uint8_t meta[W15Q64_PAGE_SIZE]; //  Страница 0 сектора victim
+    uint8_t page[W15Q64_PAGE_SIZE];
+} W15Q64ftl_t; //   Структура содержит состояние слоя логических блоков
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_FtlInit(W15Q64ftl_t *ftl,
+        W15Q64spi_t *spi,
+        uint32_t start,
+        uint16_t sectorCnt,
+        W15Q64ftlSector_t *pSectors,
+        uint16_t *pMap,
+        uint16_t lbaCnt);
+extern void W15Q64_FtlMount(W15Q64ftl_t *ftl);
+extern uint8_t W15Q64_FtlWrite(W15Q64ftl_t *ftl,
+        uint16_t lba,
+        const uint8_t *pData);
+extern _Bool W15Q64_FtlRead(W15Q64ftl_t *ftl,
+        uint16_t lba,
+        uint8_t *pRxData);
+extern _Bool W15Q64_FtlPoll(W15Q64ftl_t *ftl);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
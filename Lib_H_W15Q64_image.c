@@ -0,0 +1,218 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_image.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Образ микросхемы flash памяти w15q64 в файле на хосте (Linux)
+ *              для утилит подготовки и проверки прошивок
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#define _POSIX_C_SOURCE 200809L
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Lib_H_W15Q64_image.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_ImageFinish(W15Q64image_t *img);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция открывает файл образа, отображает его в память и
+ *          подключает модель микросхемы к W15Q64spi_t
+ *  @param  *img:   Указатель на структуру образа
+ *  @param  *pPath: Имя файла
+ *  @param  size:   Объем микросхемы (степень 2, от 64 КБ до
+ *                  W15Q64_SIM_MAX_SIZE), 0 - по размеру файла
+ *  @param  flags:  W15Q64_IMAGE_CREATE, W15Q64_IMAGE_READONLY,
+ *                  W15Q64_IMAGE_TIMED
+ *  @param  *spi:   Указатель на структуру в которую записываются указатели на
+ *                  функции модели
+ *  @retval true - образ открыт
+ */
+_Bool W15Q64_ImageOpen(W15Q64image_t *img,
+                       const char *pPath,
+                       uint32_t size,
+                       uint8_t flags,
+                       W15Q64spi_t *spi)
+{
+    const _Bool readOnly = (flags & W15Q64_IMAGE_READONLY) != 0;
+    struct stat st;
+    void *pMap;
+    uint32_t fileSize;
+
+    memset(img, 0, sizeof (*img));
+    img->fd = open(pPath, readOnly ? O_RDONLY
+                   : (O_RDWR | (((flags & W15Q64_IMAGE_CREATE) != 0) ? O_CREAT : 0)), 0644);
+    if (img->fd < 0)
+    {
+        return false;
+    }
+    if (fstat(img->fd, &st) != 0)
+    {
+        W15Q64_ImageClose(img);
+        return false;
+    }
+    fileSize = (st.st_size > (off_t) W15Q64_SIM_MAX_SIZE)
+            ? W15Q64_SIM_MAX_SIZE : (uint32_t) st.st_size;
+    if (size == 0)
+    {
+        size = fileSize;
+    }
+    if ((size < W15Q64_SIM_BLOCK_64KB_SIZE)
+        || ((size & (size - 1)) != 0)
+        || (size > W15Q64_SIM_MAX_SIZE)
+        || ((fileSize < size)
+            && ((readOnly || ((flags & W15Q64_IMAGE_CREATE) == 0))
+                || (ftruncate(img->fd, (off_t) size) != 0))))
+    {
+        W15Q64_ImageClose(img);
+        return false;
+    }
+
+    // Для образа только для чтения изменения остаются в копиях страниц
+    pMap = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                readOnly ? MAP_PRIVATE : MAP_SHARED, img->fd, 0);
+    if (pMap == MAP_FAILED)
+    {
+        W15Q64_ImageClose(img);
+        return false;
+    }
+    img->pMap = (uint8_t *) pMap;
+    img->size = size;
+    img->flags = flags;
+    if (fileSize < size)
+    {
+        memset(&img->pMap[fileSize], 0xFF, size - fileSize); // Стертая память
+    }
+
+    W15Q64_SimInit(&img->sim, img->pMap, size);
+    if ((flags & W15Q64_IMAGE_TIMED) == 0)
+    {
+        // Таблица SFDP уже содержит времена микросхемы по умолчанию
+        img->sim.timing.readDataMaxHz = img->sim.timing.clockHz;
+        img->sim.timing.callNs = 0;
+        img->sim.timing.csHighNs = 0;
+        img->sim.timing.tW_us = 0;
+        img->sim.timing.tPP_us = 0;
+        img->sim.timing.tSE_us = 0;
+        img->sim.timing.tBE1_us = 0;
+        img->sim.timing.tBE2_us = 0;
+        img->sim.timing.tCE_us = 0;
+        img->sim.timing.tSUS_us = 0;
+        img->sim.timing.tRS_us = 0;
+    }
+    if (!W15Q64_SimBind(&img->sim, spi))
+    {
+        W15Q64_ImageClose(img);
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция возвращает указатель на данные образа без копирования.
+ *          Незавершенная операция записи или стирания перед этим
+ *          завершается (кроме приостановленной командой Suspend)
+ *  @param  *img:   Указатель на структуру образа
+ *  @param  addr:   Адрес
+ *  @param  cnt:    Количество байт, которые будут прочитаны
+ *  @retval Указатель, NULL - область выходит за пределы образа
+ */
+const uint8_t *W15Q64_ImagePtr(W15Q64image_t *img,
+                               uint32_t addr,
+                               uint32_t cnt)
+{
+    if ((addr >= img->size) || (cnt > img->size - addr))
+    {
+        return NULL;
+    }
+    W15Q64_ImageFinish(img);
+    return &img->pMap[addr];
+}
+
+/**
+ *  @brief  Функция завершает выполняемую операцию и записывает изменения
+ *          образа в файл
+ *  @param  *img:   Указатель на структуру образа
+ *  @retval true - данные записаны
+ */
+_Bool W15Q64_ImageSync(W15Q64image_t *img)
+{
+    W15Q64_ImageFinish(img);
+    if ((img->flags & W15Q64_IMAGE_READONLY) != 0)
+    {
+        return true;
+    }
+    return msync(img->pMap, img->size, MS_SYNC) == 0;
+}
+
+/**
+ *  @brief  Функция записывает изменения в файл, отключает модель от
+ *          W15Q64spi_t и закрывает образ
+ *  @param  *img:   Указатель на структуру образа
+ *  @retval None
+ */
+void W15Q64_ImageClose(W15Q64image_t *img)
+{
+    if (img->pMap != NULL)
+    {
+        W15Q64_ImageSync(img);
+        W15Q64_SimFree(&img->sim);
+        munmap(img->pMap, img->size);
+        img->pMap = NULL;
+    }
+    if (img->fd >= 0)
+    {
+        close(img->fd);
+        img->fd = -1;
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция продвигает время модели до окончания внутренней операции
+ */
+static void W15Q64_ImageFinish(W15Q64image_t *img)
+{
+    W15Q64sim_t *sim = &img->sim;
+
+    if (W15Q64_SimIsBusy(sim) && (!sim->suspended))
+    {
+        W15Q64_SimAdvanceNs(sim, (sim->busyUntilPs - *sim->pNowPs + 999) / 1000);
+        W15Q64_SimIsBusy(sim);
+    }
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
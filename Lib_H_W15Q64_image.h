@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_image.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Образ микросхемы flash памяти w15q64 в файле на хосте (Linux)
+ *              для утилит подготовки и проверки прошивок
+ *  @warning    Файл отображается в память (mmap) и используется как массив
+ *              памяти модели Lib_H_W15Q64_sim.h, поэтому драйвер и модули
+ *              верхнего уровня работают с образом через W15Q64spi_t так же,
+ *              как с микросхемой (все команды модели). Изменения попадают в
+ *              файл без копирования, W15Q64_ImageSync() сбрасывает их на диск.
+ *              По умолчанию времена операций модели нулевые, передача по
+ *              шине выполняется копированием блоков, без побайтной
+ *              эмуляции протокола. W15Q64_ImagePtr() дает доступ к данным
+ *              образа без копирования.
+ *              Сборка только для POSIX.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_IMAGE_H
+#define	LIB_H_W15Q64_IMAGE_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#include "Lib_H_W15Q64_sim.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Флаги W15Q64_ImageOpen()
+#define W15Q64_IMAGE_CREATE                               0x01 // Создать файл или
+//                                                                увеличить его до
+//                                                                size, новые байты
+//                                                                заполняются 0xFF
+#define W15Q64_IMAGE_READONLY                             0x02 // Изменения не
+//                                                                записываются в файл
+#define W15Q64_IMAGE_TIMED                                0x04 // Времена операций
+//                                                                микросхемы по
+//                                                                умолчанию модели
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    W15Q64sim_t sim; //         Модель, память которой - отображение файла
+    int fd;
+    uint8_t *pMap;
+    uint32_t size;
+    uint8_t flags;
+} W15Q64image_t; // Структура содержит образ микросхемы в файле
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_ImageOpen(W15Q64image_t *img,
+        const char *pPath,
+        uint32_t size,
+        uint8_t flags,
+        W15Q64spi_t *spi);
+extern const uint8_t *W15Q64_ImagePtr(W15Q64image_t *img,
+        uint32_t addr,
+        uint32_t cnt);
+extern _Bool W15Q64_ImageSync(W15Q64image_t *img);
+extern void W15Q64_ImageClose(W15Q64image_t *img);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,263 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_integrity.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Контроль целостности страниц микросхемы flash памяти w15q64
+ *              по CRC-32C
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_integrity.h"
+#include "Lib_H_W15Q64_crc.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static _Bool W15Q64_IntegrityPages(W15Q64spi_t *spi,
+                                   uint32_t addr,
+                                   uint8_t *pRxData,
+                                   uint32_t pageCnt,
+                                   W15Q64verifyResult_t *pRes);
+static _Bool W15Q64_IntegrityPageOk(const uint8_t *pPage);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция программирует защищенную страницу: данные и их CRC-32C.
+ *          Если страница микросхемы меньше W15Q64_PAGE_SIZE, защищенная
+ *          страница программируется частями. Окончания программирования
+ *          последней части функция не ждет
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес страницы, кратен W15Q64_PAGE_SIZE
+ *  @param  *pData: Данные
+ *  @param  cnt:    Количество байт, не больше W15Q64_INTEGRITY_DATA
+ *                  (остаток страницы заполняется 0xFF)
+ *  @retval None
+ */
+void W15Q64_IntegrityProg(W15Q64spi_t *spi,
+                          uint32_t addr,
+                          const uint8_t *pData,
+                          uint16_t cnt)
+{
+    uint8_t page[W15Q64_PAGE_SIZE];
+    uint32_t crc;
+    uint16_t pos,
+            prog = W15Q64_PageSize(spi);
+
+    if (cnt > W15Q64_INTEGRITY_DATA)
+    {
+        cnt = W15Q64_INTEGRITY_DATA;
+    }
+    memcpy(page, pData, cnt);
+    memset(&page[cnt], 0xFF, W15Q64_INTEGRITY_DATA - cnt);
+    crc = W15Q64_Crc32c(0, page, W15Q64_INTEGRITY_DATA);
+    page[W15Q64_INTEGRITY_DATA] = (uint8_t) crc;
+    page[W15Q64_INTEGRITY_DATA + 1] = (uint8_t) (crc >> 8);
+    page[W15Q64_INTEGRITY_DATA + 2] = (uint8_t) (crc >> 16);
+    page[W15Q64_INTEGRITY_DATA + 3] = (uint8_t) (crc >> 24);
+
+    if (prog > W15Q64_PAGE_SIZE)
+    {
+        prog = W15Q64_PAGE_SIZE;
+    }
+    for (pos = 0; pos < W15Q64_PAGE_SIZE; pos = (uint16_t) (pos + prog))
+    {
+        if (pos != 0)
+        {
+            W15Q64_WaitBusy(spi);
+        }
+        W15Q64_PageProg(spi, addr + pos, &page[pos], prog);
+    }
+}
+
+/**
+ *  @brief  Функция читает данные защищенных страниц и проверяет их CRC
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес первой страницы, кратен W15Q64_PAGE_SIZE
+ *  @param  *pRxData:   Буфер на pageCnt * W15Q64_INTEGRITY_DATA байт
+ *  @param  pageCnt:    Количество страниц
+ *  @param  *pRes:  Указатель на структуру результата (firstAddr - адрес
+ *                  первой испорченной страницы, mismatches - их количество)
+ *                  или NULL
+ *  @retval true - все страницы целы
+ */
+_Bool W15Q64_IntegrityRead(W15Q64spi_t *spi,
+                           uint32_t addr,
+                           uint8_t *pRxData,
+                           uint32_t pageCnt,
+                           W15Q64verifyResult_t *pRes)
+{
+    return W15Q64_IntegrityPages(spi, addr, pRxData, pageCnt, pRes);
+}
+
+/**
+ *  @brief  Функция проверяет CRC защищенных страниц области (поиск
+ *          разрушенных данных). Страницы читаются по шине через
+ *          W15Q64_ReadChunk(), но данные вызывающей стороне не копируются
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес первой страницы, кратен W15Q64_PAGE_SIZE
+ *  @param  pageCnt:    Количество страниц
+ *  @param  *pRes:  Указатель на структуру результата или NULL
+ *  @retval true - все страницы целы
+ */
+_Bool W15Q64_IntegrityScrub(W15Q64spi_t *spi,
+                            uint32_t addr,
+                            uint32_t pageCnt,
+                            W15Q64verifyResult_t *pRes)
+{
+    return W15Q64_IntegrityPages(spi, addr, NULL, pageCnt, pRes);
+}
+
+/**
+ *  @brief  Функция вычисляет CRC-32C произвольной области микросхемы
+ *          (например, образа прошивки), вычисление идет во время чтения
+ *          следующего блока
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес начала области
+ *  @param  cnt:    Размер области в байтах
+ *  @retval CRC-32C
+ */
+uint32_t W15Q64_IntegrityCrc(W15Q64spi_t *spi,
+                             uint32_t addr,
+                             uint32_t cnt)
+{
+    uint32_t buf[2][W15Q64_VERIFY_CHUNK / 4],
+            crc = 0,
+            chunk,
+            next;
+    uint8_t cur = 0;
+
+    chunk = (cnt < W15Q64_VERIFY_CHUNK) ? cnt : W15Q64_VERIFY_CHUNK;
+    if (chunk != 0)
+    {
+        W15Q64_ReadChunk(spi, addr, (uint8_t *) buf[cur], chunk);
+    }
+    while (chunk != 0)
+    {
+        W15Q64_WaitChunk(spi);
+        addr += chunk;
+        cnt -= chunk;
+        next = (cnt < W15Q64_VERIFY_CHUNK) ? cnt : W15Q64_VERIFY_CHUNK;
+        if (next != 0)
+        {
+            W15Q64_ReadChunk(spi, addr, (uint8_t *) buf[cur ^ 1], next);
+        }
+        crc = W15Q64_Crc32c(crc, (const uint8_t *) buf[cur], chunk);
+        chunk = next;
+        cur ^= 1;
+    }
+    return crc;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция читает страницы в два буфера и проверяет CRC каждой, пока
+ *          читается следующая. pRxData = NULL - данные не копируются
+ */
+static _Bool W15Q64_IntegrityPages(W15Q64spi_t *spi,
+                                   uint32_t addr,
+                                   uint8_t *pRxData,
+                                   uint32_t pageCnt,
+                                   W15Q64verifyResult_t *pRes)
+{
+    uint32_t buf[2][W15Q64_PAGE_SIZE / 4],
+            page;
+    const uint8_t *pPage;
+    uint8_t cur = 0;
+
+    if (pRes != NULL)
+    {
+        pRes->firstAddr = 0xFFFFFFFFUL;
+        pRes->mismatches = 0;
+    }
+    if (pageCnt == 0)
+    {
+        return true;
+    }
+
+    W15Q64_ReadChunk(spi, addr, (uint8_t *) buf[cur], W15Q64_PAGE_SIZE);
+    for (page = 0; page < pageCnt; page++)
+    {
+        W15Q64_WaitChunk(spi);
+        if (page + 1 < pageCnt)
+        {
+            W15Q64_ReadChunk(spi, addr + (page + 1) * W15Q64_PAGE_SIZE,
+                             (uint8_t *) buf[cur ^ 1], W15Q64_PAGE_SIZE);
+        }
+
+        pPage = (const uint8_t *) buf[cur];
+        if (pRxData != NULL)
+        {
+            memcpy(&pRxData[page * W15Q64_INTEGRITY_DATA], pPage, W15Q64_INTEGRITY_DATA);
+        }
+        if (!W15Q64_IntegrityPageOk(pPage))
+        {
+            if (pRes == NULL)
+            {
+                W15Q64_WaitChunk(spi);
+                return false;
+            }
+            if (pRes->mismatches == 0)
+            {
+                pRes->firstAddr = addr + page * W15Q64_PAGE_SIZE;
+            }
+            pRes->mismatches++;
+        }
+        cur ^= 1;
+    }
+    return (pRes == NULL) || (pRes->mismatches == 0);
+}
+
+/**
+ *  @brief  Функция сравнивает CRC данных страницы с записанным, при
+ *          несовпадении проверяет, что страница чистая
+ */
+static _Bool W15Q64_IntegrityPageOk(const uint8_t *pPage)
+{
+    const uint8_t *pCrc = &pPage[W15Q64_INTEGRITY_DATA];
+    uint16_t i;
+
+    if (W15Q64_Crc32c(0, pPage, W15Q64_INTEGRITY_DATA)
+        == ((uint32_t) pCrc[0] | ((uint32_t) pCrc[1] << 8)
+            | ((uint32_t) pCrc[2] << 16) | ((uint32_t) pCrc[3] << 24)))
+    {
+        return true;
+    }
+    for (i = 0; (i < W15Q64_PAGE_SIZE) && (pPage[i] == 0xFF); i++)
+    {
+    }
+    return i == W15Q64_PAGE_SIZE;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
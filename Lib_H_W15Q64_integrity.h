@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_integrity.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Контроль целостности страниц микросхемы flash памяти w15q64
+ *              по CRC-32C: запись, чтение с проверкой, проверка области
+ *  @warning    Защищенная страница содержит W15Q64_INTEGRITY_DATA байт
+ *              данных и CRC-32C этих данных в последних 4 байтах (младший
+ *              байт первым), которые программируются одной командой Page
+ *              Program. Несовпадение CRC означает разрушение данных или
+ *              прерванное программирование; чистая страница (все 0xFF)
+ *              считается целой.
+ *              Страницы читаются в два буфера на стеке: если порт
+ *              поддерживает transmitReceiveDMA, CRC страницы вычисляется,
+ *              пока читается следующая, и проверка не увеличивает время
+ *              чтения. Если указатель на результат равен NULL, чтение
+ *              прекращается на первой испорченной странице.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_INTEGRITY_H
+#define	LIB_H_W15Q64_INTEGRITY_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#include "Lib_H_W15Q64_verify.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_INTEGRITY_DATA                             (W15Q64_PAGE_SIZE - 4)
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_IntegrityProg(W15Q64spi_t *spi,
+        uint32_t addr,
+        const uint8_t *pData,
+        uint16_t cnt);
+extern _Bool W15Q64_IntegrityRead(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t pageCnt,
+        W15Q64verifyResult_t *pRes);
+extern _Bool W15Q64_IntegrityScrub(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint32_t pageCnt,
+        W15Q64verifyResult_t *pRes);
+extern uint32_t W15Q64_IntegrityCrc(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint32_t cnt);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
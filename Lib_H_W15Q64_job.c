@@ -0,0 +1,491 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_job.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Неблокирующее выполнение операций записи и стирания микросхемы
+ *              flash памяти w15q64
+ *  @warning    W15Q64_JobSubmit() и W15Q64_Poll() должны вызываться из одного
+ *              контекста (или с запретом прерываний вокруг W15Q64_JobSubmit())
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include "Lib_H_W15Q64_job.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_JobIssue(W15Q64jobQueue_t *queue,
+                            W15Q64job_t *job);
+static _Bool W15Q64_JobFinished(W15Q64job_t *job);
+static void W15Q64_JobComplete(W15Q64job_t *job);
+static void W15Q64_JobServeRead(W15Q64jobQueue_t *queue);
+static _Bool W15Q64_JobCanSuspend(W15Q64jobQueue_t *queue);
+static _Bool W15Q64_JobReadOverlaps(W15Q64jobQueue_t *queue);
+static uint32_t W15Q64_JobNow(W15Q64jobQueue_t *queue);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция инициализирует пустую очередь заданий
+ *  @param  *queue: Указатель на структуру очереди
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_JobInit(W15Q64jobQueue_t *queue,
+                    W15Q64spi_t *spi)
+{
+    queue->spi = spi;
+    queue->pHead = NULL;
+    queue->pTail = NULL;
+    queue->issued = false;
+    queue->pRead = NULL;
+    queue->pReadTail = NULL;
+    queue->preempt = false;
+    queue->now_us = NULL;
+    queue->suspended = false;
+    queue->suspendReads = 0;
+    queue->readServed = false;
+    queue->resumeUs = 0;
+    queue->suspends = 0;
+    queue->reads = 0;
+    queue->maxReadUs = 0;
+}
+
+/**
+ *  @brief  Функция заполняет задание на запись массива произвольной длины
+ *  @param  *job:   Указатель на структуру задания
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  *pData: Указатель на первый элемент массива с данными
+ *  @param  cnt:    Количество байт для записи
+ *  @param  done:   Функция завершения или NULL
+ *  @param  *pCtx:  Указатель, передаваемый в функцию завершения
+ *  @retval None
+ */
+void W15Q64_JobProgram(W15Q64job_t *job,
+                       uint32_t addr,
+                       uint8_t *pData,
+                       uint32_t cnt,
+                       W15Q64jobDone_t done,
+                       void *pCtx)
+{
+    job->instruct = W15Q64_PAGE_PROGRAM;
+    job->addr = addr;
+    job->pData = pData;
+    job->cnt = cnt;
+    job->done = done;
+    job->pCtx = pCtx;
+    job->state = W15Q64_JOB_IDLE;
+}
+
+/**
+ *  @brief  Функция заполняет задание на стирание
+ *  @param  *job:   Указатель на структуру задания
+ *  @param  instruct:   W15Q64_SECTOR_ERASE_4KB, W15Q64_BLOCK_ERASE_32KB,
+ *                      W15Q64_BLOCK_ERASE_64KB или W15Q64_CHIP_ERASE
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  done:   Функция завершения или NULL
+ *  @param  *pCtx:  Указатель, передаваемый в функцию завершения
+ *  @retval None
+ */
+void W15Q64_JobErase(W15Q64job_t *job,
+                     uint8_t instruct,
+                     uint32_t addr,
+                     W15Q64jobDone_t done,
+                     void *pCtx)
+{
+    job->instruct = instruct;
+    job->addr = addr;
+    job->pData = NULL;
+    job->cnt = 0;
+    job->done = done;
+    job->pCtx = pCtx;
+    job->state = W15Q64_JOB_IDLE;
+}
+
+/**
+ *  @brief  Функция заполняет задание на чтение (Fast Read)
+ *  @param  *job:   Указатель на структуру задания
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  *pData: Указатель на первый элемент массива для принятых данных
+ *  @param  cnt:    Количество байт
+ *  @param  done:   Функция завершения или NULL
+ *  @param  *pCtx:  Указатель, передаваемый в функцию завершения
+ *  @retval None
+ */
+void W15Q64_JobRead(W15Q64job_t *job,
+                    uint32_t addr,
+                    uint8_t *pData,
+                    uint32_t cnt,
+                    W15Q64jobDone_t done,
+                    void *pCtx)
+{
+    W15Q64_JobProgram(job, addr, pData, cnt, done, pCtx);
+    job->instruct = W15Q64_FAST_READ;
+}
+
+/**
+ *  @brief  Функция ставит задание в конец очереди. Выполнение начнется при
+ *          очередном вызове W15Q64_Poll()
+ *  @param  *queue: Указатель на структуру очереди
+ *  @param  *job:   Указатель на заполненное задание
+ *  @retval None
+ */
+void W15Q64_JobSubmit(W15Q64jobQueue_t *queue,
+                      W15Q64job_t *job)
+{
+    job->pos = 0;
+    job->pNext = NULL;
+    job->state = W15Q64_JOB_QUEUED;
+
+    if (queue->pTail == NULL)
+    {
+        queue->pHead = job;
+    }
+    else
+    {
+        queue->pTail->pNext = job;
+    }
+    queue->pTail = job;
+}
+
+/**
+ *  @brief  Функция ставит задание на чтение в очередь срочных чтений: оно
+ *          выполняется раньше следующего шага записи или стирания, а при
+ *          включенном вытеснении - во время текущего шага
+ *  @param  *queue: Указатель на структуру очереди
+ *  @param  *job:   Указатель на задание, заполненное W15Q64_JobRead()
+ *  @retval None
+ */
+void W15Q64_JobSubmitRead(W15Q64jobQueue_t *queue,
+                          W15Q64job_t *job)
+{
+    job->pos = 0;
+    job->pNext = NULL;
+    job->state = W15Q64_JOB_QUEUED;
+    job->submitUs = W15Q64_JobNow(queue);
+
+    if (queue->pReadTail == NULL)
+    {
+        queue->pRead = job;
+    }
+    else
+    {
+        queue->pReadTail->pNext = job;
+    }
+    queue->pReadTail = job;
+}
+
+/**
+ *  @brief  Функция включает или выключает приостановку стирания и записи
+ *          для срочных чтений
+ *  @param  *queue: Указатель на структуру очереди
+ *  @param  enable: true - вытеснение разрешено
+ *  @param  now_us: Функция, возвращающая текущее время в микросекундах.
+ *                  Нужна для соблюдения интервала tRS и оценки
+ *                  задержки чтений; без нее вытеснение не выполняется
+ *  @retval None
+ */
+void W15Q64_JobPreempt(W15Q64jobQueue_t *queue,
+                       _Bool enable,
+                       uint32_t (* now_us) (void))
+{
+    queue->preempt = enable;
+    queue->now_us = now_us;
+    queue->resumeUs = W15Q64_JobNow(queue) - W15Q64_JobTrsUs(queue->spi);
+}
+
+/**
+ *  @brief  Функция выполняет один шаг обработки очереди: если микросхема
+ *          занята - сразу возвращает управление (или приостанавливает
+ *          операцию ради срочного чтения), иначе выполняет срочное чтение,
+ *          отправляет следующую страницу текущего задания или завершает
+ *          его и запускает следующее
+ *  @param  *queue: Указатель на структуру очереди
+ *  @retval true - в очереди остались задания, false - очередь пуста
+ */
+_Bool W15Q64_Poll(W15Q64jobQueue_t *queue)
+{
+    W15Q64job_t *job = queue->pHead;
+    uint8_t reg1;
+    _Bool overlap;
+
+    if ((job == NULL) && (queue->pRead == NULL))
+    {
+        return false;
+    }
+
+    if (queue->issued)
+    {
+        // Одно чтение Status Register 1 на шаг
+        reg1 = W15Q64_ReadStatReg(queue->spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_1);
+        if (queue->suspended)
+        {
+            // BUSY остается в "1" в течение tSUS после Suspend
+            if ((reg1 & (1 << W15Q64_BUSY)) == 0)
+            {
+                // Чтение из приостановленной области ждет окончания операции
+                overlap = W15Q64_JobReadOverlaps(queue);
+                if (!overlap)
+                {
+                    W15Q64_JobServeRead(queue);
+                    queue->suspendReads++;
+                }
+                // Поток чтений не должен держать операцию приостановленной
+                if (overlap
+                    || (queue->pRead == NULL)
+                    || (queue->suspendReads >= W15Q64_JOB_SUSPEND_READS))
+                {
+                    W15Q64_EraseProgram_Resume(queue->spi);
+                    queue->suspended = false;
+                    queue->resumeUs = W15Q64_JobNow(queue);
+                }
+            }
+            return true;
+        }
+        if ((reg1 & (1 << W15Q64_BUSY)) != 0)
+        {
+            if (W15Q64_JobCanSuspend(queue))
+            {
+                W15Q64_EraseProgram_Suspend(queue->spi);
+                queue->suspended = true;
+                queue->suspendReads = 0;
+                queue->suspends++;
+            }
+            return true;
+        }
+        queue->issued = false;
+
+        if (W15Q64_JobFinished(job))
+        {
+            queue->pHead = job->pNext;
+            if (queue->pHead == NULL)
+            {
+                queue->pTail = NULL;
+            }
+            W15Q64_JobComplete(job);
+            job = queue->pHead;
+        }
+    }
+
+    // Срочные чтения - раньше следующего шага записи, но не больше одного
+    // подряд, если шаг ожидает: иначе поток чтений остановит запись
+    if ((queue->pRead != NULL) && ((job == NULL) || (!queue->readServed)))
+    {
+        W15Q64_JobServeRead(queue);
+        queue->readServed = true;
+        return true;
+    }
+    if (job == NULL)
+    {
+        return false;
+    }
+
+    W15Q64_JobIssue(queue, job);
+    queue->readServed = false;
+    return true;
+}
+
+/**
+ *  @brief  Функция возвращает минимальный интервал Resume -> Suspend: из
+ *          параметров SFDP (spi->pDev), если они подключены, иначе
+ *          W15Q64_T_RS_US
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @retval Интервал в микросекундах
+ */
+uint32_t W15Q64_JobTrsUs(W15Q64spi_t *spi)
+{
+    return ((spi->pDev != NULL) && (spi->pDev->tRSminUs != 0))
+            ? spi->pDev->tRSminUs : W15Q64_T_RS_US;
+}
+
+/**
+ *  @brief  Функция возвращает наибольшую задержку Suspend: из параметров SFDP
+ *          (spi->pDev), если они подключены, иначе W15Q64_T_SUS_US
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @retval Задержка в микросекундах, 0 - Suspend не поддерживается
+ */
+uint32_t W15Q64_JobTsusUs(W15Q64spi_t *spi)
+{
+    return (spi->pDev != NULL) ? spi->pDev->tSUSmaxUs : W15Q64_T_SUS_US;
+}
+
+/**
+ *  @brief  Функция проверяет, пуста ли очередь заданий
+ *  @param  *queue: Указатель на структуру очереди
+ *  @retval true - все задания выполнены
+ */
+_Bool W15Q64_JobIdle(W15Q64jobQueue_t *queue)
+{
+    return (queue->pHead == NULL) && (queue->pRead == NULL);
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция отправляет в микросхему команду очередного шага задания
+ *          (Page Program одной страницы или команду стирания)
+ */
+static void W15Q64_JobIssue(W15Q64jobQueue_t *queue,
+                            W15Q64job_t *job)
+{
+    const uint16_t page = W15Q64_PageSize(queue->spi);
+    uint32_t addr = job->addr + job->pos;
+    uint16_t chunk;
+
+    job->state = W15Q64_JOB_RUNNING;
+    switch (job->instruct)
+    {
+        case W15Q64_PAGE_PROGRAM:
+            chunk = (uint16_t) (page - (addr % page));
+            if (chunk > (job->cnt - job->pos))
+            {
+                chunk = (uint16_t) (job->cnt - job->pos);
+            }
+            if (chunk != 0)
+            {
+                W15Q64_PageProg(queue->spi, addr, &job->pData[job->pos], chunk);
+            }
+            job->pos += chunk;
+            break;
+        case W15Q64_CHIP_ERASE:
+            W15Q64_ChipErase(queue->spi);
+            break;
+        case W15Q64_FAST_READ:
+            W15Q64_FastReadAuto(queue->spi, job->addr, job->pData, job->cnt);
+            job->pos = job->cnt;
+            break;
+        default:
+            W15Q64_Erase(queue->spi, job->addr, job->instruct);
+            break;
+    }
+    queue->issued = true;
+}
+
+static _Bool W15Q64_JobFinished(W15Q64job_t *job)
+{
+    return (job->instruct != W15Q64_PAGE_PROGRAM) || (job->pos >= job->cnt);
+}
+
+static void W15Q64_JobComplete(W15Q64job_t *job)
+{
+    job->state = W15Q64_JOB_DONE;
+    if (job->done != NULL)
+    {
+        job->done(job->pCtx, job);
+    }
+}
+
+/**
+ *  @brief  Функция выполняет первое срочное чтение и учитывает его задержку
+ */
+static void W15Q64_JobServeRead(W15Q64jobQueue_t *queue)
+{
+    W15Q64job_t *job = queue->pRead;
+    uint32_t latency;
+
+    queue->pRead = job->pNext;
+    if (queue->pRead == NULL)
+    {
+        queue->pReadTail = NULL;
+    }
+
+    job->state = W15Q64_JOB_RUNNING;
+    W15Q64_FastReadAuto(queue->spi, job->addr, job->pData, job->cnt);
+    job->pos = job->cnt;
+
+    latency = W15Q64_JobNow(queue) - job->submitUs;
+    if (latency > queue->maxReadUs)
+    {
+        queue->maxReadUs = latency;
+    }
+    queue->reads++;
+    W15Q64_JobComplete(job);
+}
+
+/**
+ *  @brief  Функция проверяет, можно ли приостановить текущую операцию ради
+ *          срочного чтения
+ */
+static _Bool W15Q64_JobCanSuspend(W15Q64jobQueue_t *queue)
+{
+    return (queue->pRead != NULL)
+            && queue->preempt
+            && (queue->now_us != NULL)
+            && (queue->pHead->instruct != W15Q64_CHIP_ERASE)
+            && (W15Q64_JobTsusUs(queue->spi) != 0)
+            && !W15Q64_JobReadOverlaps(queue)
+            // Строгое сравнение: показания часов округлены до 1 мкс
+            && ((uint32_t) (queue->now_us() - queue->resumeUs) > W15Q64_JobTrsUs(queue->spi));
+}
+
+/**
+ *  @brief  Функция проверяет, пересекается ли первое срочное чтение с
+ *          областью выполняемой операции: стираемым блоком (размер - по
+ *          инструкции, W15Q64_EraseSize()) или программируемой страницей.
+ *          Данные этой области во время Suspend не определены
+ */
+static _Bool W15Q64_JobReadOverlaps(W15Q64jobQueue_t *queue)
+{
+    const W15Q64job_t *job = queue->pHead,
+            *read = queue->pRead;
+    uint32_t lo,
+            size;
+
+    switch (job->instruct)
+    {
+        case W15Q64_PAGE_PROGRAM:
+            // Страница последнего отправленного шага задания
+            size = W15Q64_PageSize(queue->spi);
+            lo = (job->addr + job->pos - 1) & ~(size - 1UL);
+            break;
+        case W15Q64_FAST_READ:
+            return false;
+        default:
+            size = W15Q64_EraseSize(queue->spi, job->instruct);
+            if (size == 0)
+            {
+                return true; //             Chip Erase или неизвестная область
+            }
+            lo = job->addr & ~(size - 1UL);
+            break;
+    }
+    // Сравнение разностей не переполняется у конца адресного пространства
+    return ((uint32_t) (read->addr - lo) < size)
+            || ((uint32_t) (lo - read->addr) < read->cnt);
+}
+
+static uint32_t W15Q64_JobNow(W15Q64jobQueue_t *queue)
+{
+    return (queue->now_us != NULL) ? queue->now_us() : 0;
+}
+
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_job.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Неблокирующее выполнение операций записи и стирания микросхемы
+ *              flash памяти w15q64
+ *  @warning    Операции (jobs) ставятся в очередь функцией W15Q64_JobSubmit()
+ *              и выполняются по шагам функцией W15Q64_Poll(), которую следует
+ *              вызывать из главного цикла или прерывания таймера. Один вызов
+ *              W15Q64_Poll() выполняет не более одного чтения Status Register
+ *              и одной команды, поэтому никогда не ждет окончания BUSY.
+ *              Память под задания выделяет вызывающая сторона, задание не
+ *              должно изменяться до вызова функции завершения.
+ *              Срочные чтения (W15Q64_JobSubmitRead()) выполняются раньше
+ *              следующего шага записи. Если включено вытеснение
+ *              (W15Q64_JobPreempt()), то во время стирания или записи
+ *              страницы очередь выполняет Erase/Program Suspend, читает и
+ *              выполняет Resume. За один Suspend выполняется не больше
+ *              W15Q64_JOB_SUSPEND_READS чтений, после чего операция
+ *              возобновляется, даже если чтения еще есть в очереди.
+ *              Чтение, пересекающее стираемый блок или программируемую
+ *              страницу, не выполняется во время Suspend: оно остается в
+ *              очереди до окончания операции.
+ *              Следующий Suspend отправляется не раньше, чем через tRS
+ *              (spi->pDev->tRSminUs или W15Q64_T_RS_US) после Resume, чтобы
+ *              операция продвигалась вперед при любом потоке чтений.
+ *              Chip Erase не приостанавливается, как и операции
+ *              микросхемы, параметры SFDP которой не описывают Suspend
+ *              (spi->pDev->tSUSmaxUs = 0).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_JOB_H
+#define	LIB_H_W15Q64_JOB_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Состояния задания
+#define W15Q64_JOB_IDLE                                   0
+#define W15Q64_JOB_QUEUED                                 1
+#define W15Q64_JOB_RUNNING                                2
+#define W15Q64_JOB_DONE                                   3
+
+// Минимальный интервал Resume -> Suspend и задержка Suspend, мкс (см. 7.2.26
+// Erase / Program Suspend)
+#define W15Q64_T_RS_US                                    64
+#define W15Q64_T_SUS_US                                   20
+
+// Наибольшее количество срочных чтений за один Suspend
+#define W15Q64_JOB_SUSPEND_READS                          4
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+struct W15Q64job_s;
+
+typedef void (* W15Q64jobDone_t) (void *pCtx,
+        struct W15Q64job_s *job); //    Функция, вызываемая по окончании задания
+
+typedef struct W15Q64job_s {
+    uint8_t instruct; //        Операция: W15Q64_PAGE_PROGRAM, W15Q64_SECTOR_ERASE_4KB,
+    //                          W15Q64_BLOCK_ERASE_32KB, W15Q64_BLOCK_ERASE_64KB,
+    //                          W15Q64_CHIP_ERASE или W15Q64_FAST_READ
+    uint32_t addr; //           Адрес начала операции
+    uint8_t *pData; //          Данные для записи или буфер для чтения
+    uint32_t cnt; //            Количество байт для записи, любое, разбивается
+    //                          на страницы автоматически
+    W15Q64jobDone_t done; //    Функция завершения, может быть NULL
+    void *pCtx; //              Указатель, передаваемый в функцию завершения
+    uint8_t prio; //            Приоритет запроса (см. W15Q64_SrvSubmit())
+
+    // Служебные поля
+    volatile uint8_t state;
+    uint32_t pos; //            Количество уже записанных байт
+    uint32_t submitUs; //       Момент постановки срочного чтения в очередь
+    struct W15Q64job_s *pNext;
+} W15Q64job_t; //       Структура описывает одно задание записи или стирания
+
+typedef struct {
+    W15Q64spi_t *spi;
+    W15Q64job_t *pHead; //      Выполняемое задание
+    W15Q64job_t *pTail;
+    _Bool issued; //            Команда текущего шага отправлена в микросхему
+    W15Q64job_t *pRead; //      Срочные чтения
+    W15Q64job_t *pReadTail;
+
+    // Вытеснение операций чтениями (см. W15Q64_JobPreempt())
+    _Bool preempt;
+    uint32_t (* now_us) (void);
+    _Bool suspended; //         Отправлен Erase/Program Suspend
+    uint8_t suspendReads; //    Выполнено чтений за текущий Suspend
+    _Bool readServed; //        Последним выполнено чтение, а не шаг задания
+    uint32_t resumeUs; //       Момент последнего Resume
+    uint32_t suspends; //       Количество Suspend
+    uint32_t reads; //          Выполнено срочных чтений
+    uint32_t maxReadUs; //      Наибольшая задержка срочного чтения
+} W15Q64jobQueue_t; //  Структура содержит очередь заданий для одной микросхемы
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_JobInit(W15Q64jobQueue_t *queue,
+        W15Q64spi_t *spi);
+extern void W15Q64_JobProgram(W15Q64job_t *job,
+        uint32_t addr,
+        uint8_t *pData,
+        uint32_t cnt,
+        W15Q64jobDone_t done,
+        void *pCtx);
+extern void W15Q64_JobErase(W15Q64job_t *job,
+        uint8_t instruct,
+        uint32_t addr,
+        W15Q64jobDone_t done,
+        void *pCtx);
+extern void W15Q64_JobRead(W15Q64job_t *job,
+        uint32_t addr,
+        uint8_t *pData,
+        uint32_t cnt,
+        W15Q64jobDone_t done,
+        void *pCtx);
+extern void W15Q64_JobSubmit(W15Q64jobQueue_t *queue,
+        W15Q64job_t *job);
+extern void W15Q64_JobSubmitRead(W15Q64jobQueue_t *queue,
+        W15Q64job_t *job);
+extern void W15Q64_JobPreempt(W15Q64jobQueue_t *queue,
+        _Bool enable,
+        uint32_t (* now_us) (void));
+extern _Bool W15Q64_Poll(W15Q64jobQueue_t *queue);
+extern _Bool W15Q64_JobIdle(W15Q64jobQueue_t *queue);
+extern uint32_t W15Q64_JobTrsUs(W15Q64spi_t *spi);
+extern uint32_t W15Q64_JobTsusUs(W15Q64spi_t *spi);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,48 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_port.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Порт шины SPI на этапе компиляции (W15Q64_STATIC_PORT) для
+ *              модели микросхемы flash памяти w15q64
+ *  @warning    Образец заголовка W15Q64_PORT_HEADER: макросы порта
+ *              передают байты модели pW15Q64portSim (см. Lib_H_W15Q64_sim.h),
+ *              которую выбирает вызывающая сторона до первого обращения к
+ *              структуре W15Q64spi_t с sc_ON = NULL и transaction = NULL.
+ *              В проекте с микросхемой заголовок заменяется своим (через
+ *              -DW15Q64_PORT_HEADER=\"...\" или файлом с тем же именем), в
+ *              котором макросы обращаются к регистрам SPI и вывода CS.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_PORT_H
+#define	LIB_H_W15Q64_PORT_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include "Lib_H_W15Q64_sim.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция глобальных переменных
+extern W15Q64sim_t *pW15Q64portSim; //  Модель, к которой подключен порт
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+#define W15Q64_PORT_CS_ON()             W15Q64_SimSelect(pW15Q64portSim)
+#define W15Q64_PORT_CS_OFF()            W15Q64_SimDeselect(pW15Q64portSim)
+#define W15Q64_PORT_TRANSMIT(pTx, cnt)  W15Q64_SimTransmit(pW15Q64portSim, (pTx), (cnt))
+#define W15Q64_PORT_RECEIVE(pRx, cnt)   W15Q64_SimReceive(pW15Q64portSim, (pRx), (cnt))
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
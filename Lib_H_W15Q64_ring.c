@@ -0,0 +1,612 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_ring.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Кольцевой журнал записей (телеметрия) на микросхеме flash
+ *              памяти w15q64
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_ring.h"
+#include "Lib_H_W15Q64_verify.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_RingStartErase(W15Q64ring_t *ring,
+                                  uint16_t sector);
+static uint32_t W15Q64_RingKey(W15Q64ring_t *ring,
+                               uint16_t sector);
+static _Bool W15Q64_RingHeaderOk(const uint8_t *pHdr,
+                                 uint32_t *pSeq);
+static uint8_t W15Q64_RingCheckPage(W15Q64ring_t *ring,
+                                    uint32_t page);
+static uint8_t *W15Q64_RingSlot(W15Q64ring_t *ring,
+                                uint8_t i);
+static uint32_t W15Q64_RingAddr(W15Q64ring_t *ring,
+                                uint32_t page);
+static uint16_t W15Q64_RingCrc(uint16_t crc,
+                               const uint8_t *pData,
+                               uint16_t cnt);
+static uint32_t W15Q64_RingGet32(const uint8_t *p);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция задает область микросхемы и очередь страниц журнала.
+ *          После нее вызывается W15Q64_RingMount()
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  start:  Адрес области, кратен 4 КБ
+ *  @param  sectorCnt:  Количество секторов области
+ *  @param  *pQueue:    Массив на queuePages * W15Q64_PAGE_SIZE байт
+ *  @param  queuePages: Количество страниц очереди (не меньше 2), должно
+ *                      вмещать записи, поступающие за время стирания сектора
+ *  @retval true - параметры допустимы
+ */
+_Bool W15Q64_RingInit(W15Q64ring_t *ring,
+                      W15Q64spi_t *spi,
+                      uint32_t start,
+                      uint16_t sectorCnt,
+                      uint8_t *pQueue,
+                      uint8_t queuePages)
+{
+    if (((start & (W15Q64_SECTOR_SIZE - 1)) != 0)
+        || (sectorCnt < 3) || (sectorCnt == W15Q64_RING_NONE)
+        || (queuePages < 2)
+        || (start + (uint32_t) sectorCnt * W15Q64_SECTOR_SIZE > W15Q64_Capacity(spi)))
+    {
+        return false;
+    }
+
+    memset(ring, 0, sizeof (*ring));
+    ring->spi = spi;
+    ring->start = start;
+    ring->sectorCnt = sectorCnt;
+    ring->pQueue = pQueue;
+    ring->queuePages = queuePages;
+    ring->erased = W15Q64_RING_NONE;
+    ring->erasing = W15Q64_RING_NONE;
+    ring->preErase = W15Q64_RING_NONE;
+    return true;
+}
+
+/**
+ *  @brief  Функция находит место записи: сектор - двоичным поиском по
+ *          номерам в заголовках секторов, страницу - по заголовкам страниц
+ *          сектора. Подсчитывает недописанные записи последней страницы,
+ *          пропускает страницы с прерванным программированием и проверяет,
+ *          что следующий сектор стерт
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @retval None
+ */
+void W15Q64_RingMount(W15Q64ring_t *ring)
+{
+    const uint32_t pages = (uint32_t) ring->sectorCnt * W15Q64_RING_PAGES;
+    uint8_t hdr[W15Q64_RING_PAGE_HEADER];
+    uint32_t key = 0,
+            headKey,
+            k;
+    uint16_t g,
+            lo,
+            hi,
+            mid,
+            head,
+            next;
+    uint8_t last,
+            plo,
+            phi,
+            pmid,
+            i;
+
+    ring->qHead = 0;
+    ring->qCnt = 0;
+    ring->fill = 0;
+    ring->flushed = 0;
+    ring->flushReq = false;
+    ring->erased = W15Q64_RING_NONE;
+    ring->erasing = W15Q64_RING_NONE;
+    ring->preErase = W15Q64_RING_NONE;
+
+    // Стираемый заранее сектор и сектор с прерванным заголовком не имеют
+    // действительного номера, поэтому опорный сектор - первый из трех с ним
+    for (g = 0; g < 3; g++)
+    {
+        key = W15Q64_RingKey(ring, g);
+        if (key != 0)
+        {
+            break;
+        }
+    }
+    if (key == 0)
+    {
+        ring->progPage = 0;
+        ring->seq = 1;
+        ring->tail = 0;
+        ring->erased = W15Q64_BlankCheck(ring->spi, ring->start, W15Q64_SECTOR_SIZE, NULL)
+                ? 0 : W15Q64_RING_NONE;
+        return;
+    }
+
+    // От опорного сектора номера не меньше его номера идут до сектора
+    // записи, дальше - стертые сектора и сектора предыдущего круга
+    headKey = key;
+    lo = 0;
+    hi = (uint16_t) (ring->sectorCnt - 1);
+    while (lo < hi)
+    {
+        mid = (uint16_t) ((lo + hi + 1) / 2);
+        k = W15Q64_RingKey(ring, (uint16_t) ((g + mid) % ring->sectorCnt));
+        if (k >= key)
+        {
+            lo = mid;
+            headKey = k;
+        }
+        else
+        {
+            hi = (uint16_t) (mid - 1);
+        }
+    }
+    head = (uint16_t) ((g + lo) % ring->sectorCnt);
+
+    // Страницы сектора программируются по порядку
+    plo = 0;
+    phi = W15Q64_RING_PAGES - 1;
+    while (plo < phi)
+    {
+        pmid = (uint8_t) ((plo + phi + 1) / 2);
+        W15Q64_FastReadData(ring->spi,
+                            W15Q64_RingAddr(ring, (uint32_t) head * W15Q64_RING_PAGES + pmid),
+                            hdr, sizeof (hdr));
+        ring->stats.mountReads++;
+        for (i = 0; (i < sizeof (hdr)) && (hdr[i] == 0xFF); i++)
+        {
+        }
+        if (i < sizeof (hdr))
+        {
+            plo = pmid;
+        }
+        else
+        {
+            phi = (uint8_t) (pmid - 1);
+        }
+    }
+    last = plo;
+    W15Q64_RingCheckPage(ring, (uint32_t) head * W15Q64_RING_PAGES + last);
+
+    ring->progPage = ((uint32_t) head * W15Q64_RING_PAGES + last + 1) % pages;
+    ring->seq = headKey + last + 1;
+    while (((ring->progPage % W15Q64_RING_PAGES) != 0)
+           && (!W15Q64_BlankCheck(ring->spi, W15Q64_RingAddr(ring, ring->progPage),
+                                  W15Q64_PAGE_SIZE, NULL)))
+    {
+        ring->progPage = (ring->progPage + 1) % pages;
+        ring->seq++;
+    }
+
+    // Сектор, следующий за сектором записи, должен быть стерт
+    next = (uint16_t) (ring->progPage / W15Q64_RING_PAGES);
+    if ((ring->progPage % W15Q64_RING_PAGES) != 0)
+    {
+        next = (uint16_t) ((next + 1) % ring->sectorCnt);
+    }
+    if (W15Q64_BlankCheck(ring->spi, W15Q64_RingAddr(ring, (uint32_t) next * W15Q64_RING_PAGES),
+                          W15Q64_SECTOR_SIZE, NULL))
+    {
+        ring->erased = next;
+    }
+    else if (next != ring->progPage / W15Q64_RING_PAGES)
+    {
+        ring->preErase = next;
+    }
+
+    // Самые старые записи - за стираемым сектором, если журнал прошел круг
+    ring->tail = (uint16_t) ((next + 1) % ring->sectorCnt);
+    k = W15Q64_RingKey(ring, ring->tail);
+    if ((k == 0) || (k >= key))
+    {
+        ring->tail = g;
+    }
+}
+
+/**
+ *  @brief  Функция добавляет запись в очередь страниц в ОЗУ. Обращений к
+ *          микросхеме нет, запись программирует W15Q64_RingPoll()
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @param  *pData: Данные записи
+ *  @param  len:    Длина, от 1 до W15Q64_RING_MAX_RECORD
+ *  @retval W15Q64_RING_OK, W15Q64_RING_ERR_LEN, W15Q64_RING_ERR_OVERRUN
+ */
+uint8_t W15Q64_RingAppend(W15Q64ring_t *ring,
+                          const uint8_t *pData,
+                          uint8_t len)
+{
+    uint8_t *pPage;
+    uint16_t crc;
+    uint32_t seq;
+
+    if ((len == 0) || (len > W15Q64_RING_MAX_RECORD))
+    {
+        return W15Q64_RING_ERR_LEN;
+    }
+    if ((ring->fill != 0)
+        && (ring->fill + W15Q64_RING_RECORD_HEADER + len > W15Q64_PAGE_SIZE))
+    {
+        ring->qCnt++;
+        ring->fill = 0;
+    }
+    if (ring->fill == 0)
+    {
+        if (ring->qCnt >= ring->queuePages)
+        {
+            ring->stats.overruns++;
+            return W15Q64_RING_ERR_OVERRUN;
+        }
+        pPage = W15Q64_RingSlot(ring, ring->qCnt);
+        seq = ring->seq + ring->qCnt;
+        memset(pPage, 0xFF, W15Q64_PAGE_SIZE);
+        pPage[0] = (uint8_t) W15Q64_RING_MAGIC;
+        pPage[1] = (uint8_t) (W15Q64_RING_MAGIC >> 8);
+        pPage[2] = (uint8_t) seq;
+        pPage[3] = (uint8_t) (seq >> 8);
+        pPage[4] = (uint8_t) (seq >> 16);
+        pPage[5] = (uint8_t) (seq >> 24);
+        crc = W15Q64_RingCrc(0xFFFF, pPage, 6);
+        pPage[6] = (uint8_t) crc;
+        pPage[7] = (uint8_t) (crc >> 8);
+        ring->fill = W15Q64_RING_PAGE_HEADER;
+    }
+
+    pPage = &W15Q64_RingSlot(ring, ring->qCnt)[ring->fill];
+    pPage[0] = len;
+    memcpy(&pPage[W15Q64_RING_RECORD_HEADER], pData, len);
+    crc = W15Q64_RingCrc(W15Q64_RingCrc(0xFFFF, pPage, 1), pData, len);
+    pPage[1] = (uint8_t) crc;
+    pPage[2] = (uint8_t) (crc >> 8);
+    ring->fill = (uint16_t) (ring->fill + W15Q64_RING_RECORD_HEADER + len);
+    ring->stats.records++;
+
+    // Страница без места для записи из одного байта закрывается сразу
+    if (ring->fill > W15Q64_PAGE_SIZE - W15Q64_RING_RECORD_HEADER - 1)
+    {
+        ring->qCnt++;
+        ring->fill = 0;
+    }
+    return W15Q64_RING_OK;
+}
+
+/**
+ *  @brief  Функция выполняет один шаг работы с микросхемой без ожидания:
+ *          проверку BUSY, программирование страницы из очереди или запуск
+ *          стирания. Вызывается из главного цикла (задачи) чаще, чем
+ *          заполняется страница
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @retval true - работа не закончена
+ */
+_Bool W15Q64_RingPoll(W15Q64ring_t *ring)
+{
+    const uint16_t sector = (uint16_t) (ring->progPage / W15Q64_RING_PAGES);
+    const uint8_t page = (uint8_t) (ring->progPage % W15Q64_RING_PAGES);
+    uint16_t end = 0,
+            prog;
+
+    if ((W15Q64_ReadStatReg(ring->spi, (uint8_t) W15Q64_READ_STATUS_REGISTER_1)
+         & (1 << W15Q64_BUSY)) != 0)
+    {
+        return true;
+    }
+    if (ring->erasing != W15Q64_RING_NONE)
+    {
+        ring->erased = ring->erasing;
+        ring->erasing = W15Q64_RING_NONE;
+        ring->stats.erases++;
+    }
+
+    if (ring->qCnt != 0)
+    {
+        end = W15Q64_PAGE_SIZE;
+    }
+    else if (ring->flushReq)
+    {
+        end = ring->fill;
+    }
+
+    // Стирание заранее - когда очередь пуста, но не позже середины сектора
+    if ((ring->preErase != W15Q64_RING_NONE)
+        && ((end <= ring->flushed) || (page >= W15Q64_RING_PAGES / 2)))
+    {
+        W15Q64_RingStartErase(ring, ring->preErase);
+        ring->preErase = W15Q64_RING_NONE;
+        return true;
+    }
+    if (end <= ring->flushed)
+    {
+        return false;
+    }
+    if ((page == 0) && (ring->flushed == 0))
+    {
+        if (ring->erased != sector)
+        {
+            W15Q64_RingStartErase(ring, sector); // Стирание не успело
+            return true;
+        }
+        ring->erased = W15Q64_RING_NONE;
+        ring->preErase = (uint16_t) ((sector + 1) % ring->sectorCnt);
+    }
+
+    // Не дальше границы страницы микросхемы, остаток - на следующем шаге
+    prog = W15Q64_PageSize(ring->spi);
+    prog = (uint16_t) (prog - (ring->flushed & (prog - 1U)));
+    if (prog > end - ring->flushed)
+    {
+        prog = (uint16_t) (end - ring->flushed);
+    }
+    W15Q64_PageProg(ring->spi, W15Q64_RingAddr(ring, ring->progPage) + ring->flushed,
+                    &W15Q64_RingSlot(ring, 0)[ring->flushed], prog);
+    if (ring->flushed + prog == W15Q64_PAGE_SIZE)
+    {
+        ring->progPage = (ring->progPage + 1) % ((uint32_t) ring->sectorCnt * W15Q64_RING_PAGES);
+        ring->seq++;
+        ring->flushed = 0;
+        ring->qHead = (uint8_t) ((ring->qHead + 1) % ring->queuePages);
+        ring->qCnt--;
+        ring->stats.pages++;
+    }
+    else
+    {
+        ring->flushed = (uint16_t) (ring->flushed + prog);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция программирует все записи очереди, включая незаполненную
+ *          страницу (ее можно дописывать дальше), с ожиданием
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @retval None
+ */
+void W15Q64_RingFlush(W15Q64ring_t *ring)
+{
+    ring->flushReq = true;
+    while ((ring->qCnt != 0) || (ring->fill > ring->flushed))
+    {
+        W15Q64_RingPoll(ring);
+        W15Q64_WaitBusy(ring->spi);
+    }
+    ring->flushReq = false;
+}
+
+/**
+ *  @brief  Функция устанавливает положение чтения на самые старые записи
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @param  *cur:   Указатель на положение чтения
+ *  @retval None
+ */
+void W15Q64_RingFirst(W15Q64ring_t *ring,
+                      W15Q64ringCursor_t *cur)
+{
+    W15Q64_WaitBusy(ring->spi);
+    cur->page = (uint32_t) ring->tail * W15Q64_RING_PAGES;
+    cur->seq = W15Q64_RingKey(ring, ring->tail);
+    cur->offset = 0;
+}
+
+/**
+ *  @brief  Функция читает следующую запись журнала. Страницы, стертые или
+ *          записанные заново после W15Q64_RingFirst(), и записи с неверной
+ *          CRC пропускаются
+ *  @param  *ring:  Указатель на структуру журнала
+ *  @param  *cur:   Указатель на положение чтения
+ *  @param  *pRxData:   Буфер на W15Q64_RING_MAX_RECORD байт
+ *  @retval Длина записи, 0 - записей больше нет
+ */
+uint8_t W15Q64_RingNext(W15Q64ring_t *ring,
+                        W15Q64ringCursor_t *cur,
+                        uint8_t *pRxData)
+{
+    uint8_t hdr[W15Q64_RING_PAGE_HEADER];
+    uint32_t addr,
+            seq;
+    uint8_t len;
+    _Bool ok;
+
+    for (;;)
+    {
+        if ((cur->page == ring->progPage)
+            && ((ring->flushed == 0) || (cur->offset >= ring->flushed)))
+        {
+            return 0;
+        }
+        W15Q64_WaitBusy(ring->spi);
+        addr = W15Q64_RingAddr(ring, cur->page);
+        ok = true;
+        if (cur->offset == 0)
+        {
+            W15Q64_FastReadData(ring->spi, addr, hdr, sizeof (hdr));
+            ok = W15Q64_RingHeaderOk(hdr, &seq) && ((cur->seq == 0) || (seq == cur->seq));
+            if (ok)
+            {
+                cur->seq = seq;
+                cur->offset = W15Q64_RING_PAGE_HEADER;
+            }
+        }
+        if (ok && (cur->offset + W15Q64_RING_RECORD_HEADER < W15Q64_PAGE_SIZE))
+        {
+            W15Q64_FastReadData(ring->spi, addr + cur->offset, hdr, W15Q64_RING_RECORD_HEADER);
+            len = hdr[0];
+            if ((len != 0) && (len <= W15Q64_PAGE_SIZE - W15Q64_RING_RECORD_HEADER - cur->offset))
+            {
+                W15Q64_FastReadData(ring->spi, addr + cur->offset + W15Q64_RING_RECORD_HEADER,
+                                    pRxData, len);
+                if (W15Q64_RingCrc(W15Q64_RingCrc(0xFFFF, hdr, 1), pRxData, len)
+                    == (uint16_t) (hdr[1] | (hdr[2] << 8)))
+                {
+                    cur->offset = (uint16_t) (cur->offset + W15Q64_RING_RECORD_HEADER + len);
+                    return len;
+                }
+                ring->stats.torn++;
+            }
+        }
+
+        // Конец страницы (0xFF), недописанная запись или чужая страница
+        cur->page = (cur->page + 1) % ((uint32_t) ring->sectorCnt * W15Q64_RING_PAGES);
+        cur->seq = (cur->seq != 0) ? (cur->seq + 1) : 0;
+        cur->offset = 0;
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция запускает стирание сектора без ожидания. Самые старые
+ *          записи переходят к следующему сектору
+ */
+static void W15Q64_RingStartErase(W15Q64ring_t *ring,
+                                  uint16_t sector)
+{
+    if (sector == ring->tail)
+    {
+        ring->tail = (uint16_t) ((sector + 1) % ring->sectorCnt);
+    }
+    W15Q64_Erase(ring->spi, W15Q64_RingAddr(ring, (uint32_t) sector * W15Q64_RING_PAGES),
+                 W15Q64_SECTOR_ERASE_4KB);
+    ring->erasing = sector;
+}
+
+/**
+ *  @brief  Функция читает номер первой страницы сектора
+ *  @retval Номер, 0 - заголовок недействителен (сектор стерт, не дописан)
+ */
+static uint32_t W15Q64_RingKey(W15Q64ring_t *ring,
+                               uint16_t sector)
+{
+    uint8_t hdr[W15Q64_RING_PAGE_HEADER];
+    uint32_t seq;
+
+    W15Q64_FastReadData(ring->spi, W15Q64_RingAddr(ring, (uint32_t) sector * W15Q64_RING_PAGES),
+                        hdr, sizeof (hdr));
+    ring->stats.mountReads++;
+    return W15Q64_RingHeaderOk(hdr, &seq) ? seq : 0;
+}
+
+static _Bool W15Q64_RingHeaderOk(const uint8_t *pHdr,
+                                 uint32_t *pSeq)
+{
+    *pSeq = W15Q64_RingGet32(&pHdr[2]);
+    return (pHdr[0] == (uint8_t) W15Q64_RING_MAGIC)
+            && (pHdr[1] == (uint8_t) (W15Q64_RING_MAGIC >> 8))
+            && (*pSeq != 0)
+            && (W15Q64_RingCrc(0xFFFF, pHdr, 6) == (uint16_t) (pHdr[6] | (pHdr[7] << 8)));
+}
+
+/**
+ *  @brief  Функция проверяет записи страницы (в слоте 0 очереди) и считает
+ *          недописанную
+ *  @retval Количество целых записей
+ */
+static uint8_t W15Q64_RingCheckPage(W15Q64ring_t *ring,
+                                    uint32_t page)
+{
+    uint8_t *pPage = W15Q64_RingSlot(ring, 0);
+    uint32_t seq;
+    uint16_t offset = W15Q64_RING_PAGE_HEADER;
+    uint8_t len,
+            cnt = 0;
+
+    W15Q64_FastReadData(ring->spi, W15Q64_RingAddr(ring, page), pPage, W15Q64_PAGE_SIZE);
+    ring->stats.mountReads++;
+    if (!W15Q64_RingHeaderOk(pPage, &seq))
+    {
+        return 0;
+    }
+    while (offset + W15Q64_RING_RECORD_HEADER < W15Q64_PAGE_SIZE)
+    {
+        len = pPage[offset];
+        if (len == 0xFF)
+        {
+            break;
+        }
+        if ((len == 0) || (len > W15Q64_PAGE_SIZE - W15Q64_RING_RECORD_HEADER - offset)
+            || (W15Q64_RingCrc(W15Q64_RingCrc(0xFFFF, &pPage[offset], 1),
+                               &pPage[offset + W15Q64_RING_RECORD_HEADER], len)
+                != (uint16_t) (pPage[offset + 1] | (pPage[offset + 2] << 8))))
+        {
+            ring->stats.torn++;
+            break;
+        }
+        offset = (uint16_t) (offset + W15Q64_RING_RECORD_HEADER + len);
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ *  @brief  Функция возвращает i-ю от страницы progPage страницу очереди
+ */
+static uint8_t *W15Q64_RingSlot(W15Q64ring_t *ring,
+                                uint8_t i)
+{
+    return &ring->pQueue[(uint32_t) ((ring->qHead + i) % ring->queuePages) * W15Q64_PAGE_SIZE];
+}
+
+static uint32_t W15Q64_RingAddr(W15Q64ring_t *ring,
+                                uint32_t page)
+{
+    return ring->start + page * W15Q64_PAGE_SIZE;
+}
+
+/**
+ *  @brief  Функция вычисляет CRC-16 (полином 0x1021, CCITT), crc -
+ *          начальное значение (0xFFFF) или результат для предыдущих байт
+ */
+static uint16_t W15Q64_RingCrc(uint16_t crc,
+                               const uint8_t *pData,
+                               uint16_t cnt)
+{
+    uint8_t k;
+
+    while (cnt-- != 0)
+    {
+        crc ^= (uint16_t) (*pData++ << 8);
+        for (k = 0; k < 8; k++)
+        {
+            crc = (uint16_t) ((crc << 1) ^ (0x1021 & (0U - (crc >> 15))));
+        }
+    }
+    return crc;
+}
+
+static uint32_t W15Q64_RingGet32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8)
+            | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
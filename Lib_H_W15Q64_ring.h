@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_ring.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Кольцевой журнал записей (телеметрия) на микросхеме flash
+ *              памяти w15q64: быстрое монтирование, стирание сектора заранее,
+ *              обнаружение недописанных записей
+ *  @warning    Каждая страница начинается с заголовка (признак, номер
+ *              страницы, CRC16), за ним идут записи: длина, CRC16, данные.
+ *              Запись не пересекает границу страницы. Номер страницы растет
+ *              на 1 с каждой страницей области, поэтому номера заголовков
+ *              первых страниц секторов по кругу возрастают, а после
+ *              сектора записи уменьшаются. W15Q64_RingMount() находит сектор
+ *              записи двоичным поиском по заголовкам секторов, страницу в
+ *              нем - двоичным поиском по заголовкам страниц: O(log) чтений
+ *              по 8 байт вместо чтения всей области.
+ *
+ *              W15Q64_RingAppend() только копирует запись в очередь страниц
+ *              в ОЗУ и не обращается к шине. Программирование страниц и
+ *              стирание выполняет W15Q64_RingPoll() без ожидания BUSY. При
+ *              входе в сектор следующий за ним сектор стирается заранее
+ *              (в момент, когда очередь пуста), поэтому запись не ждет
+ *              стирания, если очередь вмещает данные, поступающие за время
+ *              стирания (tSE). При переполнении очереди запись отбрасывается
+ *              (счетчик overruns). Стираемый сектор содержит самые старые
+ *              записи.
+ *
+ *              Страница в очереди программируется после заполнения или по
+ *              W15Q64_RingFlush() (с дозаписью той же страницы позже), при
+ *              пропадании питания теряются записи в очереди. Запись с
+ *              неверной CRC (прерванное программирование) и остаток ее
+ *              страницы пропускаются, после монтирования запись продолжается
+ *              со следующей чистой страницы.
+ *
+ *              W15Q64_RingFirst()/W15Q64_RingNext() читают записи от самых
+ *              старых до последней запрограммированной (очередь в ОЗУ не
+ *              читается, перед чтением - W15Q64_RingFlush()).
+ *              Область - не меньше 3 секторов.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_RING_H
+#define	LIB_H_W15Q64_RING_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_RING_MAGIC                                 0x474C // "LG"
+#define W15Q64_RING_PAGE_HEADER                           8
+#define W15Q64_RING_RECORD_HEADER                         3
+#define W15Q64_RING_MAX_RECORD                            (W15Q64_PAGE_SIZE \
+                                                           - W15Q64_RING_PAGE_HEADER \
+                                                           - W15Q64_RING_RECORD_HEADER)
+#define W15Q64_RING_PAGES                                 (W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE)
+#define W15Q64_RING_NONE                                  0xFFFF
+
+// Результат W15Q64_RingAppend()
+#define W15Q64_RING_OK                                    0
+#define W15Q64_RING_ERR_LEN                               1
+#define W15Q64_RING_ERR_OVERRUN                           2
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t records; //        Принято записей
+    uint32_t pages; //          Запрограммировано страниц
+    uint32_t erases;
+    uint32_t overruns; //       Записей отброшено (очередь заполнена)
+    uint32_t torn; //           Недописанных записей найдено
+    uint32_t mountReads; //     Чтений при монтировании
+} W15Q64ringStats_t;
+
+typedef struct {
+    uint32_t page; //           Номер страницы в области
+    uint32_t seq; //            Ожидаемый номер в ее заголовке
+    uint16_t offset; //         Смещение следующей записи, 0 - заголовок не
+    //                          проверен
+} W15Q64ringCursor_t; //    Положение чтения журнала
+
+typedef struct {
+    W15Q64spi_t *spi;
+    uint32_t start; //                  Адрес области, кратен 4 КБ
+    uint16_t sectorCnt;
+    uint8_t *pQueue; //                 Очередь страниц, queuePages * 256 байт
+    uint8_t queuePages;
+    W15Q64ringStats_t stats;
+
+    // Служебные поля
+    uint32_t progPage; //               Страница, программируемая следующей
+    uint32_t seq; //                    Ее номер
+    uint16_t flushed; //                Байт этой страницы уже запрограммировано
+    uint8_t qHead; //                   Слот очереди страницы progPage
+    uint8_t qCnt; //                    Заполненных страниц в очереди
+    uint16_t fill; //                   Байт в текущей (заполняемой) странице
+    _Bool flushReq;
+    uint16_t tail; //                   Сектор с самыми старыми записями
+    uint16_t erased; //                 Стертый заранее сектор
+    uint16_t erasing; //                Стирание запущено
+    uint16_t preErase; //               Сектор, который нужно стереть заранее
+} W15Q64ring_t; //  Структура содержит состояние кольцевого журнала
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_RingInit(W15Q64ring_t *ring,
+        W15Q64spi_t *spi,
+        uint32_t start,
+        uint16_t sectorCnt,
+        uint8_t *pQueue,
+        uint8_t queuePages);
+extern void W15Q64_RingMount(W15Q64ring_t *ring);
+extern uint8_t W15Q64_RingAppend(W15Q64ring_t *ring,
+        const uint8_t *pData,
+        uint8_t len);
+extern _Bool W15Q64_RingPoll(W15Q64ring_t *ring);
+extern void W15Q64_RingFlush(W15Q64ring_t *ring);
+extern void W15Q64_RingFirst(W15Q64ring_t *ring,
+        W15Q64ringCursor_t *cur);
+extern uint8_t W15Q64_RingNext(W15Q64ring_t *ring,
+        W15Q64ringCursor_t *cur,
+        uint8_t *pRxData);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,304 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_sfdp.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Определение параметров микросхемы flash памяти по таблицам
+ *              SFDP (JESD216)
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_sfdp.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+
+// Единицы времен в BFPT: стирание (DWORD 10), Chip Erase (DWORD 11),
+// Suspend latency (DWORD 12)
+static const uint32_t eraseUnitUs[4] = {1000UL, 16000UL, 128000UL, 1000000UL};
+static const uint32_t chipUnitMs[4] = {16UL, 256UL, 4000UL, 64000UL};
+static const uint32_t suspUnitNs[4] = {128UL, 1000UL, 8000UL, 64000UL};
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint32_t W15Q64_SfdpWord(const uint8_t *pData);
+static void W15Q64_SfdpParse(W15Q64dev_t *dev,
+                             const uint32_t *dw,
+                             uint8_t dwCnt);
+static void W15Q64_SfdpRead(W15Q64readType_t *pRead,
+                            _Bool supported,
+                            uint16_t field);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция читает таблицы SFDP и заполняет параметры микросхемы
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  *dev:   Указатель на структуру параметров микросхемы
+ *  @retval true - найдена Basic Flash Parameter Table, false - микросхема
+ *          не поддерживает SFDP (*dev не изменяется)
+ */
+_Bool W15Q64_SfdpProbe(W15Q64spi_t *spi,
+                       W15Q64dev_t *dev)
+{
+    uint8_t header[8],
+            data[W15Q64_SFDP_BFPT_DWORDS * 4],
+            headerCnt,
+            dwCnt,
+            i,
+            j;
+    uint32_t dw[W15Q64_SFDP_BFPT_DWORDS];
+
+    // SFDP Header: сигнатура, ревизия, количество заголовков параметров - 1
+    W15Q64_ReadSfdp(spi, 0, header, sizeof (header));
+    if ((W15Q64_SfdpWord(header) != W15Q64_SFDP_SIGNATURE) || (header[5] != 0x01))
+    {
+        return false;
+    }
+    headerCnt = (uint8_t) (header[6] + 1);
+    if (headerCnt > W15Q64_SFDP_MAX_HEADERS)
+    {
+        headerCnt = W15Q64_SFDP_MAX_HEADERS;
+    }
+
+    // Parameter Headers: ID LSB, ревизия, длина в словах, адрес, ID MSB
+    for (i = 0; i < headerCnt; i++)
+    {
+        W15Q64_ReadSfdp(spi, 8UL + 8UL * i, header, sizeof (header));
+        if (((((uint16_t) header[7] << 8) | header[0]) != W15Q64_SFDP_BFPT_ID)
+            || (header[2] != 0x01) || (header[3] < 9))
+        {
+            continue;
+        }
+
+        dwCnt = (header[3] < W15Q64_SFDP_BFPT_DWORDS) ? header[3] : W15Q64_SFDP_BFPT_DWORDS;
+        W15Q64_ReadSfdp(spi, W15Q64_SfdpWord(&header[4]) & 0xFFFFFFUL, data, dwCnt * 4U);
+        memset(dw, 0xFF, sizeof (dw));
+        for (j = 0; j < dwCnt; j++)
+        {
+            dw[j] = W15Q64_SfdpWord(&data[j * 4]);
+        }
+        W15Q64_SfdpParse(dev, dw, dwCnt);
+        return true;
+    }
+    return false;
+}
+
+/**
+ *  @brief  Функция подключает параметры микросхемы к драйверу: задает
+ *          задержки опроса BUSY по временам записи и стирания и для
+ *          микросхем больше 16 MiB включает режим 4-Byte Address
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  *dev:   Указатель на параметры, заполненные W15Q64_SfdpProbe()
+ *  @retval true - драйвер может адресовать весь объем микросхемы
+ */
+_Bool W15Q64_SfdpApply(W15Q64spi_t *spi,
+                       const W15Q64dev_t *dev)
+{
+    uint32_t pollMaxUs = 0xFFFFFFFFUL;
+    uint8_t i;
+
+    spi->pDev = dev;
+
+    // Повторный опрос - через типовое время Page Program (запись страницы
+    // завершается за один опрос), задержка удваивается до части времени
+    // самого быстрого стирания
+    if (dev->tPPtypUs != 0)
+    {
+        spi->pollFirstUs = dev->tPPtypUs;
+    }
+    for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+    {
+        if ((dev->erase[i].instruct != 0) && (dev->erase[i].typUs != 0)
+            && (dev->erase[i].typUs / W15Q64_SFDP_POLL_DIV < pollMaxUs))
+        {
+            pollMaxUs = dev->erase[i].typUs / W15Q64_SFDP_POLL_DIV;
+        }
+    }
+    if ((pollMaxUs != 0xFFFFFFFFUL) && (pollMaxUs > spi->pollFirstUs))
+    {
+        spi->pollMaxUs = pollMaxUs;
+    }
+
+    if (dev->capacity <= 0x1000000UL)
+    {
+        spi->addrBytes = 3;
+        return true;
+    }
+    if ((dev->addrModes & W15Q64_ADDR_3BYTE) == 0)
+    {
+        spi->addrBytes = 4; //          Микросхема работает только с 4-Byte Address
+        return true;
+    }
+    if ((dev->enter4Byte & (W15Q64_ENTER_4BYTE_B7 | W15Q64_ENTER_4BYTE_WREN_B7)) != 0)
+    {
+        W15Q64_Addr4Byte(spi, true);
+        return true;
+    }
+    // Доступны только первые 16 MiB
+    spi->addrBytes = 3;
+    return false;
+}
+
+//==============================================================================
+// Локальные функции
+
+static uint32_t W15Q64_SfdpWord(const uint8_t *pData)
+{
+    return (uint32_t) pData[0] | ((uint32_t) pData[1] << 8)
+            | ((uint32_t) pData[2] << 16) | ((uint32_t) pData[3] << 24);
+}
+
+/**
+ *  @brief  Функция разбирает слова Basic Flash Parameter Table (JESD216B).
+ *          Слова, отсутствующие в таблице ранних ревизий, не разбираются
+ */
+static void W15Q64_SfdpParse(W15Q64dev_t *dev,
+                             const uint32_t *dw,
+                             uint8_t dwCnt)
+{
+    uint32_t mult,
+            field,
+            unit;
+    uint8_t i;
+
+    memset(dev, 0, sizeof (*dev));
+
+    // DWORD 1: длина адреса, поддержка команд Fast Read
+    switch ((dw[0] >> 17) & 0x03)
+    {
+        case 0:
+            dev->addrModes = W15Q64_ADDR_3BYTE;
+            break;
+        case 1:
+            dev->addrModes = W15Q64_ADDR_3BYTE | W15Q64_ADDR_4BYTE;
+            break;
+        default:
+            dev->addrModes = W15Q64_ADDR_4BYTE;
+            break;
+    }
+
+    // DWORD 2: объем в битах
+    if ((dw[1] & 0x80000000UL) == 0)
+    {
+        dev->capacity = (dw[1] >> 3) + 1;
+    }
+    else
+    {
+        field = dw[1] & 0x7FFFFFFFUL;
+        dev->capacity = ((field >= 3) && (field < 34)) ? (1UL << (field - 3)) : 0x80000000UL;
+    }
+
+    // DWORD 3, 4: 1-4-4, 1-1-4, 1-1-2, 1-2-2
+    W15Q64_SfdpRead(&dev->read[0], (dw[0] & (1UL << 16)) != 0, (uint16_t) dw[3]);
+    W15Q64_SfdpRead(&dev->read[1], (dw[0] & (1UL << 20)) != 0, (uint16_t) (dw[3] >> 16));
+    W15Q64_SfdpRead(&dev->read[2], (dw[0] & (1UL << 22)) != 0, (uint16_t) (dw[2] >> 16));
+    W15Q64_SfdpRead(&dev->read[3], (dw[0] & (1UL << 21)) != 0, (uint16_t) dw[2]);
+
+    // DWORD 8, 9: типы стирания (размер 2^N байт, инструкция)
+    for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+    {
+        field = (dw[7 + i / 2] >> (16 * (i % 2))) & 0xFFFF;
+        if (((field & 0xFF) != 0) && ((field & 0xFF) < 32))
+        {
+            dev->erase[i].size = 1UL << (field & 0xFF);
+            dev->erase[i].instruct = (uint8_t) (field >> 8);
+        }
+    }
+
+    dev->pageSize = 256;
+    if (dwCnt < 11)
+    {
+        return;
+    }
+
+    // DWORD 10: типовые времена стирания, множитель максимального времени
+    mult = 2 * ((dw[9] & 0x0F) + 1);
+    for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+    {
+        field = (dw[9] >> (4 + 7 * i)) & 0x7F;
+        if (dev->erase[i].instruct != 0)
+        {
+            dev->erase[i].typUs = ((field & 0x1F) + 1) * eraseUnitUs[field >> 5];
+            dev->erase[i].maxUs = dev->erase[i].typUs * mult;
+        }
+    }
+
+    // DWORD 11: размер страницы, Page Program, Chip Erase
+    mult = 2 * ((dw[10] & 0x0F) + 1);
+    dev->pageSize = (uint16_t) (1U << ((dw[10] >> 4) & 0x0F));
+    unit = ((dw[10] & (1UL << 13)) != 0) ? 64 : 8;
+    dev->tPPtypUs = (((dw[10] >> 8) & 0x1F) + 1) * unit;
+    dev->tPPmaxUs = dev->tPPtypUs * mult;
+    dev->tCEtypMs = (((dw[10] >> 24) & 0x1F) + 1) * chipUnitMs[(dw[10] >> 29) & 0x03];
+    dev->tCEmaxMs = dev->tCEtypMs * mult;
+
+    // DWORD 12: Suspend/Resume (бит 31 = 0 - поддерживается), берется
+    // большая из задержек Suspend записи и стирания
+    if ((dwCnt >= 12) && ((dw[11] & 0x80000000UL) == 0))
+    {
+        field = ((((dw[11] >> 24) & 0x1F) + 1) * suspUnitNs[(dw[11] >> 29) & 0x03] + 999) / 1000;
+        dev->tSUSmaxUs = ((((dw[11] >> 13) & 0x1F) + 1) * suspUnitNs[(dw[11] >> 18) & 0x03]
+                          + 999) / 1000;
+        if (field > dev->tSUSmaxUs)
+        {
+            dev->tSUSmaxUs = field;
+        }
+        field = (((dw[11] >> 20) & 0x0F) + 1) * 64;
+        dev->tRSminUs = (((dw[11] >> 9) & 0x0F) + 1) * 64;
+        if (field > dev->tRSminUs)
+        {
+            dev->tRSminUs = field;
+        }
+    }
+
+    // DWORD 16: способ входа в режим 4-Byte Address
+    if (dwCnt >= 16)
+    {
+        dev->enter4Byte = (uint8_t) ((dw[15] >> 24)
+                                     & (W15Q64_ENTER_4BYTE_B7 | W15Q64_ENTER_4BYTE_WREN_B7));
+    }
+}
+
+/**
+ *  @brief  Функция разбирает 16-битное поле команды Fast Read: такты dummy
+ *          (биты 4-0), такты M7-0 (биты 7-5), инструкция (биты 15-8)
+ */
+static void W15Q64_SfdpRead(W15Q64readType_t *pRead,
+                            _Bool supported,
+                            uint16_t field)
+{
+    if (!supported)
+    {
+        return;
+    }
+    pRead->instruct = (uint8_t) (field >> 8);
+    pRead->modeClocks = (uint8_t) ((field >> 5) & 0x07);
+    pRead->dummyClocks = (uint8_t) (field & 0x1F);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
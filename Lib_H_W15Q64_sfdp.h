@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_sfdp.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Определение параметров микросхемы flash памяти по таблицам
+ *              SFDP (JESD216)
+ *  @warning    W15Q64_SfdpProbe() читает заголовок SFDP и Basic Flash
+ *              Parameter Table и заполняет W15Q64dev_t: объем, размер
+ *              страницы, типы стирания, команды чтения Dual/Quad с тактами
+ *              M7-0 и dummy, типовые и максимальные времена операций, способ
+ *              входа в режим 4-Byte Address.
+ *              W15Q64_SfdpApply() подключает параметры к W15Q64spi_t: драйвер
+ *              берет из них количество тактов dummy и объем, модуль стирания -
+ *              времена стирания, задержки опроса BUSY вычисляются из времен
+ *              записи и стирания. Микросхема больше 16 MiB переводится в
+ *              режим 4-Byte Address.
+ *              Структура W15Q64dev_t должна существовать, пока используется
+ *              структура spi.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_SFDP_H
+#define	LIB_H_W15Q64_SFDP_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_SFDP_SIGNATURE                             0x50444653UL // "SFDP"
+#define W15Q64_SFDP_BFPT_ID                               0xFF00 // Basic Flash
+//                                                                  Parameter Table
+#define W15Q64_SFDP_BFPT_DWORDS                           16 // Слов JESD216B
+#define W15Q64_SFDP_MAX_HEADERS                           8
+
+// Предел задержки опроса BUSY - часть времени самого быстрого стирания
+#define W15Q64_SFDP_POLL_DIV                              8
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_SfdpProbe(W15Q64spi_t *spi,
+        W15Q64dev_t *dev);
+extern _Bool W15Q64_SfdpApply(W15Q64spi_t *spi,
+        const W15Q64dev_t *dev);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
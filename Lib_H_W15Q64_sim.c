@@ -0,0 +1,1596 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_sim.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Программная модель микросхемы flash памяти w15q64 для запуска
+ *              драйвера на хосте (Linux) без отладочной платы
+ *  @warning    Модель декодирует поток байт на шине так же, как микросхема:
+ *              команда принимается по первому байту после CS low, а
+ *              выполняется (запись, стирание, WEL) по CS high.
+ *              Соблюдаются правила NOR: программирование только сбрасывает
+ *              биты в "0", стирание устанавливает байты в 0xFF, запись и
+ *              стирание без WEL игнорируются, Page Program заворачивает адрес
+ *              внутри страницы 256 байт.
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stdlib.h>
+#include <string.h>
+#include "Lib_H_W15Q64_sim.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+W15Q64sim_t *pW15Q64portSim = NULL; //  Модель порта W15Q64_STATIC_PORT (см.
+//                                      Lib_H_W15Q64_port.h)
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+static W15Q64sim_t *pSimSlot[W15Q64_SIM_SLOTS];
+static W15Q64spi_t *pSpiSlot[W15Q64_SIM_SLOTS];
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_SimCall(W15Q64sim_t *sim);
+static void W15Q64_SimTick(W15Q64sim_t *sim,
+                           uint64_t ps);
+static void W15Q64_SimSync(W15Q64sim_t *sim);
+static _Bool W15Q64_SimBusy(W15Q64sim_t *sim);
+static void W15Q64_SimStart(W15Q64sim_t *sim,
+                            uint8_t op,
+                            uint32_t addr,
+                            uint32_t len,
+                            uint32_t us);
+static void W15Q64_SimComplete(W15Q64sim_t *sim);
+static uint8_t W15Q64_SimLines(W15Q64sim_t *sim);
+static uint32_t W15Q64_SimDataIdx(W15Q64sim_t *sim);
+static _Bool W15Q64_SimHasAddr(uint8_t opcode);
+static uint8_t W15Q64_SimAddrLen(W15Q64sim_t *sim);
+static _Bool W15Q64_SimHasMode(uint8_t opcode);
+static void W15Q64_SimOpcode(W15Q64sim_t *sim,
+                             uint8_t opcode);
+static void W15Q64_SimTxByte(W15Q64sim_t *sim,
+                             uint8_t byte);
+static uint8_t W15Q64_SimRxByte(W15Q64sim_t *sim);
+static uint32_t W15Q64_SimRxBulk(W15Q64sim_t *sim,
+                                 uint8_t *pRxData,
+                                 uint32_t cnt);
+static uint32_t W15Q64_SimTxBulk(W15Q64sim_t *sim,
+                                 const uint8_t *pTxData,
+                                 uint32_t cnt);
+static void W15Q64_SimNextAddr(W15Q64sim_t *sim);
+static void W15Q64_SimCheckRead(W15Q64sim_t *sim,
+                                uint32_t cnt);
+static void W15Q64_SimExecute(W15Q64sim_t *sim);
+static void W15Q64_SimBuildSfdp(W15Q64sim_t *sim);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция заполняет структуру временной модели типовыми значениями
+ *          из документации на микросхему
+ *  @param  *timing:    Указатель на структуру временной модели
+ *  @retval None
+ */
+void W15Q64_SimDefaultTiming(W15Q64simTiming_t *timing)
+{
+    timing->clockHz = 50000000UL;
+    timing->readDataMaxHz = 50000000UL;
+    timing->callNs = 500;
+    timing->csHighNs = 50;
+    timing->tW_us = 10000;
+    timing->tPP_us = 700;
+    timing->tSE_us = 45000;
+    timing->tBE1_us = 120000;
+    timing->tBE2_us = 150000;
+    timing->tCE_us = 20000000UL;
+    timing->tSUS_us = 20;
+    timing->tRS_us = 64;
+}
+
+/**
+ *  @brief  Функция инициализирует модель микросхемы
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *pMem:  Указатель на массив памяти микросхемы или NULL, если
+ *                  память должна быть выделена моделью (заполняется 0xFF)
+ *  @param  size:   Размер памяти в байтах (степень двойки, не более
+ *                  W15Q64_SIM_MAX_SIZE). Микросхемы больше 16 MiB 
+ *                  поддерживают режим 4-Byte Address (B7h/E9h)
+ *  @retval true - модель готова к работе, false - ошибка параметров или
+ *          нехватка памяти
+ */
+_Bool W15Q64_SimInit(W15Q64sim_t *sim,
+                     uint8_t *pMem,
+                     uint32_t size)
+{
+    uint8_t i;
+
+    if ((size < W15Q64_SIM_BLOCK_64KB_SIZE)
+        || ((size & (size - 1)) != 0)
+        || (size > W15Q64_SIM_MAX_SIZE))
+    {
+        return false;
+    }
+
+    memset(sim, 0, sizeof (*sim));
+    if (pMem == NULL)
+    {
+        pMem = (uint8_t *) malloc(size);
+        if (pMem == NULL)
+        {
+            return false;
+        }
+        memset(pMem, 0xFF, size);
+        sim->ownMem = true;
+    }
+    sim->pMem = pMem;
+    sim->size = size;
+    sim->pNowPs = &sim->nowPs;
+    W15Q64_SimDefaultTiming(&sim->timing);
+
+    sim->wrapBits = 0x10; //            Burst with Wrap выключен
+    memset(sim->secReg, 0xFF, sizeof (sim->secReg));
+    for (i = 0; i < W15Q64_SIM_UNIQUE_ID_SIZE; i++)
+    {
+        sim->uniqueId[i] = (uint8_t) (0xD0 + i);
+    }
+    W15Q64_SimBuildSfdp(sim);
+    return true;
+}
+
+/**
+ *  @brief  Функция освобождает память модели и отключает ее от W15Q64spi_t
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval None
+ */
+void W15Q64_SimFree(W15Q64sim_t *sim)
+{
+    W15Q64_SimUnbind(sim);
+    if (sim->ownMem)
+    {
+        free(sim->pMem);
+    }
+    sim->pMem = NULL;
+    sim->ownMem = false;
+}
+
+/**
+ *  @brief  Функция подключает модель к часам другой модели. Используется
+ *          для нескольких микросхем на одной шине: время передачи по шине
+ *          любой из них продвигает общее время, а внутренние операции
+ *          (BUSY) разных микросхем идут параллельно
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *clock: Указатель на модель, часы которой используются
+ *  @retval None
+ */
+void W15Q64_SimShareClock(W15Q64sim_t *sim,
+                          W15Q64sim_t *clock)
+{
+    sim->pNowPs = clock->pNowPs;
+}
+
+/**
+ *  @brief  Функция возвращает текущее виртуальное время модели
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval Время в наносекундах
+ */
+uint64_t W15Q64_SimNowNs(W15Q64sim_t *sim)
+{
+    return *sim->pNowPs / 1000;
+}
+
+/**
+ *  @brief  Функция продвигает виртуальное время модели (например, на время
+ *          работы программы между обращениями к шине)
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  ns:     Интервал в наносекундах
+ *  @retval None
+ */
+void W15Q64_SimAdvanceNs(W15Q64sim_t *sim,
+                         uint64_t ns)
+{
+    W15Q64_SimTick(sim, ns * 1000);
+}
+
+/**
+ *  @brief  Функция сбрасывает счетчики трафика модели
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval None
+ */
+void W15Q64_SimResetStats(W15Q64sim_t *sim)
+{
+    memset(&sim->stats, 0, sizeof (sim->stats));
+}
+
+/**
+ *  @brief  Функция возвращает состояние бита BUSY без обращения к шине
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval true - идет внутренняя операция
+ */
+_Bool W15Q64_SimIsBusy(W15Q64sim_t *sim)
+{
+    W15Q64_SimSync(sim);
+    return W15Q64_SimBusy(sim);
+}
+
+/**
+ *  @brief  Функция устанавливает CS в "0" и начинает новую транзакцию
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval None
+ */
+void W15Q64_SimSelect(W15Q64sim_t *sim)
+{
+    W15Q64_SimSync(sim);
+    if (sim->csLow)
+    {
+        sim->stats.violations++;
+    }
+    sim->csLow = true;
+    sim->idx = 0;
+    sim->addr = 0;
+    sim->mode = 0;
+    sim->pageCnt = 0;
+    sim->susRead = false;
+    sim->opcode = 0;
+    memset(sim->page, 0xFF, sizeof (sim->page));
+    sim->stats.csCycles++;
+
+    // В режиме Continuous Read микросхема ожидает сразу адрес, без инструкции
+    if (sim->contRead)
+    {
+        sim->opcode = sim->contOpcode;
+        sim->idx = 1;
+    }
+}
+
+/**
+ *  @brief  Функция устанавливает CS в "1" и выполняет принятую команду
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval None
+ */
+void W15Q64_SimDeselect(W15Q64sim_t *sim)
+{
+    if (!sim->csLow)
+    {
+        sim->stats.violations++;
+        return;
+    }
+    W15Q64_SimExecute(sim);
+    sim->csLow = false;
+    W15Q64_SimTick(sim, (uint64_t) sim->timing.csHighNs * 1000);
+}
+
+/**
+ *  @brief  Функция передает массив байт в модель микросхемы
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *pTxData:   Указатель на первый элемент массива
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_SimTransmit(W15Q64sim_t *sim,
+                        const uint8_t *pTxData,
+                        uint32_t cnt)
+{
+    uint32_t i = 0,
+            n;
+    if (!sim->csLow)
+    {
+        sim->stats.violations++;
+        return;
+    }
+    while (i < cnt)
+    {
+        n = W15Q64_SimTxBulk(sim, &pTxData[i], cnt - i);
+        if (n != 0)
+        {
+            i += n;
+            continue;
+        }
+        W15Q64_SimTick(sim, 8000000000000ULL
+                       / ((uint64_t) sim->timing.clockHz * W15Q64_SimLines(sim)));
+        W15Q64_SimTxByte(sim, pTxData[i++]);
+    }
+    sim->stats.txBytes += cnt;
+}
+
+/**
+ *  @brief  Функция принимает массив байт из модели микросхемы
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *pRxData:   Указатель на первый элемент массива
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_SimReceive(W15Q64sim_t *sim,
+                       uint8_t *pRxData,
+                       uint32_t cnt)
+{
+    uint32_t i = 0,
+            n;
+    if (!sim->csLow)
+    {
+        sim->stats.violations++;
+        memset(pRxData, 0xFF, cnt);
+        return;
+    }
+    while (i < cnt)
+    {
+        n = W15Q64_SimRxBulk(sim, &pRxData[i], cnt - i);
+        if (n != 0)
+        {
+            i += n;
+            continue;
+        }
+        W15Q64_SimTick(sim, 8000000000000ULL
+                       / ((uint64_t) sim->timing.clockHz * W15Q64_SimLines(sim)));
+        pRxData[i++] = W15Q64_SimRxByte(sim);
+    }
+    sim->stats.rxBytes += cnt;
+}
+
+
+/**
+ *  @brief  Функция выполняет полнодуплексный обмен с моделью микросхемы:
+ *          до фазы выдачи данных микросхемой байты передаются в модель, 
+ *          в фазе выдачи данных - принимаются из нее
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *pTxData:   Указатель на массив передаваемых байт или NULL (нули)
+ *  @param  *pRxData:   Указатель на массив принимаемых байт или NULL
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_SimTransmitReceive(W15Q64sim_t *sim,
+                               const uint8_t *pTxData,
+                               uint8_t *pRxData,
+                               uint32_t cnt)
+{
+    uint32_t i;
+    uint8_t rxByte;
+
+    if (pTxData == NULL)
+    {
+        if (pRxData != NULL)
+        {
+            W15Q64_SimReceive(sim, pRxData, cnt);
+        }
+        else
+        {
+            for (i = 0; i < cnt; i++)
+            {
+                W15Q64_SimReceive(sim, &rxByte, 1);
+            }
+        }
+        return;
+    }
+    if (pRxData == NULL)
+    {
+        W15Q64_SimTransmit(sim, pTxData, cnt);
+        return;
+    }
+    for (i = 0; i < cnt; i++)
+    {
+        if (sim->idx < W15Q64_SimDataIdx(sim))
+        {
+            W15Q64_SimTransmit(sim, &pTxData[i], 1);
+            pRxData[i] = 0xFF;
+        }
+        else
+        {
+            // Фаза данных продолжается до конца транзакции
+            W15Q64_SimReceive(sim, &pRxData[i], cnt - i);
+            break;
+        }
+    }
+}
+
+/**
+ *  @brief  Функция выполняет транзакцию из нескольких сегментов (CS low,
+ *          сегменты по порядку, CS high)
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *pSeg:  Указатель на первый элемент массива сегментов
+ *  @param  segCnt: Количество сегментов
+ *  @retval None
+ */
+void W15Q64_SimSegments(W15Q64sim_t *sim,
+                        W15Q64seg_t *pSeg,
+                        uint8_t segCnt)
+{
+    uint8_t i,
+            zeros[8] = {0};
+    uint32_t cnt;
+
+    W15Q64_SimSelect(sim);
+    for (i = 0; i < segCnt; i++)
+    {
+        if (pSeg[i].dir == W15Q64_SEG_RX)
+        {
+            W15Q64_SimReceive(sim, pSeg[i].pData, pSeg[i].cnt);
+        }
+        else if (pSeg[i].dir == W15Q64_SEG_DUMMY)
+        {
+            // Такты dummy: модель считает их байтами по количеству линий фазы
+            cnt = (pSeg[i].cnt * ((pSeg[i].lines > 1) ? pSeg[i].lines : 1) + 7) / 8;
+            W15Q64_SimTransmit(sim, zeros, (cnt < sizeof (zeros)) ? cnt : sizeof (zeros));
+        }
+        else
+        {
+            W15Q64_SimTransmit(sim, pSeg[i].pData, pSeg[i].cnt);
+        }
+    }
+    W15Q64_SimDeselect(sim);
+}
+
+//==============================================================================
+// Подключение модели к структуре W15Q64spi_t
+//
+// Функции порта в W15Q64spi_t не имеют параметра контекста, поэтому для каждой
+// из W15Q64_SIM_SLOTS моделей создается свой набор функций-переходников
+
+#define W15Q64_SIM_PORT(n)                                                      \
+static void W15Q64_SimTransmit##n(uint8_t *pTxData, uint16_t cnt)              \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimTransmit(pSimSlot[n], pTxData, cnt);                              \
+}                                                                               \
+static void W15Q64_SimReceive##n(uint8_t *pRxData, uint16_t cnt)               \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimReceive(pSimSlot[n], pRxData, cnt);                               \
+}                                                                               \
+static void W15Q64_SimCsOn##n(void)                                            \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimSelect(pSimSlot[n]);                                              \
+}                                                                               \
+static void W15Q64_SimCsOff##n(void)                                           \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimDeselect(pSimSlot[n]);                                            \
+}                                                                               \
+static void W15Q64_SimDelay##n(uint32_t us)                                    \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimAdvanceNs(pSimSlot[n], (uint64_t) us * 1000);                     \
+}                                                                               \
+static void W15Q64_SimTransaction##n(W15Q64seg_t *pSeg, uint8_t segCnt)        \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimSegments(pSimSlot[n], pSeg, segCnt);                              \
+}                                                                               \
+static void W15Q64_SimDuplex##n(uint8_t *pTxData, uint8_t *pRxData,            \
+                                uint32_t cnt)                                   \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimTransmitReceive(pSimSlot[n], pTxData, pRxData, cnt);              \
+}                                                                               \
+static void W15Q64_SimDma##n(uint8_t *pTxData, uint8_t *pRxData,               \
+                             uint32_t cnt)                                      \
+{                                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+    W15Q64_SimTransmitReceive(pSimSlot[n], pTxData, pRxData, cnt);              \
+    W15Q64_DmaComplete(pSpiSlot[n]);                                            \
+}                                                                               \
+static void W15Q64_SimSetLines##n(uint8_t lines)                               \
+{                                                                               \
+    (void) lines;                                                               \
+    W15Q64_SimCall(pSimSlot[n]);                                                \
+}
+
+W15Q64_SIM_PORT(0)
+W15Q64_SIM_PORT(1)
+W15Q64_SIM_PORT(2)
+W15Q64_SIM_PORT(3)
+
+// Заполнение W15Q64spi_t функциями слота n
+#define W15Q64_SIM_PORT_INIT(n)                                                 \
+    {                                                                           \
+        .transmit = W15Q64_SimTransmit##n,                                      \
+        .receive = W15Q64_SimReceive##n,                                        \
+        .sc_ON = W15Q64_SimCsOn##n,                                             \
+        .cs_OFF = W15Q64_SimCsOff##n,                                           \
+        .delay_us = W15Q64_SimDelay##n,                                         \
+    }
+
+// Функция transaction подключается отдельно (см. W15Q64_SimGather())
+static void (* const simTransaction[W15Q64_SIM_SLOTS]) (W15Q64seg_t *pSeg,
+        uint8_t segCnt) = {
+    W15Q64_SimTransaction0,
+    W15Q64_SimTransaction1,
+    W15Q64_SimTransaction2,
+    W15Q64_SimTransaction3,
+};
+
+// Функции transmitReceive и transmitReceiveDMA подключаются отдельно
+// (см. W15Q64_SimDuplex()). Модель DMA завершает обмен сразу, вызывая
+// W15Q64_DmaComplete() до возврата из функции порта
+static void (* const simDuplex[W15Q64_SIM_SLOTS]) (uint8_t *pTxData,
+        uint8_t *pRxData,
+        uint32_t cnt) = {
+    W15Q64_SimDuplex0,
+    W15Q64_SimDuplex1,
+    W15Q64_SimDuplex2,
+    W15Q64_SimDuplex3,
+};
+static void (* const simDma[W15Q64_SIM_SLOTS]) (uint8_t *pTxData,
+        uint8_t *pRxData,
+        uint32_t cnt) = {
+    W15Q64_SimDma0,
+    W15Q64_SimDma1,
+    W15Q64_SimDma2,
+    W15Q64_SimDma3,
+};
+
+// Функция setLines подключается отдельно (см. W15Q64_SimMultiIo()). Модель
+// сама определяет количество линий по фазе команды, поэтому функция только
+// учитывает накладные расходы на вызов
+static void (* const simSetLines[W15Q64_SIM_SLOTS]) (uint8_t lines) = {
+    W15Q64_SimSetLines0,
+    W15Q64_SimSetLines1,
+    W15Q64_SimSetLines2,
+    W15Q64_SimSetLines3,
+};
+
+static const W15Q64spi_t simPort[W15Q64_SIM_SLOTS] = {
+    W15Q64_SIM_PORT_INIT(0),
+    W15Q64_SIM_PORT_INIT(1),
+    W15Q64_SIM_PORT_INIT(2),
+    W15Q64_SIM_PORT_INIT(3),
+};
+
+/**
+ *  @brief  Функция подключает модель к структуре W15Q64spi_t: после вызова
+ *          все функции драйвера работают с моделью
+ *  @param  *sim:   Указатель на структуру модели
+ *  @param  *spi:   Указатель на структуру с функциями для работы с шиной SPI,
+ *                  которая будет заполнена функциями модели
+ *  @retval true - модель подключена, false - нет свободных слотов
+ */
+_Bool W15Q64_SimBind(W15Q64sim_t *sim,
+                     W15Q64spi_t *spi)
+{
+    uint8_t i,
+            slot = W15Q64_SIM_SLOTS;
+
+    for (i = 0; i < W15Q64_SIM_SLOTS; i++)
+    {
+        if (pSimSlot[i] == sim)
+        {
+            slot = i;
+            break;
+        }
+        if ((pSimSlot[i] == NULL) && (slot == W15Q64_SIM_SLOTS))
+        {
+            slot = i;
+        }
+    }
+    if (slot == W15Q64_SIM_SLOTS)
+    {
+        return false;
+    }
+
+    pSimSlot[slot] = sim;
+    pSpiSlot[slot] = spi;
+    *spi = simPort[slot];
+    return true;
+}
+
+/**
+ *  @brief  Функция включает или выключает в структуре W15Q64spi_t функцию
+ *          transaction модели (одна транзакция на один вызов функции порта)
+ *  @param  *sim:   Указатель на структуру модели, подключенной W15Q64_SimBind()
+ *  @param  *spi:   Указатель на структуру с функциями для работы с шиной SPI
+ *  @param  enable: true - подключить функцию transaction, false - отключить
+ *  @retval None
+ */
+void W15Q64_SimGather(W15Q64sim_t *sim,
+                      W15Q64spi_t *spi,
+                      _Bool enable)
+{
+    uint8_t i;
+
+    spi->transaction = NULL;
+    for (i = 0; (i < W15Q64_SIM_SLOTS) && enable; i++)
+    {
+        if (pSimSlot[i] == sim)
+        {
+            spi->transaction = simTransaction[i];
+        }
+    }
+}
+
+/**
+ *  @brief  Функция включает или выключает в структуре W15Q64spi_t функции
+ *          transmitReceive и transmitReceiveDMA модели
+ *  @param  *sim:   Указатель на структуру модели, подключенной W15Q64_SimBind()
+ *  @param  *spi:   Указатель на структуру с функциями для работы с шиной SPI
+ *  @param  enable: true - подключить функции, false - отключить
+ *  @retval None
+ */
+void W15Q64_SimDuplex(W15Q64sim_t *sim,
+                      W15Q64spi_t *spi,
+                      _Bool enable)
+{
+    uint8_t i;
+
+    spi->transmitReceive = NULL;
+    spi->transmitReceiveDMA = NULL;
+    for (i = 0; (i < W15Q64_SIM_SLOTS) && enable; i++)
+    {
+        if (pSimSlot[i] == sim)
+        {
+            spi->transmitReceive = simDuplex[i];
+            spi->transmitReceiveDMA = simDma[i];
+        }
+    }
+}
+
+/**
+ *  @brief  Функция задает в структуре W15Q64spi_t количество линий данных,
+ *          которые поддерживает порт модели
+ *  @param  *sim:   Указатель на структуру модели, подключенной W15Q64_SimBind()
+ *  @param  *spi:   Указатель на структуру с функциями для работы с шиной SPI
+ *  @param  busWidths:  W15Q64_BUS_DUAL | W15Q64_BUS_QUAD или 0 (только 1 линия)
+ *  @retval None
+ */
+void W15Q64_SimMultiIo(W15Q64sim_t *sim,
+                       W15Q64spi_t *spi,
+                       uint8_t busWidths)
+{
+    uint8_t i;
+
+    spi->busWidths = 0;
+    spi->setLines = NULL;
+    spi->dummyAsClocks = false;
+    for (i = 0; (i < W15Q64_SIM_SLOTS) && (busWidths != 0); i++)
+    {
+        if (pSimSlot[i] == sim)
+        {
+            spi->busWidths = busWidths;
+            spi->setLines = simSetLines[i];
+            spi->dummyAsClocks = true;
+        }
+    }
+}
+
+/**
+ *  @brief  Функция освобождает слот, занятый моделью
+ *  @param  *sim:   Указатель на структуру модели
+ *  @retval None
+ */
+void W15Q64_SimUnbind(W15Q64sim_t *sim)
+{
+    uint8_t i;
+    for (i = 0; i < W15Q64_SIM_SLOTS; i++)
+    {
+        if (pSimSlot[i] == sim)
+        {
+            pSimSlot[i] = NULL;
+            pSpiSlot[i] = NULL;
+        }
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция учитывает накладные расходы на вызов функции порта
+ */
+static void W15Q64_SimCall(W15Q64sim_t *sim)
+{
+    sim->stats.portCalls++;
+    W15Q64_SimTick(sim, (uint64_t) sim->timing.callNs * 1000);
+}
+
+static void W15Q64_SimTick(W15Q64sim_t *sim,
+                           uint64_t ps)
+{
+    *sim->pNowPs += ps;
+}
+
+/**
+ *  @brief  Функция завершает внутреннюю операцию, если ее время истекло
+ */
+static void W15Q64_SimSync(W15Q64sim_t *sim)
+{
+    if ((sim->busyOp != 0)
+        && (!sim->suspended)
+        && (*sim->pNowPs >= sim->busyUntilPs))
+    {
+        W15Q64_SimComplete(sim);
+    }
+}
+
+/**
+ *  @brief  Функция возвращает значение бита BUSY. Во время Suspend бит
+ *          остается установленным в течение tSUS
+ */
+static _Bool W15Q64_SimBusy(W15Q64sim_t *sim)
+{
+    return (sim->busyOp != 0) && (*sim->pNowPs < sim->busyUntilPs);
+}
+
+static void W15Q64_SimStart(W15Q64sim_t *sim,
+                            uint8_t op,
+                            uint32_t addr,
+                            uint32_t len,
+                            uint32_t us)
+{
+    sim->busyOp = op;
+    sim->busyAddr = addr;
+    sim->busyLen = len;
+    sim->busyRemainPs = (uint64_t) us * 1000000ULL;
+    sim->busyUntilPs = *sim->pNowPs + sim->busyRemainPs;
+    sim->resumePs = *sim->pNowPs - ((uint64_t) sim->timing.tRS_us * 1000000ULL);
+    sim->suspended = false;
+    sim->sr1 |= (1 << W15Q64_BUSY);
+}
+
+/**
+ *  @brief  Функция применяет результат внутренней операции к памяти
+ */
+static void W15Q64_SimComplete(W15Q64sim_t *sim)
+{
+    uint32_t i;
+
+    switch (sim->busyOp)
+    {
+        case W15Q64_PAGE_PROGRAM:
+        case W15Q64_QUAD_PAGE_PROGRAM:
+            for (i = 0; i < W15Q64_SIM_PAGE_SIZE; i++)
+            {
+                sim->pMem[sim->busyAddr + i] &= sim->pending[i];
+            }
+            break;
+        case W15Q64_SECTOR_ERASE_4KB:
+        case W15Q64_BLOCK_ERASE_32KB:
+        case W15Q64_BLOCK_ERASE_64KB:
+        case W15Q64_CHIP_ERASE:
+            memset(&sim->pMem[sim->busyAddr], 0xFF, sim->busyLen);
+            break;
+        case W15Q64_ERASE_SECURITY_REGISTER:
+            memset(sim->secReg[sim->busyAddr], 0xFF, W15Q64_SIM_SEC_REG_SIZE);
+            break;
+        default:
+            break;
+    }
+    sim->busyOp = 0;
+    sim->sr1 &= (uint8_t) ~((1 << W15Q64_BUSY) | (1 << W15Q64_WEL));
+
+    // Page Program во время Erase Suspend: стирание снова приостановлено
+    if (sim->susOp != 0)
+    {
+        sim->busyOp = sim->susOp;
+        sim->busyAddr = sim->susAddr;
+        sim->busyLen = sim->susLen;
+        sim->busyRemainPs = sim->susRemainPs;
+        sim->busyUntilPs = *sim->pNowPs;
+        sim->suspended = true;
+        sim->susOp = 0;
+        sim->sr1 |= (1 << W15Q64_BUSY);
+    }
+}
+
+/**
+ *  @brief  Функция возвращает количество линий данных, по которым передается
+ *          текущий байт транзакции (1 - SPI, 2 - Dual, 4 - Quad)
+ */
+static uint8_t W15Q64_SimLines(W15Q64sim_t *sim)
+{
+    if (sim->qpi)
+    {
+        return 4;
+    }
+    if (sim->idx == 0)
+    {
+        return 1; //                    Instruction
+    }
+
+    switch (sim->opcode)
+    {
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+            return (sim->idx >= 2UL + W15Q64_SimAddrLen(sim)) ? 2 : 1;
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+            return (sim->idx >= 2UL + W15Q64_SimAddrLen(sim)) ? 4 : 1;
+        case W15Q64_QUAD_PAGE_PROGRAM:
+            return (sim->idx >= 1UL + W15Q64_SimAddrLen(sim)) ? 4 : 1;
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+            return 2;
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+        case W15Q64_SET_BURST_WITH_WRAP:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+/**
+ *  @brief  Функция возвращает номер первого байта фазы данных на выходе
+ *          микросхемы (после инструкции, адреса, M7-0 и dummy)
+ */
+static uint32_t W15Q64_SimDataIdx(W15Q64sim_t *sim)
+{
+    uint32_t extra = (W15Q64_SimAddrLen(sim) == 4) ? 1 : 0;
+
+    switch (sim->opcode)
+    {
+        case W15Q64_READ_STATUS_REGISTER_1:
+        case W15Q64_READ_STATUS_REGISTER_2:
+        case W15Q64_JEDEC_ID:
+            return 1;
+        case W15Q64_MANUFACTURER_DEVICE_ID:
+        case W15Q64_RELEASE_POWER_DOWN:
+            return 4;
+        case W15Q64_READ_DATA:
+            return 4 + extra;
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+        case W15Q64_READ_SFDP_REGISTER:
+        case W15Q64_READ_UNIQUE_ID:
+            return 5;
+        case W15Q64_FAST_READ:
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+        case W15Q64_READ_SECURITY_REGISTER:
+            return 5 + extra;
+        case W15Q64_WORD_READ_QUAD_IO:
+            return 6 + extra;
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+            return 7;
+        case W15Q64_FAST_READ_QUAD_IO:
+            return 7 + extra;
+        case W15Q64_BURST_READ_WITH_WRAP:
+            // Количество dummy clocks задается битами P5-4 (2, 4, 6, 8)
+            return 4 + extra + (((sim->readParams >> 4) & 0x03) + 1);
+        default:
+            return 0xFFFFFFFFUL;
+    }
+}
+
+static _Bool W15Q64_SimHasAddr(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case W15Q64_READ_DATA:
+        case W15Q64_FAST_READ:
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+        case W15Q64_BURST_READ_WITH_WRAP:
+        case W15Q64_PAGE_PROGRAM:
+        case W15Q64_QUAD_PAGE_PROGRAM:
+        case W15Q64_SECTOR_ERASE_4KB:
+        case W15Q64_BLOCK_ERASE_32KB:
+        case W15Q64_BLOCK_ERASE_64KB:
+        case W15Q64_MANUFACTURER_DEVICE_ID:
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+        case W15Q64_READ_SFDP_REGISTER:
+        case W15Q64_READ_SECURITY_REGISTER:
+        case W15Q64_ERASE_SECURITY_REGISTER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ *  @brief  Функция возвращает количество байт адреса текущей команды: 0 -
+ *          команда без адреса, 4 - в режиме 4-Byte Address (кроме команд с
+ *          фиксированным 24-битным адресом: Read SFDP и Manufacturer/Device ID)
+ */
+static uint8_t W15Q64_SimAddrLen(W15Q64sim_t *sim)
+{
+    if (!W15Q64_SimHasAddr(sim->opcode))
+    {
+        return 0;
+    }
+    switch (sim->opcode)
+    {
+        case W15Q64_READ_SFDP_REGISTER:
+        case W15Q64_MANUFACTURER_DEVICE_ID:
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+            return 3;
+        default:
+            return sim->addr4 ? 4 : 3;
+    }
+}
+
+static _Bool W15Q64_SimHasMode(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ *  @brief  Функция принимает инструкцию и проверяет, может ли микросхема
+ *          выполнить ее в текущем состоянии. Отвергнутая инструкция
+ *          заменяется на 0x00 и не выполняется
+ */
+static void W15Q64_SimOpcode(W15Q64sim_t *sim,
+                             uint8_t opcode)
+{
+    _Bool accept = true;
+
+    sim->stats.opcodes[opcode]++;
+    if ((opcode == W15Q64_READ_STATUS_REGISTER_1)
+        || (opcode == W15Q64_READ_STATUS_REGISTER_2))
+    {
+        sim->stats.statusReads++;
+    }
+
+    if (sim->powerDown)
+    {
+        accept = (opcode == W15Q64_RELEASE_POWER_DOWN);
+    }
+    else if (W15Q64_SimBusy(sim))
+    {
+        // Во время BUSY допускается только чтение статуса и Suspend
+        accept = (opcode == W15Q64_READ_STATUS_REGISTER_1)
+                || (opcode == W15Q64_READ_STATUS_REGISTER_2)
+                || ((opcode == W15Q64_ERASE_PROGRAM_SUSPEND) && (!sim->suspended)
+                    && (sim->susOp == 0));
+    }
+    else if (sim->suspended)
+    {
+        // Во время Suspend запрещены команды записи и стирания, Page Program
+        // допускается во время Erase Suspend (см. 7.2.26)
+        switch (opcode)
+        {
+            case W15Q64_PAGE_PROGRAM:
+            case W15Q64_QUAD_PAGE_PROGRAM:
+                accept = (sim->busyOp == W15Q64_SECTOR_ERASE_4KB)
+                        || (sim->busyOp == W15Q64_BLOCK_ERASE_32KB)
+                        || (sim->busyOp == W15Q64_BLOCK_ERASE_64KB);
+                break;
+            case W15Q64_WRITE_STATUS_REGISTER:
+            case W15Q64_SECTOR_ERASE_4KB:
+            case W15Q64_BLOCK_ERASE_32KB:
+            case W15Q64_BLOCK_ERASE_64KB:
+            case W15Q64_CHIP_ERASE:
+            case 0x60:
+            case W15Q64_ERASE_SECURITY_REGISTER:
+            case W15Q64_ERASE_PROGRAM_SUSPEND:
+                accept = false;
+                break;
+            default:
+                break;
+        }
+    }
+    else if ((opcode == W15Q64_BURST_READ_WITH_WRAP) && (!sim->qpi))
+    {
+        accept = false;
+    }
+    else if ((!sim->qpi) && ((sim->sr2 & (1 << W15Q64_QE)) == 0))
+    {
+        // Команды Quad SPI выполняются только при QE = 1
+        switch (opcode)
+        {
+            case W15Q64_FAST_READ_QUAD_OUTPUT:
+            case W15Q64_FAST_READ_QUAD_IO:
+            case W15Q64_WORD_READ_QUAD_IO:
+            case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+            case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+            case W15Q64_QUAD_PAGE_PROGRAM:
+                accept = false;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if ((opcode == W15Q64_READ_DATA)
+        && (sim->timing.clockHz > sim->timing.readDataMaxHz))
+    {
+        sim->stats.violations++;
+    }
+
+    if (!accept)
+    {
+        sim->stats.violations++;
+        opcode = 0x00;
+    }
+    sim->opcode = opcode;
+}
+
+static void W15Q64_SimTxByte(W15Q64sim_t *sim,
+                             uint8_t byte)
+{
+    uint32_t i = sim->idx++;
+    uint8_t addrLen;
+
+    if (i == 0)
+    {
+        W15Q64_SimOpcode(sim, byte);
+        return;
+    }
+    addrLen = W15Q64_SimAddrLen(sim);
+    if (i <= addrLen)
+    {
+        sim->addr = (sim->addr << 8) | byte; //     24(32)-Bit Address
+        if (i == addrLen)
+        {
+            sim->addr &= (sim->size - 1);
+        }
+        return;
+    }
+    if ((i == addrLen + 1UL) && W15Q64_SimHasMode(sim->opcode))
+    {
+        sim->mode = byte; //                        M7-0
+        return;
+    }
+
+    switch (sim->opcode)
+    {
+        case W15Q64_PAGE_PROGRAM:
+        case W15Q64_QUAD_PAGE_PROGRAM:
+            // Адрес заворачивается внутри страницы: 257-й байт перезаписывает первый
+            sim->page[(uint8_t) ((sim->addr & 0xFF) + (i - addrLen - 1))] = byte;
+            if (sim->pageCnt < W15Q64_SIM_PAGE_SIZE)
+            {
+                sim->pageCnt++;
+            }
+            break;
+        case W15Q64_WRITE_STATUS_REGISTER:
+            if (i <= 2)
+            {
+                sim->pending[i - 1] = byte;
+            }
+            break;
+        case W15Q64_SET_READ_PARAMETERS:
+            if (i == 1)
+            {
+                sim->pending[0] = byte;
+            }
+            break;
+        case W15Q64_SET_BURST_WITH_WRAP:
+            if (i == 4)
+            {
+                sim->pending[0] = byte; //          W7-0 после 3 dummy bytes
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static uint8_t W15Q64_SimRxByte(W15Q64sim_t *sim)
+{
+    uint32_t i = sim->idx++,
+            dataIdx = W15Q64_SimDataIdx(sim);
+    uint8_t byte = 0xFF,
+            sel;
+
+    if (i < dataIdx)
+    {
+        return byte; //                 Микросхема еще не выдает данные
+    }
+
+    switch (sim->opcode)
+    {
+        case W15Q64_READ_STATUS_REGISTER_1:
+            // BUSY = 0 означает, что результат операции уже виден в памяти
+            W15Q64_SimSync(sim);
+            byte = sim->sr1;
+            if (!W15Q64_SimBusy(sim))
+            {
+                byte &= (uint8_t) ~(1 << W15Q64_BUSY);
+            }
+            break;
+        case W15Q64_READ_STATUS_REGISTER_2:
+            byte = sim->sr2;
+            break;
+        case W15Q64_READ_DATA:
+        case W15Q64_FAST_READ:
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+        case W15Q64_BURST_READ_WITH_WRAP:
+            W15Q64_SimCheckRead(sim, 1);
+            byte = sim->pMem[sim->addr];
+            W15Q64_SimNextAddr(sim);
+            break;
+        case W15Q64_READ_SFDP_REGISTER:
+            byte = sim->sfdp[sim->addr & (W15Q64_SIM_SFDP_SIZE - 1)];
+            sim->addr++;
+            break;
+        case W15Q64_READ_SECURITY_REGISTER:
+            sel = (uint8_t) ((sim->addr >> 12) & 0x0F);
+            if ((sel >= 1) && (sel <= 3))
+            {
+                byte = sim->secReg[sel - 1][sim->addr & 0xFF];
+            }
+            sim->addr = (sim->addr & ~0xFFUL) | ((sim->addr + 1) & 0xFF);
+            break;
+        case W15Q64_MANUFACTURER_DEVICE_ID:
+        case W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO:
+        case W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO:
+            // Порядок байт зависит от бита A0 адреса
+            byte = (((i - dataIdx) ^ sim->addr) & 1)
+                    ? W15Q64_SIM_DEVICE_ID : W15Q64_SIM_MANUFACTURER_ID;
+            break;
+        case W15Q64_JEDEC_ID:
+            switch ((i - dataIdx) % 3)
+            {
+                case 0: byte = W15Q64_SIM_MANUFACTURER_ID;
+                    break;
+                case 1: byte = W15Q64_SIM_MEMORY_TYPE;
+                    break;
+                default:
+                    // Код объема - log2(size): 17h для 8 MiB
+                    for (byte = 0; (1UL << byte) < sim->size; byte++)
+                    {
+                    }
+                    break;
+            }
+            break;
+        case W15Q64_READ_UNIQUE_ID:
+            byte = sim->uniqueId[(i - dataIdx) % W15Q64_SIM_UNIQUE_ID_SIZE];
+            break;
+        case W15Q64_RELEASE_POWER_DOWN:
+            byte = W15Q64_SIM_DEVICE_ID;
+            break;
+        default:
+            break;
+    }
+    return byte;
+}
+
+/**
+ *  @brief  Функция принимает из модели сразу несколько байт фазы данных
+ *          команды чтения без заворачивания адреса (копированием из памяти,
+ *          а не побайтно). Время передачи то же, что при побайтном приеме
+ *  @retval Количество принятых байт, 0 - быстрый путь неприменим
+ */
+static uint32_t W15Q64_SimRxBulk(W15Q64sim_t *sim,
+                                 uint8_t *pRxData,
+                                 uint32_t cnt)
+{
+    uint32_t n;
+
+    switch (sim->opcode)
+    {
+        case W15Q64_READ_DATA:
+        case W15Q64_FAST_READ:
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+            break;
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+            if ((sim->wrapBits & 0x10) == 0)
+            {
+                return 0;
+            }
+            break;
+        default:
+            return 0;
+    }
+    if ((cnt < 2) || (sim->idx < W15Q64_SimDataIdx(sim)))
+    {
+        return 0;
+    }
+
+    // До конца памяти, дальше адрес заворачивается на 0
+    n = sim->size - sim->addr;
+    if (n > cnt)
+    {
+        n = cnt;
+    }
+    W15Q64_SimTick(sim, (uint64_t) n * (8000000000000ULL
+                   / ((uint64_t) sim->timing.clockHz * W15Q64_SimLines(sim))));
+    W15Q64_SimCheckRead(sim, n);
+    memcpy(pRxData, &sim->pMem[sim->addr], n);
+    sim->addr = (sim->addr + n) & (sim->size - 1);
+    sim->idx += n;
+    return n;
+}
+
+/**
+ *  @brief  Функция учитывает чтение cnt байт с текущего адреса во время
+ *          Suspend: данные приостановленной области (стираемого блока или
+ *          программируемой страницы) не определены. Нарушение учитывается
+ *          один раз за транзакцию
+ */
+static void W15Q64_SimCheckRead(W15Q64sim_t *sim,
+                                uint32_t cnt)
+{
+    if (sim->suspended
+        && (!sim->susRead)
+        && (((sim->addr - sim->busyAddr) < sim->busyLen)
+            || ((sim->busyAddr - sim->addr) < cnt)))
+    {
+        sim->stats.violations++;
+        sim->susRead = true;
+    }
+}
+
+/**
+ *  @brief  Функция передает в модель сразу несколько байт данных Page
+ *          Program (до конца страницы, следующий вызов продолжает с начала
+ *          страницы)
+ *  @retval Количество переданных байт, 0 - быстрый путь неприменим
+ */
+static uint32_t W15Q64_SimTxBulk(W15Q64sim_t *sim,
+                                 const uint8_t *pTxData,
+                                 uint32_t cnt)
+{
+    uint32_t n,
+            pos;
+
+    if (((sim->opcode != W15Q64_PAGE_PROGRAM) && (sim->opcode != W15Q64_QUAD_PAGE_PROGRAM))
+        || (cnt < 2) || (sim->idx <= W15Q64_SimAddrLen(sim)))
+    {
+        return 0;
+    }
+    // Номер байта данных в транзакции, адрес заворачивается внутри страницы
+    pos = ((sim->addr & 0xFF) + (sim->idx - W15Q64_SimAddrLen(sim) - 1)) & 0xFF;
+    n = W15Q64_SIM_PAGE_SIZE - pos;
+    if (n > cnt)
+    {
+        n = cnt;
+    }
+    W15Q64_SimTick(sim, (uint64_t) n * (8000000000000ULL
+                   / ((uint64_t) sim->timing.clockHz * W15Q64_SimLines(sim))));
+    memcpy(&sim->page[pos], pTxData, n);
+    sim->pageCnt = (uint16_t) (((sim->pageCnt + n) < W15Q64_SIM_PAGE_SIZE)
+            ? (sim->pageCnt + n) : W15Q64_SIM_PAGE_SIZE);
+    sim->idx += n;
+    return n;
+}
+
+/**
+ *  @brief  Функция вычисляет адрес следующего байта при чтении с учетом
+ *          режима Burst with Wrap
+ */
+static void W15Q64_SimNextAddr(W15Q64sim_t *sim)
+{
+    uint32_t wrap = 0;
+
+    if (sim->opcode == W15Q64_BURST_READ_WITH_WRAP)
+    {
+        wrap = 8UL << (sim->readParams & 0x03);
+    }
+    else if (((sim->opcode == W15Q64_FAST_READ_QUAD_IO)
+              || (sim->opcode == W15Q64_WORD_READ_QUAD_IO))
+             && ((sim->wrapBits & 0x10) == 0))
+    {
+        wrap = 8UL << ((sim->wrapBits >> 5) & 0x03);
+    }
+
+    if (wrap != 0)
+    {
+        sim->addr = (sim->addr & ~(wrap - 1)) | ((sim->addr + 1) & (wrap - 1));
+    }
+    else
+    {
+        sim->addr = (sim->addr + 1) & (sim->size - 1);
+    }
+}
+
+/**
+ *  @brief  Функция выполняет команду по переходу CS в "1"
+ */
+static void W15Q64_SimExecute(W15Q64sim_t *sim)
+{
+    uint8_t op = sim->opcode;
+    uint32_t n = sim->idx,
+            cmdLen = 1UL + W15Q64_SimAddrLen(sim); //   Instruction, Address
+    _Bool wel = (sim->sr1 & (1 << W15Q64_WEL)) != 0;
+    uint64_t now = *sim->pNowPs,
+            tRS = (uint64_t) sim->timing.tRS_us * 1000000ULL;
+
+    // Continuous Read: M5-4 = 10b оставляет микросхему в режиме, любое другое
+    // значение или транзакция короче адреса с M7-0 - выход из режима
+    if (W15Q64_SimHasMode(op)
+        && (op != W15Q64_MANUFACTURER_DEVICE_ID_BY_DUAL_IO)
+        && (op != W15Q64_MANUFACTURE_DEVICE_ID_BY_QUAD_IO))
+    {
+        sim->contRead = (n > cmdLen)
+                && ((sim->mode & W15Q64_SIM_CONT_READ_MASK) == W15Q64_SIM_CONT_READ_BITS);
+        sim->contOpcode = op;
+        return;
+    }
+    if (n == 0)
+    {
+        return;
+    }
+    if (op != W15Q64_ENABLE_RESET)
+    {
+        sim->resetEn = false;
+    }
+
+    switch (op)
+    {
+        case W15Q64_WRITE_ENABLE:
+            sim->sr1 |= (1 << W15Q64_WEL);
+            break;
+        case W15Q64_WRITE_DIS:
+            sim->sr1 &= (uint8_t) ~(1 << W15Q64_WEL);
+            sim->volatileSrEn = false;
+            break;
+        case W15Q64_VOLATILE_SR_WRITE_EN:
+            sim->volatileSrEn = true;
+            break;
+        case W15Q64_WRITE_STATUS_REGISTER:
+            if ((n < 2) || (!(wel || sim->volatileSrEn)))
+            {
+                sim->stats.violations++;
+                break;
+            }
+            sim->sr1 = (uint8_t) ((sim->sr1 & 0x03) | (sim->pending[0] & 0xFC));
+            // Без второго байта биты SR2 (кроме OTP битов LB) сбрасываются
+            sim->sr2 = (uint8_t) ((sim->sr2 & 0xBC)
+                    | ((n >= 3) ? (sim->pending[1] & 0x7B) : 0x00));
+            if (sim->volatileSrEn)
+            {
+                sim->volatileSrEn = false;
+            }
+            else
+            {
+                W15Q64_SimStart(sim, op, 0, 0, sim->timing.tW_us);
+            }
+            break;
+        case W15Q64_PAGE_PROGRAM:
+        case W15Q64_QUAD_PAGE_PROGRAM:
+            if ((n <= cmdLen) || (!wel))
+            {
+                sim->stats.violations++;
+                break;
+            }
+            if (sim->suspended)
+            {
+                // Программирование приостановленного сектора не определено
+                if ((sim->addr - sim->busyAddr) < sim->busyLen)
+                {
+                    sim->stats.violations++;
+                    break;
+                }
+                sim->susOp = sim->busyOp;
+                sim->susAddr = sim->busyAddr;
+                sim->susLen = sim->busyLen;
+                sim->susRemainPs = sim->busyRemainPs;
+            }
+            memcpy(sim->pending, sim->page, W15Q64_SIM_PAGE_SIZE);
+            W15Q64_SimStart(sim, op, sim->addr & ~0xFFUL,
+                            W15Q64_SIM_PAGE_SIZE, sim->timing.tPP_us);
+            break;
+        case W15Q64_SECTOR_ERASE_4KB:
+        case W15Q64_BLOCK_ERASE_32KB:
+        case W15Q64_BLOCK_ERASE_64KB:
+        {
+            uint32_t len = (op == W15Q64_SECTOR_ERASE_4KB) ? W15Q64_SIM_SECTOR_SIZE
+                    : (op == W15Q64_BLOCK_ERASE_32KB) ? W15Q64_SIM_BLOCK_32KB_SIZE
+                    : W15Q64_SIM_BLOCK_64KB_SIZE;
+            uint32_t us = (op == W15Q64_SECTOR_ERASE_4KB) ? sim->timing.tSE_us
+                    : (op == W15Q64_BLOCK_ERASE_32KB) ? sim->timing.tBE1_us
+                    : sim->timing.tBE2_us;
+            if ((n != cmdLen) || (!wel))
+            {
+                sim->stats.violations++;
+                break;
+            }
+            W15Q64_SimStart(sim, op, sim->addr & ~(len - 1), len, us);
+            break;
+        }
+        case W15Q64_CHIP_ERASE:
+        case 0x60:
+            if ((n != 1) || (!wel))
+            {
+                sim->stats.violations++;
+                break;
+            }
+            W15Q64_SimStart(sim, W15Q64_CHIP_ERASE, 0, sim->size, sim->timing.tCE_us);
+            break;
+        case W15Q64_ERASE_SECURITY_REGISTER:
+        {
+            uint8_t sel = (uint8_t) ((sim->addr >> 12) & 0x0F);
+            if ((n != cmdLen) || (!wel) || (sel < 1) || (sel > 3))
+            {
+                sim->stats.violations++;
+                break;
+            }
+            W15Q64_SimStart(sim, op, sel - 1, 0, sim->timing.tSE_us);
+            break;
+        }
+        case W15Q64_ERASE_PROGRAM_SUSPEND:
+            if ((sim->busyOp == 0) || (sim->busyOp == W15Q64_WRITE_STATUS_REGISTER))
+            {
+                break;
+            }
+            // Операция продвигается вперед, только если с момента Resume
+            // прошло не меньше tRS
+            if ((now - sim->resumePs) >= tRS)
+            {
+                sim->busyRemainPs = sim->busyUntilPs - now;
+            }
+            sim->suspended = true;
+            sim->sr2 |= (1 << W15Q64_SUS);
+            sim->busyUntilPs = now + (uint64_t) sim->timing.tSUS_us * 1000000ULL;
+            break;
+        case W15Q64_ERASE_PROGRAM_RESUME:
+            if (!sim->suspended)
+            {
+                break;
+            }
+            sim->suspended = false;
+            sim->sr2 &= (uint8_t) ~(1 << W15Q64_SUS);
+            sim->busyUntilPs = now + sim->busyRemainPs;
+            sim->resumePs = now;
+            break;
+        case W15Q64_ENTER_4BYTE_ADDRESS_MODE:
+            // Микросхемы до 16 MiB не поддерживают 4-Byte Address
+            sim->addr4 = sim->size > 0x1000000UL;
+            break;
+        case W15Q64_EXIT_4BYTE_ADDRESS_MODE:
+            sim->addr4 = false;
+            break;
+        case W15Q64_POWER_DOWN:
+            sim->powerDown = true;
+            break;
+        case W15Q64_RELEASE_POWER_DOWN:
+            sim->powerDown = false;
+            break;
+        case W15Q64_ENABLE_QPI:
+            sim->qpi = true;
+            break;
+        case 0xFF:
+            sim->qpi = false; //                Disable QPI
+            break;
+        case W15Q64_ENABLE_RESET:
+            sim->resetEn = true;
+            break;
+        case W15Q64_RESET:
+            if (!sim->resetEn)
+            {
+                break;
+            }
+            sim->resetEn = false;
+            sim->busyOp = 0;
+            sim->susOp = 0;
+            sim->suspended = false;
+            sim->sr1 &= (uint8_t) ~((1 << W15Q64_BUSY) | (1 << W15Q64_WEL));
+            sim->sr2 &= (uint8_t) ~(1 << W15Q64_SUS);
+            sim->volatileSrEn = false;
+            sim->qpi = false;
+            sim->addr4 = false;
+            sim->contRead = false;
+            sim->wrapBits = 0x10;
+            sim->readParams = 0;
+            break;
+        case W15Q64_SET_READ_PARAMETERS:
+            if (n >= 2)
+            {
+                sim->readParams = sim->pending[0];
+            }
+            break;
+        case W15Q64_SET_BURST_WITH_WRAP:
+            if (n >= 5)
+            {
+                sim->wrapBits = sim->pending[0];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ *  @brief  Функция формирует таблицу SFDP (JESD216B: заголовок и Basic Flash
+ *          Parameter Table из 16 слов по адресу 0x80)
+ */
+static void W15Q64_SimBuildSfdp(W15Q64sim_t *sim)
+{
+    uint32_t dw[16] = {
+        0xFFF920E5UL, //    4KB erase 20h, 1-1-2, 1-2-2, 1-4-4, 1-1-4, 3-Byte Address
+        0, //               Density, заполняется ниже
+        0x6B08EB44UL, //    1-4-4: EBh, 2 mode + 4 dummy; 1-1-4: 6Bh, 8 dummy
+        0xBB803B08UL, //    1-1-2: 3Bh, 8 dummy; 1-2-2: BBh, 4 mode clocks
+        0xFFFFFFEEUL, //    4-4-4 supported
+        0xFFFFFFFFUL,
+        0xEB42FFFFUL, //    4-4-4: EBh, 2 mode + 2 dummy
+        0x520F200CUL, //    Erase type 1: 4KB 20h, type 2: 32KB 52h
+        0xFF00D810UL, //    Erase type 3: 64KB D8h
+        0x00000000UL, //    Времена стирания, заполняются ниже
+        0x00000000UL, //    Page size, Page Program, Chip Erase, заполняются ниже
+        0x00000000UL, //    Suspend/Resume, заполняется ниже
+        0x757A757AUL, //    Suspend 75h, Resume 7Ah
+        0x00000000UL, //    Deep Power-down B9h/ABh, заполняется ниже
+        0xFF40FFFFUL, //    QE - бит 1 SR2, запись командой 01h двумя байтами
+        0x00001000UL //     Soft reset 66h/99h; 4-Byte Address - см. ниже
+    };
+    uint8_t i;
+
+    memset(sim->sfdp, 0xFF, sizeof (sim->sfdp));
+    sim->sfdp[0] = 'S';
+    sim->sfdp[1] = 'F';
+    sim->sfdp[2] = 'D';
+    sim->sfdp[3] = 'P';
+    sim->sfdp[4] = 0x06; //             JESD216B
+    sim->sfdp[5] = 0x01;
+    sim->sfdp[6] = 0x00; //             Один заголовок параметров
+    // Parameter Header 0: Basic Flash Parameter Table
+    sim->sfdp[8] = 0x00;
+    sim->sfdp[9] = 0x06;
+    sim->sfdp[10] = 0x01;
+    sim->sfdp[11] = 16;
+    sim->sfdp[12] = 0x80;
+    sim->sfdp[13] = 0x00;
+    sim->sfdp[14] = 0x00;
+    sim->sfdp[15] = 0xFF;
+
+    dw[1] = sim->size * 8 - 1;
+    if (sim->size > 0x1000000UL)
+    {
+        // 3-Byte или 4-Byte Address, вход в 4-Byte Address командой B7h,
+        // выход - E9h
+        dw[0] |= 1UL << 17;
+        dw[15] |= (0x01UL << 24) | (0x01UL << 14);
+    }
+    // Типовые времена стирания в единицах 16 мс (с округлением вверх),
+    // максимум = 8 x типовое
+    dw[9] = 0x03UL
+            | (((((sim->timing.tSE_us + 15999) / 16000) - 1) & 0x1F) << 4) | (1UL << 9)
+            | (((((sim->timing.tBE1_us + 15999) / 16000) - 1) & 0x1F) << 11) | (1UL << 16)
+            | (((((sim->timing.tBE2_us + 15999) / 16000) - 1) & 0x1F) << 18) | (1UL << 23);
+    // Page Program в единицах 64 мкс, максимум = 6 x типовое, Chip Erase в
+    // единицах 4 с
+    dw[10] = 0x02UL | (8UL << 4)
+            | (((((sim->timing.tPP_us + 63) / 64) - 1) & 0x1F) << 8) | (1UL << 13)
+            | (((((sim->timing.tCE_us + 3999999UL) / 4000000UL) - 1) & 0x1F) << 24) | (2UL << 29);
+    // Suspend latency в единицах 1 мкс, интервал Resume -> Suspend 64 мкс
+    dw[11] = ((((sim->timing.tSUS_us) - 1) & 0x1F) << 24) | (1UL << 29)
+            | ((((sim->timing.tSUS_us) - 1) & 0x1F) << 13) | (1UL << 18)
+            | ((((sim->timing.tRS_us / 64) - 1) & 0x0F) << 20)
+            | ((((sim->timing.tRS_us / 64) - 1) & 0x0F) << 9);
+    dw[13] = (0xB9UL << 23) | (0xABUL << 15) | (1UL << 13) | (2UL << 8) | 0x04UL;
+
+    for (i = 0; i < 16; i++)
+    {
+        sim->sfdp[0x80 + 4 * i + 0] = (uint8_t) (dw[i] & 0xFF);
+        sim->sfdp[0x80 + 4 * i + 1] = (uint8_t) ((dw[i] >> 8) & 0xFF);
+        sim->sfdp[0x80 + 4 * i + 2] = (uint8_t) ((dw[i] >> 16) & 0xFF);
+        sim->sfdp[0x80 + 4 * i + 3] = (uint8_t) ((dw[i] >> 24) & 0xFF);
+    }
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
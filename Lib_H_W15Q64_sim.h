@@ -0,0 +1,199 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_sim.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Программная модель микросхемы flash памяти w15q64 для запуска
+ *              драйвера на хосте (Linux) без отладочной платы
+ *  @warning    Модель подключается к драйверу через стандартную структуру
+ *              W15Q64spi_t (см. W15Q64_SimBind()), поэтому драйвер и модули
+ *              верхнего уровня работают с ней так же, как с микросхемой.
+ *              Время в модели виртуальное: оно складывается из времени
+ *              передачи байт по шине, накладных расходов на вызов функций
+ *              порта и времени внутренних операций (BUSY).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_SIM_H
+#define	LIB_H_W15Q64_SIM_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_SIM_CAPACITY                               0x800000UL
+#define W15Q64_SIM_MAX_SIZE                               0x8000000UL // 128 MiB
+#define W15Q64_SIM_PAGE_SIZE                              256
+#define W15Q64_SIM_SECTOR_SIZE                            4096
+#define W15Q64_SIM_BLOCK_32KB_SIZE                        0x8000UL
+#define W15Q64_SIM_BLOCK_64KB_SIZE                        0x10000UL
+#define W15Q64_SIM_SEC_REG_SIZE                           256
+#define W15Q64_SIM_SFDP_SIZE                              256
+#define W15Q64_SIM_UNIQUE_ID_SIZE                         8
+
+// Количество моделей, которые одновременно могут быть подключены к W15Q64spi_t
+#define W15Q64_SIM_SLOTS                                  4
+
+// Идентификаторы, которые возвращает модель (см. 7.2.31 - 7.2.35)
+#define W15Q64_SIM_MANUFACTURER_ID                        0xEF
+#define W15Q64_SIM_DEVICE_ID                              0x16
+#define W15Q64_SIM_MEMORY_TYPE                            0x40
+#define W15Q64_SIM_CAPACITY_ID                            0x17 // Для 8 MiB, для
+//                                                                 других размеров
+//                                                                 log2(size)
+
+// Значение M7-0, при котором микросхема остается в режиме Continuous Read
+#define W15Q64_SIM_CONT_READ_MASK                         0x30
+#define W15Q64_SIM_CONT_READ_BITS                         0x20
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t clockHz; //        Частота SCK
+    uint32_t readDataMaxHz; //  Максимальная частота для Read Data (03h), fR
+    uint32_t callNs; //         Накладные расходы на один вызов функции порта
+    uint32_t csHighNs; //       Минимальное время CS в "1" между командами, tSHSL
+    uint32_t tW_us; //          Write Status Register
+    uint32_t tPP_us; //         Page Program
+    uint32_t tSE_us; //         Sector Erase 4KB
+    uint32_t tBE1_us; //        Block Erase 32KB
+    uint32_t tBE2_us; //        Block Erase 64KB
+    uint32_t tCE_us; //         Chip Erase
+    uint32_t tSUS_us; //        Suspend latency
+    uint32_t tRS_us; //         Минимальный интервал Resume -> Suspend, при
+    //                          котором операция продвигается вперед
+} W15Q64simTiming_t; // Структура содержит параметры временной модели микросхемы
+
+typedef struct {
+    uint64_t csCycles; //       Количество транзакций (CS low -> CS high)
+    uint64_t portCalls; //      Количество вызовов функций порта
+    uint64_t txBytes; //        Байт передано в микросхему
+    uint64_t rxBytes; //        Байт принято из микросхемы
+    uint64_t statusReads; //    Количество чтений Status Register
+    uint64_t violations; //     Нарушения протокола (команда во время BUSY,
+    //                          запись без WEL, превышение fR, чтение
+    //                          приостановленной области и т.п.)
+    uint64_t opcodes[256]; //   Количество команд по кодам инструкций
+} W15Q64simStats_t; // Структура содержит счетчики трафика на шине
+
+typedef struct {
+    uint8_t *pMem; //           Массив памяти микросхемы
+    uint32_t size; //           Размер памяти в байтах
+    _Bool ownMem; //            Память выделена моделью
+    W15Q64simTiming_t timing;
+    W15Q64simStats_t stats;
+    uint64_t nowPs; //          Виртуальное время в пикосекундах
+    uint64_t *pNowPs; //        Часы модели: &nowPs или общие часы шины
+    //                          (см. W15Q64_SimShareClock())
+
+    // Регистры и состояние микросхемы
+    uint8_t sr1;
+    uint8_t sr2;
+    _Bool volatileSrEn; //      Была команда 50h
+    _Bool powerDown;
+    _Bool qpi;
+    _Bool addr4; //             Режим 4-Byte Address (B7h), только при
+    //                          size > 16 MiB
+    _Bool contRead; //          Continuous Read Mode (BBh, EBh, E7h, E3h)
+    uint8_t contOpcode;
+    _Bool resetEn; //           Была команда 66h
+    uint8_t readParams; //      Set Read Parameters (C0h)
+    uint8_t wrapBits; //        Set Burst with Wrap (77h)
+    uint8_t secReg[3][W15Q64_SIM_SEC_REG_SIZE];
+    uint8_t uniqueId[W15Q64_SIM_UNIQUE_ID_SIZE];
+    uint8_t sfdp[W15Q64_SIM_SFDP_SIZE];
+
+    // Внутренняя операция (program/erase/write status)
+    uint8_t busyOp; //          Инструкция, запустившая операцию, 0 - нет
+    uint32_t busyAddr;
+    uint32_t busyLen;
+    uint64_t busyUntilPs;
+    uint64_t busyRemainPs; //   Остаток операции во время Suspend
+    uint64_t resumePs; //       Момент последней команды Resume
+    _Bool suspended;
+    uint8_t susOp; //           Стирание, приостановленное на время Page
+    //                          Program (Erase Suspend), 0 - нет
+    uint32_t susAddr;
+    uint32_t susLen;
+    uint64_t susRemainPs;
+    uint8_t pending[W15Q64_SIM_PAGE_SIZE]; // Данные Page Program / Write SR
+
+    // Декодирование текущей транзакции
+    _Bool csLow;
+    uint8_t opcode;
+    uint32_t idx; //            Номер байта в транзакции
+    uint32_t addr;
+    uint8_t mode; //            Биты M7-0
+    uint16_t pageCnt; //        Количество принятых байт Page Program
+    _Bool susRead; //           Чтение приостановленной области уже учтено
+    uint8_t page[W15Q64_SIM_PAGE_SIZE];
+} W15Q64sim_t; // Структура содержит состояние модели микросхемы
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_SimDefaultTiming(W15Q64simTiming_t *timing);
+extern _Bool W15Q64_SimInit(W15Q64sim_t *sim,
+        uint8_t *pMem,
+        uint32_t size);
+extern void W15Q64_SimFree(W15Q64sim_t *sim);
+extern _Bool W15Q64_SimBind(W15Q64sim_t *sim,
+        W15Q64spi_t *spi);
+extern void W15Q64_SimUnbind(W15Q64sim_t *sim);
+extern void W15Q64_SimGather(W15Q64sim_t *sim,
+        W15Q64spi_t *spi,
+        _Bool enable);
+extern void W15Q64_SimDuplex(W15Q64sim_t *sim,
+        W15Q64spi_t *spi,
+        _Bool enable);
+extern void W15Q64_SimMultiIo(W15Q64sim_t *sim,
+        W15Q64spi_t *spi,
+        uint8_t busWidths);
+extern void W15Q64_SimShareClock(W15Q64sim_t *sim,
+        W15Q64sim_t *clock);
+extern void W15Q64_SimResetStats(W15Q64sim_t *sim);
+extern uint64_t W15Q64_SimNowNs(W15Q64sim_t *sim);
+extern void W15Q64_SimAdvanceNs(W15Q64sim_t *sim,
+        uint64_t ns);
+extern _Bool W15Q64_SimIsBusy(W15Q64sim_t *sim);
+
+// Низкоуровневый доступ к шине модели (используется функциями порта)
+extern void W15Q64_SimSelect(W15Q64sim_t *sim);
+extern void W15Q64_SimDeselect(W15Q64sim_t *sim);
+extern void W15Q64_SimTransmit(W15Q64sim_t *sim,
+        const uint8_t *pTxData,
+        uint32_t cnt);
+extern void W15Q64_SimReceive(W15Q64sim_t *sim,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_SimTransmitReceive(W15Q64sim_t *sim,
+        const uint8_t *pTxData,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_SimSegments(W15Q64sim_t *sim,
+        W15Q64seg_t *pSeg,
+        uint8_t segCnt);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
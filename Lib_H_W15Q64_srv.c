@@ -0,0 +1,319 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_srv.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Доступ к одной микросхеме flash памяти w15q64 из нескольких
+ *              задач (потоков) через очередь запросов с приоритетами
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include "Lib_H_W15Q64_srv.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static W15Q64job_t *W15Q64_SrvPick(W15Q64srv_t *srv,
+                                   _Bool read);
+static _Bool W15Q64_SrvReady(W15Q64srv_t *srv,
+                             W15Q64job_t *job);
+static _Bool W15Q64_SrvUnlink(W15Q64srv_t *srv,
+                              W15Q64job_t *job);
+static _Bool W15Q64_SrvOverlap(const W15Q64job_t *a,
+                               const W15Q64job_t *b);
+static void W15Q64_SrvSpan(const W15Q64job_t *job,
+                           uint32_t *pLo,
+                           uint32_t *pHi);
+static _Bool W15Q64_SrvIsRead(const W15Q64job_t *job);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция инициализирует пустую очередь запросов
+ *  @param  *srv:   Указатель на структуру очереди запросов
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  *os:    Указатель на структуру с функциями синхронизации ОС
+ *                  (копируется)
+ *  @param  now_us: Функция, возвращающая текущее время в микросекундах, или
+ *                  NULL. Если задана, чтения выполняются во время стирания и
+ *                  записи (см. W15Q64_JobPreempt()). Вызывается только из
+ *                  задачи обслуживания
+ *  @retval None
+ */
+void W15Q64_SrvInit(W15Q64srv_t *srv,
+                    W15Q64spi_t *spi,
+                    const W15Q64os_t *os,
+                    uint32_t (* now_us) (void))
+{
+    W15Q64_JobInit(&srv->queue, spi);
+    W15Q64_JobPreempt(&srv->queue, now_us != NULL, now_us);
+    srv->os = *os;
+    srv->pollUs = (spi->pollFirstUs != 0) ? spi->pollFirstUs : W15Q64_SRV_POLL_US;
+    srv->pPending = NULL;
+    srv->pPendingTail = NULL;
+    srv->stop = false;
+    srv->submitted = 0;
+    srv->bypassed = 0;
+}
+
+/**
+ *  @brief  Функция ставит запрос в очередь и будит задачу обслуживания.
+ *          Может вызываться из любой задачи
+ *  @param  *srv:   Указатель на структуру очереди запросов
+ *  @param  *job:   Указатель на задание, заполненное W15Q64_JobRead(),
+ *                  W15Q64_JobProgram() или W15Q64_JobErase(). Функция
+ *                  завершения вызывается из задачи обслуживания
+ *  @param  prio:   Приоритет, запрос с большим значением выполняется раньше
+ *  @retval None
+ */
+void W15Q64_SrvSubmit(W15Q64srv_t *srv,
+                      W15Q64job_t *job,
+                      uint8_t prio)
+{
+    job->prio = prio;
+    job->pNext = NULL;
+    job->state = W15Q64_JOB_QUEUED;
+
+    srv->os.lock(srv->os.pCtx);
+    if (srv->pPendingTail == NULL)
+    {
+        srv->pPending = job;
+    }
+    else
+    {
+        srv->pPendingTail->pNext = job;
+    }
+    srv->pPendingTail = job;
+    srv->submitted++;
+    srv->os.unlock(srv->os.pCtx);
+
+    srv->os.signal(srv->os.pCtx);
+}
+
+/**
+ *  @brief  Функция передает готовые запросы в очередь драйвера и выполняет
+ *          один шаг W15Q64_Poll(). Вызывается только задачей обслуживания
+ *  @param  *srv:   Указатель на структуру очереди запросов
+ *  @retval true - остались невыполненные запросы
+ */
+_Bool W15Q64_SrvStep(W15Q64srv_t *srv)
+{
+    W15Q64job_t *job;
+    _Bool pending;
+
+    srv->os.lock(srv->os.pCtx);
+
+    // Все готовые чтения - в порядке приоритета
+    while ((job = W15Q64_SrvPick(srv, true)) != NULL)
+    {
+        if (W15Q64_SrvUnlink(srv, job) || (srv->queue.pHead != NULL))
+        {
+            srv->bypassed++;
+        }
+        W15Q64_JobSubmitRead(&srv->queue, job);
+    }
+
+    // Запись или стирание - по одной и только после выданных чтений
+    if ((srv->queue.pHead == NULL) && (srv->queue.pRead == NULL))
+    {
+        job = W15Q64_SrvPick(srv, false);
+        if (job != NULL)
+        {
+            W15Q64_SrvUnlink(srv, job);
+            W15Q64_JobSubmit(&srv->queue, job);
+        }
+    }
+    pending = srv->pPending != NULL;
+
+    srv->os.unlock(srv->os.pCtx);
+
+    return W15Q64_Poll(&srv->queue) || pending;
+}
+
+/**
+ *  @brief  Функция задачи обслуживания: выполняет запросы, а при их
+ *          отсутствии ждет W15Q64_SrvSubmit(). Возвращает управление после
+ *          W15Q64_SrvStop()
+ *  @param  *srv:   Указатель на структуру очереди запросов
+ *  @retval None
+ */
+void W15Q64_SrvRun(W15Q64srv_t *srv)
+{
+    while (!srv->stop)
+    {
+        if (!W15Q64_SrvStep(srv))
+        {
+            srv->os.wait(srv->os.pCtx, 0);
+        }
+        else if (srv->queue.issued
+                 && ((srv->queue.pRead == NULL) || (!srv->queue.preempt)))
+        {
+            // Микросхема занята, а чтений, которые можно выполнить, нет
+            srv->os.wait(srv->os.pCtx, srv->pollUs);
+        }
+    }
+}
+
+/**
+ *  @brief  Функция завершает W15Q64_SrvRun(). Невыполненные запросы
+ *          остаются в очереди
+ *  @param  *srv:   Указатель на структуру очереди запросов
+ *  @retval None
+ */
+void W15Q64_SrvStop(W15Q64srv_t *srv)
+{
+    srv->stop = true;
+    srv->os.signal(srv->os.pCtx);
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция выбирает готовый запрос с наибольшим приоритетом (при
+ *          равных - поставленный раньше)
+ *  @param  read:   true - среди чтений, false - среди записей и стираний
+ */
+static W15Q64job_t *W15Q64_SrvPick(W15Q64srv_t *srv,
+                                   _Bool read)
+{
+    W15Q64job_t *job,
+            *best = NULL;
+
+    for (job = srv->pPending; job != NULL; job = job->pNext)
+    {
+        if ((W15Q64_SrvIsRead(job) == read)
+            && ((best == NULL) || (job->prio > best->prio))
+            && W15Q64_SrvReady(srv, job))
+        {
+            best = job;
+        }
+    }
+    return best;
+}
+
+/**
+ *  @brief  Функция проверяет, что запрос не пересекается по адресам с
+ *          выполняемой записью и с ранее поставленными запросами (чтения
+ *          между собой не конфликтуют)
+ */
+static _Bool W15Q64_SrvReady(W15Q64srv_t *srv,
+                             W15Q64job_t *job)
+{
+    W15Q64job_t *prev;
+
+    if ((srv->queue.pHead != NULL) && W15Q64_SrvOverlap(srv->queue.pHead, job))
+    {
+        return false;
+    }
+    for (prev = srv->pPending; prev != job; prev = prev->pNext)
+    {
+        if (((!W15Q64_SrvIsRead(prev)) || (!W15Q64_SrvIsRead(job)))
+            && W15Q64_SrvOverlap(prev, job))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция удаляет запрос из списка ожидающих
+ *  @retval true - перед запросом в списке были записи или стирания
+ */
+static _Bool W15Q64_SrvUnlink(W15Q64srv_t *srv,
+                              W15Q64job_t *job)
+{
+    W15Q64job_t **ppLink = &srv->pPending,
+            *prev = NULL;
+    _Bool passed = false;
+
+    while (*ppLink != job)
+    {
+        prev = *ppLink;
+        passed |= !W15Q64_SrvIsRead(prev);
+        ppLink = &prev->pNext;
+    }
+    *ppLink = job->pNext;
+    if (srv->pPendingTail == job)
+    {
+        srv->pPendingTail = prev;
+    }
+    job->pNext = NULL;
+    return passed;
+}
+
+static _Bool W15Q64_SrvOverlap(const W15Q64job_t *a,
+                               const W15Q64job_t *b)
+{
+    uint32_t aLo, aHi,
+            bLo, bHi;
+
+    W15Q64_SrvSpan(a, &aLo, &aHi);
+    W15Q64_SrvSpan(b, &bLo, &bHi);
+    return (aLo < bHi) && (bLo < aHi);
+}
+
+/**
+ *  @brief  Функция возвращает диапазон адресов [*pLo, *pHi) запроса
+ */
+static void W15Q64_SrvSpan(const W15Q64job_t *job,
+                           uint32_t *pLo,
+                           uint32_t *pHi)
+{
+    uint32_t size;
+
+    switch (job->instruct)
+    {
+        case W15Q64_SECTOR_ERASE_4KB:
+            size = W15Q64_SECTOR_SIZE;
+            break;
+        case W15Q64_BLOCK_ERASE_32KB:
+            size = W15Q64_BLOCK_32KB_SIZE;
+            break;
+        case W15Q64_BLOCK_ERASE_64KB:
+            size = W15Q64_BLOCK_64KB_SIZE;
+            break;
+        case W15Q64_CHIP_ERASE:
+            *pLo = 0; //                    Объем микросхемы заданием не известен
+            *pHi = 0xFFFFFFFFUL;
+            return;
+        default:
+            *pLo = job->addr;
+            *pHi = job->addr + job->cnt;
+            return;
+    }
+    *pLo = job->addr & ~(size - 1);
+    *pHi = *pLo + size;
+}
+
+static _Bool W15Q64_SrvIsRead(const W15Q64job_t *job)
+{
+    return job->instruct == W15Q64_FAST_READ;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
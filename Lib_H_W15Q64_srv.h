@@ -0,0 +1,99 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_srv.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Доступ к одной микросхеме flash памяти w15q64 из нескольких
+ *              задач (потоков) через очередь запросов с приоритетами
+ *  @warning    Задачи-клиенты не вызывают функции драйвера, а ставят запросы
+ *              (задания из Lib_H_W15Q64_job.h) функцией W15Q64_SrvSubmit().
+ *              Все обращения к шине выполняет одна задача обслуживания
+ *              (W15Q64_SrvRun()), функция завершения задания вызывается из
+ *              нее.
+ *              Из готовых к выполнению запросов первым выбирается запрос с
+ *              большим приоритетом. Чтение выполняется раньше ранее
+ *              поставленных записей и стираний, если не пересекается с ними
+ *              по адресам; пересекающиеся запросы выполняются в порядке
+ *              постановки. Записи и стирания выполняются по одной, чтения -
+ *              между страницами записи, а при заданной функции времени -
+ *              и во время стирания (Erase/Program Suspend).
+ *              Синхронизация выполняется функциями ОС из структуры
+ *              W15Q64os_t (см. Lib_H_W15Q64_srv_posix.h для POSIX).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_SRV_H
+#define	LIB_H_W15Q64_SRV_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#include "Lib_H_W15Q64_job.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Период опроса BUSY задачей обслуживания, если spi->pollFirstUs = 0, мкс
+#define W15Q64_SRV_POLL_US                                50
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    void *pCtx; //                      Объекты ОС, передаются в функции ниже
+    void (* lock) (void *pCtx); //      Захват мьютекса очереди
+    void (* unlock) (void *pCtx); //    Освобождение мьютекса очереди
+    void (* signal) (void *pCtx); //    Пробуждение задачи обслуживания
+    void (* wait) (void *pCtx, //       Ожидание signal() не дольше timeoutUs
+            uint32_t timeoutUs); //     (0 - без ограничения)
+} W15Q64os_t; //    Структура содержит функции синхронизации ОС
+
+typedef struct {
+    W15Q64jobQueue_t queue; //  Очередь драйвера, используется только задачей
+    //                          обслуживания
+    W15Q64os_t os;
+    uint32_t pollUs;
+
+    // Служебные поля, защищены мьютексом
+    W15Q64job_t *pPending; //   Запросы в порядке постановки
+    W15Q64job_t *pPendingTail;
+    volatile _Bool stop;
+    uint32_t submitted;
+    uint32_t bypassed; //       Чтения, выполненные раньше ранее поставленных
+    //                          записей и стираний
+} W15Q64srv_t; //   Структура содержит очередь запросов к одной микросхеме
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_SrvInit(W15Q64srv_t *srv,
+        W15Q64spi_t *spi,
+        const W15Q64os_t *os,
+        uint32_t (* now_us) (void));
+extern void W15Q64_SrvSubmit(W15Q64srv_t *srv,
+        W15Q64job_t *job,
+        uint8_t prio);
+extern _Bool W15Q64_SrvStep(W15Q64srv_t *srv);
+extern void W15Q64_SrvRun(W15Q64srv_t *srv);
+extern void W15Q64_SrvStop(W15Q64srv_t *srv);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,140 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_srv_posix.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Функции синхронизации очереди запросов w15q64 (W15Q64os_t)
+ *              для POSIX threads (Linux, тесты на хосте)
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#define _POSIX_C_SOURCE 200809L
+#include <stddef.h>
+#include <time.h>
+#include "Lib_H_W15Q64_srv_posix.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция создает объекты POSIX и заполняет структуру W15Q64os_t
+ *  @param  *os:    Указатель на структуру функций синхронизации
+ *  @param  *posix: Указатель на структуру объектов POSIX, должна существовать
+ *                  все время работы очереди запросов
+ *  @retval true - объекты созданы
+ */
+_Bool W15Q64_OsPosixInit(W15Q64os_t *os,
+                         W15Q64osPosix_t *posix)
+{
+    if (pthread_mutex_init(&posix->mutex, NULL) != 0)
+    {
+        return false;
+    }
+    if (pthread_mutex_init(&posix->evMutex, NULL) != 0)
+    {
+        pthread_mutex_destroy(&posix->mutex);
+        return false;
+    }
+    if (pthread_cond_init(&posix->evCond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&posix->evMutex);
+        pthread_mutex_destroy(&posix->mutex);
+        return false;
+    }
+    posix->evFlag = false;
+
+    os->pCtx = posix;
+    os->lock = W15Q64_OsPosixLock;
+    os->unlock = W15Q64_OsPosixUnlock;
+    os->signal = W15Q64_OsPosixSignal;
+    os->wait = W15Q64_OsPosixWait;
+    return true;
+}
+
+void W15Q64_OsPosixDeinit(W15Q64osPosix_t *posix)
+{
+    pthread_cond_destroy(&posix->evCond);
+    pthread_mutex_destroy(&posix->evMutex);
+    pthread_mutex_destroy(&posix->mutex);
+}
+
+void W15Q64_OsPosixLock(void *pCtx)
+{
+    pthread_mutex_lock(&((W15Q64osPosix_t *) pCtx)->mutex);
+}
+
+void W15Q64_OsPosixUnlock(void *pCtx)
+{
+    pthread_mutex_unlock(&((W15Q64osPosix_t *) pCtx)->mutex);
+}
+
+void W15Q64_OsPosixSignal(void *pCtx)
+{
+    W15Q64osPosix_t *posix = (W15Q64osPosix_t *) pCtx;
+
+    pthread_mutex_lock(&posix->evMutex);
+    posix->evFlag = true;
+    pthread_cond_signal(&posix->evCond);
+    pthread_mutex_unlock(&posix->evMutex);
+}
+
+/**
+ *  @brief  Функция ждет W15Q64_OsPosixSignal() не дольше timeoutUs
+ *          (0 - без ограничения). Сигнал, поданный до вызова, не теряется
+ */
+void W15Q64_OsPosixWait(void *pCtx,
+                        uint32_t timeoutUs)
+{
+    W15Q64osPosix_t *posix = (W15Q64osPosix_t *) pCtx;
+    struct timespec until;
+    int err = 0;
+
+    if (timeoutUs != 0)
+    {
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += timeoutUs / 1000000UL;
+        until.tv_nsec += (long) (timeoutUs % 1000000UL) * 1000L;
+        if (until.tv_nsec >= 1000000000L)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&posix->evMutex);
+    while ((!posix->evFlag) && (err == 0))
+    {
+        err = (timeoutUs != 0)
+                ? pthread_cond_timedwait(&posix->evCond, &posix->evMutex, &until)
+                : pthread_cond_wait(&posix->evCond, &posix->evMutex);
+    }
+    posix->evFlag = false;
+    pthread_mutex_unlock(&posix->evMutex);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
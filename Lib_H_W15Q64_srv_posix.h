@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_srv_posix.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Функции синхронизации очереди запросов w15q64 (W15Q64os_t)
+ *              для POSIX threads (Linux, тесты на хосте)
+ *  @warning    Сборка с ключом -pthread.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_SRV_POSIX_H
+#define	LIB_H_W15Q64_SRV_POSIX_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "Lib_H_W15Q64_srv.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    pthread_mutex_t mutex; //   Мьютекс очереди
+    pthread_mutex_t evMutex; // Событие пробуждения задачи обслуживания
+    pthread_cond_t evCond;
+    _Bool evFlag;
+} W15Q64osPosix_t; //   Структура содержит объекты POSIX для W15Q64os_t
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_OsPosixInit(W15Q64os_t *os,
+        W15Q64osPosix_t *posix);
+extern void W15Q64_OsPosixDeinit(W15Q64osPosix_t *posix);
+extern void W15Q64_OsPosixLock(void *pCtx);
+extern void W15Q64_OsPosixUnlock(void *pCtx);
+extern void W15Q64_OsPosixSignal(void *pCtx);
+extern void W15Q64_OsPosixWait(void *pCtx,
+        uint32_t timeoutUs);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,248 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_stats.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Счетчики команд и гистограммы задержек драйвера микросхемы
+ *              flash памяти w15q64
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_stats.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint8_t W15Q64_StatsKind(uint8_t opcode);
+static void W15Q64_StatsRecord(W15Q64stats_t *stats,
+                               uint8_t kind,
+                               uint32_t startUs);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция обнуляет счетчики
+ *  @param  *stats: Указатель на структуру счетчиков
+ *  @param  now_us: Функция, возвращающая текущее время в микросекундах, или
+ *                  NULL (гистограммы задержек не ведутся)
+ *  @retval None
+ */
+void W15Q64_StatsInit(W15Q64stats_t *stats,
+                      uint32_t (* now_us) (void))
+{
+    memset(&stats->snap, 0, sizeof (stats->snap));
+    stats->now_us = now_us;
+    stats->opKind = W15Q64_STATS_NONE;
+    stats->opStartUs = 0;
+    stats->suspended = false;
+    stats->dmaStartUs = 0;
+}
+
+/**
+ *  @brief  Функция подключает счетчики к микросхеме (NULL - отключает)
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  *stats: Указатель на структуру счетчиков или NULL
+ *  @retval true - счетчики подключены, false - драйвер собран без
+ *          W15Q64_STATS
+ */
+_Bool W15Q64_StatsAttach(W15Q64spi_t *spi,
+                         W15Q64stats_t *stats)
+{
+#if W15Q64_STATS
+    spi->pStats = stats;
+    return true;
+#else
+    (void) spi;
+    (void) stats;
+    return false;
+#endif
+}
+
+/**
+ *  @brief  Функция копирует счетчики в структуру снимка
+ *  @param  *stats: Указатель на структуру счетчиков
+ *  @param  *pSnap: Указатель на структуру снимка
+ *  @param  reset:  true - обнулить счетчики после копирования
+ *  @retval None
+ */
+void W15Q64_StatsSnapshot(W15Q64stats_t *stats,
+                          W15Q64statsSnap_t *pSnap,
+                          _Bool reset)
+{
+    *pSnap = stats->snap;
+    if (reset)
+    {
+        memset(&stats->snap, 0, sizeof (stats->snap));
+    }
+}
+
+/**
+ *  @brief  Функция учитывает транзакцию перед ее выполнением
+ *  @param  *stats: Указатель на структуру счетчиков
+ *  @param  opcode: Код инструкции транзакции
+ *  @param  *pSeg:  Указатель на первый элемент массива сегментов
+ *  @param  segCnt: Количество сегментов
+ *  @retval Время начала транзакции для W15Q64_StatsBusEnd()
+ */
+uint32_t W15Q64_StatsBus(W15Q64stats_t *stats,
+                         uint8_t opcode,
+                         const W15Q64seg_t *pSeg,
+                         uint8_t segCnt)
+{
+    uint8_t i;
+
+    stats->snap.opcodes[opcode]++;
+    stats->snap.transactions++;
+    for (i = 0; i < segCnt; i++)
+    {
+        if (pSeg[i].dir == W15Q64_SEG_RX)
+        {
+            stats->snap.rxBytes += pSeg[i].cnt;
+        }
+        else if (pSeg[i].dir == W15Q64_SEG_TX)
+        {
+            stats->snap.txBytes += pSeg[i].cnt;
+        }
+    }
+    return (stats->now_us != NULL) ? stats->now_us() : 0;
+}
+
+/**
+ *  @brief  Функция учитывает окончание транзакции: для чтения записывает
+ *          задержку, для записи и стирания запоминает момент начала (время
+ *          в состоянии Suspend входит в задержку)
+ *  @param  *stats: Указатель на структуру счетчиков
+ *  @param  opcode: Код инструкции транзакции
+ *  @param  startUs:    Значение, которое вернула W15Q64_StatsBus()
+ *  @retval None
+ */
+void W15Q64_StatsBusEnd(W15Q64stats_t *stats,
+                        uint8_t opcode,
+                        uint32_t startUs)
+{
+    uint8_t kind = W15Q64_StatsKind(opcode);
+
+    // Во время Suspend бит BUSY сброшен, но операция не завершена
+    if (opcode == W15Q64_ERASE_PROGRAM_SUSPEND)
+    {
+        stats->suspended = true;
+    }
+    else if (opcode == W15Q64_ERASE_PROGRAM_RESUME)
+    {
+        stats->suspended = false;
+    }
+    else if (kind == W15Q64_STATS_READ)
+    {
+        W15Q64_StatsRecord(stats, kind, startUs);
+    }
+    else if (kind != W15Q64_STATS_NONE)
+    {
+        stats->opKind = kind;
+        stats->opStartUs = startUs;
+    }
+}
+
+/**
+ *  @brief  Функция учитывает прочитанное значение Status Register 1
+ *  @param  *stats: Указатель на структуру счетчиков
+ *  @param  reg1:   Значение Status Register 1
+ *  @retval None
+ */
+void W15Q64_StatsStatus(W15Q64stats_t *stats,
+                        uint8_t reg1)
+{
+    if ((reg1 & (1 << W15Q64_BUSY)) != 0)
+    {
+        stats->snap.busyPolls++;
+    }
+    else if ((stats->opKind != W15Q64_STATS_NONE) && (!stats->suspended))
+    {
+        W15Q64_StatsRecord(stats, stats->opKind, stats->opStartUs);
+        stats->opKind = W15Q64_STATS_NONE;
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+static uint8_t W15Q64_StatsKind(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case W15Q64_READ_DATA:
+        case W15Q64_FAST_READ:
+        case W15Q64_FAST_READ_DUAL_OUTPUT:
+        case W15Q64_FAST_READ_DUAL_IO:
+        case W15Q64_FAST_READ_QUAD_OUTPUT:
+        case W15Q64_FAST_READ_QUAD_IO:
+        case W15Q64_WORD_READ_QUAD_IO:
+        case W15Q64_OCTAL_WORD_READ_QUAD_IO:
+            return W15Q64_STATS_READ;
+        case W15Q64_PAGE_PROGRAM:
+        case W15Q64_QUAD_PAGE_PROGRAM:
+            return W15Q64_STATS_PROGRAM;
+        case W15Q64_SECTOR_ERASE_4KB:
+        case W15Q64_BLOCK_ERASE_32KB:
+        case W15Q64_BLOCK_ERASE_64KB:
+        case W15Q64_CHIP_ERASE:
+            return W15Q64_STATS_ERASE;
+        default:
+            return W15Q64_STATS_NONE;
+    }
+}
+
+static void W15Q64_StatsRecord(W15Q64stats_t *stats,
+                               uint8_t kind,
+                               uint32_t startUs)
+{
+    W15Q64hist_t *hist = &stats->snap.hist[kind];
+    uint32_t us,
+            v;
+    uint8_t i = 0;
+
+    if (stats->now_us == NULL)
+    {
+        return;
+    }
+    us = stats->now_us() - startUs;
+
+    // Номер бакета - количество значащих бит
+    for (v = us; (v != 0) && (i < W15Q64_STATS_BUCKETS - 1); v >>= 1)
+    {
+        i++;
+    }
+    hist->bucket[i]++;
+    hist->cnt++;
+    hist->sumUs += us;
+    if (us > hist->maxUs)
+    {
+        hist->maxUs = us;
+    }
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_stats.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Счетчики команд и гистограммы задержек драйвера микросхемы
+ *              flash памяти w15q64
+ *  @warning    Счетчики включаются при сборке: -DW15Q64_STATS=1. Без этого
+ *              драйвер не содержит ни поля pStats, ни вызовов функций модуля.
+ *              Счетчики подключаются к микросхеме функцией W15Q64_StatsAttach()
+ *              и ведутся для каждой транзакции на шине: количество команд по
+ *              кодам инструкций, переданные и принятые байты, опросы Status
+ *              Register 1 с установленным битом BUSY.
+ *              Если задана функция now_us, ведутся гистограммы задержек:
+ *              чтение - длительность транзакции, запись страницы и стирание -
+ *              от отправки команды до первого чтения Status Register 1 со
+ *              сброшенным BUSY. Интервал бакета i: [2^(i-1), 2^i) мкс.
+ *              Одна структура счетчиков - для одной микросхемы. Функции
+ *              модуля вызываются из того же контекста, что и драйвер.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_STATS_H
+#define	LIB_H_W15Q64_STATS_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_STATS_BUCKETS                              24
+
+// Гистограммы задержек
+#define W15Q64_STATS_READ                                 0
+#define W15Q64_STATS_PROGRAM                              1
+#define W15Q64_STATS_ERASE                                2
+#define W15Q64_STATS_KINDS                                3
+#define W15Q64_STATS_NONE                                 0xFF
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t cnt;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t bucket[W15Q64_STATS_BUCKETS];
+} W15Q64hist_t; //  Гистограмма задержек
+
+typedef struct {
+    uint32_t opcodes[256]; //   Транзакции по коду инструкции (0xFF - выход из
+    //                          Continuous Read, продолжение Continuous Read
+    //                          учитывается кодом команды чтения)
+    uint32_t transactions;
+    uint64_t txBytes;
+    uint64_t rxBytes;
+    uint32_t busyPolls; //      Чтения Status Register 1 с BUSY = 1
+    W15Q64hist_t hist[W15Q64_STATS_KINDS];
+} W15Q64statsSnap_t; // Снимок счетчиков для телеметрии
+
+typedef struct W15Q64stats_s {
+    uint32_t (* now_us) (void); //  Функция времени или NULL (без гистограмм)
+    W15Q64statsSnap_t snap;
+
+    // Служебные поля
+    uint8_t opKind; //          Ожидается окончание записи/стирания
+    uint32_t opStartUs;
+    _Bool suspended; //         Отправлен Erase/Program Suspend
+    uint32_t dmaStartUs;
+} W15Q64stats_t; // Структура содержит счетчики одной микросхемы
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_StatsInit(W15Q64stats_t *stats,
+        uint32_t (* now_us) (void));
+extern _Bool W15Q64_StatsAttach(W15Q64spi_t *spi,
+        W15Q64stats_t *stats);
+extern void W15Q64_StatsSnapshot(W15Q64stats_t *stats,
+        W15Q64statsSnap_t *pSnap,
+        _Bool reset);
+
+// Вызываются драйвером
+extern uint32_t W15Q64_StatsBus(W15Q64stats_t *stats,
+        uint8_t opcode,
+        const W15Q64seg_t *pSeg,
+        uint8_t segCnt);
+extern void W15Q64_StatsBusEnd(W15Q64stats_t *stats,
+        uint8_t opcode,
+        uint32_t startUs);
+extern void W15Q64_StatsStatus(W15Q64stats_t *stats,
+        uint8_t reg1);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
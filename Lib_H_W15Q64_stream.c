@@ -0,0 +1,225 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_stream.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Потоковое последовательное чтение микросхемы flash памяти
+ *              w15q64 с упреждением
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_stream.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_StreamFill(W15Q64stream_t *st);
+static void W15Q64_StreamDone(void *pCtx);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция открывает поток и запускает прием первых буферов
+ *  @param  *st:    Указатель на структуру потока
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес начала данных
+ *  @param  cnt:    Количество байт (ограничивается концом микросхемы)
+ *  @param  *pBuf:  Буферы, bufCnt * bufSize байт
+ *  @param  bufSize:    Размер одного буфера
+ *  @param  bufCnt: Количество буферов, не меньше 2
+ *  @retval true - поток открыт
+ */
+_Bool W15Q64_StreamOpen(W15Q64stream_t *st,
+                        W15Q64spi_t *spi,
+                        uint32_t addr,
+                        uint32_t cnt,
+                        uint8_t *pBuf,
+                        uint32_t bufSize,
+                        uint8_t bufCnt)
+{
+    const uint32_t capacity = W15Q64_Capacity(spi);
+
+    if ((bufCnt < 2) || (bufSize == 0) || (addr >= capacity) || spi->dmaBusy)
+    {
+        return false;
+    }
+    if (cnt > capacity - addr)
+    {
+        cnt = capacity - addr;
+    }
+
+    memset(st, 0, sizeof (*st));
+    st->spi = spi;
+    st->pBuf = pBuf;
+    st->bufSize = bufSize;
+    st->bufCnt = bufCnt;
+    st->addr = addr;
+    st->reqRemain = cnt;
+    st->outRemain = cnt;
+    st->hold = (cnt != 0) && W15Q64_ReadOpen(spi, addr);
+    st->dma = st->hold && (spi->transmitReceiveDMA != NULL);
+    if (st->dma)
+    {
+        W15Q64_StreamFill(st);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция возвращает предыдущий буфер в кольцо и выдает следующий,
+ *          при необходимости дожидаясь окончания его приема
+ *  @param  *st:    Указатель на структуру потока
+ *  @param  *pCnt:  Количество байт в буфере (меньше bufSize только в
+ *                  последнем буфере)
+ *  @retval Указатель на данные или NULL - данные потока закончились
+ */
+const uint8_t *W15Q64_StreamGet(W15Q64stream_t *st,
+                                uint32_t *pCnt)
+{
+    const uint8_t *pData;
+    uint32_t cnt;
+
+    if (st->released != st->taken)
+    {
+        st->released++;
+        if (st->dma)
+        {
+            // Если прием идет, освободившийся буфер займет функция завершения
+            W15Q64_StreamFill(st);
+        }
+    }
+    if (st->filled == st->taken)
+    {
+        if (!st->dma)
+        {
+            W15Q64_StreamFill(st);
+        }
+        else if (st->busy)
+        {
+            st->stats.stalls++;
+        }
+        while ((st->filled == st->taken) && st->busy)
+        {
+        }
+    }
+    if (st->filled == st->taken)
+    {
+        *pCnt = 0;
+        return NULL;
+    }
+
+    cnt = (st->outRemain < st->bufSize) ? st->outRemain : st->bufSize;
+    pData = &st->pBuf[st->readIdx * st->bufSize];
+    st->readIdx = (uint8_t) ((st->readIdx + 1) % st->bufCnt);
+    st->outRemain -= cnt;
+    st->taken++;
+    st->stats.buffers++;
+    st->stats.bytes += cnt;
+    *pCnt = cnt;
+    return pData;
+}
+
+/**
+ *  @brief  Функция закрывает поток: дожидается окончания приема и переводит
+ *          CS в "1". Непрочитанные данные отбрасываются
+ *  @param  *st:    Указатель на структуру потока
+ *  @retval None
+ */
+void W15Q64_StreamClose(W15Q64stream_t *st)
+{
+    // Новые приемы не запускаются
+    st->reqRemain = 0;
+    while (st->busy)
+    {
+    }
+    if (st->hold)
+    {
+        W15Q64_ReadClose(st->spi);
+        st->hold = false;
+    }
+    st->outRemain = 0;
+    st->filled = st->taken = st->released = 0;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция запускает прием следующего буфера, если есть свободный
+ *          буфер и прием не идет. Вызывается из W15Q64_StreamGet() и из
+ *          функции завершения DMA (прерывание), одновременно эти вызовы не
+ *          выполняются: при busy = true буфер займет прерывание
+ */
+static void W15Q64_StreamFill(W15Q64stream_t *st)
+{
+    uint8_t *pRxData;
+    uint32_t cnt;
+
+    if (st->busy || (st->reqRemain == 0) || (st->filled - st->released >= st->bufCnt))
+    {
+        return;
+    }
+
+    cnt = (st->reqRemain < st->bufSize) ? st->reqRemain : st->bufSize;
+    pRxData = &st->pBuf[st->fillIdx * st->bufSize];
+    st->fillIdx = (uint8_t) ((st->fillIdx + 1) % st->bufCnt);
+    st->reqRemain -= cnt;
+
+    if (st->dma)
+    {
+        st->addr += cnt;
+        st->busy = true;
+        W15Q64_ReadNextDMA(st->spi, pRxData, cnt, W15Q64_StreamDone, st);
+        return;
+    }
+    if (st->hold)
+    {
+        W15Q64_ReadNext(st->spi, pRxData, cnt);
+    }
+    else
+    {
+        W15Q64_FastReadAuto(st->spi, st->addr, pRxData, cnt);
+    }
+    st->addr += cnt;
+    st->filled++;
+}
+
+/**
+ *  @brief  Функция завершения приема буфера через DMA: сразу запускает
+ *          прием следующего, чтобы шина не простаивала
+ */
+static void W15Q64_StreamDone(void *pCtx)
+{
+    W15Q64stream_t *st = (W15Q64stream_t *) pCtx;
+
+    st->filled++;
+    st->busy = false;
+    W15Q64_StreamFill(st);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
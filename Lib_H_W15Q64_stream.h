@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_stream.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Потоковое последовательное чтение микросхемы flash памяти
+ *              w15q64 с упреждением (звук, изображения)
+ *  @warning    Поток читается одной командой чтения (W15Q64_ReadOpen()): CS
+ *              остается в "0" от W15Q64_StreamOpen() до W15Q64_StreamClose(),
+ *              инструкция, адрес и dummy передаются один раз. Данные
+ *              принимаются в кольцо из bufCnt буферов вызывающей стороны.
+ *              W15Q64_StreamGet() возвращает указатель на очередной
+ *              заполненный буфер (без копирования), указатель действителен
+ *              до следующего вызова W15Q64_StreamGet() или
+ *              W15Q64_StreamClose(). Если порт поддерживает
+ *              transmitReceiveDMA, освобожденный буфер сразу ставится в
+ *              очередь приема, а следующий прием запускается из функции
+ *              завершения DMA: шина занята непрерывно, пока есть свободный
+ *              буфер. Без DMA буфер принимается в W15Q64_StreamGet(), но
+ *              по-прежнему без заголовка команды.
+ *              Пока поток открыт, другие функции драйвера для этой
+ *              микросхемы вызывать нельзя. Если порт не может удерживать CS
+ *              (только функция transaction), каждый буфер читается
+ *              отдельной командой W15Q64_FastReadAuto().
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_STREAM_H
+#define	LIB_H_W15Q64_STREAM_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t buffers; //        Выдано буферов
+    uint32_t bytes; //          Выдано байт
+    uint32_t stalls; //         W15Q64_StreamGet() ждал окончания приема
+} W15Q64streamStats_t;
+
+typedef struct {
+    W15Q64spi_t *spi;
+    uint8_t *pBuf; //                   Буферы, bufCnt * bufSize байт
+    uint32_t bufSize;
+    uint8_t bufCnt;
+    W15Q64streamStats_t stats;
+
+    // Служебные поля
+    uint32_t addr; //                   Адрес следующего принимаемого буфера
+    uint32_t reqRemain; //              Байт еще не запрошено у микросхемы
+    uint32_t outRemain; //              Байт еще не выдано
+    uint8_t fillIdx; //                 Следующий принимаемый буфер
+    uint8_t readIdx; //                 Следующий выдаваемый буфер
+    volatile uint32_t filled; //        Принято буферов (в том числе из
+    //                                  прерывания)
+    uint32_t taken; //                  Выдано буферов
+    uint32_t released; //               Возвращено буферов
+    volatile _Bool busy; //             Идет прием через DMA
+    _Bool hold; //                      CS удерживается (W15Q64_ReadOpen())
+    _Bool dma;
+} W15Q64stream_t; //    Структура содержит состояние потокового чтения
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_StreamOpen(W15Q64stream_t *st,
+        W15Q64spi_t *spi,
+        uint32_t addr,
+        uint32_t cnt,
+        uint8_t *pBuf,
+        uint32_t bufSize,
+        uint8_t bufCnt);
+extern const uint8_t *W15Q64_StreamGet(W15Q64stream_t *st,
+        uint32_t *pCnt);
+extern void W15Q64_StreamClose(W15Q64stream_t *st);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,370 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_stripe.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Том из нескольких микросхем flash памяти w15q64 на разных
+ *              линиях CS с чередованием (striping) адресного пространства
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include "Lib_H_W15Q64_stripe.h"
+#include "Lib_H_W15Q64_erase.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static void W15Q64_StripeRun(W15Q64stripe_t *vol,
+                             uint32_t start,
+                             uint32_t end,
+                             uint8_t *pTxData);
+static uint32_t W15Q64_StripeIssue(W15Q64stripe_t *vol,
+                                   uint8_t chip,
+                                   uint32_t pos,
+                                   uint32_t hi,
+                                   uint32_t start,
+                                   uint8_t *pTxData);
+static _Bool W15Q64_StripeChipRange(W15Q64stripe_t *vol,
+                                    uint8_t chip,
+                                    uint32_t start,
+                                    uint32_t end,
+                                    uint32_t *pLo,
+                                    uint32_t *pHi);
+static uint32_t W15Q64_StripeToVol(W15Q64stripe_t *vol,
+                                   uint8_t chip,
+                                   uint32_t chipAddr);
+static _Bool W15Q64_StripeInRange(W15Q64stripe_t *vol,
+                                  uint32_t addr,
+                                  uint32_t cnt);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция инициализирует том
+ *  @param  *vol:   Указатель на структуру тома
+ *  @param  ppSpi:  Массив указателей на структуры W15Q64spi_t микросхем
+ *  @param  chipCnt:    Количество микросхем, от 1 до W15Q64_STRIPE_MAX_CHIPS
+ *  @param  unit:   Размер полосы: степень 2 от W15Q64_PAGE_SIZE до
+ *                  W15Q64_BLOCK_64KB_SIZE
+ *  @retval true - параметры допустимы
+ */
+_Bool W15Q64_StripeInit(W15Q64stripe_t *vol,
+                        W15Q64spi_t * const *ppSpi,
+                        uint8_t chipCnt,
+                        uint32_t unit)
+{
+    uint8_t i;
+
+    if ((chipCnt == 0) || (chipCnt > W15Q64_STRIPE_MAX_CHIPS)
+        || (unit < W15Q64_PAGE_SIZE) || (unit > W15Q64_BLOCK_64KB_SIZE)
+        || ((unit & (unit - 1)) != 0))
+    {
+        return false;
+    }
+    for (i = 0; i < chipCnt; i++)
+    {
+        vol->spi[i] = ppSpi[i];
+    }
+    vol->chipCnt = chipCnt;
+    vol->unit = unit;
+    vol->size = (uint32_t) chipCnt * W15Q64_Capacity(ppSpi[0]);
+
+    // Сектор микросхемы при unit < 4 КБ содержит полосы всех микросхем
+    vol->eraseSize = (unit >= W15Q64_SECTOR_SIZE)
+            ? W15Q64_SECTOR_SIZE : (uint32_t) chipCnt * W15Q64_SECTOR_SIZE;
+    return true;
+}
+
+/**
+ *  @brief  Функция читает массив байт из тома
+ *  @param  *vol:   Указатель на структуру тома
+ *  @param  addr:   Адрес в томе
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут
+ *                      записаны данные
+ *  @param  cnt:    Количество байт
+ *  @retval true - область находится внутри тома, false - чтение не
+ *          выполнялось
+ */
+_Bool W15Q64_StripeRead(W15Q64stripe_t *vol,
+                        uint32_t addr,
+                        uint8_t *pRxData,
+                        uint32_t cnt)
+{
+    uint32_t stripe,
+            chunk;
+
+    if (!W15Q64_StripeInRange(vol, addr, cnt))
+    {
+        return false;
+    }
+    while (cnt != 0)
+    {
+        stripe = addr / vol->unit;
+        chunk = vol->unit - (addr & (vol->unit - 1));
+        if (chunk > cnt)
+        {
+            chunk = cnt;
+        }
+        W15Q64_FastReadAuto(vol->spi[stripe % vol->chipCnt],
+                            (stripe / vol->chipCnt) * vol->unit + (addr & (vol->unit - 1)),
+                            pRxData, chunk);
+        addr += chunk;
+        pRxData += chunk;
+        cnt -= chunk;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция записывает массив произвольной длины в том, программируя
+ *          страницы во всех микросхемах одновременно, и ожидает окончания
+ *          записи
+ *  @param  *vol:   Указатель на структуру тома
+ *  @param  addr:   Адрес в томе
+ *  @param  *pTxData:   Указатель на первый элемент массива с данными
+ *  @param  cnt:    Количество байт для записи
+ *  @retval true - область находится внутри тома, false - запись не
+ *          выполнялась
+ *
+ *  @warning    Область памяти должна быть предварительно стерта
+ */
+_Bool W15Q64_StripeWrite(W15Q64stripe_t *vol,
+                         uint32_t addr,
+                         uint8_t *pTxData,
+                         uint32_t cnt)
+{
+    if (!W15Q64_StripeInRange(vol, addr, cnt))
+    {
+        return false;
+    }
+    if (cnt != 0)
+    {
+        W15Q64_StripeRun(vol, addr, addr + cnt, pTxData);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Функция стирает область тома, выполняя стирание во всех
+ *          микросхемах одновременно (в каждой - самыми крупными блоками,
+ *          помещающимися в ее часть области), и ожидает окончания стирания
+ *  @param  *vol:   Указатель на структуру тома
+ *  @param  addr:   Адрес начала области
+ *  @param  len:    Размер области в байтах, область расширяется до границ
+ *                  блоков по eraseSize байт
+ *  @retval true - область находится внутри тома, false - стирание не
+ *          выполнялось
+ */
+_Bool W15Q64_StripeErase(W15Q64stripe_t *vol,
+                         uint32_t addr,
+                         uint32_t len)
+{
+    uint32_t end;
+
+    if (!W15Q64_StripeInRange(vol, addr, len))
+    {
+        return false;
+    }
+    if (len == 0)
+    {
+        return true;
+    }
+    // Размер тома кратен eraseSize, граница блока не выходит за том
+    end = ((addr + len - 1) / vol->eraseSize + 1) * vol->eraseSize;
+    addr = (addr / vol->eraseSize) * vol->eraseSize;
+    W15Q64_StripeRun(vol, addr, end, NULL);
+    return true;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция выполняет запись (pTxData != NULL) или стирание области
+ *          тома [start, end): каждой свободной микросхеме отправляется
+ *          следующая команда ее части области, занятые только опрашиваются
+ */
+static void W15Q64_StripeRun(W15Q64stripe_t *vol,
+                             uint32_t start,
+                             uint32_t end,
+                             uint8_t *pTxData)
+{
+    uint32_t pos[W15Q64_STRIPE_MAX_CHIPS],
+            hi[W15Q64_STRIPE_MAX_CHIPS];
+    uint8_t work = 0,
+            busy = 0,
+            mask,
+            i;
+    _Bool issued;
+
+    for (i = 0; i < vol->chipCnt; i++)
+    {
+        if (W15Q64_StripeChipRange(vol, i, start, end, &pos[i], &hi[i]))
+        {
+            work |= (uint8_t) (1U << i);
+        }
+    }
+
+    while ((work | busy) != 0)
+    {
+        issued = false;
+        for (i = 0; i < vol->chipCnt; i++)
+        {
+            mask = (uint8_t) (1U << i);
+            if ((busy & mask) != 0)
+            {
+                if ((W15Q64_ReadStatReg(vol->spi[i], (uint8_t) W15Q64_READ_STATUS_REGISTER_1)
+                     & (1 << W15Q64_BUSY)) != 0)
+                {
+                    continue;
+                }
+                busy &= (uint8_t) ~mask;
+            }
+            if ((work & mask) == 0)
+            {
+                continue;
+            }
+
+            pos[i] += W15Q64_StripeIssue(vol, i, pos[i], hi[i], start, pTxData);
+            busy |= mask;
+            issued = true;
+            if (pos[i] >= hi[i])
+            {
+                work &= (uint8_t) ~mask;
+            }
+        }
+
+        // Все микросхемы заняты
+        if ((!issued) && (vol->spi[0]->delay_us != NULL) && (vol->spi[0]->pollFirstUs != 0))
+        {
+            vol->spi[0]->delay_us(vol->spi[0]->pollFirstUs);
+        }
+    }
+}
+
+/**
+ *  @brief  Функция отправляет микросхеме одну команду записи или стирания
+ *  @retval Количество байт микросхемы, обработанных командой
+ */
+static uint32_t W15Q64_StripeIssue(W15Q64stripe_t *vol,
+                                   uint8_t chip,
+                                   uint32_t pos,
+                                   uint32_t hi,
+                                   uint32_t start,
+                                   uint8_t *pTxData)
+{
+    uint32_t cnt;
+    uint8_t instruct;
+
+    if (pTxData != NULL)
+    {
+        // Не дальше конца страницы и конца полосы
+        cnt = W15Q64_PageSize(vol->spi[chip]);
+        cnt -= pos & (cnt - 1);
+        if (cnt > hi - pos)
+        {
+            cnt = hi - pos;
+        }
+        W15Q64_PageProg(vol->spi[chip], pos,
+                        &pTxData[W15Q64_StripeToVol(vol, chip, pos) - start],
+                        (uint16_t) cnt);
+        return cnt;
+    }
+
+    // Блоки, которые микросхема не стирает, заменяются меньшими
+    if (((pos & (W15Q64_BLOCK_64KB_SIZE - 1)) == 0) && (hi - pos >= W15Q64_BLOCK_64KB_SIZE)
+        && (W15Q64_EraseUs(vol->spi[chip], W15Q64_BLOCK_ERASE_64KB) != 0xFFFFFFFFUL))
+    {
+        instruct = W15Q64_BLOCK_ERASE_64KB;
+        cnt = W15Q64_BLOCK_64KB_SIZE;
+    }
+    else if (((pos & (W15Q64_BLOCK_32KB_SIZE - 1)) == 0) && (hi - pos >= W15Q64_BLOCK_32KB_SIZE)
+             && (W15Q64_EraseUs(vol->spi[chip], W15Q64_BLOCK_ERASE_32KB) != 0xFFFFFFFFUL))
+    {
+        instruct = W15Q64_BLOCK_ERASE_32KB;
+        cnt = W15Q64_BLOCK_32KB_SIZE;
+    }
+    else
+    {
+        instruct = W15Q64_SECTOR_ERASE_4KB;
+        cnt = W15Q64_SECTOR_SIZE;
+    }
+    W15Q64_Erase(vol->spi[chip], pos, instruct);
+    return cnt;
+}
+
+/**
+ *  @brief  Функция определяет часть области тома [start, end), которая
+ *          находится в микросхеме chip. Эта часть всегда непрерывна
+ *  @retval false - в микросхеме нет байт области
+ */
+static _Bool W15Q64_StripeChipRange(W15Q64stripe_t *vol,
+                                    uint8_t chip,
+                                    uint32_t start,
+                                    uint32_t end,
+                                    uint32_t *pLo,
+                                    uint32_t *pHi)
+{
+    uint32_t first = start / vol->unit,
+            last = (end - 1) / vol->unit,
+            s1,
+            s2;
+
+    // Первая и последняя полосы области, принадлежащие микросхеме
+    s1 = first + (chip + vol->chipCnt - first % vol->chipCnt) % vol->chipCnt;
+    if (s1 > last)
+    {
+        return false;
+    }
+    s2 = last - (last % vol->chipCnt + vol->chipCnt - chip) % vol->chipCnt;
+
+    *pLo = (s1 / vol->chipCnt) * vol->unit
+            + ((s1 == first) ? (start & (vol->unit - 1)) : 0);
+    *pHi = (s2 / vol->chipCnt) * vol->unit
+            + ((s2 == last) ? (((end - 1) & (vol->unit - 1)) + 1) : vol->unit);
+    return true;
+}
+
+static uint32_t W15Q64_StripeToVol(W15Q64stripe_t *vol,
+                                   uint8_t chip,
+                                   uint32_t chipAddr)
+{
+    return ((chipAddr / vol->unit) * vol->chipCnt + chip) * vol->unit
+            + (chipAddr & (vol->unit - 1));
+}
+
+/**
+ *  @brief  Функция проверяет, что область [addr, addr + cnt) находится
+ *          внутри тома (без переполнения при addr + cnt > 0xFFFFFFFF)
+ */
+static _Bool W15Q64_StripeInRange(W15Q64stripe_t *vol,
+                                  uint32_t addr,
+                                  uint32_t cnt)
+{
+    return (addr <= vol->size) && (cnt <= vol->size - addr);
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,85 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_stripe.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Том из нескольких микросхем flash памяти w15q64 на разных
+ *              линиях CS с чередованием (striping) адресного пространства
+ *  @warning    Линейное адресное пространство тома делится на полосы по
+ *              unit байт, полоса s находится в микросхеме s % chipCnt по
+ *              адресу (s / chipCnt) * unit.
+ *              Запись и стирание выполняются одновременно во всех
+ *              микросхемах: пока одна программирует страницу или стирает
+ *              сектор, следующая получает свою команду. Поэтому время
+ *              последовательной записи, в которой преобладают tPP и tSE,
+ *              сокращается почти в chipCnt раз.
+ *              Стирание выполняется блоками по eraseSize байт (сектор 4 КБ,
+ *              а при unit < 4 КБ - chipCnt секторов), область расширяется
+ *              до их границ.
+ *              Области, выходящие за размер тома, отвергаются целиком
+ *              (функции возвращают false и не обращаются к микросхемам).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_STRIPE_H
+#define	LIB_H_W15Q64_STRIPE_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_STRIPE_MAX_CHIPS                           4
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    W15Q64spi_t *spi[W15Q64_STRIPE_MAX_CHIPS];
+    uint8_t chipCnt;
+    uint32_t unit; //           Размер полосы, степень 2 от W15Q64_PAGE_SIZE
+    //                          до W15Q64_BLOCK_64KB_SIZE
+    uint32_t size; //           Размер тома
+    uint32_t eraseSize; //      Минимальный блок стирания тома
+} W15Q64stripe_t; //    Структура описывает том из нескольких микросхем
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_StripeInit(W15Q64stripe_t *vol,
+        W15Q64spi_t * const *ppSpi,
+        uint8_t chipCnt,
+        uint32_t unit);
+extern _Bool W15Q64_StripeRead(W15Q64stripe_t *vol,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern _Bool W15Q64_StripeWrite(W15Q64stripe_t *vol,
+        uint32_t addr,
+        uint8_t *pTxData,
+        uint32_t cnt);
+extern _Bool W15Q64_StripeErase(W15Q64stripe_t *vol,
+        uint32_t addr,
+        uint32_t len);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
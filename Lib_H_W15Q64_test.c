@@ -0,0 +1,1607 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_test.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Регрессионные тесты драйвера w15q64 на модели микросхемы
+ *              (запускается на хосте)
+ *  @warning    Сборка и запуск - через CMakeLists.txt (цель w15q64_test,
+ *              ctest) или вручную:
+ *                  gcc -O2 -o w15q64_test Lib_H_W15Q64_test.c \
+ *                      $(ls Lib_H_W15Q64_*.c | grep -v -e bench -e test) \
+ *                      -pthread
+ *                  ./w15q64_test [-g] [-d] [-q] [имя теста ...]
+ *              Ключи порта те же, что у w15q64_bench. При сборке с
+ *              W15Q64_STATIC_PORT добавляется тест порта этапа компиляции
+ *              (Lib_H_W15Q64_port.h), с W15Q64_STATS - тест счетчиков
+ *              драйвера. Без имен выполняются
+ *              все тесты. Каждый тест проверяет результат по памяти модели
+ *              и отсутствие нарушений протокола (sim.stats.violations).
+ *              Код возврата - количество не прошедших тестов.
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+#include "Lib_H_W15Q64_sim.h"
+#include "Lib_H_W15Q64_job.h"
+#include "Lib_H_W15Q64_cache.h"
+#include "Lib_H_W15Q64_wbuf.h"
+#include "Lib_H_W15Q64_erase.h"
+#include "Lib_H_W15Q64_verify.h"
+#include "Lib_H_W15Q64_srv.h"
+#include "Lib_H_W15Q64_srv_posix.h"
+#include "Lib_H_W15Q64_stripe.h"
+#include "Lib_H_W15Q64_sfdp.h"
+#include "Lib_H_W15Q64_ftl.h"
+#include "Lib_H_W15Q64_ring.h"
+#include "Lib_H_W15Q64_update.h"
+#include "Lib_H_W15Q64_crc.h"
+#include "Lib_H_W15Q64_integrity.h"
+#include "Lib_H_W15Q64_stream.h"
+#include "Lib_H_W15Q64_image.h"
+#include "Lib_H_W15Q64_stats.h"
+#if W15Q64_STATIC_PORT
+#include W15Q64_PORT_HEADER
+#endif
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_TEST_LOOP_PERIOD_US                        100
+#define W15Q64_TEST_VERIFY_START                          0x10000UL
+#define W15Q64_TEST_VERIFY_OFFSET                         0x123
+#define W15Q64_TEST_VERIFY_LEN                            5000
+#define W15Q64_TEST_STREAM_START                          0x20010UL
+#define W15Q64_TEST_STREAM_LEN                            10000
+#define W15Q64_TEST_STREAM_CHUNK                          256
+#define W15Q64_TEST_STREAM_BUFS                           4
+#define W15Q64_TEST_RANGE_START                           0x100000UL
+#define W15Q64_TEST_RANGE_DIRTY                           3 //  Единственный не чистый сектор
+#define W15Q64_TEST_FTL_START                             0x200000UL
+#define W15Q64_TEST_FTL_SECTORS                           16
+#define W15Q64_TEST_FTL_BLOCKS                            64
+#define W15Q64_TEST_FTL_WRITES                            1500
+#define W15Q64_TEST_RING_START                            0x240000UL
+#define W15Q64_TEST_RING_SECTORS                          8
+#define W15Q64_TEST_RING_QUEUE                            8 //  Страниц очереди
+#define W15Q64_TEST_RING_RECORD                           16
+#define W15Q64_TEST_RING_RECORDS                          4000 //    Больше объема журнала
+#define W15Q64_TEST_RING_PERIOD_US                        1000
+#define W15Q64_TEST_STRIPE_CHIPS                          4
+#define W15Q64_TEST_STRIPE_UNIT                           4096
+#define W15Q64_TEST_STRIPE_OFFSET                         0x321
+#define W15Q64_TEST_STRIPE_LEN                            0x9000UL
+#define W15Q64_TEST_CACHE_START                           0x280000UL
+#define W15Q64_TEST_CACHE_LINES                           8
+#define W15Q64_TEST_CACHE_LINE_SIZE                       128
+#define W15Q64_TEST_SCRUB_START                           0x2C0000UL
+#define W15Q64_TEST_SCRUB_PAGES                           64
+#define W15Q64_TEST_UPD_START                             0x300000UL
+#define W15Q64_TEST_UPD_LEN                               0x10000UL
+#define W15Q64_TEST_UPD_CHUNK                             1000 //    Не кратно странице
+#define W15Q64_TEST_WBUF_START                            0x340000UL
+#define W15Q64_TEST_IMAGE_SIZE                            0x10000UL
+#define W15Q64_TEST_IMAGE_ADDR                            0x1010UL
+#define W15Q64_TEST_IMAGE_LEN                             300
+#define W15Q64_TEST_RWE_READS                             2 //  Чтений в очереди во время стирания
+#define W15Q64_TEST_RWE_MAX_POLLS                         100000
+#define W15Q64_TEST_MC_READERS                            2
+#define W15Q64_TEST_MC_READS                              300
+#define W15Q64_TEST_MC_READ_LEN                           16
+#define W15Q64_TEST_MC_READ_BASE                          0x380000UL
+#define W15Q64_TEST_MC_WRITE_BASE                         0x3C0000UL
+#define W15Q64_TEST_MC_SECTORS                            4
+#define W15Q64_TEST_WSTREAM_START                         0x30045UL
+#define W15Q64_TEST_WSTREAM_LEN                           3000
+#define W15Q64_TEST_CONT_START                            0x40000UL
+#define W15Q64_TEST_CRC_CHECK                             0xE3069283UL // CRC-32C "123456789"
+#define W15Q64_TEST_CRC_LENGTHS                           300
+#define W15Q64_TEST_PAGE_SIZE_SMALL                       64 // Страница из SFDP
+#define W15Q64_TEST_BUF_SIZE                              0x10000UL
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    W15Q64sim_t sim;
+    W15Q64spi_t spi;
+    uint32_t seed;
+    uint8_t *pRef; //           Буфер на W15Q64_TEST_BUF_SIZE байт
+    uint8_t *pRx; //            Буфер на W15Q64_TEST_BUF_SIZE байт
+} W15Q64test_t; //      Структура содержит окружение тестов
+
+typedef struct {
+    W15Q64srv_t *srv;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    W15Q64job_t job;
+    uint8_t prio;
+    uint32_t seed;
+    uint32_t errors; //         Чтения с неверными данными
+    uint8_t buf[W15Q64_PAGE_SIZE];
+} W15Q64testClient_t; //    Задача-клиент очереди запросов (поток POSIX)
+
+typedef struct {
+    const char *name;
+    _Bool (* run) (W15Q64test_t *test);
+} W15Q64testCase_t; //  Описание одного теста
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+
+// Проверка условия: при ошибке печатает строку теста и завершает тест
+#define W15Q64_TEST_CHECK(cond)                                                \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            return false;                                                      \
+        }                                                                      \
+    }                                                                          \
+    while (0)
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+static W15Q64test_t test;
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint32_t W15Q64_TestRand(W15Q64test_t *test);
+static uint32_t W15Q64_TestNowUs(void);
+static void W15Q64_TestFill(W15Q64test_t *test,
+                            uint8_t *pData,
+                            uint32_t cnt);
+static _Bool W15Q64_TestIsFilled(const uint8_t *pData,
+                                 uint8_t value,
+                                 uint32_t cnt);
+static _Bool W15Q64_TestVerify(W15Q64test_t *test);
+static _Bool W15Q64_TestPageWrap(W15Q64test_t *test);
+static _Bool W15Q64_TestStream(W15Q64test_t *test);
+static _Bool W15Q64_TestEraseRange(W15Q64test_t *test);
+static _Bool W15Q64_TestPageSize(W15Q64test_t *test);
+static _Bool W15Q64_TestCache(W15Q64test_t *test);
+static _Bool W15Q64_TestScrub(W15Q64test_t *test);
+static _Bool W15Q64_TestFtl(W15Q64test_t *test);
+static _Bool W15Q64_TestRing(W15Q64test_t *test);
+static _Bool W15Q64_TestStripe(W15Q64test_t *test);
+static _Bool W15Q64_TestUpdate(W15Q64test_t *test);
+static _Bool W15Q64_TestWbuf(W15Q64test_t *test);
+static _Bool W15Q64_TestImage(W15Q64test_t *test);
+static _Bool W15Q64_TestReadErase(W15Q64test_t *test);
+static _Bool W15Q64_TestReadSuspended(W15Q64test_t *test);
+static void W15Q64_TestSrvWait(void *pCtx,
+                              uint32_t timeoutUs);
+static void W15Q64_TestClientDone(void *pCtx,
+                                  W15Q64job_t *job);
+static void W15Q64_TestClientExec(W15Q64testClient_t *client);
+static void *W15Q64_TestReader(void *pArg);
+static void *W15Q64_TestWriter(void *pArg);
+static void *W15Q64_TestServer(void *pArg);
+static _Bool W15Q64_TestMultiClient(W15Q64test_t *test);
+static _Bool W15Q64_TestWbufFlush(W15Q64test_t *test);
+static uint32_t W15Q64_TestCrcBitwise(const uint8_t *pData,
+                                      uint32_t cnt);
+static _Bool W15Q64_TestCrc(W15Q64test_t *test);
+static _Bool W15Q64_TestStatus(W15Q64test_t *test);
+static _Bool W15Q64_TestContRead(W15Q64test_t *test);
+static void W15Q64_TestStreamFill(void *pCtx,
+                                  uint32_t addr,
+                                  uint8_t *pBuf,
+                                  uint16_t cnt);
+static _Bool W15Q64_TestWriteStream(W15Q64test_t *test);
+#if W15Q64_STATS
+static _Bool W15Q64_TestStats(W15Q64test_t *test);
+#endif
+#if W15Q64_STATIC_PORT
+static _Bool W15Q64_TestStaticPort(W15Q64test_t *test);
+#endif
+static _Bool W15Q64_TestRun(W15Q64test_t *test,
+                            const W15Q64testCase_t *pCase);
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Список тестов
+//------------------------------------------------------------------------------
+static const W15Q64testCase_t testCases[] = {
+    {"verify", W15Q64_TestVerify},
+    {"page_wrap", W15Q64_TestPageWrap},
+    {"stream", W15Q64_TestStream},
+    {"erase_range", W15Q64_TestEraseRange},
+    {"page_size", W15Q64_TestPageSize},
+    {"cache", W15Q64_TestCache},
+    {"scrub", W15Q64_TestScrub},
+    {"ftl", W15Q64_TestFtl},
+    {"ring", W15Q64_TestRing},
+    {"stripe", W15Q64_TestStripe},
+    {"update", W15Q64_TestUpdate},
+    {"wbuf", W15Q64_TestWbuf},
+    {"image", W15Q64_TestImage},
+    {"read_erase", W15Q64_TestReadErase},
+    {"read_suspended", W15Q64_TestReadSuspended},
+    {"srv_threads", W15Q64_TestMultiClient},
+    {"wbuf_flush", W15Q64_TestWbufFlush},
+    {"crc", W15Q64_TestCrc},
+    {"status", W15Q64_TestStatus},
+    {"cont_read", W15Q64_TestContRead},
+    {"write_stream", W15Q64_TestWriteStream},
+#if W15Q64_STATS
+    {"stats", W15Q64_TestStats},
+#endif
+#if W15Q64_STATIC_PORT
+    {"static_port", W15Q64_TestStaticPort},
+#endif
+};
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+int main(int argc, char *argv[])
+{
+    uint32_t i,
+            j,
+            failed = 0;
+    _Bool all = true;
+
+    if (!W15Q64_SimInit(&test.sim, NULL, W15Q64_SIM_CAPACITY)
+        || !W15Q64_SimBind(&test.sim, &test.spi))
+    {
+        fprintf(stderr, "w15q64_test: simulator init failed\n");
+        return 1;
+    }
+    for (i = 1; i < (uint32_t) argc; i++)
+    {
+        if (strcmp(argv[i], "-g") == 0)
+        {
+            W15Q64_SimGather(&test.sim, &test.spi, true);
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            W15Q64_SimDuplex(&test.sim, &test.spi, true);
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            W15Q64_SimMultiIo(&test.sim, &test.spi, W15Q64_BUS_DUAL | W15Q64_BUS_QUAD);
+        }
+        else
+        {
+            all = false;
+        }
+    }
+    test.seed = 12345;
+    test.pRef = (uint8_t *) malloc(W15Q64_TEST_BUF_SIZE);
+    test.pRx = (uint8_t *) malloc(W15Q64_TEST_BUF_SIZE);
+    if ((test.pRef == NULL) || (test.pRx == NULL))
+    {
+        fprintf(stderr, "w15q64_test: out of memory\n");
+        return 1;
+    }
+    W15Q64_BusInit(&test.spi);
+
+    for (i = 0; i < sizeof (testCases) / sizeof (testCases[0]); i++)
+    {
+        for (j = 1; !all && (j < (uint32_t) argc); j++)
+        {
+            if (strcmp(argv[j], testCases[i].name) == 0)
+            {
+                break;
+            }
+        }
+        if (all || (j < (uint32_t) argc))
+        {
+            failed += W15Q64_TestRun(&test, &testCases[i]) ? 0 : 1;
+        }
+    }
+    printf("%lu failed\n", (unsigned long) failed);
+
+    free(test.pRx);
+    free(test.pRef);
+    W15Q64_SimFree(&test.sim);
+    return (int) failed;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция выполняет один тест на стертой модели и печатает
+ *          результат
+ *  @param  *test:  Указатель на окружение тестов
+ *  @param  *pCase: Указатель на описание теста
+ *  @retval true - тест пройден, нарушений протокола нет
+ */
+static _Bool W15Q64_TestRun(W15Q64test_t *test,
+                            const W15Q64testCase_t *pCase)
+{
+    _Bool ok;
+
+    memset(test->sim.pMem, 0xFF, W15Q64_SIM_CAPACITY);
+    W15Q64_SimResetStats(&test->sim);
+    ok = pCase->run(test);
+    if (test->sim.stats.violations != 0)
+    {
+        printf("  %lu protocol violations\n", (unsigned long) test->sim.stats.violations);
+        ok = false;
+    }
+    printf("%-16s %s\n", pCase->name, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static uint32_t W15Q64_TestRand(W15Q64test_t *test)
+{
+    test->seed = test->seed * 1103515245UL + 12345UL;
+    return test->seed >> 1;
+}
+
+static uint32_t W15Q64_TestNowUs(void)
+{
+    return (uint32_t) (W15Q64_SimNowNs(&test.sim) / 1000);
+}
+
+/**
+ *  @brief  Функция заполняет буфер случайными байтами без 0xFF (данные
+ *          отличаются от чистой памяти в каждом байте)
+ */
+static void W15Q64_TestFill(W15Q64test_t *test,
+                            uint8_t *pData,
+                            uint32_t cnt)
+{
+    uint32_t i;
+
+    for (i = 0; i < cnt; i++)
+    {
+        pData[i] = (uint8_t) (W15Q64_TestRand(test) % 0xFF);
+    }
+}
+
+static _Bool W15Q64_TestIsFilled(const uint8_t *pData,
+                                 uint8_t value,
+                                 uint32_t cnt)
+{
+    uint32_t i;
+
+    for (i = 0; i < cnt; i++)
+    {
+        if (pData[i] != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief  W15Q64_BlankCheck() и W15Q64_Verify(): чистая область, запись с
+ *          невыровненного адреса через W15Q64_Write(), две ошибки в образце
+ */
+static _Bool W15Q64_TestVerify(W15Q64test_t *test)
+{
+    const uint32_t addr = W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET;
+    W15Q64verifyResult_t res;
+
+    W15Q64_TEST_CHECK(W15Q64_BlankCheck(&test->spi, W15Q64_TEST_VERIFY_START,
+                                        W15Q64_BLOCK_64KB_SIZE, &res));
+    W15Q64_TEST_CHECK(res.mismatches == 0);
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_VERIFY_LEN);
+    W15Q64_Write(&test->spi, addr, test->pRef, W15Q64_TEST_VERIFY_LEN);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[addr], test->pRef, W15Q64_TEST_VERIFY_LEN) == 0);
+
+    W15Q64_TEST_CHECK(!W15Q64_BlankCheck(&test->spi, W15Q64_TEST_VERIFY_START,
+                                         W15Q64_BLOCK_64KB_SIZE, &res));
+    W15Q64_TEST_CHECK(res.firstAddr == addr);
+    W15Q64_TEST_CHECK(res.mismatches == W15Q64_TEST_VERIFY_LEN);
+    W15Q64_TEST_CHECK(W15Q64_BlankCheck(&test->spi, addr + W15Q64_TEST_VERIFY_LEN,
+                                        W15Q64_SECTOR_SIZE, &res));
+
+    W15Q64_TEST_CHECK(W15Q64_Verify(&test->spi, addr, test->pRef, W15Q64_TEST_VERIFY_LEN, &res));
+    W15Q64_TEST_CHECK(res.mismatches == 0);
+    test->pRef[777] ^= 0x01;
+    test->pRef[4000] ^= 0x80;
+    W15Q64_TEST_CHECK(!W15Q64_Verify(&test->spi, addr, test->pRef, W15Q64_TEST_VERIFY_LEN, &res));
+    W15Q64_TEST_CHECK(res.firstAddr == addr + 777);
+    W15Q64_TEST_CHECK(res.mismatches == 2);
+    W15Q64_TEST_CHECK(!W15Q64_Verify(&test->spi, addr, test->pRef, W15Q64_TEST_VERIFY_LEN, NULL));
+    return true;
+}
+
+/**
+ *  @brief  Модель: Page Program с числом байт больше страницы заворачивается
+ *          на начало страницы (последние байты остаются в памяти), и при
+ *          побайтовой передаче, и одним вызовом
+ */
+static _Bool W15Q64_TestPageWrap(W15Q64test_t *test)
+{
+    uint8_t cmd[4 + 300] = {W15Q64_PAGE_PROGRAM, 0x00, 0x01, 0x10};
+    uint8_t wren = W15Q64_WRITE_ENABLE;
+    uint8_t exp[W15Q64_PAGE_SIZE];
+    uint32_t i,
+            bulk;
+
+    for (i = 0; i < 300; i++)
+    {
+        cmd[4 + i] = (uint8_t) (i + 1);
+    }
+    memset(exp, 0xFF, sizeof (exp));
+    for (i = 0; i < 300; i++)
+    {
+        exp[(0x10 + i) & (W15Q64_PAGE_SIZE - 1)] = (uint8_t) (i + 1);
+    }
+
+    for (bulk = 0; bulk < 2; bulk++)
+    {
+        memset(&test->sim.pMem[0x100], 0xFF, W15Q64_PAGE_SIZE);
+        W15Q64_SimSelect(&test->sim);
+        W15Q64_SimTransmit(&test->sim, &wren, 1);
+        W15Q64_SimDeselect(&test->sim);
+        W15Q64_SimSelect(&test->sim);
+        if (bulk != 0)
+        {
+            W15Q64_SimTransmit(&test->sim, cmd, sizeof (cmd));
+        }
+        else
+        {
+            for (i = 0; i < sizeof (cmd); i++)
+            {
+                W15Q64_SimTransmit(&test->sim, &cmd[i], 1);
+            }
+        }
+        W15Q64_SimDeselect(&test->sim);
+        W15Q64_WaitBusy(&test->spi);
+        W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[0x100], exp, W15Q64_PAGE_SIZE) == 0);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Потоковое чтение: данные всех буферов совпадают с памятью модели
+ */
+static _Bool W15Q64_TestStream(W15Q64test_t *test)
+{
+    static uint8_t bufs[W15Q64_TEST_STREAM_BUFS * W15Q64_TEST_STREAM_CHUNK];
+    W15Q64stream_t st;
+    const uint8_t *pData;
+    uint32_t cnt,
+            total = 0;
+
+    W15Q64_TestFill(test, &test->sim.pMem[W15Q64_TEST_STREAM_START], W15Q64_TEST_STREAM_LEN);
+    W15Q64_TEST_CHECK(W15Q64_StreamOpen(&st, &test->spi, W15Q64_TEST_STREAM_START,
+                                        W15Q64_TEST_STREAM_LEN, bufs,
+                                        W15Q64_TEST_STREAM_CHUNK, W15Q64_TEST_STREAM_BUFS));
+    while ((pData = W15Q64_StreamGet(&st, &cnt)) != NULL)
+    {
+        W15Q64_TEST_CHECK(total + cnt <= W15Q64_TEST_STREAM_LEN);
+        memcpy(&test->pRx[total], pData, cnt);
+        total += cnt;
+    }
+    W15Q64_StreamClose(&st);
+    W15Q64_TEST_CHECK(total == W15Q64_TEST_STREAM_LEN);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, &test->sim.pMem[W15Q64_TEST_STREAM_START],
+                             W15Q64_TEST_STREAM_LEN) == 0);
+
+    // Чтение после потока снова идет отдельными командами
+    W15Q64_FastReadData(&test->spi, W15Q64_TEST_STREAM_START, test->pRx, 16);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, &test->sim.pMem[W15Q64_TEST_STREAM_START], 16) == 0);
+    return true;
+}
+
+/**
+ *  @brief  W15Q64_EraseRange() с пропуском чистых секторов: в блоке 64 КБ
+ *          один не чистый сектор, соседние блоки не затрагиваются
+ */
+static _Bool W15Q64_TestEraseRange(W15Q64test_t *test)
+{
+    const uint32_t dirty = W15Q64_TEST_RANGE_START + W15Q64_TEST_RANGE_DIRTY * W15Q64_SECTOR_SIZE;
+    W15Q64erasePlan_t plan = {0};
+    W15Q64verifyResult_t res;
+
+    memset(&test->sim.pMem[dirty + 100], 0x00, 10);
+    test->sim.pMem[W15Q64_TEST_RANGE_START - 1] = 0x00;
+    test->sim.pMem[W15Q64_TEST_RANGE_START + W15Q64_BLOCK_64KB_SIZE] = 0x00;
+
+    W15Q64_ErasePlan(&test->spi, W15Q64_TEST_RANGE_START, W15Q64_BLOCK_64KB_SIZE, true, &plan);
+    W15Q64_TEST_CHECK(plan.opCnt == 1);
+    W15Q64_TEST_CHECK(plan.cnt4KB == 1);
+    W15Q64_TEST_CHECK(plan.skipped == W15Q64_BLOCK_64KB_SIZE / W15Q64_SECTOR_SIZE - 1);
+
+    W15Q64_EraseRange(&test->spi, W15Q64_TEST_RANGE_START, W15Q64_BLOCK_64KB_SIZE, true, &plan);
+    W15Q64_TEST_CHECK(W15Q64_BlankCheck(&test->spi, W15Q64_TEST_RANGE_START,
+                                        W15Q64_BLOCK_64KB_SIZE, &res));
+    W15Q64_TEST_CHECK(test->sim.pMem[W15Q64_TEST_RANGE_START - 1] == 0x00);
+    W15Q64_TEST_CHECK(test->sim.pMem[W15Q64_TEST_RANGE_START + W15Q64_BLOCK_64KB_SIZE] == 0x00);
+
+    // Без пропуска чистых секторов блок стирается одной командой 64 КБ
+    W15Q64_ErasePlan(&test->spi, W15Q64_TEST_RANGE_START, W15Q64_BLOCK_64KB_SIZE, false, &plan);
+    W15Q64_TEST_CHECK((plan.opCnt == 1) && (plan.cnt64KB == 1) && (plan.skipped == 0));
+    return true;
+}
+
+/**
+ *  @brief  Размер страницы из SFDP (spi->pDev) меньше 256 байт: запись и
+ *          защищенная страница делятся на страницы этого размера. Размер
+ *          стирания берется из SFDP по инструкции
+ */
+static _Bool W15Q64_TestPageSize(W15Q64test_t *test)
+{
+    W15Q64dev_t dev;
+    const W15Q64dev_t *pDev = test->spi.pDev;
+    _Bool ok,
+            intact;
+
+    W15Q64_TEST_CHECK(W15Q64_SfdpProbe(&test->spi, &dev));
+    W15Q64_TEST_CHECK(dev.capacity == W15Q64_SIM_CAPACITY);
+    W15Q64_TEST_CHECK(dev.pageSize == W15Q64_PAGE_SIZE);
+
+    dev.pageSize = W15Q64_TEST_PAGE_SIZE_SMALL;
+    test->spi.pDev = &dev;
+#if W15Q64_STATIC_GEOMETRY
+    ok = (W15Q64_PageSize(&test->spi) == W15Q64_PAGE_SIZE);
+#else
+    ok = (W15Q64_PageSize(&test->spi) == W15Q64_TEST_PAGE_SIZE_SMALL);
+#endif
+    ok = ok && (W15Q64_EraseSize(&test->spi, W15Q64_SECTOR_ERASE_4KB) == W15Q64_SECTOR_SIZE)
+            && (W15Q64_EraseSize(&test->spi, W15Q64_BLOCK_ERASE_64KB) == W15Q64_BLOCK_64KB_SIZE)
+            && (W15Q64_EraseSize(&test->spi, W15Q64_CHIP_ERASE) == 0);
+    W15Q64_TestFill(test, test->pRef, 300);
+    W15Q64_Write(&test->spi, 0x1030, test->pRef, 300);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_IntegrityProg(&test->spi, 0x2000, &test->pRef[300], W15Q64_INTEGRITY_DATA);
+    W15Q64_WaitBusy(&test->spi);
+    intact = W15Q64_IntegrityRead(&test->spi, 0x2000, test->pRx, 1, NULL);
+    test->spi.pDev = pDev;
+    W15Q64_TEST_CHECK(ok);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[0x1030], test->pRef, 300) == 0);
+    W15Q64_TEST_CHECK(intact);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, &test->pRef[300], W15Q64_INTEGRITY_DATA) == 0);
+    return true;
+}
+
+/**
+ *  @brief  Кэш чтения: попадания после первого чтения, обновление строк при
+ *          записи и стирании через драйвер, W15Q64_CacheInvalidate() после
+ *          записи в обход драйвера
+ */
+static _Bool W15Q64_TestCache(W15Q64test_t *test)
+{
+    static W15Q64cacheLine_t lines[W15Q64_TEST_CACHE_LINES];
+    static uint8_t arena[W15Q64_TEST_CACHE_LINES * W15Q64_TEST_CACHE_LINE_SIZE];
+    W15Q64cache_t cache;
+    uint8_t *pMem = &test->sim.pMem[W15Q64_TEST_CACHE_START];
+    _Bool ok = true;
+
+    W15Q64_TestFill(test, pMem, 512);
+    W15Q64_TEST_CHECK(W15Q64_CacheInit(&cache, &test->spi, lines, W15Q64_TEST_CACHE_LINES,
+                                       arena, W15Q64_TEST_CACHE_LINE_SIZE));
+    W15Q64_CacheRead(&cache, W15Q64_TEST_CACHE_START + 10, test->pRx, 300);
+    ok = ok && (memcmp(test->pRx, &pMem[10], 300) == 0);
+    W15Q64_CacheRead(&cache, W15Q64_TEST_CACHE_START + 20, test->pRx, 200);
+    ok = ok && (memcmp(test->pRx, &pMem[20], 200) == 0) && (cache.stats.hits != 0);
+
+    // Стирание и запись через драйвер обновляют строки
+    W15Q64_Erase(&test->spi, W15Q64_TEST_CACHE_START, W15Q64_SECTOR_ERASE_4KB);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_CacheRead(&cache, W15Q64_TEST_CACHE_START, test->pRx, 256);
+    ok = ok && W15Q64_TestIsFilled(test->pRx, 0xFF, 256);
+    W15Q64_TestFill(test, test->pRef, W15Q64_PAGE_SIZE);
+    W15Q64_PageProg(&test->spi, W15Q64_TEST_CACHE_START + W15Q64_PAGE_SIZE, test->pRef,
+                    W15Q64_PAGE_SIZE);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_CacheRead(&cache, W15Q64_TEST_CACHE_START + W15Q64_PAGE_SIZE, test->pRx,
+                     W15Q64_PAGE_SIZE);
+    ok = ok && (memcmp(test->pRx, test->pRef, W15Q64_PAGE_SIZE) == 0);
+
+    // Запись в обход драйвера видна только после сброса строк
+    pMem[5] = 0x00;
+    W15Q64_CacheInvalidate(&cache, W15Q64_TEST_CACHE_START + 5, 1);
+    W15Q64_CacheRead(&cache, W15Q64_TEST_CACHE_START, test->pRx, 16);
+    ok = ok && (test->pRx[5] == 0x00);
+
+    test->spi.modify = NULL;
+    test->spi.pModifyCtx = NULL;
+    W15Q64_TEST_CHECK(ok);
+    return true;
+}
+
+/**
+ *  @brief  W15Q64_IntegrityProg() и проверка CRC-32C: испорченные в памяти
+ *          модели страницы находятся и при чтении, и при проверке области
+ */
+static _Bool W15Q64_TestScrub(W15Q64test_t *test)
+{
+    W15Q64verifyResult_t res;
+    uint32_t page;
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_SCRUB_PAGES * W15Q64_INTEGRITY_DATA);
+    for (page = 0; page < W15Q64_TEST_SCRUB_PAGES; page++)
+    {
+        W15Q64_IntegrityProg(&test->spi, W15Q64_TEST_SCRUB_START + page * W15Q64_PAGE_SIZE,
+                             &test->pRef[page * W15Q64_INTEGRITY_DATA], W15Q64_INTEGRITY_DATA);
+        W15Q64_WaitBusy(&test->spi);
+    }
+    W15Q64_TEST_CHECK(W15Q64_IntegrityScrub(&test->spi, W15Q64_TEST_SCRUB_START,
+                                            W15Q64_TEST_SCRUB_PAGES, &res));
+    W15Q64_TEST_CHECK(res.mismatches == 0);
+    W15Q64_TEST_CHECK(W15Q64_IntegrityRead(&test->spi, W15Q64_TEST_SCRUB_START, test->pRx,
+                                           W15Q64_TEST_SCRUB_PAGES, &res));
+    W15Q64_TEST_CHECK(memcmp(test->pRx, test->pRef,
+                             W15Q64_TEST_SCRUB_PAGES * W15Q64_INTEGRITY_DATA) == 0);
+
+    test->sim.pMem[W15Q64_TEST_SCRUB_START + 5 * W15Q64_PAGE_SIZE + 17] ^= 0x04;
+    test->sim.pMem[W15Q64_TEST_SCRUB_START + 40 * W15Q64_PAGE_SIZE + W15Q64_INTEGRITY_DATA] ^= 0x01;
+    W15Q64_TEST_CHECK(!W15Q64_IntegrityScrub(&test->spi, W15Q64_TEST_SCRUB_START,
+                                             W15Q64_TEST_SCRUB_PAGES, &res));
+    W15Q64_TEST_CHECK(res.mismatches == 2);
+    W15Q64_TEST_CHECK(res.firstAddr == W15Q64_TEST_SCRUB_START + 5 * W15Q64_PAGE_SIZE);
+    W15Q64_TEST_CHECK(!W15Q64_IntegrityRead(&test->spi, W15Q64_TEST_SCRUB_START, test->pRx,
+                                            W15Q64_TEST_SCRUB_PAGES, NULL));
+    return true;
+}
+
+/**
+ *  @brief  Журнальный слой: случайные записи и чтения с фоновой сборкой
+ *          мусора (запись и чтение приостанавливают стирание), затем
+ *          повторное монтирование. Содержимое сравнивается с копией в ОЗУ
+ */
+static _Bool W15Q64_TestFtl(W15Q64test_t *test)
+{
+    static W15Q64ftlSector_t sectors[W15Q64_TEST_FTL_SECTORS];
+    static uint16_t map[W15Q64_TEST_FTL_BLOCKS];
+    uint8_t (*pShadow)[W15Q64_PAGE_SIZE] = (uint8_t (*)[W15Q64_PAGE_SIZE]) test->pRef;
+    W15Q64ftl_t ftl;
+    uint8_t buf[W15Q64_PAGE_SIZE];
+    uint32_t i,
+            k,
+            bad = 0;
+    uint16_t lba;
+
+    W15Q64_TEST_CHECK(W15Q64_FtlInit(&ftl, &test->spi, W15Q64_TEST_FTL_START,
+                                     W15Q64_TEST_FTL_SECTORS, sectors, map,
+                                     W15Q64_TEST_FTL_BLOCKS));
+    ftl.now_us = W15Q64_TestNowUs;
+    W15Q64_FtlMount(&ftl);
+    memset(pShadow, 0xFF, W15Q64_TEST_FTL_BLOCKS * W15Q64_PAGE_SIZE);
+    for (i = 0; i < W15Q64_TEST_FTL_WRITES; i++)
+    {
+        lba = (uint16_t) (W15Q64_TestRand(test) % W15Q64_TEST_FTL_BLOCKS);
+        W15Q64_TestFill(test, buf, sizeof (buf));
+        W15Q64_TEST_CHECK(W15Q64_FtlWrite(&ftl, lba, buf) == W15Q64_FTL_OK);
+        memcpy(pShadow[lba], buf, sizeof (buf));
+
+        lba = (uint16_t) (W15Q64_TestRand(test) % W15Q64_TEST_FTL_BLOCKS);
+        W15Q64_FtlRead(&ftl, lba, buf);
+        bad += (memcmp(buf, pShadow[lba], sizeof (buf)) != 0) ? 1 : 0;
+        for (k = W15Q64_TestRand(test) % 20; k > 0; k--)
+        {
+            W15Q64_FtlPoll(&ftl);
+            W15Q64_SimAdvanceNs(&test->sim, 200000UL);
+        }
+    }
+    while (W15Q64_FtlPoll(&ftl))
+    {
+        W15Q64_SimAdvanceNs(&test->sim, W15Q64_TEST_LOOP_PERIOD_US * 1000UL);
+    }
+    W15Q64_TEST_CHECK(bad == 0);
+    W15Q64_TEST_CHECK(ftl.stats.erases != 0);
+    W15Q64_TEST_CHECK(ftl.stats.suspends != 0);
+
+    W15Q64_TEST_CHECK(W15Q64_FtlInit(&ftl, &test->spi, W15Q64_TEST_FTL_START,
+                                     W15Q64_TEST_FTL_SECTORS, sectors, map,
+                                     W15Q64_TEST_FTL_BLOCKS));
+    W15Q64_FtlMount(&ftl);
+    for (lba = 0; lba < W15Q64_TEST_FTL_BLOCKS; lba++)
+    {
+        W15Q64_FtlRead(&ftl, lba, buf);
+        bad += (memcmp(buf, pShadow[lba], sizeof (buf)) != 0) ? 1 : 0;
+    }
+    W15Q64_TEST_CHECK(bad == 0);
+    return true;
+}
+
+/**
+ *  @brief  Кольцевой журнал: записей больше объема области (журнал проходит
+ *          круг), после повторного монтирования читаются последние записи
+ *          подряд, до последней добавленной
+ */
+static _Bool W15Q64_TestRing(W15Q64test_t *test)
+{
+    static uint8_t queue[W15Q64_TEST_RING_QUEUE * W15Q64_PAGE_SIZE];
+    W15Q64ring_t ring;
+    W15Q64ringCursor_t cur;
+    uint8_t rec[W15Q64_RING_MAX_RECORD];
+    uint64_t startNs,
+            opNs;
+    uint32_t i,
+            idx,
+            prev = 0,
+            cnt = 0;
+
+    W15Q64_TEST_CHECK(W15Q64_RingInit(&ring, &test->spi, W15Q64_TEST_RING_START,
+                                      W15Q64_TEST_RING_SECTORS, queue, W15Q64_TEST_RING_QUEUE));
+    W15Q64_RingMount(&ring);
+    for (i = 0; i < W15Q64_TEST_RING_RECORDS; i++)
+    {
+        memset(rec, (uint8_t) i, W15Q64_TEST_RING_RECORD);
+        memcpy(rec, &i, sizeof (i));
+        startNs = W15Q64_SimNowNs(&test->sim);
+        W15Q64_TEST_CHECK(W15Q64_RingAppend(&ring, rec, W15Q64_TEST_RING_RECORD) == W15Q64_RING_OK);
+        W15Q64_RingPoll(&ring);
+        opNs = W15Q64_SimNowNs(&test->sim) - startNs;
+        if (opNs < W15Q64_TEST_RING_PERIOD_US * 1000ULL)
+        {
+            W15Q64_SimAdvanceNs(&test->sim, W15Q64_TEST_RING_PERIOD_US * 1000ULL - opNs);
+        }
+    }
+    W15Q64_RingFlush(&ring);
+    W15Q64_TEST_CHECK(ring.stats.overruns == 0);
+    W15Q64_TEST_CHECK(ring.stats.erases != 0);
+
+    W15Q64_TEST_CHECK(W15Q64_RingInit(&ring, &test->spi, W15Q64_TEST_RING_START,
+                                      W15Q64_TEST_RING_SECTORS, queue, W15Q64_TEST_RING_QUEUE));
+    W15Q64_RingMount(&ring);
+    W15Q64_RingFirst(&ring, &cur);
+    while ((i = W15Q64_RingNext(&ring, &cur, rec)) != 0)
+    {
+        W15Q64_TEST_CHECK(i == W15Q64_TEST_RING_RECORD);
+        memcpy(&idx, rec, sizeof (idx));
+        W15Q64_TEST_CHECK((cnt == 0) || (idx == prev + 1));
+        W15Q64_TEST_CHECK(rec[W15Q64_TEST_RING_RECORD - 1] == (uint8_t) idx);
+        prev = idx;
+        cnt++;
+    }
+    W15Q64_TEST_CHECK(cnt != 0);
+    W15Q64_TEST_CHECK(cnt < W15Q64_TEST_RING_RECORDS);
+    W15Q64_TEST_CHECK(prev == W15Q64_TEST_RING_RECORDS - 1);
+
+    // Запись после монтирования продолжает журнал
+    i = W15Q64_TEST_RING_RECORDS;
+    memset(rec, (uint8_t) i, W15Q64_TEST_RING_RECORD);
+    memcpy(rec, &i, sizeof (i));
+    W15Q64_TEST_CHECK(W15Q64_RingAppend(&ring, rec, W15Q64_TEST_RING_RECORD) == W15Q64_RING_OK);
+    W15Q64_RingFlush(&ring);
+    W15Q64_RingFirst(&ring, &cur);
+    while (W15Q64_RingNext(&ring, &cur, rec) != 0)
+    {
+        memcpy(&idx, rec, sizeof (idx));
+    }
+    W15Q64_TEST_CHECK(idx == W15Q64_TEST_RING_RECORDS);
+    return true;
+}
+
+/**
+ *  @brief  Том из W15Q64_TEST_STRIPE_CHIPS микросхем: стирание, запись и
+ *          чтение с невыровненного адреса, размещение частей по микросхемам,
+ *          отказ для областей за концом тома, стирание блоками 32 КБ в
+ *          микросхеме без Block Erase 64KB (по параметрам SFDP)
+ */
+static _Bool W15Q64_TestStripe(W15Q64test_t *test)
+{
+    W15Q64sim_t sims[W15Q64_TEST_STRIPE_CHIPS - 1];
+    W15Q64spi_t spi[W15Q64_TEST_STRIPE_CHIPS - 1];
+    W15Q64spi_t *ppSpi[W15Q64_TEST_STRIPE_CHIPS] = {&test->spi};
+    W15Q64sim_t *ppSim[W15Q64_TEST_STRIPE_CHIPS] = {&test->sim};
+    W15Q64stripe_t vol;
+    W15Q64dev_t dev;
+    const W15Q64dev_t *pDev = test->spi.pDev;
+    uint64_t progs;
+    uint32_t i,
+            unit,
+            violations = 0;
+    _Bool ok;
+
+    for (i = 1; i < W15Q64_TEST_STRIPE_CHIPS; i++)
+    {
+        if (!W15Q64_SimInit(&sims[i - 1], NULL, W15Q64_SIM_CAPACITY))
+        {
+            return false;
+        }
+        W15Q64_SimBind(&sims[i - 1], &spi[i - 1]);
+        W15Q64_SimShareClock(&sims[i - 1], &test->sim);
+        memset(sims[i - 1].pMem, 0x00, W15Q64_TEST_STRIPE_LEN);
+        ppSpi[i] = &spi[i - 1];
+        ppSim[i] = &sims[i - 1];
+    }
+    memset(test->sim.pMem, 0x00, W15Q64_TEST_STRIPE_LEN);
+
+    ok = W15Q64_StripeInit(&vol, ppSpi, W15Q64_TEST_STRIPE_CHIPS, W15Q64_TEST_STRIPE_UNIT);
+    if (ok)
+    {
+        W15Q64_StripeErase(&vol, 0, W15Q64_TEST_STRIPE_LEN);
+        for (i = 0; i < W15Q64_TEST_STRIPE_CHIPS; i++)
+        {
+            ok = ok && W15Q64_TestIsFilled(ppSim[i]->pMem, 0xFF,
+                                           (W15Q64_TEST_STRIPE_LEN / W15Q64_TEST_STRIPE_UNIT
+                                            / W15Q64_TEST_STRIPE_CHIPS) * W15Q64_TEST_STRIPE_UNIT);
+        }
+        W15Q64_TestFill(test, test->pRef, W15Q64_TEST_STRIPE_LEN);
+        W15Q64_StripeWrite(&vol, W15Q64_TEST_STRIPE_OFFSET, test->pRef,
+                           W15Q64_TEST_STRIPE_LEN - W15Q64_TEST_STRIPE_OFFSET);
+        memset(test->pRx, 0, W15Q64_TEST_STRIPE_LEN);
+        W15Q64_StripeRead(&vol, W15Q64_TEST_STRIPE_OFFSET, test->pRx,
+                          W15Q64_TEST_STRIPE_LEN - W15Q64_TEST_STRIPE_OFFSET);
+        ok = ok && (memcmp(test->pRx, test->pRef,
+                           W15Q64_TEST_STRIPE_LEN - W15Q64_TEST_STRIPE_OFFSET) == 0);
+
+        // Часть unit тома находится в микросхеме unit % N по адресу
+        // (unit / N) * W15Q64_TEST_STRIPE_UNIT
+        for (unit = 1; unit < W15Q64_TEST_STRIPE_LEN / W15Q64_TEST_STRIPE_UNIT; unit++)
+        {
+            ok = ok && (memcmp(&ppSim[unit % W15Q64_TEST_STRIPE_CHIPS]->pMem[
+                                   (unit / W15Q64_TEST_STRIPE_CHIPS) * W15Q64_TEST_STRIPE_UNIT],
+                               &test->pRef[unit * W15Q64_TEST_STRIPE_UNIT - W15Q64_TEST_STRIPE_OFFSET],
+                               W15Q64_TEST_STRIPE_UNIT) == 0);
+        }
+
+        // Области за концом тома (в том числе с переполнением addr + cnt)
+        progs = test->sim.stats.opcodes[W15Q64_PAGE_PROGRAM];
+        ok = ok && !W15Q64_StripeRead(&vol, vol.size - 1, test->pRx, 2)
+                && !W15Q64_StripeWrite(&vol, 0xFFFFFF00UL, test->pRef, 0x200)
+                && !W15Q64_StripeErase(&vol, vol.size, 1)
+                && W15Q64_StripeRead(&vol, vol.size - 1, test->pRx, 1)
+                && (test->sim.stats.opcodes[W15Q64_PAGE_PROGRAM] == progs);
+
+        // Микросхема 0 не поддерживает Block Erase 64KB
+        ok = ok && W15Q64_SfdpProbe(&test->spi, &dev);
+        for (i = 0; i < W15Q64_DEV_ERASE_TYPES; i++)
+        {
+            if (dev.erase[i].instruct == W15Q64_BLOCK_ERASE_64KB)
+            {
+                dev.erase[i].instruct = 0;
+            }
+        }
+        test->spi.pDev = &dev;
+        memset(&test->sim.pMem[W15Q64_BLOCK_64KB_SIZE], 0x00, W15Q64_BLOCK_64KB_SIZE);
+        ok = ok && W15Q64_StripeErase(&vol, W15Q64_TEST_STRIPE_CHIPS * W15Q64_BLOCK_64KB_SIZE,
+                                      W15Q64_TEST_STRIPE_CHIPS * W15Q64_BLOCK_64KB_SIZE);
+        test->spi.pDev = pDev;
+        ok = ok && (test->sim.stats.opcodes[W15Q64_BLOCK_ERASE_64KB] == 0)
+                && (test->sim.stats.opcodes[W15Q64_BLOCK_ERASE_32KB] == 2)
+                && (sims[0].stats.opcodes[W15Q64_BLOCK_ERASE_64KB] == 1)
+                && W15Q64_TestIsFilled(&test->sim.pMem[W15Q64_BLOCK_64KB_SIZE], 0xFF,
+                                       W15Q64_BLOCK_64KB_SIZE);
+    }
+    for (i = 1; i < W15Q64_TEST_STRIPE_CHIPS; i++)
+    {
+        violations += sims[i - 1].stats.violations;
+        W15Q64_SimFree(&sims[i - 1]);
+    }
+    W15Q64_TEST_CHECK(ok);
+    W15Q64_TEST_CHECK(violations == 0);
+    return true;
+}
+
+/**
+ *  @brief  Обновление образа частями с записью только измененных секторов:
+ *          в одном секторе биты только сбрасываются, в двух - и
+ *          устанавливаются, остальные не изменены
+ */
+static _Bool W15Q64_TestUpdate(W15Q64test_t *test)
+{
+    static W15Q64update_t upd;
+    uint32_t addr,
+            cnt,
+            i;
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_UPD_LEN);
+    memset(&test->pRef[W15Q64_TEST_UPD_LEN - W15Q64_SECTOR_SIZE], 0xFF, W15Q64_SECTOR_SIZE);
+    memcpy(&test->sim.pMem[W15Q64_TEST_UPD_START], test->pRef, W15Q64_TEST_UPD_LEN);
+    memset(&test->pRef[W15Q64_TEST_UPD_LEN - W15Q64_SECTOR_SIZE], 0x5A, 300);
+    for (i = 0; i < 64; i++)
+    {
+        test->pRef[5 * W15Q64_SECTOR_SIZE + 100 + i] ^= 0xFF;
+        test->pRef[11 * W15Q64_SECTOR_SIZE + 7 * i] ^= 0x10;
+    }
+
+    W15Q64_TEST_CHECK(W15Q64_UpdateBegin(&upd, &test->spi, W15Q64_TEST_UPD_START,
+                                         W15Q64_TestNowUs));
+    for (addr = 0; addr < W15Q64_TEST_UPD_LEN; addr += cnt)
+    {
+        cnt = W15Q64_TEST_UPD_LEN - addr;
+        if (cnt > W15Q64_TEST_UPD_CHUNK)
+        {
+            cnt = W15Q64_TEST_UPD_CHUNK;
+        }
+        W15Q64_TEST_CHECK(W15Q64_UpdateWrite(&upd, &test->pRef[addr], cnt));
+    }
+    W15Q64_TEST_CHECK(W15Q64_UpdateEnd(&upd));
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[W15Q64_TEST_UPD_START], test->pRef,
+                             W15Q64_TEST_UPD_LEN) == 0);
+    W15Q64_TEST_CHECK(upd.stats.sectors == W15Q64_TEST_UPD_LEN / W15Q64_SECTOR_SIZE);
+    W15Q64_TEST_CHECK(upd.stats.skipped == upd.stats.sectors - 3);
+    W15Q64_TEST_CHECK(upd.stats.programmed == 1);
+    W15Q64_TEST_CHECK(upd.stats.erased == 2);
+    W15Q64_TEST_CHECK(upd.stats.verifyErrors == 0);
+    return true;
+}
+
+/**
+ *  @brief  Буфер записи: установка битов в байте, записанном в буфер или
+ *          уже запрограммированном в микросхеме (после W15Q64_WbufFlush()),
+ *          возвращает W15Q64_WBUF_NEED_ERASE
+ */
+static _Bool W15Q64_TestWbuf(W15Q64test_t *test)
+{
+    const uint32_t addr = W15Q64_TEST_WBUF_START + 0x10;
+    W15Q64wbuf_t wbuf;
+    uint8_t data[2] = {0x0F, 0x3C},
+            set = 0xFF,
+            clear = 0x0C;
+
+    W15Q64_WbufInit(&wbuf, &test->spi, 0, NULL);
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr, data, 2) == W15Q64_WBUF_OK);
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr, &set, 1) == W15Q64_WBUF_NEED_ERASE);
+    W15Q64_WbufFlush(&wbuf);
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 1);
+    W15Q64_TEST_CHECK((test->sim.pMem[addr] == 0x0F) && (test->sim.pMem[addr + 1] == 0x3C));
+
+    // Повторная запись после Flush: буфер открывается на той же странице
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr + 1, &set, 1) == W15Q64_WBUF_NEED_ERASE);
+    W15Q64_TEST_CHECK(wbuf.stats.conflictAddr == addr + 1);
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr, &clear, 1) == W15Q64_WBUF_OK);
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr + 2, &set, 1) == W15Q64_WBUF_OK);
+    W15Q64_WbufFlush(&wbuf);
+    W15Q64_TEST_CHECK(wbuf.stats.conflicts == 2);
+    W15Q64_TEST_CHECK((test->sim.pMem[addr] == 0x0C) && (test->sim.pMem[addr + 1] == 0x3C));
+    return true;
+}
+
+/**
+ *  @brief  Образ во временном файле: запись и стирание через драйвер
+ *          сохраняются после повторного открытия, W15Q64_ImagePtr() дает
+ *          данные отображения, изменения образа только для чтения в файл
+ *          не попадают
+ */
+static _Bool W15Q64_TestImage(W15Q64test_t *test)
+{
+    char path[] = "/tmp/w15q64_test_XXXXXX";
+    W15Q64image_t img;
+    W15Q64spi_t spi;
+    const uint8_t *pData;
+    FILE *pFile;
+    int fd;
+    _Bool ok;
+
+    fd = mkstemp(path);
+    W15Q64_TEST_CHECK(fd >= 0);
+    close(fd);
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_IMAGE_LEN + 16);
+
+    // Новый образ: чистая память, запись и стирание сектора
+    memset(&spi, 0, sizeof (spi));
+    ok = W15Q64_ImageOpen(&img, path, W15Q64_TEST_IMAGE_SIZE, W15Q64_IMAGE_CREATE, &spi);
+    if (ok)
+    {
+        W15Q64_BusInit(&spi);
+        W15Q64_Write(&spi, W15Q64_TEST_IMAGE_ADDR, test->pRef, W15Q64_TEST_IMAGE_LEN);
+        W15Q64_Write(&spi, 0x3000, &test->pRef[W15Q64_TEST_IMAGE_LEN], 16);
+        W15Q64_SectorErase4KB(&spi, 0x3000);
+        W15Q64_WaitBusy(&spi);
+        pData = W15Q64_ImagePtr(&img, W15Q64_TEST_IMAGE_ADDR, W15Q64_TEST_IMAGE_LEN);
+        ok = (pData != NULL) && (memcmp(pData, test->pRef, W15Q64_TEST_IMAGE_LEN) == 0)
+                && (W15Q64_ImagePtr(&img, W15Q64_TEST_IMAGE_SIZE - 1, 2) == NULL);
+        pData = W15Q64_ImagePtr(&img, 0, W15Q64_TEST_IMAGE_SIZE);
+        ok = ok && (pData != NULL) && W15Q64_TestIsFilled(pData, 0xFF, W15Q64_TEST_IMAGE_ADDR)
+                && W15Q64_TestIsFilled(&pData[0x3000], 0xFF, W15Q64_SECTOR_SIZE);
+        W15Q64_ImageClose(&img);
+    }
+
+    // Повторное открытие для записи: данные сохранились
+    ok = ok && W15Q64_ImageOpen(&img, path, 0, 0, &spi);
+    if (ok)
+    {
+        W15Q64_BusInit(&spi);
+        W15Q64_FastReadData(&spi, W15Q64_TEST_IMAGE_ADDR, test->pRx, W15Q64_TEST_IMAGE_LEN);
+        ok = (img.size == W15Q64_TEST_IMAGE_SIZE)
+                && (memcmp(test->pRx, test->pRef, W15Q64_TEST_IMAGE_LEN) == 0);
+        W15Q64_ImageClose(&img);
+    }
+
+    // Только для чтения: стирание видно в образе, но не в файле
+    ok = ok && W15Q64_ImageOpen(&img, path, 0, W15Q64_IMAGE_READONLY, &spi);
+    if (ok)
+    {
+        W15Q64_BusInit(&spi);
+        W15Q64_SectorErase4KB(&spi, W15Q64_TEST_IMAGE_ADDR);
+        W15Q64_WaitBusy(&spi);
+        pData = W15Q64_ImagePtr(&img, W15Q64_TEST_IMAGE_ADDR, W15Q64_TEST_IMAGE_LEN);
+        ok = (pData != NULL) && W15Q64_TestIsFilled(pData, 0xFF, W15Q64_TEST_IMAGE_LEN);
+        W15Q64_ImageClose(&img);
+    }
+    pFile = fopen(path, "rb");
+    ok = ok && (pFile != NULL)
+            && (fseek(pFile, (long) W15Q64_TEST_IMAGE_ADDR, SEEK_SET) == 0)
+            && (fread(test->pRx, 1, W15Q64_TEST_IMAGE_LEN, pFile) == W15Q64_TEST_IMAGE_LEN)
+            && (memcmp(test->pRx, test->pRef, W15Q64_TEST_IMAGE_LEN) == 0);
+    if (pFile != NULL)
+    {
+        fclose(pFile);
+    }
+    unlink(path);
+    W15Q64_TEST_CHECK(ok);
+    return true;
+}
+
+/**
+ *  @brief  Очередь заданий с вытеснением: чтения все время стоят в очереди,
+ *          стирание приостанавливается для них, но не останавливается
+ *          (ограничение числа чтений за одну приостановку)
+ */
+static _Bool W15Q64_TestReadErase(W15Q64test_t *test)
+{
+    W15Q64jobQueue_t queue;
+    W15Q64job_t erase,
+            reads[W15Q64_TEST_RWE_READS];
+    uint8_t bufs[W15Q64_TEST_RWE_READS][16];
+    uint32_t polls,
+            k,
+            bad = 0;
+    _Bool done;
+
+    W15Q64_TestFill(test, &test->sim.pMem[0x8000], 16);
+    W15Q64_TestFill(test, test->sim.pMem, 16);
+    W15Q64_JobInit(&queue, &test->spi);
+    W15Q64_JobPreempt(&queue, true, W15Q64_TestNowUs);
+    W15Q64_JobErase(&erase, W15Q64_SECTOR_ERASE_4KB, 0, NULL, NULL);
+    W15Q64_JobSubmit(&queue, &erase);
+    for (k = 0; k < W15Q64_TEST_RWE_READS; k++)
+    {
+        reads[k].state = W15Q64_JOB_DONE;
+    }
+    for (polls = 0; (erase.state != W15Q64_JOB_DONE) && (polls < W15Q64_TEST_RWE_MAX_POLLS); polls++)
+    {
+        for (k = 0; k < W15Q64_TEST_RWE_READS; k++)
+        {
+            if (reads[k].state == W15Q64_JOB_DONE)
+            {
+                if ((polls != 0) && (memcmp(bufs[k], &test->sim.pMem[0x8000], 16) != 0))
+                {
+                    bad++;
+                }
+                W15Q64_JobRead(&reads[k], 0x8000, bufs[k], 16, NULL, NULL);
+                W15Q64_JobSubmitRead(&queue, &reads[k]);
+            }
+        }
+        W15Q64_Poll(&queue);
+        W15Q64_SimAdvanceNs(&test->sim, 10000UL);
+    }
+    done = (erase.state == W15Q64_JOB_DONE);
+    while (W15Q64_Poll(&queue))
+    {
+        W15Q64_SimAdvanceNs(&test->sim, W15Q64_TEST_LOOP_PERIOD_US * 1000UL);
+    }
+    W15Q64_TEST_CHECK(done);
+    W15Q64_TEST_CHECK(queue.suspends != 0);
+    W15Q64_TEST_CHECK(bad == 0);
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(test->sim.pMem, 0xFF, W15Q64_SECTOR_SIZE));
+    return true;
+}
+
+/**
+ *  @brief  Очередь заданий с вытеснением: чтение вне стираемого сектора
+ *          выполняется во время Suspend, чтение стираемого сектора и
+ *          программируемой страницы - только после окончания операции
+ *          (модель считает чтение приостановленной области нарушением)
+ */
+static _Bool W15Q64_TestReadSuspended(W15Q64test_t *test)
+{
+    W15Q64jobQueue_t queue;
+    W15Q64job_t op,
+            outside,
+            inside;
+    uint8_t bufOut[16],
+            bufIn[16];
+    uint32_t polls;
+    _Bool served;
+
+    W15Q64_TestFill(test, test->sim.pMem, W15Q64_SECTOR_SIZE);
+    W15Q64_TestFill(test, &test->sim.pMem[0x8000], 16);
+    W15Q64_JobInit(&queue, &test->spi);
+    W15Q64_JobPreempt(&queue, true, W15Q64_TestNowUs);
+    W15Q64_JobErase(&op, W15Q64_SECTOR_ERASE_4KB, 0, NULL, NULL);
+    W15Q64_JobSubmit(&queue, &op);
+    W15Q64_Poll(&queue);
+
+    // Чтения поданы сразу после команды стирания, оно еще идет
+    W15Q64_JobRead(&outside, 0x8000, bufOut, 16, NULL, NULL);
+    W15Q64_JobSubmitRead(&queue, &outside);
+    W15Q64_JobRead(&inside, 0x100, bufIn, 16, NULL, NULL);
+    W15Q64_JobSubmitRead(&queue, &inside);
+    for (polls = 0; (op.state != W15Q64_JOB_DONE) && (polls < W15Q64_TEST_RWE_MAX_POLLS); polls++)
+    {
+        W15Q64_TEST_CHECK(inside.state != W15Q64_JOB_DONE);
+        W15Q64_Poll(&queue);
+        W15Q64_SimAdvanceNs(&test->sim, 10000UL);
+    }
+    served = (outside.state == W15Q64_JOB_DONE);
+    while (W15Q64_Poll(&queue))
+    {
+        W15Q64_SimAdvanceNs(&test->sim, W15Q64_TEST_LOOP_PERIOD_US * 1000UL);
+    }
+    W15Q64_TEST_CHECK(served && (queue.suspends != 0));
+    W15Q64_TEST_CHECK(memcmp(bufOut, &test->sim.pMem[0x8000], 16) == 0);
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(bufIn, 0xFF, 16));
+
+    // Чтение программируемой страницы
+    W15Q64_TestFill(test, test->pRef, W15Q64_PAGE_SIZE);
+    W15Q64_JobProgram(&op, 0x200, test->pRef, W15Q64_PAGE_SIZE, NULL, NULL);
+    W15Q64_JobSubmit(&queue, &op);
+    W15Q64_Poll(&queue);
+    W15Q64_JobRead(&inside, 0x210, bufIn, 16, NULL, NULL);
+    W15Q64_JobSubmitRead(&queue, &inside);
+    while (W15Q64_Poll(&queue))
+    {
+        W15Q64_SimAdvanceNs(&test->sim, 10000UL);
+    }
+    W15Q64_TEST_CHECK(memcmp(bufIn, &test->pRef[0x10], 16) == 0);
+    return true;
+}
+
+/**
+ *  @brief  Ожидание задачи обслуживания: во время BUSY продвигает время
+ *          модели на время ожидания (модель не связана с реальным временем)
+ */
+static void W15Q64_TestSrvWait(void *pCtx,
+                              uint32_t timeoutUs)
+{
+    if (timeoutUs != 0)
+    {
+        W15Q64_SimAdvanceNs(&test.sim, timeoutUs * 1000UL);
+    }
+    W15Q64_OsPosixWait(pCtx, timeoutUs);
+}
+
+static void W15Q64_TestClientDone(void *pCtx,
+                                  W15Q64job_t *job)
+{
+    W15Q64testClient_t *client = (W15Q64testClient_t *) pCtx;
+
+    (void) job;
+    pthread_mutex_lock(&client->mutex);
+    pthread_cond_signal(&client->cond);
+    pthread_mutex_unlock(&client->mutex);
+}
+
+/**
+ *  @brief  Функция ставит запрос клиента в очередь и ждет его выполнения
+ */
+static void W15Q64_TestClientExec(W15Q64testClient_t *client)
+{
+    pthread_mutex_lock(&client->mutex);
+    W15Q64_SrvSubmit(client->srv, &client->job, client->prio);
+    while (client->job.state != W15Q64_JOB_DONE)
+    {
+        pthread_cond_wait(&client->cond, &client->mutex);
+    }
+    pthread_mutex_unlock(&client->mutex);
+}
+
+/**
+ *  @brief  Задача чтения: случайные чтения области, которую не изменяет
+ *          задача записи, сравниваются с памятью модели
+ */
+static void *W15Q64_TestReader(void *pArg)
+{
+    W15Q64testClient_t *client = (W15Q64testClient_t *) pArg;
+    uint32_t i,
+            addr;
+
+    for (i = 0; i < W15Q64_TEST_MC_READS; i++)
+    {
+        client->seed = client->seed * 1103515245UL + 12345UL;
+        addr = W15Q64_TEST_MC_READ_BASE + (client->seed >> 8) % 0x10000UL;
+        W15Q64_JobRead(&client->job, addr, client->buf, W15Q64_TEST_MC_READ_LEN,
+                       W15Q64_TestClientDone, client);
+        W15Q64_TestClientExec(client);
+        if (memcmp(client->buf, &test.sim.pMem[addr], W15Q64_TEST_MC_READ_LEN) != 0)
+        {
+            client->errors++;
+        }
+    }
+    return NULL;
+}
+
+static void *W15Q64_TestWriter(void *pArg)
+{
+    W15Q64testClient_t *client = (W15Q64testClient_t *) pArg;
+    uint32_t sector,
+            addr;
+
+    memset(client->buf, 0x3C, sizeof (client->buf));
+    for (sector = 0; sector < W15Q64_TEST_MC_SECTORS; sector++)
+    {
+        W15Q64_JobErase(&client->job, W15Q64_SECTOR_ERASE_4KB,
+                        W15Q64_TEST_MC_WRITE_BASE + sector * W15Q64_SECTOR_SIZE,
+                        W15Q64_TestClientDone, client);
+        W15Q64_TestClientExec(client);
+        for (addr = 0; addr < W15Q64_SECTOR_SIZE; addr += W15Q64_PAGE_SIZE)
+        {
+            W15Q64_JobProgram(&client->job,
+                              W15Q64_TEST_MC_WRITE_BASE + sector * W15Q64_SECTOR_SIZE + addr,
+                              client->buf, W15Q64_PAGE_SIZE,
+                              W15Q64_TestClientDone, client);
+            W15Q64_TestClientExec(client);
+        }
+    }
+    return NULL;
+}
+
+static void *W15Q64_TestServer(void *pArg)
+{
+    W15Q64_SrvRun((W15Q64srv_t *) pArg);
+    return NULL;
+}
+
+/**
+ *  @brief  Задача записи (стирание и запись секторов, приоритет 0) и
+ *          W15Q64_TEST_MC_READERS задач чтения работают с одной микросхемой
+ *          через очередь запросов и задачу обслуживания (потоки POSIX)
+ */
+static _Bool W15Q64_TestMultiClient(W15Q64test_t *test)
+{
+    static W15Q64testClient_t clients[W15Q64_TEST_MC_READERS + 1];
+    pthread_t threads[W15Q64_TEST_MC_READERS + 1],
+            server;
+    W15Q64osPosix_t posix;
+    W15Q64os_t os;
+    W15Q64srv_t srv;
+    uint32_t errors = 0;
+    uint8_t i;
+
+    W15Q64_TestFill(test, &test->sim.pMem[W15Q64_TEST_MC_READ_BASE],
+                    0x10000UL + W15Q64_TEST_MC_READ_LEN);
+    memset(&test->sim.pMem[W15Q64_TEST_MC_WRITE_BASE], 0x00,
+           W15Q64_TEST_MC_SECTORS * W15Q64_SECTOR_SIZE);
+    W15Q64_TEST_CHECK(W15Q64_OsPosixInit(&os, &posix));
+    os.wait = W15Q64_TestSrvWait;
+    W15Q64_SrvInit(&srv, &test->spi, &os, W15Q64_TestNowUs);
+    pthread_create(&server, NULL, W15Q64_TestServer, &srv);
+
+    for (i = 0; i <= W15Q64_TEST_MC_READERS; i++)
+    {
+        memset(&clients[i], 0, sizeof (clients[i]));
+        clients[i].srv = &srv;
+        clients[i].prio = i;
+        clients[i].seed = i;
+        pthread_mutex_init(&clients[i].mutex, NULL);
+        pthread_cond_init(&clients[i].cond, NULL);
+        pthread_create(&threads[i], NULL,
+                       (i == 0) ? W15Q64_TestWriter : W15Q64_TestReader, &clients[i]);
+    }
+    for (i = 0; i <= W15Q64_TEST_MC_READERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        pthread_cond_destroy(&clients[i].cond);
+        pthread_mutex_destroy(&clients[i].mutex);
+        errors += clients[i].errors;
+    }
+    W15Q64_SrvStop(&srv);
+    pthread_join(server, NULL);
+    W15Q64_OsPosixDeinit(&posix);
+
+    W15Q64_TEST_CHECK(errors == 0);
+    W15Q64_TEST_CHECK(srv.submitted == W15Q64_TEST_MC_READERS * W15Q64_TEST_MC_READS
+                      + W15Q64_TEST_MC_SECTORS * (1 + W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE));
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(&test->sim.pMem[W15Q64_TEST_MC_WRITE_BASE], 0x3C,
+                                          W15Q64_TEST_MC_SECTORS * W15Q64_SECTOR_SIZE));
+    return true;
+}
+
+/**
+ *  @brief  Буфер записи: записи в одну страницу объединяются в одну команду
+ *          Page Program, переход к другой странице и истечение deadlineUs
+ *          программируют накопленную страницу, W15Q64_WbufRead() видит
+ *          данные буфера до записи в микросхему
+ */
+static _Bool W15Q64_TestWbufFlush(W15Q64test_t *test)
+{
+    const uint32_t addr = W15Q64_TEST_WBUF_START + W15Q64_SECTOR_SIZE;
+    W15Q64wbuf_t wbuf;
+    uint32_t i;
+
+    W15Q64_TestFill(test, test->pRef, 2 * W15Q64_PAGE_SIZE);
+    W15Q64_WbufInit(&wbuf, &test->spi, 1000, W15Q64_TestNowUs);
+    for (i = 0; i < W15Q64_PAGE_SIZE; i += 16)
+    {
+        W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr + i, &test->pRef[i], 16) == W15Q64_WBUF_OK);
+    }
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 0);
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(&test->sim.pMem[addr], 0xFF, W15Q64_PAGE_SIZE));
+    W15Q64_WbufRead(&wbuf, addr + 8, test->pRx, 32);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, &test->pRef[8], 32) == 0);
+
+    // Следующая страница: предыдущая программируется одной командой
+    W15Q64_TEST_CHECK(W15Q64_WbufWrite(&wbuf, addr + W15Q64_PAGE_SIZE,
+                                       &test->pRef[W15Q64_PAGE_SIZE], 10) == W15Q64_WBUF_OK);
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 1);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[addr], test->pRef, W15Q64_PAGE_SIZE) == 0);
+    W15Q64_TEST_CHECK((wbuf.stats.writes == W15Q64_PAGE_SIZE / 16 + 1)
+                      && (wbuf.stats.bytes == W15Q64_PAGE_SIZE + 10));
+
+    // До deadlineUs данные остаются в буфере
+    W15Q64_WbufPoll(&wbuf);
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 1);
+    W15Q64_SimAdvanceNs(&test->sim, 2000000UL);
+    W15Q64_WbufPoll(&wbuf);
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 2);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[addr + W15Q64_PAGE_SIZE],
+                             &test->pRef[W15Q64_PAGE_SIZE], 10) == 0);
+    W15Q64_WbufFlush(&wbuf);
+    W15Q64_TEST_CHECK(wbuf.stats.programs == 2);
+    return true;
+}
+
+/**
+ *  @brief  CRC-32C по определению (побитно), образец для проверки
+ */
+static uint32_t W15Q64_TestCrcBitwise(const uint8_t *pData,
+                                      uint32_t cnt)
+{
+    uint32_t crc = 0xFFFFFFFFUL,
+            i;
+    uint8_t bit;
+
+    for (i = 0; i < cnt; i++)
+    {
+        crc ^= pData[i];
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (((crc & 1) != 0) ? 0x82F63B78UL : 0);
+        }
+    }
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+/**
+ *  @brief  CRC-32C: контрольное значение для "123456789", совпадение с
+ *          побитным вычислением при любых длине и выравнивании, вычисление
+ *          по частям. Путь вычисления (команды процессора, slice-by-8,
+ *          slice-by-1) выбирается при сборке: W15Q64_CRC_HW,
+ *          W15Q64_CRC_SLICES
+ */
+static _Bool W15Q64_TestCrc(W15Q64test_t *test)
+{
+    static const uint8_t check[] = "123456789";
+    uint32_t len,
+            offset,
+            split;
+
+    W15Q64_TEST_CHECK(W15Q64_Crc32c(0, check, 9) == W15Q64_TEST_CRC_CHECK);
+    W15Q64_TEST_CHECK(W15Q64_Crc32c(W15Q64_Crc32c(0, check, 4), &check[4], 5)
+                      == W15Q64_TEST_CRC_CHECK);
+    W15Q64_TEST_CHECK(W15Q64_Crc32c(0, check, 0) == 0);
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_CRC_LENGTHS + 8);
+    for (offset = 0; offset < 8; offset++)
+    {
+        for (len = 0; len < W15Q64_TEST_CRC_LENGTHS; len++)
+        {
+            split = len / 3;
+            W15Q64_TEST_CHECK(W15Q64_Crc32c(0, &test->pRef[offset], len)
+                              == W15Q64_TestCrcBitwise(&test->pRef[offset], len));
+            W15Q64_TEST_CHECK(W15Q64_Crc32c(W15Q64_Crc32c(0, &test->pRef[offset], split),
+                                            &test->pRef[offset + split], len - split)
+                              == W15Q64_TestCrcBitwise(&test->pRef[offset], len));
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief  W15Q64_Probe(), W15Q64_ReadStatus() и W15Q64_PollStatus(): JEDEC
+ *          ID модели, биты WEL и BUSY во время и после Page Program
+ */
+static _Bool W15Q64_TestStatus(W15Q64test_t *test)
+{
+    uint8_t wren = W15Q64_WRITE_ENABLE,
+            data[4] = {0x12, 0x34, 0x56, 0x78};
+    uint8_t capacity;
+    uint16_t status;
+    W15Q64id_t id;
+
+    for (capacity = 0; (1UL << capacity) < W15Q64_SIM_CAPACITY; capacity++)
+    {
+    }
+    W15Q64_TEST_CHECK(W15Q64_Probe(&test->spi, &id));
+    W15Q64_TEST_CHECK(id.manufacturerId == W15Q64_SIM_MANUFACTURER_ID);
+    W15Q64_TEST_CHECK(id.memoryType == W15Q64_SIM_MEMORY_TYPE);
+    W15Q64_TEST_CHECK(id.capacityCode == capacity);
+    W15Q64_TEST_CHECK(!W15Q64_STATUS_BUSY(id.status) && !W15Q64_STATUS_WEL(id.status));
+
+    W15Q64_SimSelect(&test->sim);
+    W15Q64_SimTransmit(&test->sim, &wren, 1);
+    W15Q64_SimDeselect(&test->sim);
+    status = W15Q64_ReadStatus(&test->spi);
+    W15Q64_TEST_CHECK(W15Q64_STATUS_WEL(status) && !W15Q64_STATUS_BUSY(status));
+    W15Q64_TEST_CHECK((uint8_t) status == W15Q64_PollStatus(&test->spi));
+
+    W15Q64_PageProg(&test->spi, 0x50000, data, sizeof (data));
+    status = W15Q64_PollStatus(&test->spi);
+    W15Q64_TEST_CHECK(W15Q64_STATUS_BUSY(status) && W15Q64_STATUS_WEL(status));
+    W15Q64_TEST_CHECK(W15Q64_STATUS_BUSY(W15Q64_ReadStatus(&test->spi)));
+    W15Q64_WaitBusy(&test->spi);
+    status = W15Q64_PollStatus(&test->spi);
+    W15Q64_TEST_CHECK(!W15Q64_STATUS_BUSY(status) && !W15Q64_STATUS_WEL(status));
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[0x50000], data, sizeof (data)) == 0);
+    return true;
+}
+
+/**
+ *  @brief  W15Q64_FastReadCont(): инструкция передается только первой
+ *          транзакцией (при поддержке 4 линий портом), следующая команда
+ *          драйвера выводит микросхему из режима Continuous Read
+ */
+static _Bool W15Q64_TestContRead(W15Q64test_t *test)
+{
+    const _Bool quad = (test->spi.busWidths & W15Q64_BUS_QUAD) != 0;
+    const uint8_t *pMem = &test->sim.pMem[W15Q64_TEST_CONT_START];
+    uint8_t data[4] = {0x01, 0x02, 0x04, 0x08};
+    uint32_t i;
+
+    W15Q64_TestFill(test, &test->sim.pMem[W15Q64_TEST_CONT_START], W15Q64_SECTOR_SIZE);
+    for (i = 0; i < 4; i++)
+    {
+        W15Q64_FastReadCont(&test->spi, W15Q64_TEST_CONT_START + i * 1000, test->pRx, 100 + i);
+        W15Q64_TEST_CHECK(memcmp(test->pRx, &pMem[i * 1000], 100 + i) == 0);
+    }
+    W15Q64_TEST_CHECK(test->sim.stats.opcodes[W15Q64_FAST_READ_QUAD_IO] == (quad ? 1 : 0));
+    W15Q64_TEST_CHECK(test->spi.contInstruct == (quad ? W15Q64_FAST_READ_QUAD_IO : 0));
+
+    // Page Program после Continuous Read
+    W15Q64_SectorErase4KB(&test->spi, W15Q64_TEST_CONT_START);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_TEST_CHECK(test->spi.contInstruct == 0);
+    W15Q64_PageProg(&test->spi, W15Q64_TEST_CONT_START, data, sizeof (data));
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_FastReadCont(&test->spi, W15Q64_TEST_CONT_START, test->pRx, 8);
+    W15Q64_ContReadExit(&test->spi);
+    W15Q64_TEST_CHECK(test->spi.contInstruct == 0);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, data, sizeof (data)) == 0);
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(&test->pRx[4], 0xFF, 4));
+    W15Q64_FastReadData(&test->spi, W15Q64_TEST_CONT_START, test->pRx, 4);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, data, sizeof (data)) == 0);
+    return true;
+}
+
+/**
+ *  @brief  Функция заполнения для W15Q64_WriteStream(): данные из pRef,
+ *          адреса частей должны идти подряд
+ */
+static void W15Q64_TestStreamFill(void *pCtx,
+                                  uint32_t addr,
+                                  uint8_t *pBuf,
+                                  uint16_t cnt)
+{
+    uint32_t *pNext = (uint32_t *) pCtx;
+
+    if (addr != *pNext)
+    {
+        *pNext = 0xFFFFFFFFUL; //       Адрес не по порядку
+        return;
+    }
+    memcpy(pBuf, &test.pRef[addr - W15Q64_TEST_WSTREAM_START], cnt);
+    *pNext = addr + cnt;
+}
+
+/**
+ *  @brief  W15Q64_WriteStream() с невыровненного адреса: части не
+ *          пересекают границ страниц, данные совпадают с образцом
+ */
+static _Bool W15Q64_TestWriteStream(W15Q64test_t *test)
+{
+    uint32_t next = W15Q64_TEST_WSTREAM_START;
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_WSTREAM_LEN);
+    W15Q64_WriteStream(&test->spi, W15Q64_TEST_WSTREAM_START, W15Q64_TEST_WSTREAM_LEN,
+                       W15Q64_TestStreamFill, &next);
+    W15Q64_TEST_CHECK(next == W15Q64_TEST_WSTREAM_START + W15Q64_TEST_WSTREAM_LEN);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[W15Q64_TEST_WSTREAM_START], test->pRef,
+                             W15Q64_TEST_WSTREAM_LEN) == 0);
+    W15Q64_TEST_CHECK(test->sim.pMem[W15Q64_TEST_WSTREAM_START - 1] == 0xFF);
+    W15Q64_TEST_CHECK(test->sim.pMem[W15Q64_TEST_WSTREAM_START + W15Q64_TEST_WSTREAM_LEN] == 0xFF);
+    W15Q64_TEST_CHECK(test->sim.stats.opcodes[W15Q64_PAGE_PROGRAM]
+                      == (W15Q64_TEST_WSTREAM_START + W15Q64_TEST_WSTREAM_LEN - 1) / W15Q64_PAGE_SIZE
+                      - W15Q64_TEST_WSTREAM_START / W15Q64_PAGE_SIZE + 1);
+    return true;
+}
+
+#if W15Q64_STATS
+/**
+ *  @brief  Счетчики драйвера: команды по кодам, байты, опросы BUSY и
+ *          гистограммы задержек чтения, записи и стирания; сброс снимком
+ */
+static _Bool W15Q64_TestStats(W15Q64test_t *test)
+{
+    W15Q64stats_t stats;
+    W15Q64statsSnap_t snap;
+    uint8_t data[16] = {0};
+
+    W15Q64_StatsInit(&stats, W15Q64_TestNowUs);
+    W15Q64_TEST_CHECK(W15Q64_StatsAttach(&test->spi, &stats));
+    W15Q64_FastReadData(&test->spi, 0x60000, test->pRx, 100);
+    W15Q64_PageProg(&test->spi, 0x60000, data, sizeof (data));
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_SectorErase4KB(&test->spi, 0x60000);
+    W15Q64_WaitBusy(&test->spi);
+    W15Q64_StatsSnapshot(&stats, &snap, true);
+    W15Q64_StatsAttach(&test->spi, NULL);
+
+    W15Q64_TEST_CHECK(snap.opcodes[W15Q64_FAST_READ] == 1);
+    W15Q64_TEST_CHECK(snap.opcodes[W15Q64_PAGE_PROGRAM] == 1);
+    W15Q64_TEST_CHECK(snap.opcodes[W15Q64_SECTOR_ERASE_4KB] == 1);
+    W15Q64_TEST_CHECK(snap.opcodes[W15Q64_WRITE_ENABLE] == 2);
+    W15Q64_TEST_CHECK(snap.rxBytes >= 100);
+    W15Q64_TEST_CHECK(snap.txBytes >= sizeof (data));
+    W15Q64_TEST_CHECK(snap.busyPolls != 0);
+    W15Q64_TEST_CHECK(snap.hist[W15Q64_STATS_READ].cnt >= 1);
+    W15Q64_TEST_CHECK(snap.hist[W15Q64_STATS_PROGRAM].cnt == 1);
+    W15Q64_TEST_CHECK(snap.hist[W15Q64_STATS_ERASE].cnt == 1);
+    W15Q64_TEST_CHECK(snap.hist[W15Q64_STATS_ERASE].maxUs >= test->sim.timing.tSE_us);
+
+    W15Q64_StatsSnapshot(&stats, &snap, false);
+    W15Q64_TEST_CHECK((snap.transactions == 0) && (snap.busyPolls == 0));
+    return true;
+}
+#endif
+
+#if W15Q64_STATIC_PORT
+/**
+ *  @brief  Порт этапа компиляции: структура без указателей на функции
+ *          работает с моделью через макросы W15Q64_PORT_HEADER
+ */
+static _Bool W15Q64_TestStaticPort(W15Q64test_t *test)
+{
+    W15Q64spi_t spi;
+    W15Q64verifyResult_t res;
+
+    memset(&spi, 0, sizeof (spi));
+    pW15Q64portSim = &test->sim;
+    W15Q64_TestFill(test, &test->sim.pMem[W15Q64_TEST_VERIFY_START], W15Q64_SECTOR_SIZE);
+    W15Q64_Erase(&spi, W15Q64_TEST_VERIFY_START, W15Q64_SECTOR_ERASE_4KB);
+    W15Q64_WaitBusy(&spi);
+    W15Q64_TEST_CHECK(W15Q64_TestIsFilled(&test->sim.pMem[W15Q64_TEST_VERIFY_START], 0xFF,
+                                          W15Q64_SECTOR_SIZE));
+
+    W15Q64_TestFill(test, test->pRef, W15Q64_TEST_VERIFY_LEN);
+    W15Q64_Write(&spi, W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET, test->pRef,
+                 W15Q64_TEST_VERIFY_LEN);
+    W15Q64_WaitBusy(&spi);
+    W15Q64_TEST_CHECK(memcmp(&test->sim.pMem[W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET],
+                             test->pRef, W15Q64_TEST_VERIFY_LEN) == 0);
+    W15Q64_FastReadData32(&spi, W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET, test->pRx,
+                          W15Q64_TEST_VERIFY_LEN);
+    W15Q64_TEST_CHECK(memcmp(test->pRx, test->pRef, W15Q64_TEST_VERIFY_LEN) == 0);
+    W15Q64_TEST_CHECK(W15Q64_ReadData(&spi, W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET + 1)
+                      == test->pRef[1]);
+    W15Q64_TEST_CHECK(W15Q64_Verify(&spi, W15Q64_TEST_VERIFY_START + W15Q64_TEST_VERIFY_OFFSET,
+                                    test->pRef, W15Q64_TEST_VERIFY_LEN, &res));
+    return true;
+}
+#endif
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,246 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_update.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Обновление образа прошивки в микросхеме flash памяти w15q64 с
+ *              записью только измененных секторов
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_update.h"
+#include "Lib_H_W15Q64_erase.h"
+#include "Lib_H_W15Q64_verify.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static _Bool W15Q64_UpdateSector(W15Q64update_t *upd);
+static uint32_t W15Q64_UpdateProgUs(W15Q64spi_t *spi);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция начинает обновление образа
+ *  @param  *upd:   Указатель на структуру обновления
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  start:  Адрес образа в микросхеме, кратен 4 КБ
+ *  @param  now_us: Источник времени в мкс для статистики или NULL
+ *  @retval true - адрес допустим
+ */
+_Bool W15Q64_UpdateBegin(W15Q64update_t *upd,
+                         W15Q64spi_t *spi,
+                         uint32_t start,
+                         uint32_t (* now_us) (void))
+{
+    if (((start & (W15Q64_SECTOR_SIZE - 1)) != 0) || (start >= W15Q64_Capacity(spi)))
+    {
+        return false;
+    }
+    memset(&upd->stats, 0, sizeof (upd->stats));
+    upd->spi = spi;
+    upd->start = start;
+    upd->now_us = now_us;
+    upd->startUs = (now_us != NULL) ? now_us() : 0;
+    upd->addr = start;
+    upd->fill = 0;
+    upd->ok = true;
+    return true;
+}
+
+/**
+ *  @brief  Функция принимает следующую часть образа. Заполненные сектора
+ *          сравниваются с микросхемой и записываются при отличии
+ *  @param  *upd:   Указатель на структуру обновления
+ *  @param  *pData: Данные
+ *  @param  cnt:    Количество байт
+ *  @retval false - образ не помещается в микросхему или ошибка проверки
+ *          записанного сектора (в том числе на предыдущих вызовах)
+ */
+_Bool W15Q64_UpdateWrite(W15Q64update_t *upd,
+                         const uint8_t *pData,
+                         uint32_t cnt)
+{
+    uint32_t part;
+
+    while ((cnt != 0) && upd->ok)
+    {
+        if (upd->addr + W15Q64_SECTOR_SIZE > W15Q64_Capacity(upd->spi))
+        {
+            upd->ok = false;
+            break;
+        }
+        part = W15Q64_SECTOR_SIZE - upd->fill;
+        if (part > cnt)
+        {
+            part = cnt;
+        }
+        memcpy(&upd->sector[upd->fill], pData, part);
+        upd->fill = (uint16_t) (upd->fill + part);
+        upd->stats.bytes += part;
+        pData += part;
+        cnt -= part;
+        if (upd->fill == W15Q64_SECTOR_SIZE)
+        {
+            upd->ok = W15Q64_UpdateSector(upd);
+            upd->addr += W15Q64_SECTOR_SIZE;
+            upd->fill = 0;
+        }
+    }
+    return upd->ok;
+}
+
+/**
+ *  @brief  Функция записывает последний неполный сектор (байты после конца
+ *          образа остаются прежними) и заполняет статистику
+ *  @param  *upd:   Указатель на структуру обновления
+ *  @retval true - образ записан и проверен
+ */
+_Bool W15Q64_UpdateEnd(W15Q64update_t *upd)
+{
+    W15Q64updateStats_t *st = &upd->stats;
+    const uint32_t blocks = (st->bytes + W15Q64_BLOCK_64KB_SIZE - 1) / W15Q64_BLOCK_64KB_SIZE;
+    const uint32_t pages = (st->bytes + W15Q64_PAGE_SIZE - 1) / W15Q64_PAGE_SIZE;
+    uint32_t blockUs = W15Q64_EraseUs(upd->spi, W15Q64_BLOCK_ERASE_64KB),
+            timeUs;
+
+    if (upd->ok && (upd->fill != 0))
+    {
+        W15Q64_FastReadData(upd->spi, upd->addr + upd->fill, &upd->sector[upd->fill],
+                            (uint16_t) (W15Q64_SECTOR_SIZE - upd->fill));
+        upd->ok = W15Q64_UpdateSector(upd);
+        upd->fill = 0;
+    }
+
+    if (blockUs == 0xFFFFFFFFUL)
+    {
+        blockUs = W15Q64_EraseUs(upd->spi, W15Q64_SECTOR_ERASE_4KB)
+                * (W15Q64_BLOCK_64KB_SIZE / W15Q64_SECTOR_SIZE);
+    }
+    st->busyUs = st->erased * W15Q64_EraseUs(upd->spi, W15Q64_SECTOR_ERASE_4KB)
+            + st->pages * W15Q64_UpdateProgUs(upd->spi);
+    st->fullUs = blocks * blockUs + pages * W15Q64_UpdateProgUs(upd->spi);
+    st->elapsedUs = (upd->now_us != NULL) ? (upd->now_us() - upd->startUs) : 0;
+    timeUs = (upd->now_us != NULL) ? st->elapsedUs : st->busyUs;
+    st->savedUs = (st->fullUs > timeUs) ? (st->fullUs - timeUs) : 0;
+    st->bytesSaved = (st->bytes > st->pages * W15Q64_PAGE_SIZE)
+            ? (st->bytes - st->pages * W15Q64_PAGE_SIZE) : 0;
+    return upd->ok;
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция сравнивает сектор буфера с микросхемой и записывает
+ *          измененные страницы, при необходимости со стиранием
+ *  @retval false - ошибка проверки записанного сектора
+ */
+static _Bool W15Q64_UpdateSector(W15Q64update_t *upd)
+{
+    const uint8_t *pNew;
+    uint16_t diff = 0,
+            i;
+    uint8_t page;
+    _Bool erase = false;
+
+    upd->stats.sectors++;
+    for (page = 0; (page < W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE) && (!erase); page++)
+    {
+        pNew = &upd->sector[page * W15Q64_PAGE_SIZE];
+        W15Q64_FastReadData(upd->spi, upd->addr + page * W15Q64_PAGE_SIZE,
+                            upd->old, W15Q64_PAGE_SIZE);
+        if (memcmp(upd->old, pNew, W15Q64_PAGE_SIZE) == 0)
+        {
+            continue;
+        }
+        diff |= (uint16_t) (1U << page);
+        for (i = 0; i < W15Q64_PAGE_SIZE; i++)
+        {
+            if ((pNew[i] & (uint8_t) ~upd->old[i]) != 0)
+            {
+                erase = true; //    Бит нужно установить в "1"
+                break;
+            }
+        }
+    }
+    if (diff == 0)
+    {
+        upd->stats.skipped++;
+        return true;
+    }
+
+    if (erase)
+    {
+        W15Q64_Erase(upd->spi, upd->addr, W15Q64_SECTOR_ERASE_4KB);
+        W15Q64_WaitBusy(upd->spi);
+        upd->stats.erased++;
+
+        // После стирания программируются все непустые страницы
+        diff = 0;
+        for (page = 0; page < W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE; page++)
+        {
+            pNew = &upd->sector[page * W15Q64_PAGE_SIZE];
+            for (i = 0; (i < W15Q64_PAGE_SIZE) && (pNew[i] == 0xFF); i++)
+            {
+            }
+            if (i < W15Q64_PAGE_SIZE)
+            {
+                diff |= (uint16_t) (1U << page);
+            }
+        }
+    }
+    else
+    {
+        upd->stats.programmed++;
+    }
+
+    for (page = 0; page < W15Q64_SECTOR_SIZE / W15Q64_PAGE_SIZE; page++)
+    {
+        if ((diff & (1U << page)) != 0)
+        {
+            W15Q64_Write(upd->spi, upd->addr + page * W15Q64_PAGE_SIZE,
+                         &upd->sector[page * W15Q64_PAGE_SIZE], W15Q64_PAGE_SIZE);
+            upd->stats.pages++;
+        }
+    }
+    if (!W15Q64_Verify(upd->spi, upd->addr, upd->sector, W15Q64_SECTOR_SIZE, NULL))
+    {
+        upd->stats.verifyErrors++;
+        return false;
+    }
+    return true;
+}
+
+static uint32_t W15Q64_UpdateProgUs(W15Q64spi_t *spi)
+{
+    return ((spi->pDev != NULL) && (spi->pDev->tPPtypUs != 0))
+            ? spi->pDev->tPPtypUs : W15Q64_UPDATE_T_PP_US;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_update.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Обновление образа прошивки в микросхеме flash памяти w15q64 с
+ *              записью только измененных секторов
+ *  @warning    Новый образ передается частями любой длины
+ *              (W15Q64_UpdateWrite()) и накапливается в буфере сектора 4 КБ.
+ *              Каждый заполненный сектор сравнивается с содержимым микросхемы
+ *              по страницам (W15Q64_FastReadData()):
+ *              - сектор без изменений пропускается;
+ *              - если в измененных страницах биты только сбрасываются в "0",
+ *                эти страницы программируются без стирания;
+ *              - иначе сектор стирается и программируются его непустые
+ *                страницы.
+ *              Записанный сектор проверяется чтением (W15Q64_Verify()).
+ *              Байты последнего неполного сектора после конца образа
+ *              сохраняются.
+ *              Сектора стираются по 4 КБ, поэтому при изменении всего образа
+ *              обновление медленнее записи блоками 64 КБ; в статистике
+ *              fullUs - оценка времени такой записи (типовые времена
+ *              W15Q64_EraseUs(), pDev или W15Q64_UPDATE_T_PP_US).
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_UPDATE_H
+#define	LIB_H_W15Q64_UPDATE_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Типовое время Page Program, мкс (см. 9.6 AC Electrical Characteristics)
+#define W15Q64_UPDATE_T_PP_US                             700UL
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t bytes; //          Байт образа
+    uint32_t sectors;
+    uint32_t skipped; //        Сектора без изменений
+    uint32_t programmed; //     Сектора, записанные без стирания
+    uint32_t erased; //         Сектора, записанные со стиранием
+    uint32_t pages; //          Выполнено команд Page Program
+    uint32_t bytesSaved; //     Байт образа, не записанных в микросхему
+    uint32_t verifyErrors;
+    uint32_t elapsedUs; //      Время обновления (now_us), 0 - нет источника
+    //                          времени
+    uint32_t busyUs; //         Оценка времени стирания и программирования
+    uint32_t fullUs; //         Оценка времени записи всего образа блоками
+    //                          64 КБ
+    uint32_t savedUs; //        fullUs - elapsedUs (или busyUs)
+} W15Q64updateStats_t;
+
+typedef struct {
+    W15Q64spi_t *spi;
+    uint32_t start; //                  Адрес образа, кратен 4 КБ
+    uint32_t (* now_us) (void); //      Источник времени или NULL
+    uint32_t startUs;
+    W15Q64updateStats_t stats;
+
+    // Служебные поля
+    uint32_t addr; //                   Адрес сектора в буфере
+    uint16_t fill;
+    _Bool ok;
+    uint8_t sector[W15Q64_SECTOR_SIZE];
+    uint8_t old[W15Q64_PAGE_SIZE];
+} W15Q64update_t; //    Структура содержит состояние обновления образа
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_UpdateBegin(W15Q64update_t *upd,
+        W15Q64spi_t *spi,
+        uint32_t start,
+        uint32_t (* now_us) (void));
+extern _Bool W15Q64_UpdateWrite(W15Q64update_t *upd,
+        const uint8_t *pData,
+        uint32_t cnt);
+extern _Bool W15Q64_UpdateEnd(W15Q64update_t *upd);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,250 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_verify.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Проверка чистоты (0xFF) и сравнение содержимого микросхемы
+ *              flash памяти w15q64 с массивом
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_verify.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static _Bool W15Q64_Compare(W15Q64spi_t *spi,
+                            uint32_t addr,
+                            const uint8_t *pRef,
+                            uint32_t cnt,
+                            W15Q64verifyResult_t *pRes);
+static uint32_t W15Q64_CompareChunk(const uint32_t *pData,
+                                    const uint8_t *pRef,
+                                    uint32_t cnt,
+                                    uint32_t *pFirst);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция проверяет, что область памяти заполнена значением 0xFF
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес начала области
+ *  @param  cnt:    Размер области в байтах
+ *  @param  *pRes:  Указатель на структуру результата или NULL (проверка
+ *                  прекращается на первом несовпадении)
+ *  @retval true - область чистая
+ */
+_Bool W15Q64_BlankCheck(W15Q64spi_t *spi,
+                        uint32_t addr,
+                        uint32_t cnt,
+                        W15Q64verifyResult_t *pRes)
+{
+    return W15Q64_Compare(spi, addr, NULL, cnt, pRes);
+}
+
+/**
+ *  @brief  Функция сравнивает область памяти с массивом
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес начала области
+ *  @param  *pRef:  Указатель на первый элемент массива для сравнения
+ *  @param  cnt:    Размер области в байтах
+ *  @param  *pRes:  Указатель на структуру результата или NULL (проверка
+ *                  прекращается на первом несовпадении)
+ *  @retval true - содержимое совпадает
+ */
+_Bool W15Q64_Verify(W15Q64spi_t *spi,
+                    uint32_t addr,
+                    const uint8_t *pRef,
+                    uint32_t cnt,
+                    W15Q64verifyResult_t *pRes)
+{
+    return W15Q64_Compare(spi, addr, pRef, cnt, pRes);
+}
+
+/**
+ *  @brief  Функция запускает чтение блока: через DMA, если порт его
+ *          поддерживает, иначе чтение выполняется сразу. Если запустить DMA
+ *          не удалось (шина занята другим приемом), блок читается сразу.
+ *          Используется для двойной буферизации: следующий блок принимается,
+ *          пока проверяется текущий
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  addr:   Адрес начала блока
+ *  @param  *pRxData:   Указатель на буфер приема
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_ReadChunk(W15Q64spi_t *spi,
+                      uint32_t addr,
+                      uint8_t *pRxData,
+                      uint32_t cnt)
+{
+    if (!W15Q64_FastReadDataDMA(spi, addr, pRxData, cnt, NULL, NULL))
+    {
+        W15Q64_WaitChunk(spi);
+        W15Q64_FastReadAuto(spi, addr, pRxData, cnt);
+    }
+}
+
+/**
+ *  @brief  Функция дожидается окончания чтения, запущенного
+ *          W15Q64_ReadChunk()
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @retval None
+ */
+void W15Q64_WaitChunk(W15Q64spi_t *spi)
+{
+    while (spi->dmaBusy)
+    {
+    }
+}
+
+//==============================================================================
+// Локальные функции
+
+/**
+ *  @brief  Функция читает область блоками в два буфера и сравнивает каждый
+ *          блок с массивом pRef (NULL - со значением 0xFF), пока читается
+ *          следующий
+ */
+static _Bool W15Q64_Compare(W15Q64spi_t *spi,
+                            uint32_t addr,
+                            const uint8_t *pRef,
+                            uint32_t cnt,
+                            W15Q64verifyResult_t *pRes)
+{
+    uint32_t buf[2][W15Q64_VERIFY_CHUNK / 4],
+            pos = 0,
+            chunk,
+            next,
+            first,
+            bad;
+    uint8_t cur = 0;
+
+    if (pRes != NULL)
+    {
+        pRes->firstAddr = 0xFFFFFFFFUL;
+        pRes->mismatches = 0;
+    }
+    if (cnt == 0)
+    {
+        return true;
+    }
+
+    chunk = (cnt < W15Q64_VERIFY_CHUNK) ? cnt : W15Q64_VERIFY_CHUNK;
+    W15Q64_ReadChunk(spi, addr, (uint8_t *) buf[cur], chunk);
+    while (pos < cnt)
+    {
+        W15Q64_WaitChunk(spi);
+
+        // Чтение следующего блока во второй буфер
+        next = cnt - pos - chunk;
+        if (next > W15Q64_VERIFY_CHUNK)
+        {
+            next = W15Q64_VERIFY_CHUNK;
+        }
+        if (next != 0)
+        {
+            W15Q64_ReadChunk(spi, addr + pos + chunk, (uint8_t *) buf[cur ^ 1], next);
+        }
+
+        bad = W15Q64_CompareChunk(buf[cur], (pRef != NULL) ? &pRef[pos] : NULL,
+                                  chunk, &first);
+        if (bad != 0)
+        {
+            if (pRes == NULL)
+            {
+                W15Q64_WaitChunk(spi);
+                return false;
+            }
+            if (pRes->mismatches == 0)
+            {
+                pRes->firstAddr = addr + pos + first;
+            }
+            pRes->mismatches += bad;
+        }
+
+        pos += chunk;
+        chunk = next;
+        cur ^= 1;
+    }
+    return (pRes == NULL) || (pRes->mismatches == 0);
+}
+
+/**
+ *  @brief  Функция сравнивает блок словами по 4 байта
+ *  @retval Количество несовпавших байт, в *pFirst - смещение первого из них
+ */
+static uint32_t W15Q64_CompareChunk(const uint32_t *pData,
+                                    const uint8_t *pRef,
+                                    uint32_t cnt,
+                                    uint32_t *pFirst)
+{
+    const uint8_t *pByte = (const uint8_t *) pData;
+    uint32_t i,
+            j,
+            ref = 0xFFFFFFFFUL,
+            bad = 0;
+
+    for (i = 0; i < cnt / 4; i++)
+    {
+        if (pRef != NULL)
+        {
+            memcpy(&ref, &pRef[i * 4], 4); //   pRef может быть не выровнен
+        }
+        if (pData[i] == ref)
+        {
+            continue;
+        }
+        for (j = i * 4; j < i * 4 + 4; j++)
+        {
+            if (pByte[j] != ((pRef != NULL) ? pRef[j] : 0xFF))
+            {
+                if (bad++ == 0)
+                {
+                    *pFirst = j;
+                }
+            }
+        }
+    }
+    for (j = i * 4; j < cnt; j++)
+    {
+        if (pByte[j] != ((pRef != NULL) ? pRef[j] : 0xFF))
+        {
+            if (bad++ == 0)
+            {
+                *pFirst = j;
+            }
+        }
+    }
+    return bad;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
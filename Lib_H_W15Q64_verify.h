@@ -0,0 +1,74 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_verify.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Проверка чистоты (0xFF) и сравнение содержимого микросхемы
+ *              flash памяти w15q64 с массивом
+ *  @warning    Память читается блоками по W15Q64_VERIFY_CHUNK байт в два
+ *              буфера на стеке. Если порт поддерживает transmitReceiveDMA,
+ *              чтение следующего блока запускается до сравнения текущего.
+ *              Сравнение выполняется словами по 4 байта, побайтно - только
+ *              внутри несовпавшего слова.
+ *              Если указатель на результат равен NULL, проверка прекращается
+ *              на первом несовпадении.
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_VERIFY_H
+#define	LIB_H_W15Q64_VERIFY_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+#define W15Q64_VERIFY_CHUNK                               512
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t firstAddr; //      Адрес первого несовпавшего байта
+    uint32_t mismatches; //     Количество несовпавших байт
+} W15Q64verifyResult_t; //  Структура содержит результат проверки
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern _Bool W15Q64_BlankCheck(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint32_t cnt,
+        W15Q64verifyResult_t *pRes);
+extern _Bool W15Q64_Verify(W15Q64spi_t *spi,
+        uint32_t addr,
+        const uint8_t *pRef,
+        uint32_t cnt,
+        W15Q64verifyResult_t *pRes);
+extern void W15Q64_ReadChunk(W15Q64spi_t *spi,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_WaitChunk(W15Q64spi_t *spi);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,220 @@
+/**
+ *******************************************************************************
+ *  @file       Lib_H_W15Q64_wbuf.c
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Буфер записи микросхемы flash памяти w15q64: объединение
+ *              небольших записей в одну страницу в одну команду Page Program
+ *******************************************************************************
+ */
+
+//******************************************************************************
+// Секция include: здесь подключается заголовочный файл к модулю
+#include <stddef.h>
+#include <string.h>
+#include "Lib_H_W15Q64_wbuf.h"
+//******************************************************************************
+
+
+//******************************************************************************
+//------------------------------------------------------------------------------
+// Глобальные переменные
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Локальные переменные
+//------------------------------------------------------------------------------
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов локальных функций
+static uint16_t W15Q64_WbufPageSize(W15Q64wbuf_t *wbuf);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция описания функций (сначала глобальных, потом локальных)
+
+/**
+ *  @brief  Функция инициализирует пустой буфер записи
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @param  *spi:   Указатель на структуру в которой содержатся указатели на
+ *                  функции для работы с шиной SPI
+ *  @param  deadlineUs: Максимальное время хранения данных в буфере, 0 - без
+ *                      ограничения
+ *  @param  now_us: Функция, возвращающая текущее время в микросекундах,
+ *                  или NULL (тогда deadlineUs не используется)
+ *  @retval None
+ */
+void W15Q64_WbufInit(W15Q64wbuf_t *wbuf,
+                     W15Q64spi_t *spi,
+                     uint32_t deadlineUs,
+                     uint32_t (* now_us) (void))
+{
+    wbuf->spi = spi;
+    wbuf->now_us = now_us;
+    wbuf->deadlineUs = deadlineUs;
+    wbuf->dirty = false;
+    memset(&wbuf->stats, 0, sizeof (wbuf->stats));
+}
+
+/**
+ *  @brief  Функция помещает массив байт в буфер записи. Если данные
+ *          относятся к другой странице, накопленная страница сначала
+ *          программируется, а содержимое новой страницы читается из
+ *          микросхемы. Массив может пересекать границы страниц
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  *pData: Указатель на первый элемент массива с данными
+ *  @param  cnt:    Количество байт
+ *  @retval W15Q64_WBUF_OK или W15Q64_WBUF_NEED_ERASE - хотя бы один байт
+ *          перекрывает ранее записанный (в буфер или в микросхему) и
+ *          требует установки битов
+ */
+uint8_t W15Q64_WbufWrite(W15Q64wbuf_t *wbuf,
+                         uint32_t addr,
+                         const uint8_t *pData,
+                         uint32_t cnt)
+{
+    const uint16_t page = W15Q64_WbufPageSize(wbuf);
+    uint8_t result = W15Q64_WBUF_OK;
+    uint16_t offset;
+    uint8_t old;
+
+    wbuf->stats.writes++;
+    wbuf->stats.bytes += cnt;
+
+    for (; cnt != 0; cnt--, addr++, pData++)
+    {
+        offset = (uint16_t) (addr & (page - 1U));
+        if (wbuf->dirty && ((addr - offset) != wbuf->pageAddr))
+        {
+            W15Q64_WbufFlush(wbuf);
+        }
+        if (!wbuf->dirty)
+        {
+            // Биты, сброшенные в микросхеме, тоже нельзя установить
+            W15Q64_FastReadAuto(wbuf->spi, addr - offset, wbuf->page, page);
+            wbuf->pageAddr = addr - offset;
+            wbuf->lo = offset;
+            wbuf->hi = offset;
+            wbuf->dirty = true;
+            if (wbuf->now_us != NULL)
+            {
+                wbuf->firstUs = wbuf->now_us();
+            }
+        }
+
+        old = wbuf->page[offset];
+        if ((old & *pData) != *pData)
+        {
+            // Бит, сброшенный предыдущей записью, нельзя установить без стирания
+            wbuf->stats.conflicts++;
+            wbuf->stats.conflictAddr = addr;
+            result = W15Q64_WBUF_NEED_ERASE;
+        }
+        wbuf->page[offset] = old & *pData;
+
+        if (offset < wbuf->lo)
+        {
+            wbuf->lo = offset;
+        }
+        if (offset >= wbuf->hi)
+        {
+            wbuf->hi = (uint16_t) (offset + 1);
+        }
+    }
+    return result;
+}
+
+/**
+ *  @brief  Функция читает массив байт с учетом данных, еще не записанных
+ *          из буфера в микросхему
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @param  addr:   Адрес памяти в микросхеме "24-Bit Address"
+ *  @param  *pRxData:   Указатель на первый элемент массива, в который будут
+ *                      записаны данные
+ *  @param  cnt:    Количество байт
+ *  @retval None
+ */
+void W15Q64_WbufRead(W15Q64wbuf_t *wbuf,
+                     uint32_t addr,
+                     uint8_t *pRxData,
+                     uint32_t cnt)
+{
+    const uint16_t page = W15Q64_WbufPageSize(wbuf);
+    uint32_t i;
+
+    W15Q64_FastReadAuto(wbuf->spi, addr, pRxData, cnt);
+    if (!wbuf->dirty)
+    {
+        return;
+    }
+    for (i = 0; i < cnt; i++)
+    {
+        if (((addr + i) & ~(page - 1UL)) == wbuf->pageAddr)
+        {
+            pRxData[i] &= wbuf->page[(addr + i) & (page - 1U)];
+        }
+    }
+}
+
+/**
+ *  @brief  Функция программирует накопленную страницу одной командой Page
+ *          Program (от первого до последнего измененного байта) и ожидает
+ *          ее окончания
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @retval None
+ */
+void W15Q64_WbufFlush(W15Q64wbuf_t *wbuf)
+{
+    if (!wbuf->dirty)
+    {
+        return;
+    }
+    wbuf->dirty = false;
+    wbuf->stats.programs++;
+
+    // Байты 0xFF внутри диапазона не изменяют содержимое микросхемы
+    W15Q64_PageProg(wbuf->spi, wbuf->pageAddr + wbuf->lo,
+                    &wbuf->page[wbuf->lo], (uint16_t) (wbuf->hi - wbuf->lo));
+    W15Q64_WaitBusy(wbuf->spi);
+}
+
+/**
+ *  @brief  Функция программирует страницу, если данные находятся в буфере
+ *          дольше deadlineUs. Вызывается периодически (главный цикл, таймер)
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @retval None
+ */
+void W15Q64_WbufPoll(W15Q64wbuf_t *wbuf)
+{
+    if (wbuf->dirty
+        && (wbuf->now_us != NULL)
+        && (wbuf->deadlineUs != 0)
+        && ((uint32_t) (wbuf->now_us() - wbuf->firstUs) >= wbuf->deadlineUs))
+    {
+        W15Q64_WbufFlush(wbuf);
+    }
+}
+
+/**
+ *  @brief  Функция возвращает размер страницы буфера: страница микросхемы,
+ *          но не больше W15Q64_PAGE_SIZE (размер массива page)
+ *  @param  *wbuf:  Указатель на структуру буфера
+ *  @retval Размер в байтах
+ */
+static uint16_t W15Q64_WbufPageSize(W15Q64wbuf_t *wbuf)
+{
+    const uint16_t page = W15Q64_PageSize(wbuf->spi);
+
+    return (page < W15Q64_PAGE_SIZE) ? page : W15Q64_PAGE_SIZE;
+}
+//******************************************************************************
+
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ *  @file       Lib_H_W15Q64_wbuf.h
+ *  @author     Исаев Михаил
+ *  @version    v1.0
+ *  @date       1.09.2017
+ *  @brief      Буфер записи микросхемы flash памяти w15q64: объединение
+ *              небольших записей в одну страницу в одну команду Page Program
+ *  @warning    Записи в одну страницу накапливаются в ОЗУ и программируются
+ *              одной командой при переходе к другой странице, при вызове
+ *              W15Q64_WbufFlush() или по истечении deadlineUs с момента
+ *              первой записи (проверяется W15Q64_WbufPoll()).
+ *              Без стирания биты можно только сбрасывать, поэтому повторная
+ *              запись в байт объединяется по "И" так же, как в микросхеме.
+ *              Если новое значение требует установки битов в "1", запись
+ *              выполняется (результат - "И"), но функция возвращает
+ *              W15Q64_WBUF_NEED_ERASE и счетчик conflicts увеличивается.
+ *              При открытии буфера на новой странице ее содержимое
+ *              читается из микросхемы (одно чтение страницы), поэтому
+ *              проверяются и байты, запрограммированные раньше, в том числе
+ *              до предыдущего W15Q64_WbufFlush().
+ *******************************************************************************
+ */
+
+//
+#ifndef LIB_H_W15Q64_WBUF_H
+#define	LIB_H_W15Q64_WBUF_H
+
+//******************************************************************************
+// Секция include (подключаем заголовочные файлы используемых модулей)
+#include <stdint.h>
+#include <stdbool.h>
+#include "Lib_H_W15Q64_flash_memory.h"
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения констант
+
+// Результат W15Q64_WbufWrite()
+#define W15Q64_WBUF_OK                                    0
+#define W15Q64_WBUF_NEED_ERASE                            1
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения типов
+
+typedef struct {
+    uint32_t writes; //         Вызовы W15Q64_WbufWrite()
+    uint32_t bytes; //          Байт принято в буфер
+    uint32_t programs; //       Выполнено команд Page Program
+    uint32_t conflicts; //      Байт, требующих стирания
+    uint32_t conflictAddr; //   Адрес последнего такого байта
+} W15Q64wbufStats_t;
+
+typedef struct {
+    W15Q64spi_t *spi;
+    uint32_t (* now_us) (void); //      Источник времени для deadline или NULL
+    uint32_t deadlineUs; //             Максимальное время данных в буфере,
+    //                                  0 - без ограничения
+    W15Q64wbufStats_t stats;
+
+    // Служебные поля
+    uint32_t pageAddr; //               Адрес страницы в буфере
+    _Bool dirty;
+    uint32_t firstUs; //                Момент первой записи в буфер
+    uint16_t lo; //                     Первый и последний + 1 измененные байты
+    uint16_t hi;
+    uint8_t page[W15Q64_PAGE_SIZE]; //  Содержимое страницы с учетом записей
+} W15Q64wbuf_t; //  Структура содержит состояние буфера записи
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция прототипов глобальных функций
+extern void W15Q64_WbufInit(W15Q64wbuf_t *wbuf,
+        W15Q64spi_t *spi,
+        uint32_t deadlineUs,
+        uint32_t (* now_us) (void));
+extern uint8_t W15Q64_WbufWrite(W15Q64wbuf_t *wbuf,
+        uint32_t addr,
+        const uint8_t *pData,
+        uint32_t cnt);
+extern void W15Q64_WbufRead(W15Q64wbuf_t *wbuf,
+        uint32_t addr,
+        uint8_t *pRxData,
+        uint32_t cnt);
+extern void W15Q64_WbufFlush(W15Q64wbuf_t *wbuf);
+extern void W15Q64_WbufPoll(W15Q64wbuf_t *wbuf);
+//******************************************************************************
+
+
+//******************************************************************************
+// Секция определения макросов
+//******************************************************************************
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// END OF FILE
+////////////////////////////////////////////////////////////////////////////////